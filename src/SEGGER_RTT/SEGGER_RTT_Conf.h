@@ -80,7 +80,7 @@ Revision: $Rev: 24316 $
 // Up-channel 1: SystemView
 //
 #ifndef   SEGGER_RTT_MAX_NUM_UP_BUFFERS
-  #define SEGGER_RTT_MAX_NUM_UP_BUFFERS             (3)     // Max. number of up-buffers (T->H) available on this target    (Default: 3)
+  #define SEGGER_RTT_MAX_NUM_UP_BUFFERS             (4)     // Max. number of up-buffers (T->H) available on this target    (Default: 3)
 #endif
 //
 // Most common case:
@@ -88,7 +88,7 @@ Revision: $Rev: 24316 $
 // Down-channel 1: SystemView
 //
 #ifndef   SEGGER_RTT_MAX_NUM_DOWN_BUFFERS
-  #define SEGGER_RTT_MAX_NUM_DOWN_BUFFERS           (3)     // Max. number of down-buffers (H->T) available on this target  (Default: 3)
+  #define SEGGER_RTT_MAX_NUM_DOWN_BUFFERS           (4)     // Max. number of down-buffers (H->T) available on this target  (Default: 3)
 #endif
 
 #ifndef   BUFFER_SIZE_UP
@@ -425,6 +425,16 @@ void OS_SIM_LeaveCriticalSection(void);
   #define SEGGER_RTT_UNLOCK()              // Unlock RTT (nestable) (i.e. enable previous interrupt lock state)
 #endif
 
+/*********************************************************************
+*
+*       Control block and buffers in non-cacheable RAM: the debugger
+*       reads them behind the CPU, so they must stay coherent when the
+*       data cache is on (PDM_CFG_DCACHE_ENABLE, see pdm_mem.h).
+*/
+#ifndef   SEGGER_RTT_SECTION
+  #define SEGGER_RTT_SECTION ".ram_nocache"
+#endif
+
 /*********************************************************************
 *
 *       If SEGGER_RTT_SECTION is defined but SEGGER_RTT_BUFFER_SECTION
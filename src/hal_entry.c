@@ -2,6 +2,10 @@
 #include "SEGGER_RTT/SEGGER_RTT.h"
 #include <stdio.h>
 #include "pdm.h"
+#include "pdm_cfg.h"
+#include "pdm_bench.h"
+#include "pdm_mem.h"
+#include "pdm_core1.h"
 
 
 FSP_CPP_HEADER
@@ -18,7 +22,14 @@ void hal_entry(void)
 {
 
     /* TODO: add your own code here */
+#if defined(BSP_SECONDARY_CORE_BUILD) && PDM_CFG_DUAL_CORE_ENABLE
+    /* Core 1 image of the dual-core pipeline: store the spans core 0 hands over */
+    pdm_core1_main();
+#elif PDM_CFG_BENCH_ENABLE
+    pdm_bench_app();
+#else
     r_pdm_basic_messaging_core0_example();
+#endif
     
     
 
@@ -56,6 +67,9 @@ void R_BSP_WarmStart(bsp_warm_start_event_t event)
         /* Configure pins. */
         R_IOPORT_Open (&IOPORT_CFG_CTRL, &IOPORT_CFG_NAME);
 
+        /* Data cache per PDM_CFG_DCACHE_ENABLE */
+        pdm_mem_init();
+
 #if BSP_CFG_SDRAM_ENABLED
 
         /* Setup SDRAM and initialize it. Must configure pins first. */
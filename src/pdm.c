@@ -1,12 +1,28 @@
 #include "hal_data.h"
 #include "SEGGER_RTT/SEGGER_RTT.h"
+#include "pdm.h"
+#include "pdm_cfg.h"
+#include "pdm_sched.h"
+#include "pdm_work.h"
+#include "pdm_prof.h"
+#include "pdm_integrity.h"
+#include "pdm_log.h"
+#include "pdm_mem.h"
+#include "pdm_dsp.h"
+#include "pdm_cmd.h"
+#include "pdm_filter.h"
+#include "pdm_trigger.h"
+#include "pdm_segment.h"
+#include "pdm_slot.h"
+#include "pdm_session.h"
+#include "pdm_kernel.h"
+#include "pdm_loudness.h"
+#include "pdm_slm.h"
+#if PDM_CFG_DUAL_CORE_ENABLE
+ #include "pdm_core1.h"
+#endif
 
-#define PDM_BUFFER_NUM_SAMPLES 4096
-#define PDM_CALLBACK_NUM_SAMPLES 1024
-#define PDM_MIC_STARTUP_TIME_US 35000 
-#define PDM_SDE_UPPER_LIMIT 5000
-#define PDM_SDE_LOWER_LIMIT 0xFFF80000
-#define PDM0_FILTER_SETTLING_TIME_US (25000U)
+#define PDM_FIFO_INTERRUPT_SAMPLES 16     // Data interrupt threshold set in the Configurator
 
 // Text output setting
 #define ENABLE_AUDIO_TEXT_OUTPUT 1      
@@ -16,185 +32,1653 @@
 
 // Complete data storage buffer
 #define MAX_TOTAL_SAMPLES 160000         // About 10 seconds
+#define MAX_RECORDED_GAPS 64             // Gap table printed with the dump
+#define MAX_RECORDED_STAMPS ((MAX_TOTAL_SAMPLES / PDM_CALLBACK_NUM_SAMPLES) + 2) // Block timestamps printed with the dump
+#define COLLECT_CHUNK_SAMPLES PDM_KERNEL_BLOCK  // Detector chunk of the trigger and segment paths, one kernel pass
+#define DUMP_RECORD_SAMPLES 16           // Samples per dump line (one log record)
+#define DUMP_STALL_TIMEOUT_MS 1000       // Give up when the host stops draining the log channel
+#define FETCH_RECORDS_PER_STEP 64        // Segment fetch records written per wake-up, so block work is not held up
+#define CORE1_FLUSH_TIMEOUT_MS 100       // Longest wait for core 1 to store the last spans of a recording
 
 // 저장용 버퍼
+#if PDM_CFG_DUAL_CORE_ENABLE
+ #if PDM_IPC_BLOCK_SAMPLES < PDM_CALLBACK_NUM_SAMPLES
+  #error "PDM_IPC_BLOCK_SAMPLES must hold a whole PDM block"
+ #endif
+// Core 1 stores the recording: uncached on both cores, like the ring that hands it over
+uint32_t g_all_audio_data[MAX_TOTAL_SAMPLES] BSP_PLACE_IN_SECTION(PDM_IPC_SHARED_SECTION);
+#else
 uint32_t g_all_audio_data[MAX_TOTAL_SAMPLES];
+#endif
 uint32_t g_total_collected_samples = 0;
 
-uint32_t g_pdm0_buffer[PDM_BUFFER_NUM_SAMPLES];
+#if (PDM_CFG_BLOCK_SLOTS < 2) || (PDM_CFG_BLOCK_SLOTS > PDM_SLOT_MAX_SLOTS)
+ #error "PDM_CFG_BLOCK_SLOTS must be 2 .. PDM_SLOT_MAX_SLOTS"
+#endif
+
+#if PDM_CFG_TRIGGER_ENABLE
+ #if PDM_CFG_DUAL_CORE_ENABLE
+  #error "PDM_CFG_TRIGGER_ENABLE needs the collection on this core (PDM_CFG_DUAL_CORE_ENABLE 0)"
+ #endif
+// Event-driven recording: g_all_audio_data is the pre-roll ring, the dump is the frozen event record
+static pdm_trigger_ctrl_t g_pdm_trigger;
+#endif
+
+#if PDM_CFG_SEGMENT_ENABLE
+ #if PDM_CFG_DUAL_CORE_ENABLE || PDM_CFG_TRIGGER_ENABLE
+  #error "PDM_CFG_SEGMENT_ENABLE needs the collection on this core and excludes PDM_CFG_TRIGGER_ENABLE"
+ #endif
+// Long-term monitoring: g_all_audio_data is the segment pool, the dump is the index
+#define MAX_SEGMENT_PRE_SAMPLES ((PDM_CFG_SEGMENT_PRE_MS * PDM_CFG_SAMPLE_RATE_HZ) / 1000U)
+
+static pdm_segment_ctrl_t g_pdm_segment;
+static pdm_segment_entry_t g_segment_index[PDM_CFG_SEGMENT_ENTRIES];
+static uint32_t g_segment_preroll[MAX_SEGMENT_PRE_SAMPLES];
+
+// FETCH_SEGMENTS in progress: segments next..last go out on the log channel between other work
+typedef struct st_pdm_fetch
+{
+    bool active;
+    bool started;                  // Header of entry sent
+    uint32_t next;                 // Lowest ID still to send
+    uint32_t last;
+    pdm_segment_entry_t entry;     // Segment being sent
+    uint32_t sent;                 // Its samples sent
+} pdm_fetch_t;
+
+static pdm_fetch_t g_segment_fetch;
+
+static void collect_segment_audio_data(uint32_t *buffer, uint64_t first_index, uint64_t timestamp,
+                                       uint32_t sample_count);
+#endif
+
+#if PDM_CFG_LOUDNESS_ENABLE
+ #if PDM_CFG_DUAL_CORE_ENABLE
+  #error "PDM_CFG_LOUDNESS_ENABLE needs the collection on this core (PDM_CFG_DUAL_CORE_ENABLE 0)"
+ #endif
+ #if PDM_CFG_LOUDNESS_REPORT_MS < PDM_LOUDNESS_STEP_MS
+  #error "PDM_CFG_LOUDNESS_REPORT_MS must be at least one measurement step"
+ #endif
+// Loudness of the collected stream, one record every LOUDNESS_REPORT_STEPS measurement steps
+#define LOUDNESS_REPORT_STEPS (PDM_CFG_LOUDNESS_REPORT_MS / PDM_LOUDNESS_STEP_MS)
+
+static pdm_loudness_ctrl_t g_pdm_loudness;
+static bool g_loudness_ready = false;
+#endif
+
+#if PDM_CFG_SLM_ENABLE
+ #if PDM_CFG_DUAL_CORE_ENABLE
+  #error "PDM_CFG_SLM_ENABLE needs the collection on this core (PDM_CFG_DUAL_CORE_ENABLE 0)"
+ #endif
+ #if (PDM_CFG_SLM_BANDS != 1U) && (PDM_CFG_SLM_BANDS != 3U)
+  #error "PDM_CFG_SLM_BANDS must be 1 (octave) or 3 (third-octave)"
+ #endif
+ #if (PDM_CFG_SLM_BANDS == 1U) && ((PDM_CFG_SLM_LOW_BAND % 3U) != 0U)
+  #error "PDM_CFG_SLM_LOW_BAND must be a multiple of 3 for octave bands"
+ #endif
+// Band levels per log record, after the first band number and the step
+#define SLM_BANDS_PER_RECORD (PDM_LOG_MAX_ARGS - 2U)
+
+static pdm_slm_ctrl_t g_pdm_slm;
+static bool g_slm_ready = false;
+static uint32_t g_slm_reported;    // Last interval logged
+#endif
+
+uint32_t g_pdm0_buffer[PDM_BUFFER_NUM_SAMPLES] PDM_MEM_FAST_DATA;
+
+// Deferred work posted by pdm0_callback. One lane per PDM interrupt (each has its own priority),
+// in dispatch order: errors first, then blocks, then sound detection.
+#define PDM_WORK_LANE_ERROR 0U
+#define PDM_WORK_LANE_DATA 1U
+#define PDM_WORK_LANE_SOUND 2U
+
+typedef enum e_pdm_app_work
+{
+    PDM_APP_WORK_BLOCK,            // arg: slot the block was copied to
+    PDM_APP_WORK_ERROR,            // arg: pdm_error_t bits
+    PDM_APP_WORK_SOUND,            // arg: low 32 bits of the stream index at the interrupt
+} pdm_app_work_t;
+
+static pdm_work_ctrl_t g_pdm_work PDM_MEM_FAST_DATA;
+
+// Capture session of g_pdm0: the driver ring, the block slots completed blocks are copied to (so a slow foreground
+// loses whole blocks instead of reading one the driver is overwriting), the stream integrity and the counters
+static uint32_t g_pdm_slot_storage[PDM_CFG_BLOCK_SLOTS * PDM_CALLBACK_NUM_SAMPLES] PDM_MEM_FAST_DATA;
+static pdm_integrity_block_t g_pdm_slot_info[PDM_CFG_BLOCK_SLOTS] PDM_MEM_FAST_DATA;
+static pdm_session_t g_pdm0_session PDM_MEM_FAST_DATA;
+
+// Missing stretches of the recording, so the dump can be re-aligned on the host
+typedef struct st_pdm_gap
+{
+    uint32_t offset;               // Index in g_all_audio_data (trigger mode: stored position) where the missing samples belong
+    uint32_t missing;              // Samples missing at that point
+} pdm_gap_t;
+
+static pdm_gap_t g_recorded_gaps[MAX_RECORDED_GAPS];
+static uint32_t g_recorded_gap_count = 0;
+
+// Completion time of every collected block, for the host drift estimator (tools/pdm_drift)
+typedef struct st_pdm_stamp
+{
+    uint32_t sequence;             // Block sequence number
+    uint32_t sample_index;         // Stream index of the block's first sample
+    uint64_t timestamp;            // pdm_sched_timestamp() when the block completed
+} pdm_stamp_t;
+
+static pdm_stamp_t g_recorded_stamps[MAX_RECORDED_STAMPS];
+static uint32_t g_recorded_stamp_count = 0;
+static uint64_t g_next_sample_index = 0;       // Stream index expected for the next collected block
+
+// Live filter swaps (SET_SINC); the settling outputs of the last one are left out of the collected data
+static pdm_filter_ctrl_t g_pdm_filter PDM_MEM_FAST_DATA;
+static uint32_t g_filter_swaps_seen = 0;
+static uint64_t g_settling_from = 0;
+static uint64_t g_settling_until = 0;
+
+// Startup readiness: the microphone runs from the first PDM clock edge, the filters from every start
+static uint32_t g_clock_start_tick = 0;
+static bool g_mic_ready = false;
+static uint32_t g_start_request_cycles = 0;    // pdm_record() entry, the reference of the latency figures
+static uint64_t g_first_valid_index = 0;
+static bool g_first_valid_seen = false;
+static uint32_t g_first_valid_us = 0;
 
 // Statistics counters
-static uint32_t g_sound_detection_count = 0;
-static uint32_t g_data_callback_count = 0; 
-static uint32_t g_error_count = 0;
+static uint32_t g_callback_max_cycles = 0;     // Time spent in pdm0_callback (interrupt context)
+static uint64_t g_callback_total_cycles = 0;
+static uint32_t g_callback_count = 0;
+
+// Run-time settings: build-time defaults, changed over pdm_cmd between recordings
+static pdm_cmd_config_t g_pdm_settings =
+{
+    .duration_ms = PDM_CFG_RECORDING_TIME_MS,
+    .sound_detection = 0,
+    .sound_upper = PDM_SDE_UPPER_LIMIT,
+    .sound_lower = PDM_SDE_LOWER_LIMIT,
+    .gain_q8 = PDM_CMD_GAIN_UNITY,
+    .format = PDM_CMD_FORMAT_RAW20,
+};
+
+// Conversion kernels of the channel's PCM width, picked when the PDM starts
+static pdm_kernel_t const *g_pdm_kernel = NULL;
+
+static pdm_cmd_state_t g_pdm_state = PDM_CMD_STATE_IDLE;
+static uint32_t g_recordings = 0;
+static uint32_t g_recording_start_tick = 0;
+static uint32_t g_recording_ticks = 0;         // Length of the last finished recording
+static bool g_start_requested = false;
+static bool g_stop_requested = false;
 
 // Function declarations
 void collect_all_audio_data(uint32_t *buffer, uint32_t sample_count);
 void dump_all_collected_data(void);
 void analyze_audio_data(uint32_t *buffer, uint32_t sample_count);
 void r_pdm_basic_messaging_core0_example(void);
+static void pdm_session_notify(pdm_session_t * p_session, pdm_session_event_t const * p_event, void * p_context);
 
+// Remember where samples are missing from the collected data
+static void pdm_record_gap(uint32_t missing)
+{
+#if PDM_CFG_TRIGGER_ENABLE
+    // The ring only keeps recent audio: make room by forgetting the oldest gap
+    if (g_recorded_gap_count == MAX_RECORDED_GAPS)
+    {
+        for (uint32_t i = 1; i < MAX_RECORDED_GAPS; i++)
+        {
+            g_recorded_gaps[i - 1] = g_recorded_gaps[i];
+        }
 
-// Main function
-void r_pdm_basic_messaging_core0_example(void)
+        g_recorded_gap_count--;
+    }
+
+    uint32_t offset = (uint32_t) pdm_trigger_position(&g_pdm_trigger);
+    bool room = true;
+#elif PDM_CFG_SEGMENT_ENABLE
+    // Segments end at a gap and carry their stream index: nothing to re-align
+    uint32_t offset = 0;
+    bool room = false;
+#else
+    uint32_t offset = g_total_collected_samples;
+    bool room = (g_total_collected_samples < MAX_TOTAL_SAMPLES);
+#endif
+
+    if ((g_recorded_gap_count < MAX_RECORDED_GAPS) && room)
+    {
+        g_recorded_gaps[g_recorded_gap_count].offset = offset;
+        g_recorded_gaps[g_recorded_gap_count].missing = missing;
+        g_recorded_gap_count++;
+    }
+}
+
+// PCM rate of the filters in use; the configured rate belongs to the sincdec generated in hal_data
+static uint32_t pdm_sample_rate_hz(void)
 {
-    SEGGER_RTT_Init();
-    SEGGER_RTT_printf(0, "\n=== PDM OPTIMIZED RECORDING START ===\n");
+    return (uint32_t) (((uint64_t) PDM_CFG_SAMPLE_RATE_HZ * g_pdm0_cfg_extend.sincdec) / g_pdm_filter.active.sincdec);
+}
+
+// Width of the FIFO samples: the 16-bit pdm_pcm_width_t selections follow the 20-bit ones
+static uint32_t pdm_pcm_bits(void)
+{
+    return (g_pdm0_cfg.pcm_width >= PDM_PCM_WIDTH_16_BITS_4_18) ? 16U : 20U;
+}
+
+#if PDM_CFG_LOUDNESS_ENABLE
+// Hundredths of a LU or dB, for the log records
+static int32_t pdm_loudness_centi(float value)
+{
+    return (int32_t) ((value * 100.0f) + ((value < 0.0f) ? -0.5f : 0.5f));
+}
+
+// Meter a converted chunk; the readings go out at every report interval
+static void pdm_loudness_meter(int32_t const *samples, uint32_t count)
+{
+    if (!g_loudness_ready) {
+        return;
+    }
+
+    if ((0 == pdm_loudness_process(&g_pdm_loudness, samples, count)) ||
+        (0 != (g_pdm_loudness.steps % LOUDNESS_REPORT_STEPS))) {
+        return;
+    }
+
+    pdm_loudness_result_t result;
+    pdm_loudness_get(&g_pdm_loudness, &result);
+
+    uint32_t const args[5] =
+    {
+        result.steps * PDM_LOUDNESS_STEP_MS, (uint32_t) pdm_loudness_centi(result.momentary),
+        (uint32_t) pdm_loudness_centi(result.short_term), (uint32_t) pdm_loudness_centi(result.integrated),
+        (uint32_t) pdm_loudness_centi(result.true_peak)
+    };
+    pdm_log_write(PDM_LOG_LOUDNESS, args, 5U);
+}
+
+// Readings of the whole recording
+static void pdm_loudness_summary(void)
+{
+    pdm_loudness_result_t result;
+    pdm_loudness_get(&g_pdm_loudness, &result);
+
+    uint32_t const args[6] =
+    {
+        (uint32_t) pdm_loudness_centi(result.integrated), (uint32_t) pdm_loudness_centi(result.momentary_max),
+        (uint32_t) pdm_loudness_centi(result.short_term_max), (uint32_t) pdm_loudness_centi(result.true_peak),
+        (uint32_t) pdm_loudness_centi(result.sample_peak), result.gated_blocks
+    };
+    pdm_log_write(PDM_LOG_LOUDNESS_SUMMARY, args, 6U);
+}
+#endif
+
+#if PDM_CFG_SLM_ENABLE
+// Tenths of a dB, for the log records
+static int32_t pdm_slm_deci(float value)
+{
+    return (int32_t) ((value * 10.0f) + ((value < 0.0f) ? -0.5f : 0.5f));
+}
+
+// Levels of the last completed interval, unless they went out already: the Leq record, then the bands
+static void pdm_slm_report(void)
+{
+    pdm_slm_result_t result;
+    pdm_slm_get(&g_pdm_slm, &result);
+    if ((0U == result.interval) || (result.interval == g_slm_reported)) {
+        return;
+    }
+
+    g_slm_reported = result.interval;
+
+    uint32_t const args[5] =
+    {
+        result.interval, result.duration_ms, (uint32_t) pdm_slm_deci(result.laeq),
+        (uint32_t) pdm_slm_deci(result.lceq), (uint32_t) pdm_slm_deci(result.lzeq)
+    };
+    pdm_log_write(PDM_LOG_SLM, args, 5U);
+
+    for (uint32_t first = 0; first < result.band_count; first += SLM_BANDS_PER_RECORD)
+    {
+        uint32_t n = ((result.band_count - first) < SLM_BANDS_PER_RECORD) ? (result.band_count - first)
+                                                                          : SLM_BANDS_PER_RECORD;
+        uint32_t band_args[PDM_LOG_MAX_ARGS];
+
+        band_args[0] = result.low_band + (first * result.band_step);
+        band_args[1] = result.band_step;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            band_args[2U + i] = (uint32_t) pdm_slm_deci(result.band[first + i]);
+        }
+        pdm_log_write(PDM_LOG_SLM_BANDS, band_args, 2U + n);
+    }
+}
+
+// Meter a converted chunk; an interval goes out as soon as it completes
+static void pdm_slm_meter(int32_t const *samples, uint32_t count)
+{
+    if (g_slm_ready && (0U != pdm_slm_process(&g_pdm_slm, samples, count))) {
+        pdm_slm_report();
+    }
+}
+#endif
+
+#if PDM_CFG_LOUDNESS_ENABLE || PDM_CFG_SLM_ENABLE
+// Meter collected samples: each chunk is converted once for all meters
+static void pdm_meter(uint32_t const *buffer, uint32_t sample_count)
+{
+    bool active = false;
+ #if PDM_CFG_LOUDNESS_ENABLE
+    active = active || g_loudness_ready;
+ #endif
+ #if PDM_CFG_SLM_ENABLE
+    active = active || g_slm_ready;
+ #endif
+    if (!active) {
+        return;
+    }
+
+    for (uint32_t done = 0; done < sample_count; done += COLLECT_CHUNK_SAMPLES)
+    {
+        uint32_t n = ((sample_count - done) < COLLECT_CHUNK_SAMPLES) ? (sample_count - done) : COLLECT_CHUNK_SAMPLES;
+        int32_t samples[COLLECT_CHUNK_SAMPLES];
+
+        g_pdm_kernel->convert(&buffer[done], samples, n);
+ #if PDM_CFG_LOUDNESS_ENABLE
+        pdm_loudness_meter(samples, n);
+ #endif
+ #if PDM_CFG_SLM_ENABLE
+        pdm_slm_meter(samples, n);
+ #endif
+    }
+}
+#endif
+
+// Collect samples [first, first + count) of a block
+static void pdm_collect_part(uint32_t *p_block, pdm_integrity_block_t const *p_info, uint32_t first, uint32_t count)
+{
+#if PDM_CFG_LOUDNESS_ENABLE || PDM_CFG_SLM_ENABLE
+    pdm_meter(&p_block[first], count);
+#endif
+
+#if PDM_CFG_SEGMENT_ENABLE
+    // The block completed with its last sample; date the first collected one from there
+    uint64_t before = ((uint64_t) (PDM_CALLBACK_NUM_SAMPLES - 1U - first) * SystemCoreClock) / pdm_sample_rate_hz();
+    collect_segment_audio_data(&p_block[first], p_info->sample_index + first, p_info->timestamp - before, count);
+#else
+    FSP_PARAMETER_NOT_USED(p_info);
+    collect_all_audio_data(&p_block[first], count);
+#endif
+}
+
+// Collect a block, leaving out the part that falls in the settling window of a filter swap
+static void pdm_collect_block(uint32_t *p_block, pdm_integrity_block_t const *p_info)
+{
+    uint64_t first_index = p_info->sample_index;
+    uint64_t end = first_index + PDM_CALLBACK_NUM_SAMPLES;
+    uint64_t skip_from = (g_settling_from > first_index) ? g_settling_from : first_index;
+    uint64_t skip_until = (g_settling_until < end) ? g_settling_until : end;
+
+    if (skip_from >= skip_until) {
+        pdm_collect_part(p_block, p_info, 0, PDM_CALLBACK_NUM_SAMPLES);
+        return;
+    }
+
+    uint32_t head = (uint32_t) (skip_from - first_index);
+    uint32_t skipped = (uint32_t) (skip_until - skip_from);
+
+    pdm_collect_part(p_block, p_info, 0, head);
+    pdm_record_gap(skipped);
+    pdm_collect_part(p_block, p_info, head + skipped, PDM_CALLBACK_NUM_SAMPLES - head - skipped);
+}
+
+// Pick up a swap done in the data callback: log it and arm its settling window
+static void pdm_filter_swap_check(void)
+{
+    pdm_filter_swap_t swap;
+    pdm_filter_swap_get(&g_pdm_filter, &swap);
+
+    if (swap.sequence == g_filter_swaps_seen) {
+        return;
+    }
+
+    g_filter_swaps_seen = swap.sequence;
+    g_settling_from = swap.first_sample;
+    g_settling_until = swap.first_valid;
+
+    uint32_t const args[6] =
+    {
+        swap.sequence, (uint32_t) swap.first_sample, (uint32_t) swap.first_valid, swap.settling, swap.sincdec,
+        swap.cycles
+    };
+    pdm_log_write(PDM_LOG_FILTER_SWAP, args, 6U);
+
+#if PDM_CFG_SEGMENT_ENABLE
+    pdm_segment_rate_set(&g_pdm_segment, pdm_sample_rate_hz());
+#endif
+
+#if PDM_CFG_LOUDNESS_ENABLE
+    (void) pdm_loudness_rate_set(&g_pdm_loudness, pdm_sample_rate_hz());
+#endif
+
+#if PDM_CFG_SLM_ENABLE
+    // What was metered at the old rate goes out as a short interval of its own
+    if (g_slm_ready) {
+        fsp_err_t slm_err = pdm_slm_rate_set(&g_pdm_slm, pdm_sample_rate_hz());
+        if (FSP_SUCCESS == slm_err) {
+            pdm_slm_report();
+        } else {
+            g_slm_ready = false;
+            PDM_LOG1(PDM_LOG_SLM_FAILED, slm_err);
+        }
+    }
+#endif
+}
+
+// Microphone startup time still to run, measured from the PDM clock start in whole (rounded down) ticks
+static uint32_t pdm_mic_remaining_us(void)
+{
+    if (!g_mic_ready) {
+        uint32_t elapsed_us = (uint32_t) (((uint64_t) (pdm_sched_ticks() - g_clock_start_tick) * 1000000U) /
+                                          PDM_CFG_SCHED_TICK_HZ);
+        if (elapsed_us < PDM_CFG_MIC_STARTUP_TIME_US) {
+            return PDM_CFG_MIC_STARTUP_TIME_US - elapsed_us;
+        }
+
+        g_mic_ready = true;
+    }
+
+    return 0;
+}
+
+// Report when the first valid sample was captured and when its block reached the foreground
+static void pdm_first_valid_check(pdm_integrity_block_t const *p_info)
+{
+    uint64_t end = p_info->sample_index + PDM_CALLBACK_NUM_SAMPLES;
+    if (g_first_valid_seen || (end <= g_first_valid_index)) {
+        return;
+    }
+
+    g_first_valid_seen = true;
+
+    // The block completed with its last sample; step back to the first valid one
+    uint64_t cps = pdm_port_cycles_per_second();
+    uint32_t delivered = p_info->cycles - g_start_request_cycles;
+    uint32_t after = (uint32_t) (((end - g_first_valid_index - 1U) * cps) / pdm_sample_rate_hz());
+    uint32_t captured = (after < delivered) ? (delivered - after) : 0U;
+
+    g_first_valid_us = (uint32_t) (((uint64_t) captured * 1000000U) / cps);
+    PDM_LOG3(PDM_LOG_FIRST_VALID, (uint32_t) g_first_valid_index, g_first_valid_us,
+             (uint32_t) (((uint64_t) delivered * 1000000U) / cps));
+}
+
+#if PDM_CFG_TRIGGER_ENABLE
+// Report an accepted trigger and the record it fixes
+static void pdm_trigger_log(void)
+{
+    uint32_t const args[4] =
+    {
+        g_pdm_trigger.source, (uint32_t) g_pdm_trigger.trigger, (uint32_t) (g_pdm_trigger.trigger - g_pdm_trigger.first),
+        (uint32_t) (g_pdm_trigger.end - g_pdm_trigger.trigger)
+    };
+    pdm_log_write(PDM_LOG_TRIGGER, args, 4U);
+}
+#endif
+
+#if PDM_CFG_SEGMENT_ENABLE
+// Send the segments queued by FETCH_SEGMENTS as far as the host drains the log channel; the rest goes on the next
+// wake-up. A segment evicted while it is being sent is cut short and reported. Returns the records written.
+static uint32_t pdm_fetch_step(void)
+{
+    pdm_fetch_t *p_fetch = &g_segment_fetch;
+    uint32_t records = 0;
+
+    for (; p_fetch->active && (records < FETCH_RECORDS_PER_STEP); records++)
+    {
+        if (!p_fetch->started)
+        {
+            if ((FSP_SUCCESS != pdm_segment_find(&g_pdm_segment, p_fetch->next, &p_fetch->entry)) ||
+                ((int32_t) (p_fetch->last - p_fetch->entry.id) < 0))
+            {
+                p_fetch->active = false;
+                break;
+            }
+
+            if (!pdm_log_fits(3U)) {
+                break;
+            }
+
+            uint32_t const header[3] = {p_fetch->entry.id, (uint32_t) p_fetch->entry.start, p_fetch->entry.length};
+            (void) pdm_log_write(PDM_LOG_SEGMENT_DATA, header, 3U);
+            p_fetch->started = true;
+            p_fetch->sent = 0;
+            continue;
+        }
+
+        uint32_t const *p_span;
+        uint32_t n = pdm_segment_read(&g_pdm_segment, &p_fetch->entry, p_fetch->sent, &p_span);
+        n = (n < DUMP_RECORD_SAMPLES) ? n : DUMP_RECORD_SAMPLES;
+
+        if (!pdm_log_fits((0 != n) ? n : 2U)) {
+            break;
+        }
+
+        if (0 != n) {
+            (void) pdm_log_write((0 == p_fetch->sent) ? PDM_LOG_DUMP_DATA_FIRST : PDM_LOG_DUMP_DATA, p_span, n);
+            p_fetch->sent += n;
+            continue;
+        }
+
+        if (p_fetch->sent == p_fetch->entry.length) {
+            PDM_LOG1(PDM_LOG_SEGMENT_DATA_END, p_fetch->entry.id);
+        } else {
+            PDM_LOG2(PDM_LOG_SEGMENT_EVICTED, p_fetch->entry.id, p_fetch->sent);
+        }
+
+        p_fetch->started = false;
+        p_fetch->next = p_fetch->entry.id + 1U;
+    }
+
+    return records;
+}
+#endif
+
+// Publish the integrity telemetry record
+static void pdm_print_integrity(void)
+{
+    pdm_integrity_telemetry_t tm;
+    pdm_integrity_telemetry_get(pdm_session_integrity(&g_pdm0_session), &tm);
+
+    SEGGER_RTT_printf(0, "TELEMETRY v%u blocks=%lu dropped=%lu samples=%lu lost=%lu events=%lu "
+                      "short=%lu ovl=%lu ovu=%lu overwrite=%lu\n",
+                      tm.version, tm.blocks, tm.blocks_dropped, (uint32_t) tm.samples_delivered,
+                      (uint32_t) tm.samples_lost, tm.events, tm.short_circuit, tm.overvoltage_lower,
+                      tm.overvoltage_upper, tm.buffer_overwrite);
+
+    for (uint32_t age = 0; age < PDM_INTEGRITY_EVENTS; age++)
+    {
+        pdm_integrity_event_t event;
+        if (FSP_SUCCESS != pdm_integrity_event_get(pdm_session_integrity(&g_pdm0_session), age, &event))
+        {
+            break;
+        }
+
+        SEGGER_RTT_printf(0, "EVENT cycles=%lu errors=0x%lX block=%lu lost=%lu\n",
+                          event.cycles, event.errors, event.sequence, event.lost_samples);
+    }
+}
+
+// Session block hook: one completed block, in capture order
+static void pdm_block_process(pdm_session_t * p_session, uint32_t * p_block, pdm_integrity_block_t const * p_info,
+                              void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_context);
+
+    // Dropped blocks and samples lost in hardware both show up as a jump in the stream index
+    pdm_integrity_block_t info = *p_info;
+    if (info.sample_index != g_next_sample_index)
+    {
+        pdm_record_gap((uint32_t) (info.sample_index - g_next_sample_index));
+    }
+
+    g_next_sample_index = info.sample_index + PDM_CALLBACK_NUM_SAMPLES;
+
+    // Trigger mode keeps the stamps of the blocks still in the ring, in a ring of its own
+    if ((0 != PDM_CFG_TRIGGER_ENABLE) || (g_recorded_stamp_count < MAX_RECORDED_STAMPS))
+    {
+        pdm_stamp_t *p_stamp = &g_recorded_stamps[g_recorded_stamp_count % MAX_RECORDED_STAMPS];
+        p_stamp->sequence = info.sequence;
+        p_stamp->sample_index = (uint32_t) info.sample_index;
+        p_stamp->timestamp = info.timestamp;
+        g_recorded_stamp_count++;
+    }
+
+    pdm_filter_swap_check();
+    pdm_first_valid_check(&info);
+
+    pdm_collect_block(p_block, &info);
+
+    if (p_session->processed % 100 == 0)
+    {
+        PDM_LOG0(PDM_LOG_PROGRESS);
+    }
+}
+
+// Foreground handler of a completed block. The session hands over every completed block in order, so a work item
+// lost to a full queue only delays its block to the next one.
+static void pdm_block_work(pdm_work_item_t const * p_item, void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_item);
+    FSP_PARAMETER_NOT_USED(p_context);
+
+    uint32_t start = pdm_port_cycles();
+
+    (void) pdm_session_process(&g_pdm0_session);
+
+    pdm_sched_work_account(pdm_port_cycles() - start);
+}
+
+// Foreground handler of error and sound detection events; the session has counted them already
+static void pdm_event_work(pdm_work_item_t const * p_item, void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_context);
+
+    if (PDM_APP_WORK_SOUND == p_item->type)
+    {
+#if PDM_CFG_TRIGGER_ENABLE
+        // arg: low bits of the stream index at the interrupt, behind (or, before its block is collected, ahead of)
+        // the next collected sample. Detections in the startup window are transients.
+        int32_t behind = (int32_t) ((uint32_t) g_next_sample_index - p_item->arg);
+        int64_t position = (int64_t) pdm_trigger_position(&g_pdm_trigger) - behind;
+        if (((int64_t) g_next_sample_index - behind) >= (int64_t) g_first_valid_index)
+        {
+            if (FSP_SUCCESS == pdm_trigger_fire(&g_pdm_trigger, (position > 0) ? (uint64_t) position : 0U,
+                                                PDM_TRIGGER_SOURCE_SOUND_DETECTION))
+            {
+                pdm_trigger_log();
+            }
+        }
+#elif PDM_CFG_SEGMENT_ENABLE
+        // arg: low bits of the stream index at the interrupt; detections in the startup window are transients
+        int32_t behind = (int32_t) ((uint32_t) g_next_sample_index - p_item->arg);
+        int64_t index = (int64_t) g_next_sample_index - behind;
+        if (index >= (int64_t) g_first_valid_index)
+        {
+            pdm_segment_mark(&g_pdm_segment, (uint64_t) index);
+        }
+#endif
+    }
+}
+
+// CPU load of the recording window: idle share and headroom of the slowest block against its real-time budget
+static void pdm_print_load(pdm_sched_stats_t const * p_load)
+{
+    uint64_t block_budget = ((uint64_t) SystemCoreClock * PDM_CALLBACK_NUM_SAMPLES) / PDM_CFG_SAMPLE_RATE_HZ;
+    uint32_t headroom_permille = 0;
+
+    if (p_load->work_max_cycles < block_budget)
+    {
+        headroom_permille = (uint32_t) (1000U - ((uint64_t) p_load->work_max_cycles * 1000U) / block_budget);
+    }
+
+    SEGGER_RTT_printf(0, "CPU idle: %lu.%lu %% (%lu wake-ups)\n",
+                      p_load->idle_permille / 10, p_load->idle_permille % 10, p_load->wakeups);
+    SEGGER_RTT_printf(0, "Block work: max %lu cycles, mean %lu cycles, budget %lu cycles\n",
+                      p_load->work_max_cycles,
+                      (p_load->work_count > 0) ? (uint32_t) (p_load->work_total_cycles / p_load->work_count) : 0U,
+                      (uint32_t) block_budget);
+    SEGGER_RTT_printf(0, "Processing headroom: %lu.%lu %%\n", headroom_permille / 10, headroom_permille % 10);
+}
+
+// Interrupt-side cost: measured callback time and the queue benchmark
+static void pdm_print_isr_cost(void)
+{
+    pdm_work_bench_t bench;
+    pdm_work_benchmark(&bench, 1024);
+
+    SEGGER_RTT_printf(0, "Placement: callback 0x%08lX, ring 0x%08lX, D-cache %s\n", (uint32_t) (uintptr_t) pdm0_callback,
+                      (uint32_t) (uintptr_t) g_pdm0_buffer, (0U != (SCB->CCR & SCB_CCR_DC_Msk)) ? "on" : "off");
+    SEGGER_RTT_printf(0, "Callback: max %lu cycles, mean %lu cycles\n", g_callback_max_cycles,
+                      (g_callback_count > 0) ? (uint32_t) (g_callback_total_cycles / g_callback_count) : 0U);
+    SEGGER_RTT_printf(0, "Work post: min %lu, max %lu, mean %lu cycles; dispatch %lu cycles/item\n",
+                      bench.post_min, bench.post_max, bench.post_mean, bench.dispatch_mean);
+
+    for (uint32_t lane = 0; lane < PDM_WORK_LANES; lane++)
+    {
+        pdm_work_stats_t stats;
+        pdm_work_stats_get(&g_pdm_work, lane, &stats);
+        SEGGER_RTT_printf(0, "Work lane %lu: posted %lu, dropped %lu, max backlog %lu\n",
+                          lane, stats.posted, stats.dropped, stats.high_water);
+    }
+}
+
+
+// Forget everything about the previous recording
+static void pdm_recording_reset(void)
+{
+    g_total_collected_samples = 0;
+    g_recorded_gap_count = 0;
+    g_recorded_stamp_count = 0;
+    g_next_sample_index = 0;
+    g_callback_max_cycles = 0;
+    g_callback_total_cycles = 0;
+    g_callback_count = 0;
+
+    // Swaps made while idle have settled long before the start; only later ones open a window
+    pdm_filter_swap_t swap;
+    pdm_filter_swap_get(&g_pdm_filter, &swap);
+    g_filter_swaps_seen = swap.sequence;
+    g_settling_from = 0;
+    g_settling_until = 0;
+    g_first_valid_index = 0;
+    g_first_valid_seen = false;
+    g_first_valid_us = 0;
+}
+
+// Program the sound detection window of the next recording
+static void pdm_sound_detection_apply(void)
+{
+    fsp_err_t err;
+
+    if (g_pdm_settings.sound_detection) {
+        pdm_sound_detection_setting_t setting =
+        {
+            .sound_detection_lower_limit = g_pdm_settings.sound_lower,
+            .sound_detection_upper_limit = g_pdm_settings.sound_upper,
+        };
+        err = R_PDM_SoundDetectionEnable(&g_pdm0_ctrl, setting);
+    } else {
+        err = R_PDM_SoundDetectionDisable(&g_pdm0_ctrl);
+    }
 
-    /* PDM initialization */
-    fsp_err_t err = R_PDM_Open(&g_pdm0_ctrl, &g_pdm0_cfg);
     if (FSP_SUCCESS != err) {
-        SEGGER_RTT_printf(0, "PDM Open FAILED: 0x%X\n", err);
+        PDM_LOG1(PDM_LOG_SDET_FAILED, err);
+    }
+}
+
+// Milliseconds into the current recording, or the length of the last one
+static uint32_t pdm_recording_elapsed_ms(void)
+{
+    uint32_t ticks = (PDM_CMD_STATE_RECORDING == g_pdm_state) ? (pdm_sched_ticks() - g_recording_start_tick)
+                                                              : g_recording_ticks;
+
+    return (uint32_t) (((uint64_t) ticks * 1000U) / PDM_CFG_SCHED_TICK_HZ);
+}
+
+#if PDM_CFG_CMD_ENABLE
+// Remote control (tools/pdm_ctl). Runs in the foreground from pdm_cmd_poll(); settings apply to the next recording.
+static void pdm_command(pdm_cmd_frame_t const * p_request, pdm_cmd_frame_t * p_ack, void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_context);
+
+    uint8_t const * p_args = p_request->payload;
+    bool idle = (PDM_CMD_STATE_IDLE == g_pdm_state);
+    pdm_cmd_status_t status = PDM_CMD_STATUS_OK;
+
+    switch (p_request->id)
+    {
+        case PDM_CMD_PING:
+        {
+            pdm_cmd_u32_put(p_ack, PDM_CMD_VERSION);
+            pdm_cmd_u32_put(p_ack, pdm_sample_rate_hz());
+            pdm_cmd_u32_put(p_ack, MAX_TOTAL_SAMPLES);
+            break;
+        }
+
+        case PDM_CMD_START:
+        {
+            status = (idle && !g_start_requested) ? PDM_CMD_STATUS_OK : PDM_CMD_STATUS_BUSY;
+            g_start_requested = g_start_requested || (PDM_CMD_STATUS_OK == status);
+            break;
+        }
+
+        case PDM_CMD_STOP:
+        {
+            status = (PDM_CMD_STATE_RECORDING == g_pdm_state) ? PDM_CMD_STATUS_OK : PDM_CMD_STATUS_BUSY;
+            g_stop_requested = (PDM_CMD_STATUS_OK == status);
+            break;
+        }
+
+        case PDM_CMD_SET_DURATION:
+        {
+            uint32_t duration_ms = pdm_cmd_u32_get(&p_args[0]);
+
+            if (!idle) {
+                status = PDM_CMD_STATUS_BUSY;
+            } else if ((0U == duration_ms) || (duration_ms > PDM_CMD_DURATION_MAX_MS)) {
+                status = PDM_CMD_STATUS_RANGE;
+            } else {
+                g_pdm_settings.duration_ms = duration_ms;
+            }
+            break;
+        }
+
+        case PDM_CMD_SET_SOUND_DETECTION:
+        {
+            uint32_t enable = pdm_cmd_u32_get(&p_args[0]);
+
+            if (!idle) {
+                status = PDM_CMD_STATUS_BUSY;
+            } else if (enable > 1U) {
+                status = PDM_CMD_STATUS_RANGE;
+            } else {
+                g_pdm_settings.sound_detection = enable;
+                g_pdm_settings.sound_upper = pdm_cmd_u32_get(&p_args[4]);
+                g_pdm_settings.sound_lower = pdm_cmd_u32_get(&p_args[8]);
+            }
+            break;
+        }
+
+        case PDM_CMD_SET_GAIN:
+        {
+            uint32_t gain_q8 = pdm_cmd_u32_get(&p_args[0]);
+
+            if (!idle) {
+                status = PDM_CMD_STATUS_BUSY;
+            } else if ((0U == gain_q8) || (gain_q8 > PDM_CMD_GAIN_MAX)) {
+                status = PDM_CMD_STATUS_RANGE;
+            } else {
+                g_pdm_settings.gain_q8 = gain_q8;
+            }
+            break;
+        }
+
+        case PDM_CMD_SET_FORMAT:
+        {
+            uint32_t format = pdm_cmd_u32_get(&p_args[0]);
+
+            if (!idle) {
+                status = PDM_CMD_STATUS_BUSY;
+            } else if (format >= PDM_CMD_FORMAT_COUNT) {
+                status = PDM_CMD_STATUS_RANGE;
+            } else {
+                g_pdm_settings.format = format;
+            }
+            break;
+        }
+
+        case PDM_CMD_GET_STATS:
+        {
+            pdm_integrity_telemetry_t tm;
+            pdm_integrity_telemetry_get(pdm_session_integrity(&g_pdm0_session), &tm);
+            pdm_session_stats_t stats;
+            pdm_session_stats_get(&g_pdm0_session, &stats);
+
+            pdm_cmd_u32_put(p_ack, (uint32_t) g_pdm_state);
+            pdm_cmd_u32_put(p_ack, g_recordings);
+            pdm_cmd_u32_put(p_ack, pdm_recording_elapsed_ms());
+            pdm_cmd_u32_put(p_ack, stats.callbacks);
+            pdm_cmd_u32_put(p_ack, stats.processed);
+            pdm_cmd_u32_put(p_ack, stats.errors);
+            pdm_cmd_u32_put(p_ack, stats.dropped);
+            pdm_cmd_u32_put(p_ack, stats.sound_detections);
+            pdm_cmd_u32_put(p_ack, g_total_collected_samples);
+            pdm_cmd_u32_put(p_ack, (uint32_t) tm.samples_lost);
+            pdm_cmd_u32_put(p_ack, g_first_valid_us);
+            break;
+        }
+
+        case PDM_CMD_GET_CONFIG:
+        {
+            pdm_cmd_u32_put(p_ack, g_pdm_settings.duration_ms);
+            pdm_cmd_u32_put(p_ack, g_pdm_settings.sound_detection);
+            pdm_cmd_u32_put(p_ack, g_pdm_settings.sound_upper);
+            pdm_cmd_u32_put(p_ack, g_pdm_settings.sound_lower);
+            pdm_cmd_u32_put(p_ack, g_pdm_settings.gain_q8);
+            pdm_cmd_u32_put(p_ack, g_pdm_settings.format);
+            pdm_cmd_u32_put(p_ack, g_pdm_filter.active.sincdec);
+            pdm_cmd_u32_put(p_ack, g_pdm_filter.active.sincrng);
+            pdm_cmd_u32_put(p_ack, pdm_sample_rate_hz());
+            break;
+        }
+
+        case PDM_CMD_SET_SINC:
+        {
+            // Allowed while recording: applied at the next block boundary
+            uint32_t sincdec = pdm_cmd_u32_get(&p_args[0]);
+            uint32_t sincrng = pdm_cmd_u32_get(&p_args[4]);
+            if ((0U == sincdec) || (sincdec > UINT8_MAX) || (sincrng > UINT8_MAX)) {
+                status = PDM_CMD_STATUS_RANGE;
+            } else {
+                pdm_extended_cfg_t filters = g_pdm_filter.active;
+                filters.sincdec = (uint8_t) sincdec;
+                filters.sincrng = (uint8_t) sincrng;
+
+                fsp_err_t err = pdm_filter_stage(&g_pdm_filter, &filters);
+                if (FSP_ERR_IN_USE == err) {
+                    status = PDM_CMD_STATUS_BUSY;
+                } else if (FSP_SUCCESS != err) {
+                    status = PDM_CMD_STATUS_FAILED;
+                    p_ack->length = 1U;
+                    pdm_cmd_u32_put(p_ack, (uint32_t) err);
+                }
+            }
+            break;
+        }
+
+#if PDM_CFG_SEGMENT_ENABLE
+        case PDM_CMD_GET_SEGMENT:
+        {
+            pdm_segment_entry_t entry;
+
+            if (FSP_SUCCESS != pdm_segment_find(&g_pdm_segment, pdm_cmd_u32_get(&p_args[0]), &entry)) {
+                status = PDM_CMD_STATUS_RANGE;
+            } else {
+                pdm_cmd_u32_put(p_ack, entry.id);
+                pdm_cmd_u32_put(p_ack, entry.source);
+                pdm_cmd_u32_put(p_ack, (uint32_t) entry.start);
+                pdm_cmd_u32_put(p_ack, (uint32_t) (entry.start >> 32));
+                pdm_cmd_u32_put(p_ack, entry.length);
+                pdm_cmd_u32_put(p_ack, entry.peak);
+                pdm_cmd_u32_put(p_ack, entry.rms);
+                pdm_cmd_u32_put(p_ack, (uint32_t) entry.timestamp);
+                pdm_cmd_u32_put(p_ack, (uint32_t) (entry.timestamp >> 32));
+            }
+            break;
+        }
+
+        case PDM_CMD_FETCH_SEGMENTS:
+        {
+            // Sent from the event loops by pdm_fetch_step(), also while recording
+            if (g_segment_fetch.active || (PDM_CMD_STATE_DUMPING == g_pdm_state)) {
+                status = PDM_CMD_STATUS_BUSY;
+            } else {
+                g_segment_fetch.next = pdm_cmd_u32_get(&p_args[0]);
+                g_segment_fetch.last = pdm_cmd_u32_get(&p_args[4]);
+                g_segment_fetch.started = false;
+                g_segment_fetch.active = true;
+            }
+            break;
+        }
+#endif
+
+        default:
+        {
+            status = PDM_CMD_STATUS_UNKNOWN;
+            break;
+        }
+    }
+
+    // Replies only follow an OK status, FAILED carries the driver error
+    if ((PDM_CMD_STATUS_OK != status) && (PDM_CMD_STATUS_FAILED != status)) {
+        p_ack->length = 1U;
+    }
+
+    p_ack->payload[0] = (uint8_t) status;
+    PDM_LOG3(PDM_LOG_CMD, p_request->id, p_request->sequence, status);
+}
+#endif
+
+// One recording with the current settings: capture until the duration expires or STOP arrives, report, dump
+static void pdm_record(void)
+{
+    g_start_request_cycles = (uint32_t) pdm_sched_timestamp();
+    pdm_recording_reset();
+    pdm_sound_detection_apply();
+    g_recordings++;
+    g_stop_requested = false;
+
+#if PDM_CFG_TRIGGER_ENABLE
+    // Pre- and post-roll in samples of the current rate; the ring is the collection buffer
+    uint32_t trigger_rate = pdm_sample_rate_hz();
+    pdm_trigger_cfg_t trigger_cfg =
+    {
+        .p_buffer = g_all_audio_data,
+        .capacity = MAX_TOTAL_SAMPLES,
+        .pre_samples = (uint32_t) (((uint64_t) PDM_CFG_TRIGGER_PRE_MS * trigger_rate) / 1000U),
+        .post_samples = (uint32_t) (((uint64_t) PDM_CFG_TRIGGER_POST_MS * trigger_rate) / 1000U),
+        .level = PDM_CFG_TRIGGER_LEVEL,
+    };
+
+    fsp_err_t trigger_err = pdm_trigger_open(&g_pdm_trigger, &trigger_cfg);
+    if (FSP_SUCCESS != trigger_err) {
+        PDM_LOG1(PDM_LOG_TRIGGER_FAILED, trigger_err);
         return;
     }
 
-    SEGGER_RTT_printf(0, "PDM Open: SUCCESS\n");
+    PDM_LOG3(PDM_LOG_TRIGGER_ARMED, trigger_cfg.pre_samples, trigger_cfg.post_samples, PDM_CFG_TRIGGER_LEVEL);
+#endif
 
-    /* Filter stabilization wait */
-    SEGGER_RTT_printf(0, "Filter stabilizing...\n");
-    R_BSP_SoftwareDelay(PDM0_FILTER_SETTLING_TIME_US + PDM_MIC_STARTUP_TIME_US,
-                        BSP_DELAY_UNITS_MICROSECONDS);
+#if PDM_CFG_SEGMENT_ENABLE
+    // A new store replaces the segments of the previous recording, and a fetch still sending them
+    uint32_t segment_rate = pdm_sample_rate_hz();
+    uint32_t segment_pre = (uint32_t) (((uint64_t) PDM_CFG_SEGMENT_PRE_MS * segment_rate) / 1000U);
+    pdm_segment_cfg_t segment_cfg =
+    {
+        .p_pool = g_all_audio_data,
+        .capacity = MAX_TOTAL_SAMPLES,
+        .p_index = g_segment_index,
+        .entries = PDM_CFG_SEGMENT_ENTRIES,
+        .p_preroll = g_segment_preroll,
+        .pre_samples = (segment_pre < MAX_SEGMENT_PRE_SAMPLES) ? segment_pre : MAX_SEGMENT_PRE_SAMPLES,
+        .hold_samples = (uint32_t) (((uint64_t) PDM_CFG_SEGMENT_HOLD_MS * segment_rate) / 1000U),
+        .max_samples = (uint32_t) (((uint64_t) PDM_CFG_SEGMENT_MAX_MS * segment_rate) / 1000U),
+        .level = PDM_CFG_SEGMENT_LEVEL,
+        .rate_hz = segment_rate,
+        .clock_hz = SystemCoreClock,
+    };
+
+    g_segment_fetch.active = false;
+    fsp_err_t segment_err = pdm_segment_open(&g_pdm_segment, &segment_cfg);
+    if (FSP_SUCCESS != segment_err) {
+        PDM_LOG1(PDM_LOG_SEGMENT_FAILED, segment_err);
+        return;
+    }
+
+    uint32_t const segment_args[6] =
+    {
+        segment_cfg.capacity, segment_cfg.entries, segment_cfg.pre_samples, segment_cfg.hold_samples,
+        segment_cfg.max_samples, (uint32_t) segment_cfg.level
+    };
+    pdm_log_write(PDM_LOG_SEGMENT_ARMED, segment_args, 6U);
+#endif
+
+#if PDM_CFG_LOUDNESS_ENABLE
+    // Metering is an extra: the recording goes ahead without it
+    pdm_loudness_cfg_t const loudness_cfg =
+    {
+        .rate_hz = pdm_sample_rate_hz(),
+        .scale = 1.0f / (float) (PDM_DSP_20BIT_MAX + 1),
+    };
+    fsp_err_t loudness_err = pdm_loudness_open(&g_pdm_loudness, &loudness_cfg);
+    g_loudness_ready = (FSP_SUCCESS == loudness_err);
+    if (!g_loudness_ready) {
+        PDM_LOG1(PDM_LOG_LOUDNESS_FAILED, loudness_err);
+    }
+#endif
 
+#if PDM_CFG_SLM_ENABLE
+    // Metering is an extra: the recording goes ahead without it
+    pdm_slm_cfg_t const slm_cfg =
+    {
+        .rate_hz = pdm_sample_rate_hz(),
+        .scale = 1.0f / (float) (PDM_DSP_20BIT_MAX + 1),
+        .full_scale_db = PDM_CFG_SLM_FULL_SCALE_DB,
+        .bands = (pdm_slm_bands_t) PDM_CFG_SLM_BANDS,
+        .low_band = PDM_CFG_SLM_LOW_BAND,
+        .interval_ms = PDM_CFG_SLM_INTERVAL_MS,
+    };
+    fsp_err_t slm_err = pdm_slm_open(&g_pdm_slm, &slm_cfg);
+    g_slm_ready = (FSP_SUCCESS == slm_err);
+    g_slm_reported = 0;
+    if (!g_slm_ready) {
+        PDM_LOG1(PDM_LOG_SLM_FAILED, slm_err);
+    }
+#endif
 
-    R_BSP_SoftwareDelay(100, BSP_DELAY_UNITS_MILLISECONDS);
+#if PDM_CFG_FAST_START_ENABLE
+    // Start at once; whatever the microphone and the filters produce before they are ready is left out as a gap
+    uint32_t mic_us = pdm_mic_remaining_us();
+    uint32_t rate = pdm_sample_rate_hz();
+    uint64_t window = (((uint64_t) (mic_us + PDM_FILTER_SETTLING_TIME_US) * rate) + 999999U) / 1000000U;
+    uint32_t filter_samples = pdm_filter_settling_samples(&g_pdm_filter.active);
+    if (window < filter_samples) {
+        window = filter_samples;    // Swapped filters can need more than the Configurator's figure
+    }
 
+    g_settling_until = window;
+    g_first_valid_index = window;
+    PDM_LOG3(PDM_LOG_FAST_START, (uint32_t) window, mic_us, PDM_FILTER_SETTLING_TIME_US);
+#else
+    /* Filter stabilization wait */
+    PDM_LOG0(PDM_LOG_SETTLING);
+    pdm_sched_sleep_ms((PDM0_FILTER_SETTLING_TIME_US + PDM_CFG_MIC_STARTUP_TIME_US) / 1000U + 100U);
+#endif
 
     /* PDM start */
-    err = R_PDM_Start(&g_pdm0_ctrl, g_pdm0_buffer, sizeof(g_pdm0_buffer), PDM_CALLBACK_NUM_SAMPLES);
+    g_pdm_kernel = pdm_kernel_select(pdm_pcm_bits());
+    if (NULL == g_pdm_kernel) {
+        PDM_LOG1(PDM_LOG_START_FAILED, FSP_ERR_UNSUPPORTED);
+        return;
+    }
+
+    fsp_err_t err = pdm_session_start(&g_pdm0_session, pdm_sample_rate_hz());
 
     if (FSP_SUCCESS != err) {
-        SEGGER_RTT_printf(0, "PDM Start FAILED: 0x%X\n", err);
+        PDM_LOG1(PDM_LOG_START_FAILED, err);
         return;
     }
 
-    SEGGER_RTT_printf(0, "Recording started! (10 seconds)\n");
-    SEGGER_RTT_printf(0, "Progress.... ");
+    PDM_LOG1(PDM_LOG_RECORDING, g_pdm_settings.duration_ms);
+
+    // Event loop: sleep until a block completes, the recording timer expires or the host sends a command
+    pdm_sched_stats_reset();
+    PDM_PROF_RESET();
+    pdm_sched_timer_start(g_pdm_settings.duration_ms);
+    g_recording_start_tick = pdm_sched_ticks();
+    g_pdm_state = PDM_CMD_STATE_RECORDING;
+
+    bool recording = true;
+    while (recording)
+    {
+        uint32_t events = pdm_sched_wait();
+
+        if (events & PDM_SCHED_EVENT_WORK)
+        {
+            pdm_work_dispatch(&g_pdm_work);
+        }
+
+#if PDM_CFG_CMD_ENABLE
+        if (events & PDM_SCHED_EVENT_TICK)
+        {
+            pdm_cmd_poll();
+        }
+#endif
 
-    // EXACTLY 10 seconds wait
-    R_BSP_SoftwareDelay(10, BSP_DELAY_UNITS_SECONDS);
+#if PDM_CFG_SEGMENT_ENABLE
+        (void) pdm_fetch_step();
+#endif
 
-    SEGGER_RTT_printf(0, "\nRecording completed!\n");
+        if ((events & PDM_SCHED_EVENT_TIMER) || g_stop_requested)
+        {
+            recording = false;
+        }
+
+#if PDM_CFG_TRIGGER_ENABLE
+        // The event record is complete
+        if (PDM_TRIGGER_STATE_FROZEN == pdm_trigger_state(&g_pdm_trigger))
+        {
+            recording = false;
+        }
+#endif
+    }
+
+    g_recording_ticks = pdm_sched_ticks() - g_recording_start_tick;
+    g_pdm_state = PDM_CMD_STATE_DUMPING;
+
+    pdm_sched_stats_t load;
+    pdm_sched_stats_get(&load);
+
+    PDM_LOG0(PDM_LOG_RECORDED);
 
     /* PDM stop */
-    R_PDM_Stop(&g_pdm0_ctrl);
-    R_PDM_Close(&g_pdm0_ctrl);
+    (void) pdm_session_stop(&g_pdm0_session);
+
+    // Work queued after the last wake-up, and blocks whose work item was lost
+    pdm_work_dispatch(&g_pdm_work);
+    (void) pdm_session_process(&g_pdm0_session);
+
+#if PDM_CFG_DUAL_CORE_ENABLE
+    // The last spans may still be in the ring
+    if (!pdm_core1_flush(CORE1_FLUSH_TIMEOUT_MS))
+    {
+        pdm_ipc_stats_t ipc_stats;
+        pdm_ipc_stats_get(&g_pdm_ipc_ring, &ipc_stats);
+        PDM_LOG1(PDM_LOG_DUAL_CORE_STALLED, ipc_stats.produced - ipc_stats.consumed);
+    }
+#endif
+
+#if PDM_CFG_TRIGGER_ENABLE
+    // A post-roll cut short by the timeout or STOP is dumped as far as it got
+    pdm_trigger_stop(&g_pdm_trigger);
+#endif
+
+#if PDM_CFG_SEGMENT_ENABLE
+    // Activity still going on at the end is kept as it is
+    pdm_segment_close(&g_pdm_segment);
+#endif
+
+#if PDM_CFG_LOUDNESS_ENABLE
+    if (g_loudness_ready) {
+        pdm_loudness_summary();
+    }
+#endif
+
+#if PDM_CFG_SLM_ENABLE
+    // The interval still in progress goes out as a short one
+    if (g_slm_ready && (0U != pdm_slm_flush(&g_pdm_slm))) {
+        pdm_slm_report();
+    }
+#endif
 
     // Post-recording analysis
     SEGGER_RTT_printf(0, "\n=== POST-RECORDING ANALYSIS ===\n");
-    SEGGER_RTT_printf(0, "Total callbacks: %lu\n", g_data_callback_count);
-    SEGGER_RTT_printf(0, "Errors occurred: %lu\n", g_error_count);
+    pdm_session_stats_t stats;
+    pdm_session_stats_get(&g_pdm0_session, &stats);
+    SEGGER_RTT_printf(0, "Total callbacks: %lu\n", stats.callbacks);
+    SEGGER_RTT_printf(0, "Errors occurred: %lu\n", stats.errors);
+    SEGGER_RTT_printf(0, "Block overruns: %lu\n", stats.dropped);
+    SEGGER_RTT_printf(0, "Block slots: %lu, most in use %lu\n", (uint32_t) PDM_CFG_BLOCK_SLOTS, stats.slot_high_water);
+    pdm_print_integrity();
+    pdm_print_load(&load);
+    pdm_print_isr_cost();
+    PDM_PROF_EXPORT();
+
+#if PDM_CFG_DUAL_CORE_ENABLE
+    pdm_ipc_stats_t ipc_stats;
+    pdm_ipc_stats_get(&g_pdm_ipc_ring, &ipc_stats);
+    SEGGER_RTT_printf(0, "IPC blocks: produced %lu, consumed %lu, dropped %lu, doorbells %lu\n",
+                      ipc_stats.produced, ipc_stats.consumed, ipc_stats.dropped, ipc_stats.doorbells);
+#endif
 
 
     // Final data output for Python processing
-    SEGGER_RTT_printf(0, "\nStarting data output for Python processing...\n");
-    R_BSP_SoftwareDelay(1, BSP_DELAY_UNITS_SECONDS);
+    SEGGER_RTT_printf(0, "\nStarting data output for Python processing (binary log, RTT channel %u)...\n",
+                      PDM_CFG_LOG_RTT_CHANNEL);
+    pdm_sched_sleep_ms(1000);
     dump_all_collected_data();
-    
+
+    g_pdm_state = PDM_CMD_STATE_IDLE;
+}
+
+// Main function
+void r_pdm_basic_messaging_core0_example(void)
+{
+    SEGGER_RTT_Init();
+
+    // Status messages go out as binary records on PDM_CFG_LOG_RTT_CHANNEL, decode with tools/pdm_logdec
+    pdm_log_open();
+    PDM_LOG0(PDM_LOG_START);
+
+    /* PDM initialization: g_pdm0 is driven through its capture session */
+    pdm_session_cfg_t session_cfg =
+    {
+        .p_driver = &g_pdm_session_driver_r_pdm,
+        .p_driver_ctrl = &g_pdm0_ctrl,
+        .p_driver_cfg = &g_pdm0_cfg,
+        .p_ring = g_pdm0_buffer,
+        .ring_samples = PDM_BUFFER_NUM_SAMPLES,
+        .block_samples = PDM_CALLBACK_NUM_SAMPLES,
+        .p_slot_storage = g_pdm_slot_storage,
+        .p_slot_info = g_pdm_slot_info,
+        .slots = PDM_CFG_BLOCK_SLOTS,
+        .p_timestamp = pdm_sched_timestamp,
+        .cycles_per_second = pdm_port_cycles_per_second(),
+        .p_notify = pdm_session_notify,
+        .p_block = pdm_block_process,
+        .p_context = NULL,
+    };
+    fsp_err_t err = pdm_session_open(&g_pdm0_session, &session_cfg);
+    if (FSP_SUCCESS != err) {
+        PDM_LOG1(PDM_LOG_OPEN_FAILED, err);
+        return;
+    }
+
+    PDM_LOG0(PDM_LOG_OPEN_OK);
+
+    // Filters can be swapped while capturing from here on (SET_SINC)
+    pdm_filter_open(&g_pdm_filter, &g_pdm0_ctrl);
+
+    // Sleep between interrupts instead of busy delays
+    err = pdm_sched_open(PDM_CFG_SCHED_TICK_HZ);
+    if (FSP_SUCCESS != err) {
+        PDM_LOG1(PDM_LOG_SCHED_FAILED, err);
+        return;
+    }
+
+    // The PDM clock has run since the session opened the driver: the microphone startup time counts from here
+    g_clock_start_tick = pdm_sched_ticks();
+
+    // ISR profiling (compiled out unless PDM_CFG_PROF_ENABLE)
+    PDM_PROF_OPEN();
+    PDM_PROF_ISR_WRAP(PDM_PROF_POINT_DAT_ISR, g_pdm0_cfg.dat_irq);
+    PDM_PROF_ISR_WRAP(PDM_PROF_POINT_ERR_ISR, g_pdm0_cfg.err_irq);
+    PDM_PROF_ISR_WRAP(PDM_PROF_POINT_SDET_ISR, g_pdm0_cfg.sdet_irq);
+    PDM_PROF_PERIOD_SET(PDM_PROF_POINT_DAT_ISR,
+                        (uint32_t) (((uint64_t) SystemCoreClock * PDM_FIFO_INTERRUPT_SAMPLES) / PDM_CFG_SAMPLE_RATE_HZ));
+
+    // Everything beyond bookkeeping runs from the foreground dispatcher
+    pdm_work_open(&g_pdm_work);
+    pdm_work_handler_set(&g_pdm_work, PDM_APP_WORK_BLOCK, pdm_block_work, NULL);
+    pdm_work_handler_set(&g_pdm_work, PDM_APP_WORK_ERROR, pdm_event_work, NULL);
+    pdm_work_handler_set(&g_pdm_work, PDM_APP_WORK_SOUND, pdm_event_work, NULL);
+
+#if PDM_CFG_DUAL_CORE_ENABLE
+    // Core 1 attaches to the ring and stores the recording that core 0 keeps the books of
+    pdm_core1_start(g_all_audio_data);
+    PDM_LOG0(PDM_LOG_DUAL_CORE);
+#endif
+
+#if PDM_CFG_CMD_ENABLE
+    // The RTT down channel has no interrupt: poll it on every scheduler tick
+    pdm_cmd_open(pdm_command, NULL);
+    pdm_sched_tick_events(true);
+    g_start_requested = (0 != PDM_CFG_CMD_AUTOSTART);
+    if (!g_start_requested)
+    {
+        PDM_LOG1(PDM_LOG_CMD_IDLE, PDM_CFG_CMD_RTT_CHANNEL);
+    }
+
+    while (1)
+    {
+        if (g_start_requested)
+        {
+            g_start_requested = false;
+            pdm_record();
+            PDM_LOG1(PDM_LOG_CMD_IDLE, PDM_CFG_CMD_RTT_CHANNEL);
+        }
+
+        if (pdm_sched_wait() & PDM_SCHED_EVENT_TICK)
+        {
+            pdm_cmd_poll();
+        }
+
+#if PDM_CFG_SEGMENT_ENABLE
+        (void) pdm_fetch_step();
+#endif
+    }
+#else
+    pdm_record();
+    (void) pdm_session_close(&g_pdm0_session);
+
     SEGGER_RTT_printf(0, "\n=== ALL TASKS COMPLETED ===\n");
+    pdm_sched_close();
+#endif
 }
 
 
-// ULTRA-OPTIMIZED callback function for maximum performance
-void pdm0_callback(pdm_callback_args_t * p_args)
+// Session notify hook, interrupt context: queue the event and return, the foreground does the rest
+PDM_MEM_FAST_CODE static void pdm_session_notify(pdm_session_t * p_session, pdm_session_event_t const * p_event,
+                                                 void * p_context)
 {
-    switch(p_args->event)
+    FSP_PARAMETER_NOT_USED(p_context);
+
+    switch (p_event->type)
     {
-        case PDM_EVENT_SOUND_DETECTION:
+        case PDM_SESSION_EVENT_SOUND:
         {
-            g_sound_detection_count++;
+            // arg: low bits of the stream index being captured, the trigger position in event-driven mode
+            pdm_work_post(&g_pdm_work, PDM_WORK_LANE_SOUND, PDM_APP_WORK_SOUND, (uint32_t) p_event->position);
             break;
         }
 
-        case PDM_EVENT_DATA:
+        case PDM_SESSION_EVENT_BLOCK:
         {
-            g_data_callback_count++;
+            // A staged filter set goes in between this block and the next; the block rate follows the new sincdec
+            if (pdm_filter_block_boundary(&g_pdm_filter, p_event->position + PDM_CALLBACK_NUM_SAMPLES)) {
+                pdm_session_rate_set(p_session, pdm_sample_rate_hz());
+            }
 
-            // CRITICAL: Only fast data collection!
-            collect_all_audio_data(g_pdm0_buffer, PDM_CALLBACK_NUM_SAMPLES);
-            
-            if (g_data_callback_count % 100 == 0)
-            {
-                SEGGER_RTT_printf(0, ".");
+            // Dropped blocks need no work, the session reports them with the next one
+            if (PDM_SLOT_NONE != p_event->slot) {
+                pdm_work_post(&g_pdm_work, PDM_WORK_LANE_DATA, PDM_APP_WORK_BLOCK, p_event->slot);
             }
+            break;
+        }
 
+        case PDM_SESSION_EVENT_ERROR:
+        default:
+        {
+            pdm_work_post(&g_pdm_work, PDM_WORK_LANE_ERROR, PDM_APP_WORK_ERROR, p_event->errors);
+            break;
+        }
+    }
+
+    pdm_sched_post(PDM_SCHED_EVENT_WORK);
+}
+
+// Interrupt context: hand the driver event to the session
+PDM_MEM_FAST_CODE void pdm0_callback(pdm_callback_args_t * p_args)
+{
+    uint32_t start = pdm_port_cycles();
+
+    switch(p_args->event)
+    {
+        case PDM_EVENT_DATA:
+        {
+            pdm_session_isr(&g_pdm0_session, PDM_SESSION_EVENT_BLOCK, 0U);
+            break;
+        }
+
+        case PDM_EVENT_SOUND_DETECTION:
+        {
+            pdm_session_isr(&g_pdm0_session, PDM_SESSION_EVENT_SOUND, 0U);
             break;
         }
 
         case PDM_EVENT_ERROR:
         {
-            g_error_count++;
-            // Continue data collection even on error
-            collect_all_audio_data(g_pdm0_buffer, PDM_CALLBACK_NUM_SAMPLES);
+            pdm_session_isr(&g_pdm0_session, PDM_SESSION_EVENT_ERROR, (uint32_t) p_args->error);
             break;
         }
 
         default:
             break;
     }
+
+    uint32_t cycles = pdm_port_cycles() - start;
+    g_callback_total_cycles += cycles;
+    g_callback_count++;
+    if (cycles > g_callback_max_cycles)
+    {
+        g_callback_max_cycles = cycles;
+    }
+
+    if (PDM_EVENT_DATA == p_args->event)
+    {
+        PDM_PROF_RECORD(PDM_PROF_POINT_CALLBACK, cycles);
+    }
 }
 
+// Stored format of the current settings
+static pdm_kernel_format_t store_format(void)
+{
+    return (PDM_CMD_FORMAT_PCM16 == g_pdm_settings.format) ? PDM_KERNEL_FORMAT_PCM16 : PDM_KERNEL_FORMAT_RAW20;
+}
+
+#if !PDM_CFG_DUAL_CORE_ENABLE
+// Store samples with the current gain and format; the default settings keep the FIFO words as they are
+static void store_audio_samples(uint32_t const *p_raw, uint32_t *p_out, uint32_t count)
+{
+    g_pdm_kernel->store[store_format()](p_raw, p_out, count, (int32_t) g_pdm_settings.gain_q8);
+}
+#endif
+
+#if PDM_CFG_SEGMENT_ENABLE
+// Run the segment store over collected samples chunk by chunk: the detector takes signed samples, the pool the
+// stored format
+static void collect_segment_audio_data(uint32_t *buffer, uint64_t first_index, uint64_t timestamp,
+                                       uint32_t sample_count)
+{
+    uint32_t rate = pdm_sample_rate_hz();
+
+    for (uint32_t done = 0; done < sample_count; done += COLLECT_CHUNK_SAMPLES)
+    {
+        uint32_t n = ((sample_count - done) < COLLECT_CHUNK_SAMPLES) ? (sample_count - done) : COLLECT_CHUNK_SAMPLES;
+        int32_t samples[COLLECT_CHUNK_SAMPLES];
+        uint32_t words[COLLECT_CHUNK_SAMPLES];
+
+        g_pdm_kernel->convert(&buffer[done], samples, n);
+        store_audio_samples(&buffer[done], words, n);
+        pdm_segment_append(&g_pdm_segment, first_index + done,
+                           timestamp + (((uint64_t) done * SystemCoreClock) / rate), words, samples, n);
+    }
+
+    g_total_collected_samples += sample_count;
+}
+#endif
+
 // Collect all audio data into large buffer
 void collect_all_audio_data(uint32_t *buffer, uint32_t sample_count)
 {
-    for (uint32_t i = 0; i < sample_count && g_total_collected_samples < MAX_TOTAL_SAMPLES; i++)
+#if PDM_CFG_TRIGGER_ENABLE
+    // Append to the pre-roll ring chunk by chunk, so a level trigger knows the position of every sample
+    uint32_t done = 0;
+    while (done < sample_count)
     {
-        g_all_audio_data[g_total_collected_samples] = buffer[i];
-        g_total_collected_samples++;
+        uint32_t n = ((sample_count - done) < COLLECT_CHUNK_SAMPLES) ? (sample_count - done) : COLLECT_CHUNK_SAMPLES;
+
+        if ((0 != PDM_CFG_TRIGGER_LEVEL) && (PDM_TRIGGER_STATE_ARMED == pdm_trigger_state(&g_pdm_trigger)))
+        {
+            int32_t samples[COLLECT_CHUNK_SAMPLES];
+            g_pdm_kernel->convert(&buffer[done], samples, n);
+            if (pdm_trigger_detect(&g_pdm_trigger, samples, n)) {
+                pdm_trigger_log();
+            }
+        }
+
+        uint32_t *p_span;
+        uint32_t room = pdm_trigger_reserve(&g_pdm_trigger, &p_span);
+        if (0 == room) {
+            break;      // Record complete, the rest is not needed
+        }
+
+        n = (n < room) ? n : room;
+        store_audio_samples(&buffer[done], p_span, n);
+        pdm_trigger_commit(&g_pdm_trigger, n);
+        done += n;
     }
+
+    g_total_collected_samples += done;
+#elif PDM_CFG_DUAL_CORE_ENABLE
+    // Core 1 stores the samples at their place; a span the ring has no room for is left out as a gap
+    uint32_t room = MAX_TOTAL_SAMPLES - g_total_collected_samples;
+    uint32_t count = (sample_count < room) ? sample_count : room;
+
+    if (0 == count) {
+        return;
+    }
+
+    if (FSP_SUCCESS == pdm_core1_store(buffer, count, g_total_collected_samples, store_format(),
+                                       (int32_t) g_pdm_settings.gain_q8, g_pdm_kernel->pcm_bits)) {
+        g_total_collected_samples += count;
+    } else {
+        pdm_record_gap(count);
+    }
+#else
+    uint32_t room = MAX_TOTAL_SAMPLES - g_total_collected_samples;
+    uint32_t count = (sample_count < room) ? sample_count : room;
+
+    store_audio_samples(buffer, &g_all_audio_data[g_total_collected_samples], count);
+    g_total_collected_samples += count;
+#endif
 }
 
-// Output all collected data in pure format for Python processing
-void dump_all_collected_data(void)
+// Write one dump record, waiting for the host to drain the channel. Returns false on a stalled host.
+static bool dump_record(pdm_log_id_t id, uint32_t const * p_args, uint32_t nargs)
 {
-    SEGGER_RTT_printf(0, "\n");
-    for(int i = 0; i < 60; i++){
-        SEGGER_RTT_printf(0, "=");
+    uint32_t start = pdm_port_cycles();
+    uint32_t timeout = (pdm_port_cycles_per_second() / 1000U) * DUMP_STALL_TIMEOUT_MS;
+
+    while (!pdm_log_write(id, p_args, nargs))
+    {
+        if ((pdm_port_cycles() - start) > timeout)
+        {
+            return false;
+        }
     }
 
-    SEGGER_RTT_printf(0, "\n");
+    return true;
+}
 
-    SEGGER_RTT_printf(0, "=== COMPLETE AUDIO DATA DUMP ===\n");
-    SEGGER_RTT_printf(0, "Total collected samples: %lu\n", g_total_collected_samples);
-    SEGGER_RTT_printf(0, "Data format: 32-bit hex (20-bit effective)\n");
-    SEGGER_RTT_printf(0, "Sample rate: 16000 Hz\n");
-    SEGGER_RTT_printf(0, "Bit depth: 20-bit PDM -> 16-bit PCM\n");
-    
-    SEGGER_RTT_printf(0, "\n");
-    for(int i = 0; i < 60; i++){
-        SEGGER_RTT_printf(0, "=");
+#if PDM_CFG_SEGMENT_ENABLE
+// Index of the stored segments: SEGMENT <id> <source> <start> <length> <peak> <rms> <timestamp> (64-bit hex, clock
+// Hz given). The host fetches the ones it wants; without the command channel nobody can, so all of them follow.
+static void dump_segment_index(void)
+{
+    uint32_t const header[4] =
+    {
+        pdm_segment_count(&g_pdm_segment), g_pdm_segment.evicted, SystemCoreClock, pdm_sample_rate_hz()
+    };
+    bool ok = dump_record(PDM_LOG_SEGMENT_INDEX, header, 4);
+
+    pdm_segment_entry_t entry;
+    for (uint32_t id = 0; ok && (FSP_SUCCESS == pdm_segment_find(&g_pdm_segment, id, &entry)); id = entry.id + 1U)
+    {
+        uint32_t const args[8] =
+        {
+            entry.id, entry.source, (uint32_t) entry.start, entry.length, entry.peak, entry.rms,
+            (uint32_t) (entry.timestamp >> 32), (uint32_t) entry.timestamp
+        };
+        ok = dump_record(PDM_LOG_SEGMENT, args, 8);
     }
-    SEGGER_RTT_printf(0, "\n");
-    
-    SEGGER_RTT_printf(0, "\n*** PURE DATA OUTPUT START ***\n");
-    SEGGER_RTT_printf(0, " ");
 
+#if !PDM_CFG_CMD_ENABLE
+    g_segment_fetch.next = 0;
+    g_segment_fetch.last = UINT32_MAX;
+    g_segment_fetch.started = false;
+    g_segment_fetch.active = ok;
 
-    for (uint32_t i = 0; i < g_total_collected_samples; i++)
+    uint32_t start = pdm_port_cycles();
+    uint32_t timeout = (pdm_port_cycles_per_second() / 1000U) * DUMP_STALL_TIMEOUT_MS;
+    while (g_segment_fetch.active)
     {
-        // New line every 16 samples
-        if (i % 16 == 0 && i > 0)
-        {
-            SEGGER_RTT_printf(0, "\n");
+        if (0 != pdm_fetch_step()) {
+            start = pdm_port_cycles();
+        } else if ((pdm_port_cycles() - start) > timeout) {
+            g_segment_fetch.active = false;
+            PDM_LOG1(PDM_LOG_DUMP_ABORTED, g_segment_fetch.sent);
         }
+    }
+#endif
+}
+#endif
+
+// Output all collected data in pure format for Python processing. The records expand to the
+// same text the host scripts always parsed (see pdm_log_ids.h); the target formats nothing.
+void dump_all_collected_data(void)
+{
+#if PDM_CFG_SEGMENT_ENABLE
+    dump_segment_index();
+    return;
+#endif
+
+    // The data is one linear buffer, or in trigger mode the event record: up to two spans of the ring
+    uint32_t const *spans[2] = {g_all_audio_data, NULL};
+    uint32_t counts[2] = {g_total_collected_samples, 0};
+    uint32_t first = 0;            // Gap offset of the first dumped sample
+
+#if PDM_CFG_TRIGGER_ENABLE
+    pdm_trigger_event_t event = {0};
+    if (FSP_SUCCESS == pdm_trigger_event_get(&g_pdm_trigger, &event)) {
+        spans[0] = event.p_head;
+        spans[1] = event.p_tail;
+        counts[0] = event.head_count;
+        counts[1] = event.tail_count;
+        first = (uint32_t) event.first;
+    } else {
+        counts[0] = 0;
+        PDM_LOG1(PDM_LOG_TRIGGER_NONE, g_pdm_settings.duration_ms);
+    }
+#endif
+
+    uint32_t count = counts[0] + counts[1];
+    bool ok = dump_record(PDM_LOG_DUMP_HEADER, &count, 1);
+
+    // Raw words are FIFO words of the channel's width
+    ok = ok && dump_record(PDM_LOG_DUMP_FORMAT,
+                           (uint32_t const[3]) {g_pdm_settings.format, g_pdm_settings.gain_q8, pdm_pcm_bits()}, 3);
+
+#if PDM_CFG_TRIGGER_ENABLE
+    ok = ok && dump_record(PDM_LOG_DUMP_TRIGGER,
+                           (uint32_t const[3]) {event.source, (uint32_t) (event.trigger - event.first), count}, 3);
+#endif
+
+    // Insert <missing> samples before data index <offset> to restore the original timing
+    uint32_t gaps = 0;
+    for (uint32_t i = 0; i < g_recorded_gap_count; i++)
+    {
+        gaps += ((g_recorded_gaps[i].offset - first) <= count) ? 1U : 0U;
+    }
 
-        if (i > 0) {
-            SEGGER_RTT_printf(0, " ");
+    ok = ok && dump_record(PDM_LOG_DUMP_GAPS, &gaps, 1);
+    for (uint32_t i = 0; ok && (i < g_recorded_gap_count); i++)
+    {
+        uint32_t offset = g_recorded_gaps[i].offset - first;
+        if (offset <= count)
+        {
+            ok = dump_record(PDM_LOG_DUMP_GAP, (uint32_t const[2]) {offset, g_recorded_gaps[i].missing}, 2);
         }
+    }
 
-        SEGGER_RTT_printf(0, "%08lX", g_all_audio_data[i]);
+    // Block <sequence> starting at stream index <index> completed at <timestamp> (64-bit hex, clock Hz given);
+    // trigger mode keeps the most recent blocks only
+    uint32_t stamp_first = (g_recorded_stamp_count > MAX_RECORDED_STAMPS) ?
+                           (g_recorded_stamp_count - MAX_RECORDED_STAMPS) : 0U;
+    uint32_t const stamps[4] =
+    {
+        g_recorded_stamp_count - stamp_first, PDM_CALLBACK_NUM_SAMPLES, SystemCoreClock, pdm_sample_rate_hz()
+    };
+    ok = ok && dump_record(PDM_LOG_DUMP_STAMPS, stamps, 4);
+    for (uint32_t i = stamp_first; ok && (i < g_recorded_stamp_count); i++)
+    {
+        pdm_stamp_t const *p_stamp = &g_recorded_stamps[i % MAX_RECORDED_STAMPS];
+        ok = dump_record(PDM_LOG_DUMP_STAMP,
+                         (uint32_t const[4]) {p_stamp->sequence, p_stamp->sample_index,
+                                              (uint32_t) (p_stamp->timestamp >> 32), (uint32_t) p_stamp->timestamp}, 4);
+    }
 
+    ok = ok && dump_record(PDM_LOG_DUMP_DATA_START, NULL, 0);
 
-        R_BSP_SoftwareDelay(1, BSP_DELAY_UNITS_MILLISECONDS);
+    uint32_t i = 0;
+    for (uint32_t span = 0; ok && (span < 2); span++)
+    {
+        uint32_t done = 0;
+        while (ok && (done < counts[span]))
+        {
+            uint32_t n = (counts[span] - done < DUMP_RECORD_SAMPLES) ? (counts[span] - done) : DUMP_RECORD_SAMPLES;
 
+            ok = dump_record((0 == i) ? PDM_LOG_DUMP_DATA_FIRST : PDM_LOG_DUMP_DATA, &spans[span][done], n);
+            if (ok)
+            {
+                done += n;
+                i += n;
+            }
+        }
     }
 
-    SEGGER_RTT_printf(0, "\n*** PURE DATA OUTPUT END ***\n");
-    
-    SEGGER_RTT_printf(0, "\n=== END COMPLETE DATA DUMP ===\n");
-    SEGGER_RTT_printf(0, "\n");
-    for(int i = 0; i < 60; i++){
-        SEGGER_RTT_printf(0, "=");
+    if (ok)
+    {
+        dump_record(PDM_LOG_DUMP_END, NULL, 0);
+    }
+    else
+    {
+        PDM_LOG1(PDM_LOG_DUMP_ABORTED, i);
     }
-    SEGGER_RTT_printf(0, "\n");
 }
-
@@ -0,0 +1,585 @@
+/**
+ * @file pdm_bench.c
+ * @brief Benchmark suite for the audio kernels
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_bench.h"
+#include "pdm_cfg.h"
+#include "pdm_dsp.h"
+#include "pdm_kernel.h"
+#include "pdm_loudness.h"
+#include "pdm_slm.h"
+#include "pdm_math.h"
+#include <stdio.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Buffers start on a 64-byte boundary; the alignment cases offset them by up to this much */
+#define PDM_BENCH_PRV_PAD_WORDS        (16U)
+#define PDM_BENCH_PRV_BUFFER_WORDS     (PDM_BENCH_MAX_BLOCK + PDM_BENCH_PRV_PAD_WORDS)
+
+/** Stop doubling the iteration count here even if min_time_us is not reached */
+#define PDM_BENCH_PRV_MAX_ITERATIONS   (1U << 20)
+
+#define PDM_BENCH_PRV_SINE_HZ          (1000.0f)
+#define PDM_BENCH_PRV_FIR_TAPS         (31U)
+#define PDM_BENCH_PRV_BIQUAD_STAGES    (2U)
+
+/** Software gain of the store cases (-6 dB), so the gain path is timed too */
+#define PDM_BENCH_PRV_STORE_GAIN_Q8    (128)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Input and output views of one case, offset by the case alignment */
+typedef struct st_pdm_bench_prv_buffers
+{
+    uint32_t * p_raw;                  ///< Raw FIFO words
+    int32_t  * p_pcm;                  ///< Signed samples of p_raw
+    float    * p_f32;                  ///< p_pcm scaled to +-1.0
+    float    * p_aux;                  ///< Second float input, filled by the kernel's prepare step
+    int32_t  * p_out_i32;
+    int16_t  * p_out_i16;
+    float    * p_out_f32;
+    float    * p_out_f32_b;
+} pdm_bench_prv_buffers_t;
+
+typedef struct st_pdm_bench_prv_kernel
+{
+    char const * p_name;
+    void (* p_prepare)(pdm_bench_prv_buffers_t const * p_buf, uint32_t count); ///< Resets state (may be NULL)
+    void (* p_run)(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+} pdm_bench_prv_kernel_t;
+
+typedef enum e_pdm_bench_prv_signal
+{
+    PDM_BENCH_PRV_SIGNAL_SILENCE,
+    PDM_BENCH_PRV_SIGNAL_SINE,
+    PDM_BENCH_PRV_SIGNAL_NOISE,
+    PDM_BENCH_PRV_SIGNAL_CLIPPED,
+    PDM_BENCH_PRV_SIGNAL_COUNT,
+} pdm_bench_prv_signal_t;
+
+/***********************************************************************************************************************
+ * Private function prototypes
+ **********************************************************************************************************************/
+
+static void pdm_bench_prv_convert(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_convert_w20(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_convert_w16(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_store_generic(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_store_w20(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_pack_pcm16(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_to_float(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_stats_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_stats(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_dc_block_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_dc_block(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_biquad_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_biquad(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_fir_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_fir(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_fft_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_fft(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_sincos_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_sincos(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_polar_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_polar(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_loudness_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_loudness(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_slm_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_slm(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static pdm_bench_prv_kernel_t const g_pdm_bench_kernels[] =
+{
+    {"convert_20bit", NULL,                           pdm_bench_prv_convert    },
+    {"convert_w20",   NULL,                           pdm_bench_prv_convert_w20},
+    {"convert_w16",   NULL,                           pdm_bench_prv_convert_w16},
+    {"store_generic", NULL,                           pdm_bench_prv_store_generic},
+    {"store_w20",     NULL,                           pdm_bench_prv_store_w20  },
+    {"pack_pcm16",    NULL,                           pdm_bench_prv_pack_pcm16 },
+    {"to_float",      NULL,                           pdm_bench_prv_to_float   },
+    {"stats",         pdm_bench_prv_stats_prepare,    pdm_bench_prv_stats      },
+    {"dc_block",      pdm_bench_prv_dc_block_prepare, pdm_bench_prv_dc_block   },
+    {"biquad_lp4",    pdm_bench_prv_biquad_prepare,   pdm_bench_prv_biquad     },
+    {"fir_lp31",      pdm_bench_prv_fir_prepare,      pdm_bench_prv_fir        },
+    {"fft",           pdm_bench_prv_fft_prepare,      pdm_bench_prv_fft        },
+    {"sincos",        pdm_bench_prv_sincos_prepare,   pdm_bench_prv_sincos     },
+    {"polar",         pdm_bench_prv_polar_prepare,    pdm_bench_prv_polar      },
+    {"loudness",      pdm_bench_prv_loudness_prepare, pdm_bench_prv_loudness   },
+    {"slm",           pdm_bench_prv_slm_prepare,      pdm_bench_prv_slm        },
+};
+
+#define PDM_BENCH_PRV_KERNEL_COUNT    (sizeof(g_pdm_bench_kernels) / sizeof(g_pdm_bench_kernels[0]))
+
+static char const * const g_pdm_bench_signals[PDM_BENCH_PRV_SIGNAL_COUNT] =
+{
+    "silence",
+    "sine",
+    "noise",
+    "clipped",
+};
+
+/** Byte offsets from a 64-byte boundary: aligned, word, doubleword, half cache line */
+static uint32_t const g_pdm_bench_aligns[] = {0U, 4U, 8U, 16U};
+
+#define PDM_BENCH_PRV_ALIGN_COUNT    (sizeof(g_pdm_bench_aligns) / sizeof(g_pdm_bench_aligns[0]))
+
+static uint32_t g_pdm_bench_raw[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static int32_t  g_pdm_bench_pcm[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static float    g_pdm_bench_f32[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static float    g_pdm_bench_aux[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static int32_t  g_pdm_bench_out_i32[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static int16_t  g_pdm_bench_out_i16[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static float    g_pdm_bench_out_f32[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+static float    g_pdm_bench_out_f32_b[PDM_BENCH_PRV_BUFFER_WORDS] BSP_ALIGN_VARIABLE(64);
+
+static pdm_dsp_stats_t         g_pdm_bench_stats;
+static pdm_dsp_dc_block_t      g_pdm_bench_dc_block;
+static pdm_dsp_biquad_t        g_pdm_bench_biquad;
+static pdm_dsp_biquad_coeffs_t g_pdm_bench_biquad_coeffs[PDM_BENCH_PRV_BIQUAD_STAGES];
+static pdm_dsp_fir_t           g_pdm_bench_fir;
+static float                   g_pdm_bench_fir_taps[PDM_BENCH_PRV_FIR_TAPS];
+static float                   g_pdm_bench_fir_state[2U * PDM_BENCH_PRV_FIR_TAPS];
+static pdm_dsp_fft_t           g_pdm_bench_fft;
+static float                   g_pdm_bench_fft_twiddle[PDM_BENCH_MAX_BLOCK / 2U];
+static pdm_loudness_ctrl_t     g_pdm_bench_loudness;
+static pdm_slm_ctrl_t          g_pdm_bench_slm;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_bench_prv_convert(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_convert_20bit(p_buf->p_raw, p_buf->p_out_i32, count);
+}
+
+static void pdm_bench_prv_convert_w20(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_kernel_select(20U)->convert(p_buf->p_raw, p_buf->p_out_i32, count);
+}
+
+static void pdm_bench_prv_convert_w16(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_kernel_select(16U)->convert(p_buf->p_raw, p_buf->p_out_i32, count);
+}
+
+/* Gain and PCM16 packing as separate passes with run-time checks, the path the kernels replace */
+static void pdm_bench_prv_store_generic(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    int32_t * p_samples = p_buf->p_out_i32;
+
+    pdm_dsp_convert_20bit(p_buf->p_raw, p_samples, count);
+
+    if (PDM_KERNEL_GAIN_UNITY != PDM_BENCH_PRV_STORE_GAIN_Q8)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            int64_t y = ((int64_t) p_samples[i] * PDM_BENCH_PRV_STORE_GAIN_Q8) >> 8;
+            y            = (y > PDM_DSP_20BIT_MAX) ? PDM_DSP_20BIT_MAX : y;
+            y            = (y < PDM_DSP_20BIT_MIN) ? PDM_DSP_20BIT_MIN : y;
+            p_samples[i] = (int32_t) y;
+        }
+    }
+
+    pdm_dsp_pack_pcm16(p_samples, p_buf->p_out_i16, count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p_samples[i] = (uint16_t) p_buf->p_out_i16[i];
+    }
+}
+
+static void pdm_bench_prv_store_w20(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_kernel_select(20U)->store[PDM_KERNEL_FORMAT_PCM16](p_buf->p_raw, (uint32_t *) p_buf->p_out_i32, count,
+                                                            PDM_BENCH_PRV_STORE_GAIN_Q8);
+}
+
+static void pdm_bench_prv_pack_pcm16(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_pack_pcm16(p_buf->p_pcm, p_buf->p_out_i16, count);
+}
+
+static void pdm_bench_prv_to_float(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_to_float(p_buf->p_pcm, p_buf->p_out_f32, count, 1.0f / 524288.0f);
+}
+
+static void pdm_bench_prv_stats_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+    FSP_PARAMETER_NOT_USED(count);
+
+    pdm_dsp_stats_reset(&g_pdm_bench_stats);
+}
+
+static void pdm_bench_prv_stats(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_stats_update(&g_pdm_bench_stats, p_buf->p_pcm, count);
+}
+
+static void pdm_bench_prv_dc_block_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+    FSP_PARAMETER_NOT_USED(count);
+
+    (void) pdm_dsp_dc_block_init(&g_pdm_bench_dc_block, PDM_DSP_DC_BLOCK_POLE_Q15);
+}
+
+static void pdm_bench_prv_dc_block(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_dc_block(&g_pdm_bench_dc_block, p_buf->p_pcm, p_buf->p_out_i32, count);
+}
+
+static void pdm_bench_prv_biquad_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+    FSP_PARAMETER_NOT_USED(count);
+
+    (void) pdm_dsp_biquad_init(&g_pdm_bench_biquad, g_pdm_bench_biquad_coeffs, PDM_BENCH_PRV_BIQUAD_STAGES);
+}
+
+static void pdm_bench_prv_biquad(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_biquad_process(&g_pdm_bench_biquad, p_buf->p_f32, p_buf->p_out_f32, count);
+}
+
+static void pdm_bench_prv_fir_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+    FSP_PARAMETER_NOT_USED(count);
+
+    (void) pdm_dsp_fir_init(&g_pdm_bench_fir, g_pdm_bench_fir_taps, g_pdm_bench_fir_state, PDM_BENCH_PRV_FIR_TAPS);
+}
+
+static void pdm_bench_prv_fir(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_dsp_fir_process(&g_pdm_bench_fir, p_buf->p_f32, p_buf->p_out_f32, count);
+}
+
+static void pdm_bench_prv_fft_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_fft(pdm_bench_prv_buffers_t const * p_buf, uint32_t count);
+static void pdm_bench_prv_fft_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+
+    (void) pdm_dsp_fft_init(&g_pdm_bench_fft, g_pdm_bench_fft_twiddle, count / 2U);
+}
+
+/* The block is read as count / 2 interleaved complex points, so the per-sample figure is per input float */
+static void pdm_bench_prv_fft(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(count);
+
+    pdm_dsp_fft(&g_pdm_bench_fft, p_buf->p_f32, p_buf->p_out_f32);
+}
+
+static void pdm_bench_prv_sincos_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    /* Angles over [-pi, pi), following the signal */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p_buf->p_aux[i] = p_buf->p_f32[i] * PDM_MATH_PI;
+    }
+}
+
+static void pdm_bench_prv_sincos(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_math_sincos_block(p_buf->p_aux, p_buf->p_out_f32, p_buf->p_out_f32_b, count);
+}
+
+static void pdm_bench_prv_polar_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    /* Imaginary part: the signal a quarter block later (a cosine for the sine input) */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p_buf->p_aux[i] = p_buf->p_f32[(i + (count / 4U)) % count];
+    }
+}
+
+static void pdm_bench_prv_polar(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    pdm_math_polar_block(p_buf->p_f32, p_buf->p_aux, p_buf->p_out_f32, p_buf->p_out_f32_b, count);
+}
+
+static void pdm_bench_prv_loudness_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+    FSP_PARAMETER_NOT_USED(count);
+
+    pdm_loudness_cfg_t const cfg = {.rate_hz = PDM_CFG_SAMPLE_RATE_HZ, .scale = 1.0f / (float) (PDM_DSP_20BIT_MAX + 1)};
+    (void) pdm_loudness_open(&g_pdm_bench_loudness, &cfg);
+}
+
+static void pdm_bench_prv_loudness(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    (void) pdm_loudness_process(&g_pdm_bench_loudness, p_buf->p_pcm, count);
+}
+
+static void pdm_bench_prv_slm_prepare(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    FSP_PARAMETER_NOT_USED(p_buf);
+    FSP_PARAMETER_NOT_USED(count);
+
+    /* Third-octave bands from 25 Hz, the firmware default */
+    pdm_slm_cfg_t const cfg =
+    {
+        .rate_hz       = PDM_CFG_SAMPLE_RATE_HZ,
+        .scale         = 1.0f / (float) (PDM_DSP_20BIT_MAX + 1),
+        .full_scale_db = 0.0f,
+        .bands         = PDM_SLM_BANDS_THIRD_OCTAVE,
+        .low_band      = 14U,
+        .interval_ms   = 1000U,
+    };
+    (void) pdm_slm_open(&g_pdm_bench_slm, &cfg);
+}
+
+static void pdm_bench_prv_slm(pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    (void) pdm_slm_process(&g_pdm_bench_slm, p_buf->p_pcm, count);
+}
+
+/* Fill the raw FIFO words of one signal and derive the integer and float inputs from them */
+static void pdm_bench_prv_signal(pdm_bench_prv_signal_t signal, pdm_bench_prv_buffers_t const * p_buf, uint32_t count)
+{
+    float    step = PDM_MATH_TWO_PI * PDM_BENCH_PRV_SINE_HZ / (float) PDM_CFG_SAMPLE_RATE_HZ;
+    uint32_t seed = 0x12345678U;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int32_t x;
+
+        switch (signal)
+        {
+            case PDM_BENCH_PRV_SIGNAL_SINE:
+            {
+                /* -6 dBFS */
+                x = (int32_t) (pdm_math_sinf(step * (float) i) * (float) (PDM_DSP_20BIT_MAX / 2));
+                break;
+            }
+
+            case PDM_BENCH_PRV_SIGNAL_NOISE:
+            {
+                /* xorshift32, uniform over half scale */
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                x     = (int32_t) (seed >> 13) - 0x40000;
+                break;
+            }
+
+            case PDM_BENCH_PRV_SIGNAL_CLIPPED:
+            {
+                /* +6 dBFS sine, saturated the way the filter output saturates */
+                x = (int32_t) (pdm_math_sinf(step * (float) i) * (float) (PDM_DSP_20BIT_MAX * 2));
+                x = (x > PDM_DSP_20BIT_MAX) ? PDM_DSP_20BIT_MAX : x;
+                x = (x < PDM_DSP_20BIT_MIN) ? PDM_DSP_20BIT_MIN : x;
+                break;
+            }
+
+            case PDM_BENCH_PRV_SIGNAL_SILENCE:
+            default:
+            {
+                x = 0;
+                break;
+            }
+        }
+
+        p_buf->p_raw[i] = (uint32_t) x & 0x000FFFFFU;
+    }
+
+    pdm_dsp_convert_20bit(p_buf->p_raw, p_buf->p_pcm, count);
+    pdm_dsp_to_float(p_buf->p_pcm, p_buf->p_f32, count, 1.0f / 524288.0f);
+}
+
+static uint32_t pdm_bench_prv_time(pdm_bench_prv_kernel_t const * p_kernel,
+                                   pdm_bench_prv_buffers_t const * p_buf,
+                                   uint32_t                        count,
+                                   uint32_t                        iterations)
+{
+    uint32_t start = pdm_port_cycles();
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        p_kernel->p_run(p_buf, count);
+    }
+
+    return pdm_port_cycles() - start;
+}
+
+static void pdm_bench_prv_report(pdm_bench_cfg_t const * p_cfg,
+                                 char const            * p_kernel,
+                                 char const            * p_signal,
+                                 uint32_t                count,
+                                 uint32_t                align,
+                                 uint32_t                iterations,
+                                 uint32_t                ticks)
+{
+    char     line[PDM_BENCH_LINE_MAX];
+    uint64_t hz      = pdm_port_cycles_per_second();
+    uint64_t samples = (uint64_t) iterations * count;
+
+    ticks = (0U == ticks) ? 1U : ticks;
+
+    /* Fixed point with three decimals: the target printf has no floating point */
+    uint64_t ticks_milli = ((uint64_t) ticks * 1000U) / samples;
+    uint64_t ns_milli    = (ticks_milli * 1000000000U) / hz;
+    uint64_t msps_milli  = (samples * hz) / ((uint64_t) ticks * 1000U);
+
+    (void) snprintf(line, sizeof(line), "%s,%s,%s,%u,%u,%u,%u.%03u,%u.%03u,%u.%03u\n", p_cfg->p_platform, p_kernel,
+                    p_signal, (unsigned) count, (unsigned) align, (unsigned) iterations,
+                    (unsigned) (ticks_milli / 1000U), (unsigned) (ticks_milli % 1000U),
+                    (unsigned) (ns_milli / 1000U), (unsigned) (ns_milli % 1000U),
+                    (unsigned) (msps_milli / 1000U), (unsigned) (msps_milli % 1000U));
+
+    p_cfg->p_output(line, p_cfg->p_context);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_bench_run(pdm_bench_cfg_t const * p_cfg)
+{
+    if ((NULL == p_cfg) || (NULL == p_cfg->p_output) || (NULL == p_cfg->p_platform))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((p_cfg->block_min < PDM_BENCH_MIN_BLOCK) || (p_cfg->block_max > PDM_BENCH_MAX_BLOCK) ||
+        (p_cfg->block_min > p_cfg->block_max) || (0U == p_cfg->repeats))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    uint32_t kernels = 0U;
+    uint32_t signals = 0U;
+
+    for (uint32_t k = 0; k < PDM_BENCH_PRV_KERNEL_COUNT; k++)
+    {
+        kernels += ((NULL == p_cfg->p_kernel) || (0 == strcmp(p_cfg->p_kernel, g_pdm_bench_kernels[k].p_name))) ? 1U : 0U;
+    }
+
+    for (uint32_t s = 0; s < PDM_BENCH_PRV_SIGNAL_COUNT; s++)
+    {
+        signals += ((NULL == p_cfg->p_signal) || (0 == strcmp(p_cfg->p_signal, g_pdm_bench_signals[s]))) ? 1U : 0U;
+    }
+
+    if ((0U == kernels) || (0U == signals))
+    {
+        return FSP_ERR_NOT_FOUND;
+    }
+
+    pdm_port_cycle_counter_init();
+
+    /* Filters of the suite: 4th-order Butterworth low pass at 4 kHz, 31-tap low pass at 4 kHz */
+    float fs = (float) PDM_CFG_SAMPLE_RATE_HZ;
+    (void) pdm_dsp_biquad_design(&g_pdm_bench_biquad_coeffs[0], PDM_DSP_BIQUAD_LOWPASS, 4000.0f, 0.5411961f, fs);
+    (void) pdm_dsp_biquad_design(&g_pdm_bench_biquad_coeffs[1], PDM_DSP_BIQUAD_LOWPASS, 4000.0f, 1.3065630f, fs);
+    (void) pdm_dsp_fir_lowpass(g_pdm_bench_fir_taps, PDM_BENCH_PRV_FIR_TAPS, 4000.0f, fs);
+
+    uint64_t min_ticks = ((uint64_t) p_cfg->min_time_us * pdm_port_cycles_per_second()) / 1000000U;
+    char     header[PDM_BENCH_LINE_MAX];
+
+    (void) snprintf(header, sizeof(header), "# pdm_bench v%u counter_hz=%u\n", (unsigned) PDM_BENCH_FORMAT_VERSION,
+                    (unsigned) pdm_port_cycles_per_second());
+    p_cfg->p_output(header, p_cfg->p_context);
+    p_cfg->p_output(
+        "platform,kernel,signal,block,align,iterations,ticks_per_sample,ns_per_sample,msamples_per_s\n",
+        p_cfg->p_context);
+
+    for (uint32_t k = 0; k < PDM_BENCH_PRV_KERNEL_COUNT; k++)
+    {
+        pdm_bench_prv_kernel_t const * p_kernel = &g_pdm_bench_kernels[k];
+
+        if ((NULL != p_cfg->p_kernel) && (0 != strcmp(p_cfg->p_kernel, p_kernel->p_name)))
+        {
+            continue;
+        }
+
+        for (uint32_t s = 0; s < PDM_BENCH_PRV_SIGNAL_COUNT; s++)
+        {
+            if ((NULL != p_cfg->p_signal) && (0 != strcmp(p_cfg->p_signal, g_pdm_bench_signals[s])))
+            {
+                continue;
+            }
+
+            for (uint32_t count = PDM_BENCH_MIN_BLOCK; count <= p_cfg->block_max; count *= 2U)
+            {
+                if (count < p_cfg->block_min)
+                {
+                    continue;
+                }
+
+                for (uint32_t a = 0; a < PDM_BENCH_PRV_ALIGN_COUNT; a++)
+                {
+                    uint32_t                offset = g_pdm_bench_aligns[a] / sizeof(uint32_t);
+                    pdm_bench_prv_buffers_t buf    =
+                    {
+                        .p_raw       = &g_pdm_bench_raw[offset],
+                        .p_pcm       = &g_pdm_bench_pcm[offset],
+                        .p_f32       = &g_pdm_bench_f32[offset],
+                        .p_aux       = &g_pdm_bench_aux[offset],
+                        .p_out_i32   = &g_pdm_bench_out_i32[offset],
+                        .p_out_i16   = &g_pdm_bench_out_i16[2U * offset],
+                        .p_out_f32   = &g_pdm_bench_out_f32[offset],
+                        .p_out_f32_b = &g_pdm_bench_out_f32_b[offset],
+                    };
+
+                    pdm_bench_prv_signal((pdm_bench_prv_signal_t) s, &buf, count);
+
+                    if (NULL != p_kernel->p_prepare)
+                    {
+                        p_kernel->p_prepare(&buf, count);
+                    }
+
+                    /* Warm up, then double the iterations until one run is long enough to time */
+                    uint32_t iterations = 1U;
+                    uint32_t ticks      = pdm_bench_prv_time(p_kernel, &buf, count, 1U);
+
+                    while ((ticks < min_ticks) && (iterations < PDM_BENCH_PRV_MAX_ITERATIONS))
+                    {
+                        iterations *= 2U;
+                        ticks       = pdm_bench_prv_time(p_kernel, &buf, count, iterations);
+                    }
+
+                    uint32_t best = ticks;
+
+                    for (uint32_t r = 1U; r < p_cfg->repeats; r++)
+                    {
+                        ticks = pdm_bench_prv_time(p_kernel, &buf, count, iterations);
+                        best  = (ticks < best) ? ticks : best;
+                    }
+
+                    pdm_bench_prv_report(p_cfg, p_kernel->p_name, g_pdm_bench_signals[s], count,
+                                         g_pdm_bench_aligns[a], iterations, best);
+                }
+            }
+        }
+    }
+
+    return FSP_SUCCESS;
+}
+
+char const * pdm_bench_kernel_name(uint32_t index)
+{
+    return (index < PDM_BENCH_PRV_KERNEL_COUNT) ? g_pdm_bench_kernels[index].p_name : NULL;
+}
+
+char const * pdm_bench_signal_name(uint32_t index)
+{
+    return (index < PDM_BENCH_PRV_SIGNAL_COUNT) ? g_pdm_bench_signals[index] : NULL;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file pdm_bench.h
+ * @brief Benchmark suite for the audio kernels
+ * @details Runs every kernel of pdm_dsp, pdm_kernel and pdm_math, the loudness meter and the sound level meter, over
+ *          a grid of block sizes, buffer alignments and synthetic input signals, and reports one CSV line per case
+ *          through a caller-supplied output function. The suite is portable: the host tool tools/pdm_bench and the
+ *          firmware produce the same format, timed with pdm_port_cycles() (nanoseconds on host, core cycles on
+ *          target), so results can be compared side by side.
+ *
+ *          Output format (version PDM_BENCH_FORMAT_VERSION):
+ *          - lines starting with '#' are comments; the first one names the version and the counter frequency
+ *          - one header line: platform,kernel,signal,block,align,iterations,ticks_per_sample,ns_per_sample,msamples_per_s
+ *          - one line per case; fractional columns have three decimals
+ *
+ *          Each case is calibrated to run at least min_time_us and reported as the best of `repeats` runs.
+ */
+
+#ifndef PDM_BENCH_H
+#define PDM_BENCH_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_BENCH_FORMAT_VERSION    (1U)
+
+/** Largest block size of the suite; sizes run in powers of two from PDM_BENCH_MIN_BLOCK */
+#ifndef PDM_BENCH_MAX_BLOCK
+ #define PDM_BENCH_MAX_BLOCK        (4096U)
+#endif
+
+#define PDM_BENCH_MIN_BLOCK         (16U)
+
+/** Longest line passed to the output function, including the newline */
+#define PDM_BENCH_LINE_MAX          (160U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Receives one newline-terminated report line */
+typedef void (* pdm_bench_output_t)(char const * p_line, void * p_context);
+
+/** Suite configuration */
+typedef struct st_pdm_bench_cfg
+{
+    char const       * p_platform;     ///< First column of every line, e.g. "host" or "ra8p1-dcache-on"
+    char const       * p_kernel;       ///< Run only this kernel (NULL: all)
+    char const       * p_signal;       ///< Run only this signal (NULL: all)
+    uint32_t           block_min;      ///< Smallest block size (rounded up to a power of two)
+    uint32_t           block_max;      ///< Largest block size, at most PDM_BENCH_MAX_BLOCK
+    uint32_t           min_time_us;    ///< Shortest timed run of one case
+    uint32_t           repeats;        ///< Timed runs per case, the fastest is reported
+    pdm_bench_output_t p_output;       ///< Line sink
+    void             * p_context;      ///< Passed to p_output
+} pdm_bench_cfg_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Run the suite
+ * @param[in] p_cfg  Configuration
+ * @retval FSP_SUCCESS               All selected cases reported
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Block range outside PDM_BENCH_MIN_BLOCK..PDM_BENCH_MAX_BLOCK or repeats is 0
+ * @retval FSP_ERR_NOT_FOUND         The kernel or signal filter matches nothing
+ */
+fsp_err_t pdm_bench_run(pdm_bench_cfg_t const * p_cfg);
+
+/**
+ * @brief Name of a kernel of the suite
+ * @param[in] index  0-based
+ * @return Name, NULL past the last kernel
+ */
+char const * pdm_bench_kernel_name(uint32_t index);
+
+/**
+ * @brief Name of a signal of the suite
+ * @param[in] index  0-based
+ * @return Name, NULL past the last signal
+ */
+char const * pdm_bench_signal_name(uint32_t index);
+
+#if PDM_PORT_TARGET
+
+/**
+ * @brief Benchmark firmware entry (PDM_CFG_BENCH_ENABLE)
+ * @details Runs the suite with the data cache off and then on, and writes the report to RTT channel 0, blocking
+ *          until the host has read each line so nothing is lost. Does not return.
+ */
+void pdm_bench_app(void);
+
+#endif
+
+FSP_FOOTER
+
+#endif /* PDM_BENCH_H */
@@ -0,0 +1,90 @@
+/**
+ * @file pdm_bench_app.c
+ * @brief Benchmark firmware: runs the kernel suite on target and reports over RTT
+ * @details Selected with PDM_CFG_BENCH_ENABLE. The report has the same format as tools/pdm_bench, with the platform
+ *          column telling the cache configuration, so a capture of RTT channel 0 can be compared directly with a
+ *          host report (ticks_per_sample is core cycles here).
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_bench.h"
+#include "pdm_cfg.h"
+#include "pdm_mem.h"
+#include "SEGGER_RTT/SEGGER_RTT.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_BENCH_APP_RTT_CHANNEL    (0U)
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_bench_app_output(char const * p_line, void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_context);
+
+    SEGGER_RTT_WriteString(PDM_BENCH_APP_RTT_CHANNEL, p_line);
+}
+
+static void pdm_bench_app_run(char const * p_platform)
+{
+    pdm_bench_cfg_t const cfg =
+    {
+        .p_platform  = p_platform,
+        .p_kernel    = NULL,
+        .p_signal    = NULL,
+        .block_min   = PDM_BENCH_MIN_BLOCK,
+        .block_max   = PDM_BENCH_MAX_BLOCK,
+        .min_time_us = PDM_CFG_BENCH_MIN_TIME_US,
+        .repeats     = PDM_CFG_BENCH_REPEATS,
+        .p_output    = pdm_bench_app_output,
+        .p_context   = NULL,
+    };
+
+    fsp_err_t err = pdm_bench_run(&cfg);
+    if (FSP_SUCCESS != err)
+    {
+        SEGGER_RTT_printf(PDM_BENCH_APP_RTT_CHANNEL, "# %s: pdm_bench_run failed 0x%X\n", p_platform, err);
+    }
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_bench_app(void)
+{
+    SEGGER_RTT_Init();
+
+    /* Report lines are written between timed runs, so waiting for the host does not disturb the measurements */
+    (void) SEGGER_RTT_SetFlagsUpBuffer(PDM_BENCH_APP_RTT_CHANNEL, SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL);
+
+    bool dcache_enabled = (0U != (SCB->CCR & SCB_CCR_DC_Msk));
+
+    SEGGER_RTT_printf(PDM_BENCH_APP_RTT_CHANNEL, "# pdm_bench firmware, core clock %u Hz\n", SystemCoreClock);
+
+    SCB_DisableDCache();
+    pdm_bench_app_run("ra8p1-dcache-off");
+
+    /* RTT lives in .ram_nocache: mapped non-cacheable first, or the debugger would not see the report and the
+     * target would not see the debugger drain the blocking buffer */
+    pdm_mem_dcache_enable();
+    pdm_bench_app_run("ra8p1-dcache-on");
+
+    if (!dcache_enabled)
+    {
+        SCB_DisableDCache();
+    }
+
+    SEGGER_RTT_WriteString(PDM_BENCH_APP_RTT_CHANNEL, "# pdm_bench done\n");
+
+    while (1)
+    {
+        __WFI();
+    }
+}
@@ -0,0 +1,217 @@
+/**
+ * @file pdm_cfg.h
+ * @brief Build-time configuration of the PDM application
+ * @details Every switch can be overridden from the compiler command line (-DNAME=value).
+ */
+
+#ifndef PDM_CFG_H
+#define PDM_CFG_H
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Dual-core store offload: core 1 converts the collected spans into the recording (pdm_core1.h); capture, session,
+ *  block hook and bookkeeping stay on core 0, and trigger, segment, loudness and SLM are not available. Builds only
+ *  with a CPU1 partition and a core 1 project set up as described in pdm_core1.h (0: single core). */
+#ifndef PDM_CFG_DUAL_CORE_ENABLE
+ #define PDM_CFG_DUAL_CORE_ENABLE    (0)
+#endif
+
+/** Actual PCM output rate of g_pdm0 (see the Configurator note in hal_data.h) */
+#ifndef PDM_CFG_SAMPLE_RATE_HZ
+ #define PDM_CFG_SAMPLE_RATE_HZ      (32258U)
+#endif
+
+/** Block slots between the data interrupt and the foreground (pdm_slot, 2 .. 8): more slots ride out longer
+ *  foreground stalls before blocks are dropped, at 4 KB and one block period of latency each, up to the driver ring
+ *  blocks - 1 (PDM_BUFFER_NUM_BLOCKS), after which the driver overwrites a queued block before it is copied */
+#ifndef PDM_CFG_BLOCK_SLOTS
+ #define PDM_CFG_BLOCK_SLOTS         (3U)
+#endif
+
+/** Scheduler tick: resolution of the recording timer and of pdm_sched_sleep_ms() */
+#ifndef PDM_CFG_SCHED_TICK_HZ
+ #define PDM_CFG_SCHED_TICK_HZ       (100U)
+#endif
+
+/** Length of the example recording */
+#ifndef PDM_CFG_RECORDING_TIME_MS
+ #define PDM_CFG_RECORDING_TIME_MS   (10000U)
+#endif
+
+/** DWT profiling of the PDM interrupts and callback (0: compiled out, no cost) */
+#ifndef PDM_CFG_PROF_ENABLE
+ #define PDM_CFG_PROF_ENABLE         (0)
+#endif
+
+/** RTT up channel and buffer size used to export the profiling results */
+#ifndef PDM_CFG_PROF_RTT_CHANNEL
+ #define PDM_CFG_PROF_RTT_CHANNEL    (1U)
+#endif
+
+#ifndef PDM_CFG_PROF_RTT_BUFFER_SIZE
+ #define PDM_CFG_PROF_RTT_BUFFER_SIZE    (4096U)
+#endif
+
+/** RTT up channel and buffer size of the binary logger (pdm_log) */
+#ifndef PDM_CFG_LOG_RTT_CHANNEL
+ #define PDM_CFG_LOG_RTT_CHANNEL        (2U)
+#endif
+
+#ifndef PDM_CFG_LOG_RTT_BUFFER_SIZE
+ #define PDM_CFG_LOG_RTT_BUFFER_SIZE    (8192U)
+#endif
+
+/** Live control over RTT with tools/pdm_ctl (pdm_cmd); 0: one recording with the build-time settings */
+#ifndef PDM_CFG_CMD_ENABLE
+ #define PDM_CFG_CMD_ENABLE             (1)
+#endif
+
+/** Start the first recording at boot without waiting for a START command */
+#ifndef PDM_CFG_CMD_AUTOSTART
+ #define PDM_CFG_CMD_AUTOSTART          (1)
+#endif
+
+/** RTT channel of the commands (down) and their acknowledgements (up), and the buffer sizes */
+#ifndef PDM_CFG_CMD_RTT_CHANNEL
+ #define PDM_CFG_CMD_RTT_CHANNEL        (3U)
+#endif
+
+#ifndef PDM_CFG_CMD_RTT_DOWN_SIZE
+ #define PDM_CFG_CMD_RTT_DOWN_SIZE      (128U)
+#endif
+
+#ifndef PDM_CFG_CMD_RTT_UP_SIZE
+ #define PDM_CFG_CMD_RTT_UP_SIZE        (256U)
+#endif
+
+/** HPF time constants waited for after a filter swap, on top of the FIR lengths (see pdm_filter.h) */
+#ifndef PDM_CFG_FILTER_HPF_SETTLE_TAU
+ #define PDM_CFG_FILTER_HPF_SETTLE_TAU  (0U)
+#endif
+
+/** Fast start: capture at once and leave the microphone startup and filter settling window out of the data
+ *  (0: sleep through the fixed startup delays before starting) */
+#ifndef PDM_CFG_FAST_START_ENABLE
+ #define PDM_CFG_FAST_START_ENABLE      (1)
+#endif
+
+/** Microphone startup time from the first PDM clock edge, datasheet value */
+#ifndef PDM_CFG_MIC_STARTUP_TIME_US
+ #define PDM_CFG_MIC_STARTUP_TIME_US    (35000U)
+#endif
+
+/** Event-driven recording: keep a pre-roll ring and record one event around a trigger instead of a fixed window
+ *  (pdm_trigger.h). The recording duration becomes the longest wait for a trigger. */
+#ifndef PDM_CFG_TRIGGER_ENABLE
+ #define PDM_CFG_TRIGGER_ENABLE         (0)
+#endif
+
+/** Audio kept before and after the trigger; together at most the collection buffer */
+#ifndef PDM_CFG_TRIGGER_PRE_MS
+ #define PDM_CFG_TRIGGER_PRE_MS         (1000U)
+#endif
+
+#ifndef PDM_CFG_TRIGGER_POST_MS
+ #define PDM_CFG_TRIGGER_POST_MS        (3000U)
+#endif
+
+/** Software trigger level on |sample| in 20-bit units (0: sound detection interrupt only) */
+#ifndef PDM_CFG_TRIGGER_LEVEL
+ #define PDM_CFG_TRIGGER_LEVEL          (65536)
+#endif
+
+/** Long-term monitoring: keep only active stretches of the stream as indexed segments (pdm_segment.h) instead of one
+ *  linear recording. The host reads the index and fetches the segments it wants (tools/pdm_ctl). */
+#ifndef PDM_CFG_SEGMENT_ENABLE
+ #define PDM_CFG_SEGMENT_ENABLE         (0)
+#endif
+
+/** Index entries; with the pool (the collection buffer) the oldest segments are evicted first when either is full */
+#ifndef PDM_CFG_SEGMENT_ENTRIES
+ #define PDM_CFG_SEGMENT_ENTRIES        (256U)
+#endif
+
+/** Audio kept before the start of activity and after its end, and the longest segment (pre-roll plus longest at most
+ *  the collection buffer) */
+#ifndef PDM_CFG_SEGMENT_PRE_MS
+ #define PDM_CFG_SEGMENT_PRE_MS         (100U)
+#endif
+
+#ifndef PDM_CFG_SEGMENT_HOLD_MS
+ #define PDM_CFG_SEGMENT_HOLD_MS        (500U)
+#endif
+
+#ifndef PDM_CFG_SEGMENT_MAX_MS
+ #define PDM_CFG_SEGMENT_MAX_MS         (2000U)
+#endif
+
+/** Activity level on |sample| in 20-bit units (0: sound detection interrupt only) */
+#ifndef PDM_CFG_SEGMENT_LEVEL
+ #define PDM_CFG_SEGMENT_LEVEL          (16384)
+#endif
+
+/** Streaming loudness meter on the collected stream (pdm_loudness.h): momentary, short-term and integrated loudness
+ *  and true peak go out as log records while recording, with a summary at the end */
+#ifndef PDM_CFG_LOUDNESS_ENABLE
+ #define PDM_CFG_LOUDNESS_ENABLE        (0)
+#endif
+
+/** Interval of the loudness records, in whole 100 ms measurement steps */
+#ifndef PDM_CFG_LOUDNESS_REPORT_MS
+ #define PDM_CFG_LOUDNESS_REPORT_MS     (1000U)
+#endif
+
+/** Sound level meter on the collected stream (pdm_slm.h): A, C and Z-weighted Leq and the band levels of every interval
+ *  go out as log records (about 170 bytes per interval for third-octave bands from 25 Hz), nothing else */
+#ifndef PDM_CFG_SLM_ENABLE
+ #define PDM_CFG_SLM_ENABLE             (0)
+#endif
+
+/** Leq interval of the sound level meter, 100 ms to 1 h */
+#ifndef PDM_CFG_SLM_INTERVAL_MS
+ #define PDM_CFG_SLM_INTERVAL_MS        (60000U)
+#endif
+
+/** Bands per octave: 1 (octave) or 3 (third-octave) */
+#ifndef PDM_CFG_SLM_BANDS
+ #define PDM_CFG_SLM_BANDS              (3U)
+#endif
+
+/** Band number of the lowest band (midband 10^(n/10) Hz, 14 is 25 Hz); a multiple of 3 for octave bands */
+#ifndef PDM_CFG_SLM_LOW_BAND
+ #define PDM_CFG_SLM_LOW_BAND           (14U)
+#endif
+
+/** Sound pressure level of a full scale sine: 94 dB minus the microphone sensitivity in dBFS (0 reads dBFS) */
+#ifndef PDM_CFG_SLM_FULL_SCALE_DB
+ #define PDM_CFG_SLM_FULL_SCALE_DB      (120.0f)
+#endif
+
+/** Interrupt path in ITCM and capture ring plus its state in DTCM (see pdm_mem.h) */
+#ifndef PDM_CFG_TCM_ENABLE
+ #define PDM_CFG_TCM_ENABLE             (1)
+#endif
+
+/** Turn the data cache on at startup, after mapping the non-cacheable sections with the MPU (pdm_mem_dcache_enable()),
+ *  as the BSP "Data cache" property would; that property is Disabled here */
+#ifndef PDM_CFG_DCACHE_ENABLE
+ #define PDM_CFG_DCACHE_ENABLE          (0)
+#endif
+
+/** Benchmark firmware: hal_entry runs the kernel suite (pdm_bench) and reports over RTT instead of recording */
+#ifndef PDM_CFG_BENCH_ENABLE
+ #define PDM_CFG_BENCH_ENABLE           (0)
+#endif
+
+/** Shortest timed run and best-of count of one benchmark case */
+#ifndef PDM_CFG_BENCH_MIN_TIME_US
+ #define PDM_CFG_BENCH_MIN_TIME_US      (1000U)
+#endif
+
+#ifndef PDM_CFG_BENCH_REPEATS
+ #define PDM_CFG_BENCH_REPEATS          (3U)
+#endif
+
+#endif /* PDM_CFG_H */
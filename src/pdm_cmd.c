@@ -0,0 +1,218 @@
+/**
+ * @file pdm_cmd.c
+ * @brief Binary command protocol over RTT for live control of the recorder
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_cmd.h"
+#if PDM_PORT_TARGET
+ #include "pdm_mem.h"
+ #include "SEGGER_RTT/SEGGER_RTT.h"
+#endif
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+/* Request payload bytes per command, -1: unknown */
+static int8_t const g_pdm_cmd_request_length[PDM_CMD_ID_COUNT] =
+{
+    [0]                           = -1,
+    [PDM_CMD_PING]                = 0,
+    [PDM_CMD_START]               = 0,
+    [PDM_CMD_STOP]                = 0,
+    [PDM_CMD_SET_DURATION]        = 4,
+    [PDM_CMD_SET_SOUND_DETECTION] = 12,
+    [PDM_CMD_SET_GAIN]            = 4,
+    [PDM_CMD_SET_FORMAT]          = 4,
+    [PDM_CMD_GET_STATS]           = 0,
+    [PDM_CMD_GET_CONFIG]          = 0,
+    [PDM_CMD_SET_SINC]            = 8,
+    [PDM_CMD_GET_SEGMENT]         = 4,
+    [PDM_CMD_FETCH_SEGMENTS]      = 8,
+};
+
+#if PDM_PORT_TARGET
+
+static char              g_pdm_cmd_down_buffer[PDM_CFG_CMD_RTT_DOWN_SIZE] PDM_MEM_NOCACHE;
+static char              g_pdm_cmd_up_buffer[PDM_CFG_CMD_RTT_UP_SIZE] PDM_MEM_NOCACHE;
+static pdm_cmd_parser_t  g_pdm_cmd_parser;
+static pdm_cmd_handler_t g_pdm_cmd_handler   = NULL;
+static void            * g_pdm_cmd_p_context = NULL;
+
+#endif
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_cmd_parser_init(pdm_cmd_parser_t * p_parser, uint8_t sync)
+{
+    p_parser->sync     = sync;
+    p_parser->position = 0U;
+    p_parser->sum      = 0U;
+    p_parser->errors   = 0U;
+}
+
+bool pdm_cmd_parse(pdm_cmd_parser_t * p_parser, uint8_t byte)
+{
+    uint32_t position = p_parser->position;
+
+    /* Hunt for the sync byte; anything else between frames is noise */
+    if (0U == position)
+    {
+        if (p_parser->sync == byte)
+        {
+            p_parser->sum      = byte;
+            p_parser->position = 1U;
+        }
+
+        return false;
+    }
+
+    p_parser->sum = (uint8_t) (p_parser->sum + byte);
+
+    if (1U == position)
+    {
+        p_parser->frame.id = byte;
+    }
+    else if (2U == position)
+    {
+        p_parser->frame.sequence = byte;
+    }
+    else if (3U == position)
+    {
+        if (byte > PDM_CMD_MAX_PAYLOAD)
+        {
+            p_parser->errors++;
+            p_parser->position = 0U;
+
+            return false;
+        }
+
+        p_parser->frame.length = byte;
+    }
+    else if (position < (PDM_CMD_HEADER_SIZE + p_parser->frame.length))
+    {
+        p_parser->frame.payload[position - PDM_CMD_HEADER_SIZE] = byte;
+    }
+    else
+    {
+        /* Checksum byte: the whole frame sums to zero */
+        p_parser->position = 0U;
+
+        if (0U != p_parser->sum)
+        {
+            p_parser->errors++;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    p_parser->position = (uint8_t) (position + 1U);
+
+    return false;
+}
+
+uint32_t pdm_cmd_encode(pdm_cmd_frame_t const * p_frame, uint8_t sync, uint8_t * p_out)
+{
+    uint32_t length = (p_frame->length > PDM_CMD_MAX_PAYLOAD) ? PDM_CMD_MAX_PAYLOAD : p_frame->length;
+    uint8_t  sum    = 0U;
+
+    p_out[0] = sync;
+    p_out[1] = p_frame->id;
+    p_out[2] = p_frame->sequence;
+    p_out[3] = (uint8_t) length;
+
+    for (uint32_t i = 0U; i < length; i++)
+    {
+        p_out[PDM_CMD_HEADER_SIZE + i] = p_frame->payload[i];
+    }
+
+    for (uint32_t i = 0U; i < (PDM_CMD_HEADER_SIZE + length); i++)
+    {
+        sum = (uint8_t) (sum + p_out[i]);
+    }
+
+    p_out[PDM_CMD_HEADER_SIZE + length] = (uint8_t) (0U - sum);
+
+    return PDM_CMD_HEADER_SIZE + length + 1U;
+}
+
+int32_t pdm_cmd_request_length(uint32_t id)
+{
+    return (id < PDM_CMD_ID_COUNT) ? g_pdm_cmd_request_length[id] : -1;
+}
+
+#if PDM_PORT_TARGET
+
+void pdm_cmd_open(pdm_cmd_handler_t p_handler, void * p_context)
+{
+    g_pdm_cmd_handler   = p_handler;
+    g_pdm_cmd_p_context = p_context;
+    pdm_cmd_parser_init(&g_pdm_cmd_parser, PDM_CMD_SYNC);
+
+    (void) SEGGER_RTT_ConfigDownBuffer(PDM_CFG_CMD_RTT_CHANNEL, "PdmCmd", g_pdm_cmd_down_buffer,
+                                       sizeof(g_pdm_cmd_down_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    (void) SEGGER_RTT_ConfigUpBuffer(PDM_CFG_CMD_RTT_CHANNEL, "PdmCmd", g_pdm_cmd_up_buffer,
+                                     sizeof(g_pdm_cmd_up_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+uint32_t pdm_cmd_poll(void)
+{
+    uint32_t answered = 0U;
+
+    while (0U != SEGGER_RTT_HasData(PDM_CFG_CMD_RTT_CHANNEL))
+    {
+        uint8_t  chunk[PDM_CMD_FRAME_MAX];
+        uint32_t count = SEGGER_RTT_Read(PDM_CFG_CMD_RTT_CHANNEL, chunk, sizeof(chunk));
+
+        for (uint32_t i = 0U; i < count; i++)
+        {
+            if (!pdm_cmd_parse(&g_pdm_cmd_parser, chunk[i]))
+            {
+                continue;
+            }
+
+            pdm_cmd_frame_t const * p_request = &g_pdm_cmd_parser.frame;
+            pdm_cmd_frame_t         ack       =
+            {
+                .id         = p_request->id,
+                .sequence   = p_request->sequence,
+                .length     = 1U,
+                .payload[0] = PDM_CMD_STATUS_OK,
+            };
+
+            int32_t length = pdm_cmd_request_length(p_request->id);
+            if (length < 0)
+            {
+                ack.payload[0] = PDM_CMD_STATUS_UNKNOWN;
+            }
+            else if ((uint32_t) length != p_request->length)
+            {
+                ack.payload[0] = PDM_CMD_STATUS_LENGTH;
+            }
+            else if (NULL != g_pdm_cmd_handler)
+            {
+                g_pdm_cmd_handler(p_request, &ack, g_pdm_cmd_p_context);
+            }
+            else
+            {
+                ack.payload[0] = PDM_CMD_STATUS_BUSY;
+            }
+
+            /* Acknowledgements are written whole or not at all, so the host never sees a torn frame */
+            uint8_t frame[PDM_CMD_FRAME_MAX];
+            (void) SEGGER_RTT_Write(PDM_CFG_CMD_RTT_CHANNEL, frame, pdm_cmd_encode(&ack, PDM_CMD_ACK_SYNC, frame));
+            answered++;
+        }
+    }
+
+    return answered;
+}
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * @file pdm_cmd.h
+ * @brief Binary command protocol over RTT for live control of the recorder
+ * @details The host writes request frames into RTT down channel PDM_CFG_CMD_RTT_CHANNEL; the firmware polls it with
+ *          SEGGER_RTT_HasData() from the foreground and answers every request with one acknowledgement frame on the up
+ *          channel with the same index (so a bidirectional RTT bridge such as `rtt server start <port> 3` in OpenOCD
+ *          carries both directions). The host tool tools/pdm_ctl is built against this header.
+ *
+ *          Frame layout (request and acknowledgement):
+ *          - byte 0: PDM_CMD_SYNC (request) or PDM_CMD_ACK_SYNC (acknowledgement)
+ *          - byte 1: command ID (pdm_cmd_id_t), echoed in the acknowledgement
+ *          - byte 2: sequence number chosen by the host, echoed in the acknowledgement
+ *          - byte 3: payload length, at most PDM_CMD_MAX_PAYLOAD
+ *          - payload, 32-bit little-endian words
+ *          - checksum: the 8-bit sum of the whole frame including this byte is 0
+ *
+ *          The acknowledgement payload starts with one status byte (pdm_cmd_status_t), followed by the reply words:
+ *
+ *          | Command                 | Request words              | Reply words (status OK)                          |
+ *          |-------------------------|----------------------------|--------------------------------------------------|
+ *          | PING                    | -                          | PDM_CMD_VERSION, sample rate, max samples        |
+ *          | START                   | -                          | -                                                |
+ *          | STOP                    | -                          | -                                                |
+ *          | SET_DURATION            | milliseconds               | -                                                |
+ *          | SET_SOUND_DETECTION     | enable, upper, lower       | -                                                |
+ *          | SET_GAIN                | gain, Q8 (256 = 0 dB)      | -                                                |
+ *          | SET_FORMAT              | pdm_cmd_format_t           | -                                                |
+ *          | GET_STATS               | -                          | pdm_cmd_stats_t, in declaration order            |
+ *          | GET_CONFIG              | -                          | pdm_cmd_config_t, in declaration order           |
+ *          | SET_SINC                | sincdec, sincrng           | -                                                |
+ *          | GET_SEGMENT             | id                         | pdm_cmd_segment_t of the first stored ID >= id   |
+ *          | FETCH_SEGMENTS          | first id, last id          | -                                                |
+ *
+ *          Settings apply to the next recording; changing them while recording is refused with BUSY. SET_SINC is the
+ *          exception: it swaps the decimation live at the next block boundary (pdm_filter.h), BUSY while a previous
+ *          swap is still waiting. A failed driver call replies FAILED followed by the fsp_err_t.
+ *
+ *          The segment commands need PDM_CFG_SEGMENT_ENABLE (UNKNOWN otherwise) and work while recording too.
+ *          GET_SEGMENT walks the index one entry per request (RANGE past the newest); FETCH_SEGMENTS queues the data of
+ *          the stored segments in [first, last] on the log channel, in the background, BUSY while a fetch is running.
+ */
+
+#ifndef PDM_CMD_H
+#define PDM_CMD_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_cfg.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Protocol version, reported by PING */
+#define PDM_CMD_VERSION           (3U)
+
+#define PDM_CMD_SYNC              (0x5AU)
+#define PDM_CMD_ACK_SYNC          (0x5BU)
+
+#define PDM_CMD_HEADER_SIZE       (4U)
+#define PDM_CMD_MAX_PAYLOAD       (48U)
+
+/** Longest encoded frame */
+#define PDM_CMD_FRAME_MAX         (PDM_CMD_HEADER_SIZE + PDM_CMD_MAX_PAYLOAD + 1U)
+
+/** Unity software gain and the accepted gain range (Q8) */
+#define PDM_CMD_GAIN_UNITY        (256U)
+#define PDM_CMD_GAIN_MAX          (65535U)
+
+/** Longest recording accepted by SET_DURATION: a day of segmented monitoring */
+#define PDM_CMD_DURATION_MAX_MS   (86400000U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Commands. Append new ones at the end so existing host tools keep working. */
+typedef enum e_pdm_cmd_id
+{
+    PDM_CMD_PING = 1,
+    PDM_CMD_START,
+    PDM_CMD_STOP,
+    PDM_CMD_SET_DURATION,
+    PDM_CMD_SET_SOUND_DETECTION,
+    PDM_CMD_SET_GAIN,
+    PDM_CMD_SET_FORMAT,
+    PDM_CMD_GET_STATS,
+    PDM_CMD_GET_CONFIG,
+    PDM_CMD_SET_SINC,
+    PDM_CMD_GET_SEGMENT,
+    PDM_CMD_FETCH_SEGMENTS,
+    PDM_CMD_ID_COUNT,
+} pdm_cmd_id_t;
+
+/** First payload byte of an acknowledgement */
+typedef enum e_pdm_cmd_status
+{
+    PDM_CMD_STATUS_OK = 0,
+    PDM_CMD_STATUS_UNKNOWN,            ///< Command ID not supported
+    PDM_CMD_STATUS_LENGTH,             ///< Payload length does not match the command
+    PDM_CMD_STATUS_RANGE,              ///< Argument out of range
+    PDM_CMD_STATUS_BUSY,               ///< Not possible in the current state
+    PDM_CMD_STATUS_FAILED,             ///< Driver call failed, the fsp_err_t follows
+} pdm_cmd_status_t;
+
+/** Sample format of the collected data and of the dump */
+typedef enum e_pdm_cmd_format
+{
+    PDM_CMD_FORMAT_RAW20 = 0,          ///< 20-bit two's complement in the low bits, as read from the FIFO
+    PDM_CMD_FORMAT_PCM16,              ///< 16-bit two's complement in the low bits (pdm_dsp_pack_pcm16)
+    PDM_CMD_FORMAT_COUNT,
+} pdm_cmd_format_t;
+
+/** Recorder state reported by GET_STATS */
+typedef enum e_pdm_cmd_state
+{
+    PDM_CMD_STATE_IDLE = 0,
+    PDM_CMD_STATE_RECORDING,
+    PDM_CMD_STATE_DUMPING,
+} pdm_cmd_state_t;
+
+/** GET_STATS reply */
+typedef struct st_pdm_cmd_stats
+{
+    uint32_t state;                    ///< pdm_cmd_state_t
+    uint32_t recordings;               ///< Recordings started since reset
+    uint32_t elapsed_ms;               ///< Time into the current or last recording
+    uint32_t callbacks;                ///< Data callbacks
+    uint32_t blocks;                   ///< Blocks handled by the foreground
+    uint32_t errors;                   ///< PDM error interrupts
+    uint32_t overruns;                 ///< Blocks overwritten before the foreground got to them
+    uint32_t sound_detections;         ///< Sound detection interrupts
+    uint32_t samples;                  ///< Samples collected
+    uint32_t samples_lost;             ///< Samples lost in hardware or dropped
+    uint32_t first_valid_us;           ///< Start request to the capture of the first valid sample, 0: none yet
+} pdm_cmd_stats_t;
+
+/** GET_CONFIG reply */
+typedef struct st_pdm_cmd_config
+{
+    uint32_t duration_ms;              ///< Recording length
+    uint32_t sound_detection;          ///< 1: sound detection enabled during recordings
+    uint32_t sound_upper;              ///< Sound detection upper limit (20-bit signed fixed point)
+    uint32_t sound_lower;              ///< Sound detection lower limit (20-bit signed fixed point)
+    uint32_t gain_q8;                  ///< Software gain, PDM_CMD_GAIN_UNITY = 0 dB
+    uint32_t format;                   ///< pdm_cmd_format_t
+    uint32_t sincdec;                  ///< Sinc decimation ratio in use
+    uint32_t sincrng;                  ///< Sinc output range in use
+    uint32_t sample_rate_hz;           ///< PCM rate that follows from sincdec
+} pdm_cmd_config_t;
+
+/** GET_SEGMENT reply: one index entry (pdm_segment.h) */
+typedef struct st_pdm_cmd_segment
+{
+    uint32_t id;                       ///< Segment ID, ask for id + 1 next
+    uint32_t source;                   ///< 0: sound detection, 1: level, 2: continuation of the previous segment
+    uint32_t start_low;                ///< Stream index of the first sample, low word
+    uint32_t start_high;               ///< Stream index of the first sample, high word
+    uint32_t length;                   ///< Samples
+    uint32_t peak;                     ///< Largest |sample| (20-bit units)
+    uint32_t rms;                      ///< RMS (20-bit units)
+    uint32_t timestamp_low;            ///< Time of the first sample in core clock cycles, low word
+    uint32_t timestamp_high;           ///< Time of the first sample, high word
+} pdm_cmd_segment_t;
+
+/** Decoded frame */
+typedef struct st_pdm_cmd_frame
+{
+    uint8_t id;                        ///< pdm_cmd_id_t
+    uint8_t sequence;                  ///< Host chosen, echoed in the acknowledgement
+    uint8_t length;                    ///< Payload bytes
+    uint8_t payload[PDM_CMD_MAX_PAYLOAD];
+} pdm_cmd_frame_t;
+
+/** Byte-wise frame decoder */
+typedef struct st_pdm_cmd_parser
+{
+    pdm_cmd_frame_t frame;             ///< Frame being received, valid when pdm_cmd_parse() returns true
+    uint8_t         sync;              ///< Sync byte to look for
+    uint8_t         position;          ///< Bytes of the current frame received
+    uint8_t         sum;               ///< Running checksum
+    uint32_t        errors;            ///< Frames rejected (bad length or checksum)
+} pdm_cmd_parser_t;
+
+/**
+ * @brief Command handler, runs in the foreground from pdm_cmd_poll()
+ * @param[in]  p_request  Request with a known ID and the payload length of that command
+ * @param[out] p_ack      Acknowledgement, preset to status OK without reply words
+ * @param[in]  p_context  Context given to pdm_cmd_open()
+ */
+typedef void (* pdm_cmd_handler_t)(pdm_cmd_frame_t const * p_request, pdm_cmd_frame_t * p_ack, void * p_context);
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Reset a decoder
+ * @param[out] p_parser  Decoder
+ * @param[in]  sync      PDM_CMD_SYNC to decode requests, PDM_CMD_ACK_SYNC to decode acknowledgements
+ */
+void pdm_cmd_parser_init(pdm_cmd_parser_t * p_parser, uint8_t sync);
+
+/**
+ * @brief Feed one byte to a decoder
+ * @param[in,out] p_parser  Decoder
+ * @param[in]     byte      Next byte of the stream
+ * @return true when p_parser->frame holds a complete frame with a valid checksum
+ */
+bool pdm_cmd_parse(pdm_cmd_parser_t * p_parser, uint8_t byte);
+
+/**
+ * @brief Encode a frame
+ * @param[in]  p_frame  Frame, length at most PDM_CMD_MAX_PAYLOAD
+ * @param[in]  sync     PDM_CMD_SYNC or PDM_CMD_ACK_SYNC
+ * @param[out] p_out    At least PDM_CMD_FRAME_MAX bytes
+ * @return Encoded bytes
+ */
+uint32_t pdm_cmd_encode(pdm_cmd_frame_t const * p_frame, uint8_t sync, uint8_t * p_out);
+
+/**
+ * @brief Request payload length of a command
+ * @param[in] id  Command ID
+ * @return Bytes, -1 for an unknown command
+ */
+int32_t pdm_cmd_request_length(uint32_t id);
+
+#if PDM_PORT_TARGET
+
+/**
+ * @brief Configure the RTT down and up channels and install the handler
+ * @param[in] p_handler  Called for every well-formed request
+ * @param[in] p_context  Passed to the handler
+ */
+void pdm_cmd_open(pdm_cmd_handler_t p_handler, void * p_context);
+
+/**
+ * @brief Decode pending host data and answer every complete request
+ * @details Unknown IDs and wrong payload lengths are answered here without calling the handler.
+ * @return Requests answered
+ */
+uint32_t pdm_cmd_poll(void);
+
+#endif
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/** Read a little-endian word */
+static inline uint32_t pdm_cmd_u32_get(uint8_t const * p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/** Append a little-endian word to a frame payload; ignored when it does not fit */
+static inline void pdm_cmd_u32_put(pdm_cmd_frame_t * p_frame, uint32_t value)
+{
+    if ((p_frame->length + 4U) <= PDM_CMD_MAX_PAYLOAD)
+    {
+        uint8_t * p = &p_frame->payload[p_frame->length];
+        p[0]            = (uint8_t) value;
+        p[1]            = (uint8_t) (value >> 8);
+        p[2]            = (uint8_t) (value >> 16);
+        p[3]            = (uint8_t) (value >> 24);
+        p_frame->length = (uint8_t) (p_frame->length + 4U);
+    }
+}
+
+FSP_FOOTER
+
+#endif /* PDM_CMD_H */
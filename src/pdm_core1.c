@@ -0,0 +1,98 @@
+/**
+ * @file pdm_core1.c
+ * @brief Both ends of the dual-core store offload: span handoff on core 0, span store on core 1
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_core1.h"
+
+#if PDM_CFG_DUAL_CORE_ENABLE
+
+ #if PDM_PORT_TARGET && !defined(BSP_SECONDARY_CORE_BUILD) && !defined(BSP_PARTITION_FLASH_CPU1_S_START)
+  #error "PDM_CFG_DUAL_CORE_ENABLE needs a CPU1 partition and a core 1 project, see the build setup in pdm_core1.h"
+ #endif
+
+/***********************************************************************************************************************
+ * Global variables
+ **********************************************************************************************************************/
+
+pdm_ipc_ring_t g_pdm_ipc_ring BSP_PLACE_IN_SECTION(PDM_IPC_SHARED_SECTION);
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Core 1 block handler: store one span into the recording core 0 handed over */
+static void pdm_core1_prv_span(pdm_ipc_block_t const * p_block, void * p_context)
+{
+    uint32_t           * p_record = (uint32_t *) pdm_ipc_shared_get((pdm_ipc_ring_t const *) p_context);
+    pdm_kernel_t const * p_kernel = pdm_kernel_select(p_block->args[PDM_CORE1_ARG_BITS]);
+    uint32_t             format   = p_block->args[PDM_CORE1_ARG_FORMAT];
+
+    if ((NULL == p_record) || (NULL == p_kernel) || (format >= (uint32_t) PDM_KERNEL_FORMAT_COUNT))
+    {
+        return;
+    }
+
+    p_kernel->store[format](p_block->samples, &p_record[p_block->args[PDM_CORE1_ARG_OFFSET]], p_block->sample_count,
+                            (int32_t) p_block->args[PDM_CORE1_ARG_GAIN]);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_core1_start(uint32_t * p_record)
+{
+    if (NULL == p_record)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    /* The ring is open before core 1 runs, so it attaches at once */
+    (void) pdm_ipc_producer_open(&g_pdm_ipc_ring, p_record);
+
+ #if PDM_PORT_TARGET && !defined(BSP_SECONDARY_CORE_BUILD)
+    R_BSP_SecondaryCoreStart();
+ #endif
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_core1_store(uint32_t const * p_raw, uint32_t count, uint32_t offset, pdm_kernel_format_t format,
+                          int32_t gain_q8, uint32_t pcm_bits)
+{
+    uint32_t args[PDM_IPC_BLOCK_ARGS] = {0U};
+
+    args[PDM_CORE1_ARG_OFFSET] = offset;
+    args[PDM_CORE1_ARG_FORMAT] = (uint32_t) format;
+    args[PDM_CORE1_ARG_GAIN]   = (uint32_t) gain_q8;
+    args[PDM_CORE1_ARG_BITS]   = pcm_bits;
+
+    return pdm_ipc_push(&g_pdm_ipc_ring, p_raw, count, args);
+}
+
+bool pdm_core1_flush(uint32_t timeout_ms)
+{
+    uint32_t start   = pdm_port_cycles();
+    uint32_t timeout = (pdm_port_cycles_per_second() / 1000U) * timeout_ms;
+
+    while (!pdm_ipc_idle(&g_pdm_ipc_ring))
+    {
+        if ((pdm_port_cycles() - start) > timeout)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void pdm_core1_main(void)
+{
+    pdm_ipc_consumer_run(&g_pdm_ipc_ring, pdm_core1_prv_span, &g_pdm_ipc_ring);
+}
+
+#endif
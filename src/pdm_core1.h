@@ -0,0 +1,99 @@
+/**
+ * @file pdm_core1.h
+ * @brief Both ends of the dual-core store offload (PDM_CFG_DUAL_CORE_ENABLE)
+ * @details Only the store conversion moves to core 1. Core 0 still captures, runs the session and the block hook and
+ *          keeps the recording's bookkeeping (gaps, settling windows, positions); every span it collects goes through
+ *          g_pdm_ipc_ring with its place in the recording and the store settings. Core 1 runs pdm_core1_main() from
+ *          its hal_entry and stores each span into the recording with the conversion kernel of the PCM width, so the
+ *          dump on core 0 reads what core 1 wrote. A span the ring has no room for is a gap. Core 0 saves the kernel
+ *          but pays a copy of each span into the ring; trigger, segment, loudness and SLM need the collection on core 0
+ *          and are refused at build time.
+ *
+ *          Build setup, which this single-core project does not have:
+ *          - the FSP configuration gives CPU1 a code flash and SRAM partition, so ra_gen/bsp_linker_info.h defines
+ *            BSP_PARTITION_FLASH_CPU1_S_START, which R_BSP_SecondaryCoreStart() boots core 1 from; without it
+ *            pdm_core1.c stops the core 0 build with an #error
+ *          - a second project for that partition compiles these sources with _RA_CORE=CPU1 (bsp_mcu_family_cfg.h then
+ *            sets BSP_SECONDARY_CORE_BUILD) and PDM_CFG_DUAL_CORE_ENABLE 1, like this one
+ *          - both linker scripts place PDM_IPC_SHARED_SECTION at the same SRAM address, uncached on both cores, so
+ *            g_pdm_ipc_ring lines up; the recording is handed over by address through the ring
+ */
+
+#ifndef PDM_CORE1_H
+#define PDM_CORE1_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_cfg.h"
+#include "pdm_ipc.h"
+#include "pdm_kernel.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Block parameters (pdm_ipc_block_t args) of a span */
+#define PDM_CORE1_ARG_OFFSET    (0U)   ///< Index in the recording of the first sample
+#define PDM_CORE1_ARG_FORMAT    (1U)   ///< pdm_kernel_format_t
+#define PDM_CORE1_ARG_GAIN      (2U)   ///< Gain, Q8
+#define PDM_CORE1_ARG_BITS      (3U)   ///< PCM width of the FIFO words
+
+#if PDM_IPC_BLOCK_ARGS < 4U
+ #error "PDM_IPC_BLOCK_ARGS is too small for the core 1 span parameters"
+#endif
+
+/***********************************************************************************************************************
+ * Exported global variables
+ **********************************************************************************************************************/
+
+#if PDM_CFG_DUAL_CORE_ENABLE
+
+/** Core 0 -> core 1 block ring, at the same address in both images */
+extern pdm_ipc_ring_t g_pdm_ipc_ring;
+
+#endif
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Open the ring over a recording buffer and start core 1 (core 0, once, before capture starts)
+ * @param[in] p_record  Recording buffer core 1 stores into, uncached on both cores
+ * @retval FSP_SUCCESS  Ring open, core 1 started
+ * @retval FSP_ERR_ASSERTION  p_record is NULL
+ */
+fsp_err_t pdm_core1_start(uint32_t * p_record);
+
+/**
+ * @brief Hand a span of FIFO words to core 1 (core 0)
+ * @param[in] p_raw     FIFO words
+ * @param[in] count     Number of samples (<= PDM_IPC_BLOCK_SAMPLES)
+ * @param[in] offset    Index in the recording of the first sample
+ * @param[in] format    Stored format
+ * @param[in] gain_q8   Gain, PDM_KERNEL_GAIN_UNITY = 0 dB
+ * @param[in] pcm_bits  PCM width of the FIFO words
+ * @retval FSP_SUCCESS         Span queued
+ * @retval FSP_ERR_QUEUE_FULL  Core 1 is behind, span dropped
+ */
+fsp_err_t pdm_core1_store(uint32_t const * p_raw, uint32_t count, uint32_t offset, pdm_kernel_format_t format,
+                          int32_t gain_q8, uint32_t pcm_bits);
+
+/**
+ * @brief Wait until core 1 has stored every queued span (core 0)
+ * @param[in] timeout_ms  Longest wait
+ * @return true if the ring is empty, false if core 1 stalled or never started
+ */
+bool pdm_core1_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Core 1 main loop: attach to the ring and store the spans forever (core 1, from hal_entry)
+ */
+void pdm_core1_main(void);
+
+FSP_FOOTER
+
+#endif /* PDM_CORE1_H */
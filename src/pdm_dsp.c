@@ -0,0 +1,386 @@
+/**
+ * @file pdm_dsp.c
+ * @brief Block processing kernels for the PDM audio path
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_dsp.h"
+#include "pdm_math.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_dsp_convert_20bit(uint32_t const * p_raw, int32_t * p_out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        /* Branch-free sign extension: flip the sign bit, then subtract its weight */
+        p_out[i] = (int32_t) ((p_raw[i] & 0x000FFFFFU) ^ 0x00080000U) - 0x00080000;
+    }
+}
+
+void pdm_dsp_pack_pcm16(int32_t const * p_in, int16_t * p_out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int32_t x = (p_in[i] + 8) >> 4;
+
+        x        = (x > INT16_MAX) ? INT16_MAX : x;
+        x        = (x < INT16_MIN) ? INT16_MIN : x;
+        p_out[i] = (int16_t) x;
+    }
+}
+
+void pdm_dsp_to_float(int32_t const * p_in, float * p_out, uint32_t count, float scale)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p_out[i] = (float) p_in[i] * scale;
+    }
+}
+
+void pdm_dsp_stats_reset(pdm_dsp_stats_t * p_stats)
+{
+    memset(p_stats, 0, sizeof(*p_stats));
+    p_stats->min = INT32_MAX;
+    p_stats->max = INT32_MIN;
+}
+
+void pdm_dsp_stats_update(pdm_dsp_stats_t * p_stats, int32_t const * p_in, uint32_t count)
+{
+    int32_t  min         = p_stats->min;
+    int32_t  max         = p_stats->max;
+    int64_t  sum         = 0;
+    uint64_t sum_squares = 0U;
+    uint32_t clipped     = 0U;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int32_t x = p_in[i];
+
+        min          = (x < min) ? x : min;
+        max          = (x > max) ? x : max;
+        sum         += x;
+        sum_squares += (uint64_t) ((int64_t) x * x);
+        clipped     += ((x >= PDM_DSP_20BIT_MAX) || (x <= PDM_DSP_20BIT_MIN)) ? 1U : 0U;
+    }
+
+    p_stats->min          = min;
+    p_stats->max          = max;
+    p_stats->sum         += sum;
+    p_stats->sum_squares += sum_squares;
+    p_stats->clipped     += clipped;
+    p_stats->count       += count;
+}
+
+uint32_t pdm_dsp_stats_rms(pdm_dsp_stats_t const * p_stats)
+{
+    if (0U == p_stats->count)
+    {
+        return 0U;
+    }
+
+    return (uint32_t) sqrt((double) p_stats->sum_squares / (double) p_stats->count);
+}
+
+fsp_err_t pdm_dsp_dc_block_init(pdm_dsp_dc_block_t * p_ctrl, uint32_t pole_q15)
+{
+    if (NULL == p_ctrl)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if (pole_q15 >= 32768U)
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    p_ctrl->pole_q15 = (int32_t) pole_q15;
+    p_ctrl->x1       = 0;
+    p_ctrl->y1       = 0;
+
+    return FSP_SUCCESS;
+}
+
+void pdm_dsp_dc_block(pdm_dsp_dc_block_t * p_ctrl, int32_t const * p_in, int32_t * p_out, uint32_t count)
+{
+    int32_t pole = p_ctrl->pole_q15;
+    int32_t x1   = p_ctrl->x1;
+    int32_t y1   = p_ctrl->y1;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int32_t x = p_in[i];
+
+        y1       = (x - x1) + (int32_t) (((int64_t) y1 * pole) >> 15);
+        x1       = x;
+        p_out[i] = y1;
+    }
+
+    p_ctrl->x1 = x1;
+    p_ctrl->y1 = y1;
+}
+
+fsp_err_t pdm_dsp_biquad_design(pdm_dsp_biquad_coeffs_t * p_coeffs, pdm_dsp_biquad_type_t type, float frequency_hz,
+                                float q, float sample_rate_hz)
+{
+    if (NULL == p_coeffs)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if (!(frequency_hz > 0.0f) || !(frequency_hz < (0.5f * sample_rate_hz)) || !(q > 0.0f))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    float s;
+    float c;
+    pdm_math_sincosf(PDM_MATH_TWO_PI * frequency_hz / sample_rate_hz, &s, &c);
+
+    float alpha = s / (2.0f * q);
+    float a0    = 1.0f + alpha;
+
+    switch (type)
+    {
+        case PDM_DSP_BIQUAD_HIGHPASS:
+        {
+            p_coeffs->b0 = 0.5f * (1.0f + c) / a0;
+            p_coeffs->b1 = -(1.0f + c) / a0;
+            p_coeffs->b2 = p_coeffs->b0;
+            break;
+        }
+
+        case PDM_DSP_BIQUAD_BANDPASS:
+        {
+            p_coeffs->b0 = alpha / a0;
+            p_coeffs->b1 = 0.0f;
+            p_coeffs->b2 = -alpha / a0;
+            break;
+        }
+
+        case PDM_DSP_BIQUAD_LOWPASS:
+        default:
+        {
+            p_coeffs->b0 = 0.5f * (1.0f - c) / a0;
+            p_coeffs->b1 = (1.0f - c) / a0;
+            p_coeffs->b2 = p_coeffs->b0;
+            break;
+        }
+    }
+
+    p_coeffs->a1 = -2.0f * c / a0;
+    p_coeffs->a2 = (1.0f - alpha) / a0;
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_dsp_biquad_init(pdm_dsp_biquad_t * p_ctrl, pdm_dsp_biquad_coeffs_t const * p_coeffs, uint32_t stages)
+{
+    if ((NULL == p_ctrl) || (NULL == p_coeffs))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((0U == stages) || (stages > PDM_DSP_BIQUAD_MAX_STAGES))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    memcpy(p_ctrl->coeffs, p_coeffs, stages * sizeof(p_coeffs[0]));
+    p_ctrl->stages = stages;
+
+    return FSP_SUCCESS;
+}
+
+void pdm_dsp_biquad_process(pdm_dsp_biquad_t * p_ctrl, float const * p_in, float * p_out, uint32_t count)
+{
+    /* One pass per section keeps the coefficients and state in registers */
+    for (uint32_t stage = 0; stage < p_ctrl->stages; stage++)
+    {
+        pdm_dsp_biquad_coeffs_t const * p_c = &p_ctrl->coeffs[stage];
+
+        float b0 = p_c->b0;
+        float b1 = p_c->b1;
+        float b2 = p_c->b2;
+        float a1 = p_c->a1;
+        float a2 = p_c->a2;
+        float s0 = p_ctrl->state[stage][0];
+        float s1 = p_ctrl->state[stage][1];
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float x = p_in[i];
+            float y = b0 * x + s0;
+
+            s0       = b1 * x - a1 * y + s1;
+            s1       = b2 * x - a2 * y;
+            p_out[i] = y;
+        }
+
+        p_ctrl->state[stage][0] = s0;
+        p_ctrl->state[stage][1] = s1;
+        p_in                    = p_out;
+    }
+}
+
+fsp_err_t pdm_dsp_fir_lowpass(float * p_taps, uint32_t taps, float cutoff_hz, float sample_rate_hz)
+{
+    if (NULL == p_taps)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((taps < 2U) || !(cutoff_hz > 0.0f) || !(cutoff_hz < (0.5f * sample_rate_hz)))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    float fc     = cutoff_hz / sample_rate_hz;
+    float center = 0.5f * (float) (taps - 1U);
+    float sum    = 0.0f;
+
+    pdm_math_window(PDM_MATH_WINDOW_HAMMING, p_taps, taps);
+
+    for (uint32_t i = 0; i < taps; i++)
+    {
+        float t    = (float) i - center;
+        float sinc = (fabsf(t) < 1.0e-6f) ? (2.0f * fc) : (pdm_math_sinf(PDM_MATH_TWO_PI * fc * t) / (PDM_MATH_PI * t));
+
+        p_taps[i] *= sinc;
+        sum       += p_taps[i];
+    }
+
+    for (uint32_t i = 0; i < taps; i++)
+    {
+        p_taps[i] /= sum;
+    }
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_dsp_fir_init(pdm_dsp_fir_t * p_ctrl, float const * p_taps, float * p_state, uint32_t taps)
+{
+    if ((NULL == p_ctrl) || (NULL == p_taps) || (NULL == p_state))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if (0U == taps)
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    p_ctrl->p_taps  = p_taps;
+    p_ctrl->p_state = p_state;
+    p_ctrl->taps    = taps;
+    p_ctrl->index   = 0U;
+    memset(p_state, 0, 2U * taps * sizeof(float));
+
+    return FSP_SUCCESS;
+}
+
+void pdm_dsp_fir_process(pdm_dsp_fir_t * p_ctrl, float const * p_in, float * p_out, uint32_t count)
+{
+    float const * p_taps  = p_ctrl->p_taps;
+    float       * p_state = p_ctrl->p_state;
+    uint32_t      taps    = p_ctrl->taps;
+    uint32_t      index   = p_ctrl->index;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        /* Newest sample goes in front of the previous one; the mirror copy keeps p_state[index..index+taps) linear */
+        index                 = ((0U == index) ? taps : index) - 1U;
+        p_state[index]        = p_in[i];
+        p_state[index + taps] = p_in[i];
+
+        float const * p_x = &p_state[index];
+        float         acc = 0.0f;
+
+        for (uint32_t k = 0; k < taps; k++)
+        {
+            acc += p_taps[k] * p_x[k];
+        }
+
+        p_out[i] = acc;
+    }
+
+    p_ctrl->index = index;
+}
+
+fsp_err_t pdm_dsp_fft_init(pdm_dsp_fft_t * p_ctrl, float * p_twiddle, uint32_t size)
+{
+    if ((NULL == p_ctrl) || (NULL == p_twiddle))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((size < 2U) || (0U != (size & (size - 1U))))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    float step = -PDM_MATH_TWO_PI / (float) size;
+
+    for (uint32_t k = 0; k < (size / 2U); k++)
+    {
+        pdm_math_sincosf(step * (float) k, &p_twiddle[(2U * k) + 1U], &p_twiddle[2U * k]);
+    }
+
+    p_ctrl->p_twiddle = p_twiddle;
+    p_ctrl->size      = size;
+
+    return FSP_SUCCESS;
+}
+
+void pdm_dsp_fft(pdm_dsp_fft_t const * p_ctrl, float const * p_in, float * p_out)
+{
+    uint32_t      size      = p_ctrl->size;
+    float const * p_twiddle = p_ctrl->p_twiddle;
+
+    /* Bit-reversed copy, counting j in reversed bit order */
+    uint32_t j = 0U;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        p_out[2U * j]        = p_in[2U * i];
+        p_out[(2U * j) + 1U] = p_in[(2U * i) + 1U];
+
+        uint32_t bit = size >> 1;
+        while (0U != (j & bit))
+        {
+            j   ^= bit;
+            bit >>= 1;
+        }
+
+        j |= bit;
+    }
+
+    /* Decimation-in-time butterflies */
+    for (uint32_t half = 1U; half < size; half *= 2U)
+    {
+        uint32_t stride = size / (2U * half);
+
+        for (uint32_t start = 0; start < size; start += 2U * half)
+        {
+            for (uint32_t k = 0; k < half; k++)
+            {
+                float * p_a = &p_out[2U * (start + k)];
+                float * p_b = &p_out[2U * (start + k + half)];
+                float   wr  = p_twiddle[2U * k * stride];
+                float   wi  = p_twiddle[(2U * k * stride) + 1U];
+                float   vr  = p_b[0] * wr - p_b[1] * wi;
+                float   vi  = p_b[0] * wi + p_b[1] * wr;
+
+                p_b[0]  = p_a[0] - vr;
+                p_b[1]  = p_a[1] - vi;
+                p_a[0] += vr;
+                p_a[1] += vi;
+            }
+        }
+    }
+}
@@ -0,0 +1,256 @@
+/**
+ * @file pdm_dsp.h
+ * @brief Block processing kernels for the PDM audio path
+ * @details Portable (target and host) kernels that turn raw PDM FIFO words into analysed and filtered PCM:
+ *          20-bit conversion, 16-bit packing, level statistics, DC blocking, float conversion, biquad cascades, FIR
+ *          filters and the FFT. Every kernel works on a block and keeps its history in a caller-owned state structure,
+ *          so blocks of any size can be chained. Input and output of the filter kernels may be the same buffer.
+ */
+
+#ifndef PDM_DSP_H
+#define PDM_DSP_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Range of a 20-bit PDM sample */
+#define PDM_DSP_20BIT_MAX            (0x0007FFFF)
+#define PDM_DSP_20BIT_MIN            (-0x00080000)
+
+/** Largest cascade handled by pdm_dsp_biquad_t */
+#define PDM_DSP_BIQUAD_MAX_STAGES    (4U)
+
+/** Default DC blocker pole (Q15): 0.995, -3 dB at about 26 Hz for 32 kHz */
+#define PDM_DSP_DC_BLOCK_POLE_Q15    (32604U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Level statistics accumulated over any number of blocks */
+typedef struct st_pdm_dsp_stats
+{
+    int32_t  min;                      ///< Smallest sample
+    int32_t  max;                      ///< Largest sample
+    int64_t  sum;                      ///< Sum of samples (DC = sum / count)
+    uint64_t sum_squares;              ///< Sum of squared samples
+    uint32_t clipped;                  ///< Samples at the 20-bit limits
+    uint32_t count;                    ///< Samples accumulated
+} pdm_dsp_stats_t;
+
+/** First-order DC blocker y[n] = x[n] - x[n-1] + pole * y[n-1] */
+typedef struct st_pdm_dsp_dc_block
+{
+    int32_t  pole_q15;                 ///< Pole in Q15
+    int32_t  x1;                       ///< Previous input
+    int32_t  y1;                       ///< Previous output
+} pdm_dsp_dc_block_t;
+
+/** Biquad responses of pdm_dsp_biquad_design() */
+typedef enum e_pdm_dsp_biquad_type
+{
+    PDM_DSP_BIQUAD_LOWPASS,            ///< Second-order low pass
+    PDM_DSP_BIQUAD_HIGHPASS,           ///< Second-order high pass
+    PDM_DSP_BIQUAD_BANDPASS,           ///< Band pass, 0 dB peak gain
+} pdm_dsp_biquad_type_t;
+
+/** Coefficients of one section, normalized so a0 = 1 */
+typedef struct st_pdm_dsp_biquad_coeffs
+{
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+} pdm_dsp_biquad_coeffs_t;
+
+/** Cascade of biquad sections (transposed direct form II) */
+typedef struct st_pdm_dsp_biquad
+{
+    uint32_t                stages;                                ///< Sections in use
+    pdm_dsp_biquad_coeffs_t coeffs[PDM_DSP_BIQUAD_MAX_STAGES];     ///< Section coefficients
+    float                   state[PDM_DSP_BIQUAD_MAX_STAGES][2];   ///< Section delay elements
+} pdm_dsp_biquad_t;
+
+/** Radix-2 complex FFT over a caller-supplied twiddle table */
+typedef struct st_pdm_dsp_fft
+{
+    float const * p_twiddle;           ///< size / 2 complex factors exp(-j 2 pi k / size), interleaved re, im
+    uint32_t      size;                ///< Points, a power of two
+} pdm_dsp_fft_t;
+
+/** FIR filter over a caller-supplied tap array and delay line */
+typedef struct st_pdm_dsp_fir
+{
+    float const * p_taps;              ///< Taps, p_taps[0] applies to the newest sample
+    float       * p_state;             ///< Delay line of 2 * taps entries (mirrored, so no wrap in the inner loop)
+    uint32_t      taps;                ///< Tap count
+    uint32_t      index;               ///< Position of the newest sample in p_state
+} pdm_dsp_fir_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Sign-extend raw 20-bit FIFO words
+ * @param[in]  p_raw   FIFO words (upper 12 bits ignored)
+ * @param[out] p_out   Signed samples
+ * @param[in]  count   Number of samples
+ */
+void pdm_dsp_convert_20bit(uint32_t const * p_raw, int32_t * p_out, uint32_t count);
+
+/**
+ * @brief Reduce 20-bit samples to 16-bit PCM (rounded, saturated)
+ * @param[in]  p_in    20-bit samples
+ * @param[out] p_out   16-bit samples
+ * @param[in]  count   Number of samples
+ */
+void pdm_dsp_pack_pcm16(int32_t const * p_in, int16_t * p_out, uint32_t count);
+
+/**
+ * @brief Scale signed samples to float
+ * @param[in]  p_in    Samples
+ * @param[out] p_out   p_in * scale
+ * @param[in]  count   Number of samples
+ * @param[in]  scale   Factor, e.g. 1/2^19 for full scale = 1.0
+ */
+void pdm_dsp_to_float(int32_t const * p_in, float * p_out, uint32_t count, float scale);
+
+/**
+ * @brief Clear accumulated statistics
+ * @param[out] p_stats  Statistics
+ */
+void pdm_dsp_stats_reset(pdm_dsp_stats_t * p_stats);
+
+/**
+ * @brief Add a block to the statistics
+ * @param[in,out] p_stats  Statistics
+ * @param[in]     p_in     Samples
+ * @param[in]     count    Number of samples
+ */
+void pdm_dsp_stats_update(pdm_dsp_stats_t * p_stats, int32_t const * p_in, uint32_t count);
+
+/**
+ * @brief RMS of the accumulated samples
+ * @param[in] p_stats  Statistics
+ * @return RMS in sample units (0 if empty)
+ */
+uint32_t pdm_dsp_stats_rms(pdm_dsp_stats_t const * p_stats);
+
+/**
+ * @brief Initialize a DC blocker
+ * @param[out] p_ctrl    State
+ * @param[in]  pole_q15  Pole in Q15, below 32768 (PDM_DSP_DC_BLOCK_POLE_Q15 by default)
+ * @retval FSP_SUCCESS               Initialized
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Pole out of range
+ */
+fsp_err_t pdm_dsp_dc_block_init(pdm_dsp_dc_block_t * p_ctrl, uint32_t pole_q15);
+
+/**
+ * @brief Remove DC from a block
+ * @param[in,out] p_ctrl  State
+ * @param[in]     p_in    Samples
+ * @param[out]    p_out   Filtered samples (may equal p_in)
+ * @param[in]     count   Number of samples
+ */
+void pdm_dsp_dc_block(pdm_dsp_dc_block_t * p_ctrl, int32_t const * p_in, int32_t * p_out, uint32_t count);
+
+/**
+ * @brief Design one biquad section (RBJ cookbook)
+ * @param[out] p_coeffs     Coefficients
+ * @param[in]  type         Response
+ * @param[in]  frequency_hz Corner or center frequency
+ * @param[in]  q            Quality factor (0.7071 for Butterworth)
+ * @param[in]  sample_rate_hz Sample rate
+ * @retval FSP_SUCCESS               Designed
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Frequency not in (0, fs/2) or q not positive
+ */
+fsp_err_t pdm_dsp_biquad_design(pdm_dsp_biquad_coeffs_t * p_coeffs, pdm_dsp_biquad_type_t type, float frequency_hz,
+                                float q, float sample_rate_hz);
+
+/**
+ * @brief Load a cascade and clear its state
+ * @param[out] p_ctrl    Cascade
+ * @param[in]  p_coeffs  Section coefficients, applied in order
+ * @param[in]  stages    Number of sections, 1..PDM_DSP_BIQUAD_MAX_STAGES
+ * @retval FSP_SUCCESS               Initialized
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Stage count out of range
+ */
+fsp_err_t pdm_dsp_biquad_init(pdm_dsp_biquad_t * p_ctrl, pdm_dsp_biquad_coeffs_t const * p_coeffs, uint32_t stages);
+
+/**
+ * @brief Filter a block through the cascade
+ * @param[in,out] p_ctrl  Cascade
+ * @param[in]     p_in    Samples
+ * @param[out]    p_out   Filtered samples (may equal p_in)
+ * @param[in]     count   Number of samples
+ */
+void pdm_dsp_biquad_process(pdm_dsp_biquad_t * p_ctrl, float const * p_in, float * p_out, uint32_t count);
+
+/**
+ * @brief Design a windowed-sinc (Hamming) low-pass FIR with unity DC gain
+ * @param[out] p_taps          Taps
+ * @param[in]  taps            Tap count (odd gives a symmetric type I filter)
+ * @param[in]  cutoff_hz       -6 dB frequency
+ * @param[in]  sample_rate_hz  Sample rate
+ * @retval FSP_SUCCESS               Designed
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Fewer than 2 taps or cutoff not in (0, fs/2)
+ */
+fsp_err_t pdm_dsp_fir_lowpass(float * p_taps, uint32_t taps, float cutoff_hz, float sample_rate_hz);
+
+/**
+ * @brief Bind taps and a delay line to a FIR filter and clear the delay line
+ * @param[out] p_ctrl   Filter
+ * @param[in]  p_taps   Taps (kept by reference)
+ * @param[in]  p_state  Delay line of 2 * taps floats (kept by reference)
+ * @param[in]  taps     Tap count
+ * @retval FSP_SUCCESS               Initialized
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  No taps
+ */
+fsp_err_t pdm_dsp_fir_init(pdm_dsp_fir_t * p_ctrl, float const * p_taps, float * p_state, uint32_t taps);
+
+/**
+ * @brief Filter a block
+ * @param[in,out] p_ctrl  Filter
+ * @param[in]     p_in    Samples
+ * @param[out]    p_out   Filtered samples (may equal p_in)
+ * @param[in]     count   Number of samples
+ */
+void pdm_dsp_fir_process(pdm_dsp_fir_t * p_ctrl, float const * p_in, float * p_out, uint32_t count);
+
+/**
+ * @brief Fill the twiddle table of an FFT size
+ * @param[out] p_ctrl     FFT
+ * @param[out] p_twiddle  Table of size floats (kept by reference)
+ * @param[in]  size       Points, a power of two >= 2
+ * @retval FSP_SUCCESS               Initialized
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Size not a power of two >= 2
+ */
+fsp_err_t pdm_dsp_fft_init(pdm_dsp_fft_t * p_ctrl, float * p_twiddle, uint32_t size);
+
+/**
+ * @brief Forward FFT, not normalized
+ * @param[in]  p_ctrl  FFT
+ * @param[in]  p_in    size complex inputs, interleaved re, im
+ * @param[out] p_out   size complex outputs, interleaved re, im (must not overlap p_in)
+ */
+void pdm_dsp_fft(pdm_dsp_fft_t const * p_ctrl, float const * p_in, float * p_out);
+
+FSP_FOOTER
+
+#endif /* PDM_DSP_H */
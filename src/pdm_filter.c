@@ -0,0 +1,227 @@
+/**
+ * @file pdm_filter.c
+ * @brief Hot swap of the PDM filter chain during capture
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_filter.h"
+#include "pdm_mem.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/* Polls of the channel state after the stop trigger, as in R_PDM_Close() */
+#define PDM_FILTER_STOP_LOOP_MAX    (1000U)
+
+/* HPF feedback coefficient k1 is Q14 */
+#define PDM_FILTER_HPF_ONE_Q14      (16384U)
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Filter registers, in the order and layout used by R_PDM_Open() */
+PDM_MEM_FAST_CODE static void pdm_filter_prv_program(pdm_filter_ctrl_t * p_ctrl)
+{
+    R_PDM_CH_Type            * p_reg = p_ctrl->p_pdm->p_reg;
+    pdm_extended_cfg_t const * p_ext = &p_ctrl->active;
+    pdm_cfg_t const          * p_cfg = &p_ctrl->cfg;
+
+    uint32_t pdmdsr = (uint32_t) p_cfg->pcm_width << R_PDM_CH_PDMDSR_DBIS_Pos;
+    pdmdsr |= (uint32_t) p_ext->sinc_filter_mode << R_PDM_CH_PDMDSR_SFMD_Pos;
+    pdmdsr |= (uint32_t) p_ext->moving_average_mode << R_PDM_CH_PDMDSR_SDMAMD_Pos;
+    pdmdsr |= (uint32_t) p_ext->low_pass_filter_shift << R_PDM_CH_PDMDSR_LFIS_Pos;
+    pdmdsr |= (uint32_t) p_ext->compensation_filter_shift << R_PDM_CH_PDMDSR_CFIS_Pos;
+    pdmdsr |= (uint32_t) p_ext->high_pass_filter_shift << R_PDM_CH_PDMDSR_HFIS_Pos;
+    pdmdsr |= (uint32_t) p_cfg->pcm_edge << R_PDM_CH_PDMDSR_INPSEL_Pos;
+    p_reg->PDMDSR = pdmdsr;
+
+    p_reg->PDSFCR = ((uint32_t) p_ext->sincrng << R_PDM_CH_PDSFCR_SINCRNG_Pos) |
+                    ((uint32_t) p_ext->sincdec << R_PDM_CH_PDSFCR_SINCDEC_Pos) |
+                    ((uint32_t) p_ext->clock_div << R_PDM_CH_PDSFCR_CKDIV_Pos);
+
+    p_reg->PDHFCS0R = (uint32_t) p_ext->hpf_coefficient_s0;
+    p_reg->PDHFCK1R = (uint32_t) p_ext->hpf_coefficient_k1;
+    for (uint32_t i = 0U; i < PDM_NUM_HPF_COEFFICIENT_H; i++)
+    {
+        p_reg->PDHFCHR[i] = (uint32_t) p_ext->hpf_coefficient_h[i];
+    }
+
+    for (uint32_t i = 0U; i < PDM_NUM_COMPENSATION_FILTER_COEFFICIENT_H; i++)
+    {
+        p_reg->PDCFCHR[i] = (uint32_t) p_ext->compensation_filter_coefficient_h[i];
+    }
+
+    p_reg->PDLFCH010R = (uint32_t) p_ext->lpf_coefficient_h0;
+    for (uint32_t i = 0U; i < PDM_NUM_LPF_FILTER_COEFFICIENT_H1; i++)
+    {
+        p_reg->PDLFCH1R[i] = (uint32_t) p_ext->lpf_coefficient_h1[i];
+    }
+}
+
+/* Copy the filter fields of a set; everything else stays as opened */
+static void pdm_filter_prv_copy(pdm_extended_cfg_t * p_dest, pdm_extended_cfg_t const * p_src)
+{
+    p_dest->moving_average_mode       = p_src->moving_average_mode;
+    p_dest->low_pass_filter_shift     = p_src->low_pass_filter_shift;
+    p_dest->compensation_filter_shift = p_src->compensation_filter_shift;
+    p_dest->high_pass_filter_shift    = p_src->high_pass_filter_shift;
+    p_dest->sinc_filter_mode          = p_src->sinc_filter_mode;
+    p_dest->sincrng                   = p_src->sincrng;
+    p_dest->sincdec                   = p_src->sincdec;
+    p_dest->hpf_coefficient_s0        = p_src->hpf_coefficient_s0;
+    p_dest->hpf_coefficient_k1        = p_src->hpf_coefficient_k1;
+    p_dest->lpf_coefficient_h0        = p_src->lpf_coefficient_h0;
+
+    memcpy(p_dest->hpf_coefficient_h, p_src->hpf_coefficient_h, sizeof(p_dest->hpf_coefficient_h));
+    memcpy(p_dest->compensation_filter_coefficient_h, p_src->compensation_filter_coefficient_h,
+           sizeof(p_dest->compensation_filter_coefficient_h));
+    memcpy(p_dest->lpf_coefficient_h1, p_src->lpf_coefficient_h1, sizeof(p_dest->lpf_coefficient_h1));
+}
+
+/* Stop filtering, reprogram, restart. Returns the old-filter samples left in the FIFO. */
+PDM_MEM_FAST_CODE static uint32_t pdm_filter_prv_swap(pdm_filter_ctrl_t * p_ctrl)
+{
+    R_PDM_CH_Type * p_reg = p_ctrl->p_pdm->p_reg;
+
+    p_reg->PDSTPTR = R_PDM_CH_PDSTPTR_STPTRG_Msk;
+
+    for (uint32_t loop = 0U; loop < PDM_FILTER_STOP_LOOP_MAX; loop++)
+    {
+        if (0U == (p_reg->PDSR & R_PDM_CH_PDSR_STATE_Msk))
+        {
+            break;
+        }
+    }
+
+    uint32_t residue = p_reg->PDDSR;
+
+    pdm_filter_prv_copy(&p_ctrl->active, &p_ctrl->staged);
+    pdm_filter_prv_program(p_ctrl);
+
+    p_reg->PDSTRTR = R_PDM_CH_PDSTRTR_STRTRG_Msk;
+
+    return residue;
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_filter_open(pdm_filter_ctrl_t * p_ctrl, pdm_instance_ctrl_t * p_pdm)
+{
+    if ((NULL == p_ctrl) || (NULL == p_pdm) || (NULL == p_pdm->p_cfg) || (NULL == p_pdm->p_cfg->p_extend))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->p_pdm  = p_pdm;
+    p_ctrl->cfg    = *p_pdm->p_cfg;
+    p_ctrl->active = *(pdm_extended_cfg_t const *) p_pdm->p_cfg->p_extend;
+    p_ctrl->staged = p_ctrl->active;
+
+    p_ctrl->cfg.p_extend = &p_ctrl->active;
+    p_pdm->p_cfg         = &p_ctrl->cfg;
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_filter_stage(pdm_filter_ctrl_t * p_ctrl, pdm_extended_cfg_t const * p_filters)
+{
+    if ((NULL == p_ctrl) || (NULL == p_filters))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((p_filters->sinc_filter_mode < PDM_SINC_FILTER_MODE_1) ||
+        (p_filters->sinc_filter_mode > PDM_SINC_FILTER_MODE_4) || (0U == p_filters->sincdec) ||
+        (p_filters->clock_div != p_ctrl->active.clock_div) ||
+        (p_filters->interrupt_threshold != p_ctrl->active.interrupt_threshold))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    if (p_ctrl->pending)
+    {
+        return FSP_ERR_IN_USE;
+    }
+
+    pdm_filter_prv_copy(&p_ctrl->staged, p_filters);
+
+    /* Not capturing: no block boundary will come, reprogram now and count settling from the next start */
+    if (0U == p_ctrl->p_pdm->p_reg->PDDRCR)
+    {
+        uint32_t start = pdm_port_cycles();
+        (void) pdm_filter_prv_swap(p_ctrl);
+
+        p_ctrl->last.sequence++;
+        p_ctrl->last.settling     = pdm_filter_settling_samples(&p_ctrl->active);
+        p_ctrl->last.first_sample = 0U;
+        p_ctrl->last.first_valid  = p_ctrl->last.settling;
+        p_ctrl->last.sincdec      = p_ctrl->active.sincdec;
+        p_ctrl->last.cycles       = pdm_port_cycles() - start;
+
+        return FSP_SUCCESS;
+    }
+
+    /* The data callback must see the whole set before the flag */
+    pdm_port_memory_barrier();
+    p_ctrl->pending = true;
+
+    return FSP_SUCCESS;
+}
+
+PDM_MEM_FAST_CODE bool pdm_filter_block_boundary(pdm_filter_ctrl_t * p_ctrl, uint64_t next_index)
+{
+    if (!p_ctrl->pending)
+    {
+        return false;
+    }
+
+    uint32_t start   = pdm_port_cycles();
+    uint32_t residue = pdm_filter_prv_swap(p_ctrl);
+
+    /* The driver has already read rx_int_count samples of the next block; the FIFO residue follows them */
+    pdm_filter_swap_t * p_swap = &p_ctrl->last;
+    p_swap->sequence++;
+    p_swap->settling     = pdm_filter_settling_samples(&p_ctrl->active);
+    p_swap->first_sample = next_index + p_ctrl->p_pdm->rx_int_count + residue;
+    p_swap->first_valid  = p_swap->first_sample + p_swap->settling;
+    p_swap->sincdec      = p_ctrl->active.sincdec;
+    p_swap->cycles       = pdm_port_cycles() - start;
+
+    p_ctrl->pending = false;
+
+    return true;
+}
+
+void pdm_filter_swap_get(pdm_filter_ctrl_t const * p_ctrl, pdm_filter_swap_t * p_swap)
+{
+    FSP_CRITICAL_SECTION_DEFINE;
+    FSP_CRITICAL_SECTION_ENTER;
+    *p_swap = p_ctrl->last;
+    FSP_CRITICAL_SECTION_EXIT;
+}
+
+uint32_t pdm_filter_settling_samples(pdm_extended_cfg_t const * p_filters)
+{
+    /* History at the sinc output rate: a sinc of order N settles after N outputs, each FIR after its length */
+    uint32_t sinc_rate = (uint32_t) p_filters->sinc_filter_mode + (PDM_FILTER_COMPENSATION_TAPS - 1U) +
+                         (PDM_FILTER_LPF_TAPS - 1U);
+
+#if PDM_CFG_FILTER_HPF_SETTLE_TAU > 0
+    uint32_t k1 = p_filters->hpf_coefficient_k1 & 0x7FFFU;
+    if (k1 < PDM_FILTER_HPF_ONE_Q14)
+    {
+        /* First-order IIR, time constant 1 / (1 - k1) samples */
+        sinc_rate += (PDM_CFG_FILTER_HPF_SETTLE_TAU * PDM_FILTER_HPF_ONE_Q14) / (PDM_FILTER_HPF_ONE_Q14 - k1);
+    }
+#endif
+
+    return (sinc_rate + PDM_FILTER_LPF_DECIMATION - 1U) / PDM_FILTER_LPF_DECIMATION;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file pdm_filter.h
+ * @brief Hot swap of the PDM filter chain (sinc decimation, HPF, compensation and LPF coefficients) during capture
+ * @details R_PDM_Open() is the only driver entry point that programs the filters, so changing them used to mean
+ *          Close, Open and the full startup delay. This module stages a new filter set and programs it directly into
+ *          the channel at the next block boundary, from the data callback:
+ *          1. stop the channel's filtering (PDSTPTR) and wait for it to halt at the next frame boundary
+ *          2. read how many old-filter samples are still in the FIFO (PDDSR); the driver reads them into the stream
+ *          3. write the filter registers exactly as R_PDM_Open() does and restart filtering (PDSTRTR)
+ *
+ *          Data reception, interrupts and the capture ring are left running. The swap result tells exactly where the
+ *          new filters start in the stream and how many of their outputs to discard:
+ *          - first_sample: stream index of the first new-filter output (the samples already read into the next block
+ *            plus the FIFO residue follow the block boundary)
+ *          - first_valid:  first_sample + pdm_filter_settling_samples(), the first fully settled output
+ *
+ *          Settling is the shortest history that fills every stage: sinc order plus the compensation and half-band
+ *          lengths at the sinc rate, halved by the LPF decimation, plus PDM_CFG_FILTER_HPF_SETTLE_TAU time constants of
+ *          the HPF (0: the HPF's DC decay is not waited for).
+ *
+ *          The PDM clock divider and the interrupt threshold cannot change this way (they affect the microphone and
+ *          the driver); a different sincdec changes the output rate by old / new.
+ */
+
+#ifndef PDM_FILTER_H
+#define PDM_FILTER_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "hal_data.h"
+#include "pdm_port.h"
+#include "pdm_cfg.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Taps of the symmetric compensation FIR and of the half-band LPF (h1 at the odd offsets around h0) */
+#define PDM_FILTER_COMPENSATION_TAPS    (PDM_NUM_COMPENSATION_FILTER_COEFFICIENT_H)
+#define PDM_FILTER_LPF_TAPS             ((2U * PDM_NUM_LPF_FILTER_COEFFICIENT_H1) - 1U)
+
+/** LPF decimation: the sinc output rate is twice the PCM rate */
+#define PDM_FILTER_LPF_DECIMATION       (2U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Result of one swap */
+typedef struct st_pdm_filter_swap
+{
+    uint32_t sequence;                 ///< Swaps applied so far, this one included
+    uint32_t settling;                 ///< Outputs to discard after first_sample
+    uint64_t first_sample;             ///< Stream index of the first output of the new filters
+    uint64_t first_valid;              ///< Stream index of the first settled output
+    uint32_t sincdec;                  ///< New sinc decimation ratio
+    uint32_t cycles;                   ///< Time the channel was reprogrammed for
+} pdm_filter_swap_t;
+
+/** Filter control */
+typedef struct st_pdm_filter_ctrl
+{
+    pdm_instance_ctrl_t * p_pdm;       ///< Driver instance
+    pdm_cfg_t             cfg;         ///< Driver configuration in use, p_extend points to active
+    pdm_extended_cfg_t    active;      ///< Filters programmed in the channel
+    pdm_extended_cfg_t    staged;      ///< Filters waiting for the next block boundary
+    volatile bool         pending;     ///< staged waits to be applied
+    pdm_filter_swap_t     last;        ///< Last swap (sequence 0: none yet)
+} pdm_filter_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Take over the filter configuration of an open driver instance
+ * @details The driver's configuration pointer is redirected to a copy held here, so Start and a later Open use the
+ *          swapped filters too.
+ * @param[out] p_ctrl  Filter control
+ * @param[in]  p_pdm   Open driver instance
+ * @retval FSP_SUCCESS         Ready
+ * @retval FSP_ERR_ASSERTION   NULL pointer or the driver has no extended configuration
+ */
+fsp_err_t pdm_filter_open(pdm_filter_ctrl_t * p_ctrl, pdm_instance_ctrl_t * p_pdm);
+
+/**
+ * @brief Stage a new filter set (foreground)
+ * @details While capturing, the set is applied by pdm_filter_block_boundary() at the next data callback; otherwise it
+ *          is applied at once and its settling counts from the start of the next capture.
+ * @param[in] p_ctrl     Filter control
+ * @param[in] p_filters  New configuration; only the filter fields are used
+ * @retval FSP_SUCCESS               Staged or applied
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Sinc order or decimation out of range, or the clock divider or interrupt
+ *                                   threshold differ from the active set
+ * @retval FSP_ERR_IN_USE            The previous set is still waiting
+ */
+fsp_err_t pdm_filter_stage(pdm_filter_ctrl_t * p_ctrl, pdm_extended_cfg_t const * p_filters);
+
+/**
+ * @brief Apply a staged set; call from the data callback (interrupt context)
+ * @param[in] p_ctrl      Filter control
+ * @param[in] next_index  Stream index of the first sample of the block after the one just completed
+ * @return true if a swap was applied
+ */
+bool pdm_filter_block_boundary(pdm_filter_ctrl_t * p_ctrl, uint64_t next_index);
+
+/**
+ * @brief Last swap
+ * @param[in]  p_ctrl  Filter control
+ * @param[out] p_swap  Copy of the last swap, sequence 0 if there was none
+ */
+void pdm_filter_swap_get(pdm_filter_ctrl_t const * p_ctrl, pdm_filter_swap_t * p_swap);
+
+/**
+ * @brief Outputs to discard after the filters (re)start
+ * @param[in] p_filters  Filter set
+ * @return PCM samples
+ */
+uint32_t pdm_filter_settling_samples(pdm_extended_cfg_t const * p_filters);
+
+FSP_FOOTER
+
+#endif /* PDM_FILTER_H */
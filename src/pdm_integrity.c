@@ -0,0 +1,186 @@
+/**
+ * @file pdm_integrity.c
+ * @brief Capture integrity telemetry
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_integrity.h"
+#include "pdm_mem.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_INTEGRITY_PRV_EVENT_MASK    (PDM_INTEGRITY_EVENTS - 1U)
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_integrity_open(pdm_integrity_ctrl_t * p_ctrl, pdm_integrity_cfg_t const * p_cfg)
+{
+    if ((NULL == p_ctrl) || (NULL == p_cfg))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((0U == p_cfg->samples_per_block) || (0U == p_cfg->sample_rate_hz) || (0U == p_cfg->cycles_per_second))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->cfg          = *p_cfg;
+    p_ctrl->block_cycles =
+        (uint32_t) (((uint64_t) p_cfg->samples_per_block * p_cfg->cycles_per_second) / p_cfg->sample_rate_hz);
+
+    return FSP_SUCCESS;
+}
+
+void pdm_integrity_start(pdm_integrity_ctrl_t * p_ctrl, uint32_t cycles)
+{
+    p_ctrl->last_block_cycles = cycles;
+    p_ctrl->events_seen       = p_ctrl->events;
+    p_ctrl->overwrites_seen   = p_ctrl->buffer_overwrite;
+}
+
+PDM_MEM_FAST_CODE void pdm_integrity_block(pdm_integrity_ctrl_t * p_ctrl, uint64_t timestamp,
+                                             pdm_integrity_block_t * p_block)
+{
+    uint32_t cycles     = (uint32_t) timestamp;
+    uint32_t interval   = cycles - p_ctrl->last_block_cycles;
+    uint32_t events     = p_ctrl->events;
+    uint32_t overwrites = p_ctrl->buffer_overwrite;
+    uint32_t lost       = 0U;
+    uint32_t flags      = 0U;
+
+    p_ctrl->last_block_cycles = cycles;
+
+    if (events != p_ctrl->events_seen)
+    {
+        flags |= PDM_INTEGRITY_BLOCK_FLAG_ERROR;
+    }
+
+    /* The FIFO overflowed during this block: whatever wall time exceeds one block was never delivered */
+    if ((overwrites != p_ctrl->overwrites_seen) && (interval > p_ctrl->block_cycles))
+    {
+        uint64_t excess = (uint64_t) (interval - p_ctrl->block_cycles) * p_ctrl->cfg.sample_rate_hz;
+        lost = (uint32_t) ((excess + (p_ctrl->cfg.cycles_per_second / 2U)) / p_ctrl->cfg.cycles_per_second);
+
+        if (0U != lost)
+        {
+            flags                |= PDM_INTEGRITY_BLOCK_FLAG_GAP;
+            p_ctrl->samples_lost += lost;
+
+            /* Attribute the loss to the most recent event; the error interrupt is done with it once it is counted */
+            p_ctrl->event_log[(events - 1U) & PDM_INTEGRITY_PRV_EVENT_MASK].lost_samples = lost;
+        }
+    }
+
+    p_ctrl->events_seen     = events;
+    p_ctrl->overwrites_seen = overwrites;
+    p_ctrl->sample_index   += lost;
+
+    p_block->sequence     = p_ctrl->sequence;
+    p_block->lost_before  = lost;
+    p_block->sample_index = p_ctrl->sample_index;
+    p_block->flags        = flags;
+    p_block->cycles       = cycles;
+    p_block->timestamp    = timestamp;
+
+    p_ctrl->sequence++;
+    p_ctrl->sample_index += p_ctrl->cfg.samples_per_block;
+}
+
+PDM_MEM_FAST_CODE uint64_t pdm_integrity_position(pdm_integrity_ctrl_t const * p_ctrl, uint32_t cycles)
+{
+    uint64_t elapsed = (uint64_t) (cycles - p_ctrl->last_block_cycles) * p_ctrl->cfg.sample_rate_hz;
+
+    return p_ctrl->sample_index + (elapsed / p_ctrl->cfg.cycles_per_second);
+}
+
+PDM_MEM_FAST_CODE void pdm_integrity_error(pdm_integrity_ctrl_t * p_ctrl, uint32_t cycles, uint32_t errors)
+{
+    uint32_t                events  = p_ctrl->events;
+    pdm_integrity_event_t * p_event = &p_ctrl->event_log[events & PDM_INTEGRITY_PRV_EVENT_MASK];
+
+    p_event->cycles       = cycles;
+    p_event->errors       = errors;
+    p_event->sequence     = p_ctrl->sequence;
+    p_event->lost_samples = 0U;
+
+    if (errors & PDM_INTEGRITY_ERROR_SHORT_CIRCUIT)
+    {
+        p_ctrl->short_circuit = p_ctrl->short_circuit + 1U;
+    }
+
+    if (errors & PDM_INTEGRITY_ERROR_OVERVOLTAGE_LOWER)
+    {
+        p_ctrl->overvoltage_lower = p_ctrl->overvoltage_lower + 1U;
+    }
+
+    if (errors & PDM_INTEGRITY_ERROR_OVERVOLTAGE_UPPER)
+    {
+        p_ctrl->overvoltage_upper = p_ctrl->overvoltage_upper + 1U;
+    }
+
+    if (errors & PDM_INTEGRITY_ERROR_BUFFER_OVERWRITE)
+    {
+        p_ctrl->buffer_overwrite = p_ctrl->buffer_overwrite + 1U;
+    }
+
+    /* Event must be complete before the data interrupt can see the new count */
+    pdm_port_memory_barrier();
+    p_ctrl->events = events + 1U;
+}
+
+PDM_MEM_FAST_CODE void pdm_integrity_rate_set(pdm_integrity_ctrl_t * p_ctrl, uint32_t sample_rate_hz)
+{
+    if (0U != sample_rate_hz)
+    {
+        p_ctrl->cfg.sample_rate_hz = sample_rate_hz;
+        p_ctrl->block_cycles       =
+            (uint32_t) (((uint64_t) p_ctrl->cfg.samples_per_block * p_ctrl->cfg.cycles_per_second) / sample_rate_hz);
+    }
+}
+
+void pdm_integrity_drop(pdm_integrity_ctrl_t * p_ctrl)
+{
+    p_ctrl->blocks_dropped++;
+}
+
+void pdm_integrity_telemetry_get(pdm_integrity_ctrl_t const * p_ctrl, pdm_integrity_telemetry_t * p_telemetry)
+{
+    memset(p_telemetry, 0, sizeof(*p_telemetry));
+
+    p_telemetry->version           = PDM_INTEGRITY_TELEMETRY_VERSION;
+    p_telemetry->size              = (uint16_t) sizeof(*p_telemetry);
+    p_telemetry->blocks            = p_ctrl->sequence;
+    p_telemetry->blocks_dropped    = p_ctrl->blocks_dropped;
+    p_telemetry->events            = p_ctrl->events;
+    p_telemetry->samples_delivered = (uint64_t) p_ctrl->sequence * p_ctrl->cfg.samples_per_block;
+    p_telemetry->samples_lost      = p_ctrl->samples_lost;
+    p_telemetry->short_circuit     = p_ctrl->short_circuit;
+    p_telemetry->overvoltage_lower = p_ctrl->overvoltage_lower;
+    p_telemetry->overvoltage_upper = p_ctrl->overvoltage_upper;
+    p_telemetry->buffer_overwrite  = p_ctrl->buffer_overwrite;
+
+    (void) pdm_integrity_event_get(p_ctrl, 0U, &p_telemetry->last_event);
+}
+
+fsp_err_t pdm_integrity_event_get(pdm_integrity_ctrl_t const * p_ctrl, uint32_t age, pdm_integrity_event_t * p_event)
+{
+    uint32_t events = p_ctrl->events;
+
+    if ((age >= events) || (age >= PDM_INTEGRITY_EVENTS))
+    {
+        return FSP_ERR_NOT_FOUND;
+    }
+
+    *p_event = p_ctrl->event_log[(events - 1U - age) & PDM_INTEGRITY_PRV_EVENT_MASK];
+
+    return FSP_SUCCESS;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file pdm_integrity.h
+ * @brief Capture integrity telemetry: block sequence numbers, stream positions, error events and lost samples
+ * @details Every block delivered by the driver gets a sequence number and the absolute index of its first sample in
+ *          the stream. When samples are lost the index jumps, so a decoder can insert the gap instead of silently
+ *          joining the audio on either side.
+ *
+ *          Lost samples cannot be read from the peripheral. When a buffer overwrite has been reported during a block,
+ *          the block's wall time (cycle counter between consecutive block completions) is converted back to samples
+ *          and the excess over the nominal block length is counted as lost. Blocks without an overwrite are assumed
+ *          contiguous, so interrupt jitter never shows up as phantom loss.
+ *
+ *          Each block also keeps the full 64-bit completion timestamp, so the position of every sample on the local
+ *          time base can be recovered: a host fit of timestamp against sample index (tools/pdm_drift) gives the actual
+ *          sample clock, its offset and the interrupt jitter, and lets captures of several boards be aligned.
+ *
+ *          Concurrency: pdm_integrity_block() belongs to the data interrupt and pdm_integrity_error() to the error
+ *          interrupt. Each writes its own fields only; the handoff between them is a pair of counters, so neither
+ *          needs a lock even though the data interrupt preempts the error interrupt.
+ */
+
+#ifndef PDM_INTEGRITY_H
+#define PDM_INTEGRITY_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Error events kept for pdm_integrity_event_get() (power of two, older events are overwritten) */
+#ifndef PDM_INTEGRITY_EVENTS
+ #define PDM_INTEGRITY_EVENTS                 (8U)
+#endif
+
+#if (PDM_INTEGRITY_EVENTS & (PDM_INTEGRITY_EVENTS - 1U)) != 0U
+ #error "PDM_INTEGRITY_EVENTS must be a power of two"
+#endif
+
+/** Error bits, same values as pdm_error_t */
+#define PDM_INTEGRITY_ERROR_SHORT_CIRCUIT       (1U << 0)
+#define PDM_INTEGRITY_ERROR_OVERVOLTAGE_LOWER   (1U << 1)
+#define PDM_INTEGRITY_ERROR_OVERVOLTAGE_UPPER   (1U << 2)
+#define PDM_INTEGRITY_ERROR_BUFFER_OVERWRITE    (1U << 11)
+
+/** Block flags */
+#define PDM_INTEGRITY_BLOCK_FLAG_GAP            (1U << 0) ///< Samples were lost right before this block
+#define PDM_INTEGRITY_BLOCK_FLAG_ERROR          (1U << 1) ///< An error was reported while this block was captured
+
+/** Telemetry record format version */
+#define PDM_INTEGRITY_TELEMETRY_VERSION         (1U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Stream parameters */
+typedef struct st_pdm_integrity_cfg
+{
+    uint32_t samples_per_block;        ///< Samples per data callback
+    uint32_t sample_rate_hz;           ///< Actual PCM rate
+    uint32_t cycles_per_second;        ///< Rate of the timestamps passed in, see pdm_port_cycles_per_second()
+} pdm_integrity_cfg_t;
+
+/** Position of one delivered block in the stream */
+typedef struct st_pdm_integrity_block
+{
+    uint32_t sequence;                 ///< Blocks delivered before this one
+    uint32_t lost_before;              ///< Samples lost between the previous block and this one
+    uint64_t sample_index;             ///< Stream index of the first sample, lost samples included
+    uint32_t flags;                    ///< PDM_INTEGRITY_BLOCK_FLAG_*
+    uint32_t cycles;                   ///< Completion timestamp, low 32 bits
+    uint64_t timestamp;                ///< Completion timestamp (pdm_sched_timestamp() on target)
+} pdm_integrity_block_t;
+
+/** One reported error */
+typedef struct st_pdm_integrity_event
+{
+    uint32_t cycles;                   ///< Timestamp of the error interrupt
+    uint32_t errors;                   ///< PDM_INTEGRITY_ERROR_* bits
+    uint32_t sequence;                 ///< Block being captured when the error was reported
+    uint32_t lost_samples;             ///< Samples lost to this event, set once the next block completes
+} pdm_integrity_event_t;
+
+/** Compact snapshot for publication (fixed layout, little endian on both target and host) */
+typedef struct st_pdm_integrity_telemetry
+{
+    uint16_t version;                  ///< PDM_INTEGRITY_TELEMETRY_VERSION
+    uint16_t size;                     ///< sizeof(pdm_integrity_telemetry_t)
+    uint32_t blocks;                   ///< Blocks delivered by the driver
+    uint32_t blocks_dropped;           ///< Delivered blocks the consumer could not process in time
+    uint32_t events;                   ///< Error interrupts
+    uint64_t samples_delivered;
+    uint64_t samples_lost;             ///< Estimated from overwrite events
+    uint32_t short_circuit;            ///< Error interrupts per cause
+    uint32_t overvoltage_lower;
+    uint32_t overvoltage_upper;
+    uint32_t buffer_overwrite;
+    pdm_integrity_event_t last_event;  ///< Most recent error, all zero if none
+} pdm_integrity_telemetry_t;
+
+/** Instance */
+typedef struct st_pdm_integrity_ctrl
+{
+    pdm_integrity_cfg_t cfg;
+    uint32_t            block_cycles;  ///< Nominal block length in timestamp units
+
+    /* Data interrupt side */
+    uint32_t sequence;
+    uint64_t sample_index;
+    uint64_t samples_lost;
+    uint32_t last_block_cycles;
+    uint32_t events_seen;              ///< Value of events at the previous block
+    uint32_t overwrites_seen;          ///< Value of buffer_overwrite at the previous block
+
+    /* Error interrupt side */
+    volatile uint32_t     events;
+    volatile uint32_t     short_circuit;
+    volatile uint32_t     overvoltage_lower;
+    volatile uint32_t     overvoltage_upper;
+    volatile uint32_t     buffer_overwrite;
+    pdm_integrity_event_t event_log[PDM_INTEGRITY_EVENTS];
+
+    /* Consumer side */
+    uint32_t blocks_dropped;
+} pdm_integrity_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Reset the telemetry for a new capture
+ * @param[out] p_ctrl  Instance
+ * @param[in]  p_cfg   Stream parameters
+ * @retval FSP_SUCCESS               Ready
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Zero rate or block size
+ */
+fsp_err_t pdm_integrity_open(pdm_integrity_ctrl_t * p_ctrl, pdm_integrity_cfg_t const * p_cfg);
+
+/**
+ * @brief Mark the capture start, the reference for the first block's duration
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     cycles  Timestamp
+ */
+void pdm_integrity_start(pdm_integrity_ctrl_t * p_ctrl, uint32_t cycles);
+
+/**
+ * @brief Number a completed block (data interrupt)
+ * @param[in,out] p_ctrl     Instance
+ * @param[in]     timestamp  Completion timestamp; its low 32 bits are on the pdm_integrity_start() time base
+ * @param[out]    p_block    Block position
+ */
+void pdm_integrity_block(pdm_integrity_ctrl_t * p_ctrl, uint64_t timestamp, pdm_integrity_block_t * p_block);
+
+/**
+ * @brief Stream index of the sample being captured at a given time, e.g. for an interrupt between blocks
+ * @param[in] p_ctrl  Instance
+ * @param[in] cycles  Timestamp on the same base as the block timestamps, not before the last block
+ * @return Estimated stream index
+ */
+uint64_t pdm_integrity_position(pdm_integrity_ctrl_t const * p_ctrl, uint32_t cycles);
+
+/**
+ * @brief Record an error interrupt (error interrupt)
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     cycles  Timestamp
+ * @param[in]     errors  PDM_INTEGRITY_ERROR_* bits (pdm_error_t)
+ */
+void pdm_integrity_error(pdm_integrity_ctrl_t * p_ctrl, uint32_t cycles, uint32_t errors);
+
+/**
+ * @brief Change the nominal sample rate, e.g. after a decimation change (producer context)
+ * @param[in,out] p_ctrl          Instance
+ * @param[in]     sample_rate_hz  New PCM rate, not 0
+ */
+void pdm_integrity_rate_set(pdm_integrity_ctrl_t * p_ctrl, uint32_t sample_rate_hz);
+
+/**
+ * @brief Count a delivered block that the consumer had to skip (consumer)
+ * @param[in,out] p_ctrl  Instance
+ */
+void pdm_integrity_drop(pdm_integrity_ctrl_t * p_ctrl);
+
+/**
+ * @brief Fill the compact telemetry record
+ * @param[in]  p_ctrl       Instance
+ * @param[out] p_telemetry  Record
+ */
+void pdm_integrity_telemetry_get(pdm_integrity_ctrl_t const * p_ctrl, pdm_integrity_telemetry_t * p_telemetry);
+
+/**
+ * @brief Read a logged error event, newest first
+ * @param[in]  p_ctrl   Instance
+ * @param[in]  age      0 for the most recent event
+ * @param[out] p_event  Event
+ * @retval FSP_SUCCESS        Event returned
+ * @retval FSP_ERR_NOT_FOUND  Fewer than age + 1 events logged, or overwritten
+ */
+fsp_err_t pdm_integrity_event_get(pdm_integrity_ctrl_t const * p_ctrl, uint32_t age, pdm_integrity_event_t * p_event);
+
+FSP_FOOTER
+
+#endif /* PDM_INTEGRITY_H */
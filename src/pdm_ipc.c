@@ -0,0 +1,260 @@
+/**
+ * @file pdm_ipc.c
+ * @brief Inter-core block handoff (shared SPSC ring + IPC semaphore/NMI signalling)
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_ipc.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_IPC_PRV_SLOT_MASK    (PDM_IPC_RING_SLOTS - 1U)
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+#if PDM_PORT_TARGET
+static bsp_ipc_semaphore_handle_t const g_pdm_ipc_semaphore =
+{
+    .semaphore_num = PDM_IPC_SEMAPHORE_NUM,
+};
+#else
+
+/* Host emulation of IPCSEMn: 0 means free (work pending). A take exchanges in 1 and succeeds if it read 0; a give
+ * stores 0. */
+static volatile uint32_t g_pdm_ipc_host_semaphore = 0U;
+#endif
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Mark work as pending (give/free the semaphore) */
+static void pdm_ipc_prv_signal(void)
+{
+#if PDM_PORT_TARGET
+    (void) R_BSP_IpcSemaphoreGive(&g_pdm_ipc_semaphore);
+#else
+    __atomic_store_n(&g_pdm_ipc_host_semaphore, 0U, __ATOMIC_RELEASE);
+#endif
+}
+
+/* Consume the pending flag (take the semaphore). Returns true if it was free, i.e. work was pending. */
+static bool pdm_ipc_prv_take(void)
+{
+#if PDM_PORT_TARGET
+    return FSP_SUCCESS == R_BSP_IpcSemaphoreTake(&g_pdm_ipc_semaphore);
+#else
+    return 0U == __atomic_exchange_n(&g_pdm_ipc_host_semaphore, 1U, __ATOMIC_ACQUIRE);
+#endif
+}
+
+#if PDM_PORT_TARGET && PDM_IPC_NMI_DOORBELL
+
+/* Doorbell NMI on core 1. Nothing to do here: taking the exception is what wakes pdm_ipc_wait(). */
+static void pdm_ipc_prv_nmi_callback(void)
+{
+}
+
+#endif
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_ipc_producer_open(pdm_ipc_ring_t * p_ring, void * p_shared)
+{
+    if (NULL == p_ring)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    p_ring->magic          = 0U;
+    p_ring->consumer_ready = 0U;
+    p_ring->p_shared       = p_shared;
+    p_ring->head           = 0U;
+    p_ring->produced       = 0U;
+    p_ring->dropped        = 0U;
+    p_ring->doorbells      = 0U;
+    p_ring->tail           = 0U;
+    p_ring->consumed       = 0U;
+
+    /* Start with nothing pending */
+    (void) pdm_ipc_prv_take();
+
+    pdm_port_memory_barrier();
+    p_ring->magic = PDM_IPC_RING_MAGIC;
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_ipc_push(pdm_ipc_ring_t * p_ring, uint32_t const * p_samples, uint32_t sample_count,
+                       uint32_t const * p_args)
+{
+    if (sample_count > PDM_IPC_BLOCK_SAMPLES)
+    {
+        return FSP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t head     = p_ring->head;
+    uint32_t tail     = p_ring->tail;
+    uint32_t sequence = p_ring->produced + p_ring->dropped;
+
+    if ((head - tail) >= PDM_IPC_RING_SLOTS)
+    {
+        p_ring->dropped = p_ring->dropped + 1U;
+
+        return FSP_ERR_QUEUE_FULL;
+    }
+
+    pdm_ipc_block_t * p_slot = &p_ring->slots[head & PDM_IPC_PRV_SLOT_MASK];
+    p_slot->sequence     = sequence;
+    p_slot->sample_count = sample_count;
+    for (uint32_t i = 0U; i < PDM_IPC_BLOCK_ARGS; i++)
+    {
+        p_slot->args[i] = (NULL != p_args) ? p_args[i] : 0U;
+    }
+
+    memcpy(p_slot->samples, p_samples, sample_count * sizeof(uint32_t));
+
+    /* Slot contents must be visible before the new head */
+    pdm_port_memory_barrier();
+    p_ring->head     = head + 1U;
+    p_ring->produced = p_ring->produced + 1U;
+    pdm_port_memory_barrier();
+
+    pdm_ipc_prv_signal();
+
+#if PDM_IPC_NMI_DOORBELL
+
+    /* Only the empty -> non-empty transition needs a wake-up, a busy consumer will see the rest */
+    if ((head == tail) && (0U != p_ring->consumer_ready))
+    {
+        p_ring->doorbells = p_ring->doorbells + 1U;
+ #if PDM_PORT_TARGET
+        (void) R_BSP_IpcNmiRequestSet();
+ #endif
+    }
+#endif
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_ipc_consumer_attach(pdm_ipc_ring_t * p_ring)
+{
+    if (PDM_IPC_RING_MAGIC != p_ring->magic)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+#if PDM_PORT_TARGET && PDM_IPC_NMI_DOORBELL
+    (void) R_BSP_IpcNmiEnable(pdm_ipc_prv_nmi_callback);
+#endif
+
+    pdm_port_memory_barrier();
+    p_ring->consumer_ready = 1U;
+
+    return FSP_SUCCESS;
+}
+
+void * pdm_ipc_shared_get(pdm_ipc_ring_t const * p_ring)
+{
+    return p_ring->p_shared;
+}
+
+fsp_err_t pdm_ipc_peek(pdm_ipc_ring_t * p_ring, pdm_ipc_block_t const ** pp_block)
+{
+    uint32_t tail = p_ring->tail;
+
+    if (tail == p_ring->head)
+    {
+        return FSP_ERR_QUEUE_EMPTY;
+    }
+
+    /* Head must be observed before the slot contents */
+    pdm_port_memory_barrier();
+    *pp_block = &p_ring->slots[tail & PDM_IPC_PRV_SLOT_MASK];
+
+    return FSP_SUCCESS;
+}
+
+void pdm_ipc_release(pdm_ipc_ring_t * p_ring)
+{
+    /* Finish reading the slot before handing it back */
+    pdm_port_memory_barrier();
+    p_ring->tail     = p_ring->tail + 1U;
+    p_ring->consumed = p_ring->consumed + 1U;
+}
+
+bool pdm_ipc_work_pending(pdm_ipc_ring_t * p_ring)
+{
+    FSP_PARAMETER_NOT_USED(p_ring);
+
+    return pdm_ipc_prv_take();
+}
+
+void pdm_ipc_wait(pdm_ipc_ring_t * p_ring)
+{
+    if (p_ring->tail != p_ring->head)
+    {
+        return;
+    }
+
+#if PDM_PORT_TARGET
+    __WFE();
+#endif
+}
+
+uint32_t pdm_ipc_drain(pdm_ipc_ring_t * p_ring, pdm_ipc_handler_t handler, void * p_context)
+{
+    pdm_ipc_block_t const * p_block;
+    uint32_t                count = 0U;
+
+    while (FSP_SUCCESS == pdm_ipc_peek(p_ring, &p_block))
+    {
+        handler(p_block, p_context);
+        pdm_ipc_release(p_ring);
+        count++;
+    }
+
+    return count;
+}
+
+void pdm_ipc_consumer_run(pdm_ipc_ring_t * p_ring, pdm_ipc_handler_t handler, void * p_context)
+{
+    while (FSP_SUCCESS != pdm_ipc_consumer_attach(p_ring))
+    {
+        /* Producer not up yet */
+    }
+
+    while (1)
+    {
+        if (pdm_ipc_work_pending(p_ring))
+        {
+            (void) pdm_ipc_drain(p_ring, handler, p_context);
+        }
+        else
+        {
+            pdm_ipc_wait(p_ring);
+        }
+    }
+}
+
+bool pdm_ipc_idle(pdm_ipc_ring_t const * p_ring)
+{
+    return p_ring->tail == p_ring->head;
+}
+
+void pdm_ipc_stats_get(pdm_ipc_ring_t const * p_ring, pdm_ipc_stats_t * p_stats)
+{
+    p_stats->produced  = p_ring->produced;
+    p_stats->dropped   = p_ring->dropped;
+    p_stats->consumed  = p_ring->consumed;
+    p_stats->doorbells = p_ring->doorbells;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file pdm_ipc.h
+ * @brief Inter-core block handoff for the dual-core store offload
+ * @details Core 0 (producer) copies each captured PDM block into a single-producer/single-consumer ring in shared
+ *          memory, with a few words of its own parameters. Core 1 (consumer) works on the blocks in place (pdm_core1
+ *          stores them) and then releases them. The producer can also hand the consumer one object of its own, such
+ *          as the buffer the blocks are stored into, when it opens the ring (pdm_ipc_shared_get()).
+ *
+ *          Signalling:
+ *          - The ring indices are the source of truth; each is written by one side only, so no lock is needed.
+ *          - IPC semaphore PDM_IPC_SEMAPHORE_NUM is used as a "work pending" flag. The producer gives (frees) it
+ *            after publishing a block and the consumer takes it before draining, so an idle consumer can poll a
+ *            single register instead of shared SRAM.
+ *          - When PDM_IPC_NMI_DOORBELL is set, the producer also raises the IPC NMI on the empty -> non-empty
+ *            transition so a sleeping consumer wakes up immediately.
+ *
+ *          The ring must be placed in memory that is visible and uncached on both cores (.ram_noinit_nocache), and
+ *          the core 1 image must link it at the same address. On host the IPC primitives are emulated with atomics
+ *          so the protocol can be driven from two threads.
+ */
+
+#ifndef PDM_IPC_H
+#define PDM_IPC_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Number of block slots in the ring (power of two) */
+#ifndef PDM_IPC_RING_SLOTS
+ #define PDM_IPC_RING_SLOTS       (8U)
+#endif
+
+/** Samples per block, must match the PDM callback block size */
+#ifndef PDM_IPC_BLOCK_SAMPLES
+ #define PDM_IPC_BLOCK_SAMPLES    (1024U)
+#endif
+
+/** Producer parameters carried by every block */
+#ifndef PDM_IPC_BLOCK_ARGS
+ #define PDM_IPC_BLOCK_ARGS       (4U)
+#endif
+
+/** IPC semaphore used as the "work pending" flag */
+#ifndef PDM_IPC_SEMAPHORE_NUM
+ #define PDM_IPC_SEMAPHORE_NUM    (0U)
+#endif
+
+/** Raise the IPC NMI towards the consumer when the ring goes from empty to non-empty */
+#ifndef PDM_IPC_NMI_DOORBELL
+ #define PDM_IPC_NMI_DOORBELL     (1)
+#endif
+
+/** Section used for the shared ring on target */
+#define PDM_IPC_SHARED_SECTION    ".ram_noinit_nocache"
+
+/* "IPCR" in ASCII, marks an initialized ring */
+#define PDM_IPC_RING_MAGIC        (0x49504352U)
+
+#if (PDM_IPC_RING_SLOTS & (PDM_IPC_RING_SLOTS - 1U)) != 0U
+ #error "PDM_IPC_RING_SLOTS must be a power of two"
+#endif
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** One block handed from core 0 to core 1 */
+typedef struct st_pdm_ipc_block
+{
+    uint32_t sequence;                          ///< Producer block counter, gaps mean dropped blocks
+    uint32_t sample_count;                      ///< Valid samples in samples[]
+    uint32_t args[PDM_IPC_BLOCK_ARGS];          ///< Producer parameters, passed to the handler untouched
+    uint32_t samples[PDM_IPC_BLOCK_SAMPLES];    ///< Raw PDM words
+} pdm_ipc_block_t;
+
+/** Handoff counters. Each field has a single writer so a snapshot never needs a lock. */
+typedef struct st_pdm_ipc_stats
+{
+    uint32_t produced;                 ///< Blocks published by core 0
+    uint32_t dropped;                  ///< Blocks discarded by core 0 because the ring was full
+    uint32_t consumed;                 ///< Blocks released by core 1
+    uint32_t doorbells;                ///< Doorbell NMIs raised by core 0
+} pdm_ipc_stats_t;
+
+/** Shared ring. Head and tail live on separate 32-byte lines so the two cores never write the same line. */
+typedef struct st_pdm_ipc_ring
+{
+    volatile uint32_t magic;                       ///< PDM_IPC_RING_MAGIC once the producer has opened it
+    volatile uint32_t consumer_ready;              ///< Set by core 1 once attached
+    void * volatile   p_shared;                    ///< Producer object for the consumer, set when the ring is opened
+    uint32_t          reserved0[5];
+
+    volatile uint32_t head;                        ///< Next slot to fill, written by core 0 only
+    volatile uint32_t produced;
+    volatile uint32_t dropped;
+    volatile uint32_t doorbells;
+    uint32_t          reserved1[4];
+
+    volatile uint32_t tail;                        ///< Next slot to consume, written by core 1 only
+    volatile uint32_t consumed;
+    uint32_t          reserved2[6];
+
+    pdm_ipc_block_t slots[PDM_IPC_RING_SLOTS];     ///< Block storage
+} pdm_ipc_ring_t;
+
+/** Consumer block handler, runs on core 1 */
+typedef void (* pdm_ipc_handler_t)(pdm_ipc_block_t const * p_block, void * p_context);
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Initialize the shared ring (core 0, before capture starts)
+ * @param[in,out] p_ring    Shared ring
+ * @param[in]     p_shared  Object handed to the consumer (pdm_ipc_shared_get()), may be NULL
+ * @retval FSP_SUCCESS        Ring initialized
+ * @retval FSP_ERR_ASSERTION  p_ring is NULL
+ */
+fsp_err_t pdm_ipc_producer_open(pdm_ipc_ring_t * p_ring, void * p_shared);
+
+/**
+ * @brief Copy one captured block into the ring and signal the consumer (core 0, ISR safe)
+ * @param[in,out] p_ring       Shared ring
+ * @param[in]     p_samples    Captured samples
+ * @param[in]     sample_count Number of samples (<= PDM_IPC_BLOCK_SAMPLES)
+ * @param[in]     p_args       PDM_IPC_BLOCK_ARGS parameters of the block, NULL for zeros
+ * @retval FSP_SUCCESS         Block published
+ * @retval FSP_ERR_QUEUE_FULL  Consumer is behind, block dropped and counted
+ * @retval FSP_ERR_INVALID_SIZE Block larger than a slot
+ */
+fsp_err_t pdm_ipc_push(pdm_ipc_ring_t * p_ring, uint32_t const * p_samples, uint32_t sample_count,
+                       uint32_t const * p_args);
+
+/**
+ * @brief Attach to a ring opened by the producer (core 1)
+ * @param[in,out] p_ring  Shared ring
+ * @retval FSP_SUCCESS          Attached
+ * @retval FSP_ERR_NOT_OPEN     Producer has not opened the ring yet, retry later
+ */
+fsp_err_t pdm_ipc_consumer_attach(pdm_ipc_ring_t * p_ring);
+
+/**
+ * @brief Object the producer handed over in pdm_ipc_producer_open() (core 1, once attached)
+ * @param[in] p_ring  Shared ring
+ * @return The producer's object, NULL if it gave none
+ */
+void * pdm_ipc_shared_get(pdm_ipc_ring_t const * p_ring);
+
+/**
+ * @brief Borrow the oldest published block without copying (core 1)
+ * @param[in,out] p_ring    Shared ring
+ * @param[out]    pp_block  Oldest block, valid until pdm_ipc_release()
+ * @retval FSP_SUCCESS          Block available
+ * @retval FSP_ERR_QUEUE_EMPTY  Nothing to consume
+ */
+fsp_err_t pdm_ipc_peek(pdm_ipc_ring_t * p_ring, pdm_ipc_block_t const ** pp_block);
+
+/**
+ * @brief Return the block obtained from pdm_ipc_peek() to the producer (core 1)
+ * @param[in,out] p_ring  Shared ring
+ */
+void pdm_ipc_release(pdm_ipc_ring_t * p_ring);
+
+/**
+ * @brief Check and clear the "work pending" flag (core 1)
+ * @param[in,out] p_ring  Shared ring
+ * @return true if the producer published something since the last call
+ */
+bool pdm_ipc_work_pending(pdm_ipc_ring_t * p_ring);
+
+/**
+ * @brief Sleep until the producer signals (core 1)
+ * @details Uses WFE so a doorbell NMI that lands between the last check and the sleep is not lost: the exception
+ *          sets the event register and WFE returns at once. Returns immediately on host.
+ * @param[in,out] p_ring  Shared ring
+ */
+void pdm_ipc_wait(pdm_ipc_ring_t * p_ring);
+
+/**
+ * @brief Drain every published block through a handler (core 1)
+ * @param[in,out] p_ring     Shared ring
+ * @param[in]     handler    Called once per block
+ * @param[in]     p_context  Passed to handler
+ * @return Number of blocks processed
+ */
+uint32_t pdm_ipc_drain(pdm_ipc_ring_t * p_ring, pdm_ipc_handler_t handler, void * p_context);
+
+/**
+ * @brief Core 1 main loop: attach, then sleep/drain forever
+ * @param[in,out] p_ring     Shared ring
+ * @param[in]     handler    DSP/encoding chain, called once per block
+ * @param[in]     p_context  Passed to handler
+ */
+void pdm_ipc_consumer_run(pdm_ipc_ring_t * p_ring, pdm_ipc_handler_t handler, void * p_context);
+
+/**
+ * @brief Check whether the consumer has released every published block (either core)
+ * @param[in] p_ring  Shared ring
+ * @return true if nothing is left in the ring
+ */
+bool pdm_ipc_idle(pdm_ipc_ring_t const * p_ring);
+
+/**
+ * @brief Snapshot the handoff counters (either core)
+ * @param[in]  p_ring   Shared ring
+ * @param[out] p_stats  Counters
+ */
+void pdm_ipc_stats_get(pdm_ipc_ring_t const * p_ring, pdm_ipc_stats_t * p_stats);
+
+FSP_FOOTER
+
+#endif /* PDM_IPC_H */
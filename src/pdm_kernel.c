@@ -0,0 +1,199 @@
+/**
+ * @file pdm_kernel.c
+ * @brief Sample conversion kernels specialized per PCM width
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_kernel.h"
+#include "pdm_mem.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#if (0U != (PDM_KERNEL_BLOCK % 4U)) || (0U == PDM_KERNEL_BLOCK)
+ #error "PDM_KERNEL_BLOCK must be a non-zero multiple of 4"
+#endif
+
+/* Sign bit of a width, and the shift onto the 20-bit scale */
+#define PDM_KERNEL_PRV_SIGN(bits)     (1UL << ((bits) - 1U))
+#define PDM_KERNEL_PRV_MASK(bits)     ((1UL << (bits)) - 1U)
+#define PDM_KERNEL_PRV_SHIFT(bits)    (20U - (bits))
+
+/* Branch-free sign extension onto the 20-bit scale: flip the sign bit, scale, then subtract the scaled sign weight */
+#define PDM_KERNEL_PRV_SAMPLE(bits, word)                                                                    \
+    ((int32_t) (uint32_t) ((((word) & PDM_KERNEL_PRV_MASK(bits)) ^ PDM_KERNEL_PRV_SIGN(bits)) <<             \
+                           PDM_KERNEL_PRV_SHIFT(bits)) -                                                     \
+     (int32_t) (PDM_KERNEL_PRV_SIGN(bits) << PDM_KERNEL_PRV_SHIFT(bits)))
+
+/* Run STEP(bits, i) over [first, first + n): 4 at a time, then the rest (dead code when n is a multiple of 4) */
+#define PDM_KERNEL_PRV_EACH(STEP, bits, first, n)                                                            \
+    do                                                                                                       \
+    {                                                                                                        \
+        uint32_t i_ = (first);                                                                               \
+        uint32_t e_ = (first) + (n);                                                                         \
+        for (; (i_ + 4U) <= e_; i_ += 4U)                                                                    \
+        {                                                                                                    \
+            STEP(bits, i_);                                                                                  \
+            STEP(bits, i_ + 1U);                                                                             \
+            STEP(bits, i_ + 2U);                                                                             \
+            STEP(bits, i_ + 3U);                                                                             \
+        }                                                                                                    \
+        for (; i_ < e_; i_++)                                                                                \
+        {                                                                                                    \
+            STEP(bits, i_);                                                                                  \
+        }                                                                                                    \
+    } while (0)
+
+/* Whole PDM_KERNEL_BLOCK passes with a constant trip count, then the tail */
+#define PDM_KERNEL_PRV_BLOCKS(STEP, bits, count)                                                             \
+    do                                                                                                       \
+    {                                                                                                        \
+        uint32_t b_ = 0U;                                                                                    \
+        for (; (b_ + PDM_KERNEL_BLOCK) <= (count); b_ += PDM_KERNEL_BLOCK)                                   \
+        {                                                                                                    \
+            PDM_KERNEL_PRV_EACH(STEP, bits, b_, PDM_KERNEL_BLOCK);                                           \
+        }                                                                                                    \
+        PDM_KERNEL_PRV_EACH(STEP, bits, b_, (count) - b_);                                                   \
+    } while (0)
+
+/* Sample steps; p_raw, p_out and gain_q8 are the kernel arguments */
+#define PDM_KERNEL_PRV_STEP_CONVERT(bits, i)                                                                 \
+    p_out[i] = PDM_KERNEL_PRV_SAMPLE(bits, p_raw[i])
+
+/* Raw words keep the FIFO layout of the width: the gained sample goes back from the 20-bit scale to the width */
+#define PDM_KERNEL_PRV_STEP_RAW20_GAIN(bits, i)                                                              \
+    p_out[i] = (uint32_t) (pdm_kernel_prv_gain(PDM_KERNEL_PRV_SAMPLE(bits, p_raw[i]), gain_q8) >>            \
+                           PDM_KERNEL_PRV_SHIFT(bits)) & PDM_KERNEL_PRV_MASK(bits)
+
+#define PDM_KERNEL_PRV_STEP_PCM16(bits, i)                                                                   \
+    p_out[i] = (uint16_t) pdm_kernel_prv_pcm16(PDM_KERNEL_PRV_SAMPLE(bits, p_raw[i]))
+
+#define PDM_KERNEL_PRV_STEP_PCM16_GAIN(bits, i)                                                              \
+    p_out[i] = (uint16_t) pdm_kernel_prv_pcm16(pdm_kernel_prv_gain(PDM_KERNEL_PRV_SAMPLE(bits, p_raw[i]), gain_q8))
+
+/* The kernel set of one width; the gain case is picked once per call, outside the loops */
+#define PDM_KERNEL_PRV_DEFINE(bits)                                                                          \
+    PDM_MEM_FAST_CODE static void pdm_kernel_prv_convert_##bits(uint32_t const * p_raw, int32_t * p_out,    \
+                                                                 uint32_t count)                             \
+    {                                                                                                        \
+        PDM_KERNEL_PRV_BLOCKS(PDM_KERNEL_PRV_STEP_CONVERT, bits, count);                                     \
+    }                                                                                                        \
+                                                                                                             \
+    PDM_MEM_FAST_CODE static void pdm_kernel_prv_raw20_##bits(uint32_t const * p_raw, uint32_t * p_out,     \
+                                                               uint32_t count, int32_t gain_q8)              \
+    {                                                                                                        \
+        if (PDM_KERNEL_GAIN_UNITY == gain_q8)                                                                \
+        {                                                                                                    \
+            pdm_kernel_prv_copy(p_raw, p_out, count);                                                        \
+        }                                                                                                    \
+        else                                                                                                 \
+        {                                                                                                    \
+            PDM_KERNEL_PRV_BLOCKS(PDM_KERNEL_PRV_STEP_RAW20_GAIN, bits, count);                              \
+        }                                                                                                    \
+    }                                                                                                        \
+                                                                                                             \
+    PDM_MEM_FAST_CODE static void pdm_kernel_prv_pcm16_##bits(uint32_t const * p_raw, uint32_t * p_out,     \
+                                                               uint32_t count, int32_t gain_q8)              \
+    {                                                                                                        \
+        if (PDM_KERNEL_GAIN_UNITY == gain_q8)                                                                \
+        {                                                                                                    \
+            PDM_KERNEL_PRV_BLOCKS(PDM_KERNEL_PRV_STEP_PCM16, bits, count);                                   \
+        }                                                                                                    \
+        else                                                                                                 \
+        {                                                                                                    \
+            PDM_KERNEL_PRV_BLOCKS(PDM_KERNEL_PRV_STEP_PCM16_GAIN, bits, count);                              \
+        }                                                                                                    \
+    }
+
+/* Table entry of the kernel set of one width */
+#define PDM_KERNEL_PRV_ENTRY(bits)                                                                           \
+    {                                                                                                        \
+        .p_name   = "w" #bits,                                                                               \
+        .pcm_bits = (bits),                                                                                  \
+        .convert  = pdm_kernel_prv_convert_##bits,                                                           \
+        .store    = {[PDM_KERNEL_FORMAT_RAW20] = pdm_kernel_prv_raw20_##bits,                                \
+                     [PDM_KERNEL_FORMAT_PCM16] = pdm_kernel_prv_pcm16_##bits},                               \
+    }
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/* Software gain, clipped to the 20-bit range */
+static inline int32_t pdm_kernel_prv_gain(int32_t x, int32_t gain_q8)
+{
+    int64_t y = ((int64_t) x * gain_q8) >> 8;
+
+    y = (y > 0x0007FFFF) ? 0x0007FFFF : y;
+    y = (y < -0x00080000) ? -0x00080000 : y;
+
+    return (int32_t) y;
+}
+
+/* 20-bit scale to 16-bit, rounded and saturated as pdm_dsp_pack_pcm16() */
+static inline int32_t pdm_kernel_prv_pcm16(int32_t x)
+{
+    int32_t y = (x + 8) >> 4;
+
+    y = (y > INT16_MAX) ? INT16_MAX : y;
+    y = (y < INT16_MIN) ? INT16_MIN : y;
+
+    return y;
+}
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Raw words at unity gain are stored as they come from the FIFO, whatever the width */
+PDM_MEM_FAST_CODE static void pdm_kernel_prv_copy(uint32_t const * p_raw, uint32_t * p_out, uint32_t count)
+{
+    if (p_out != p_raw)
+    {
+        for (uint32_t i = 0U; i < count; i++)
+        {
+            p_out[i] = p_raw[i];
+        }
+    }
+}
+
+PDM_KERNEL_PRV_DEFINE(20)
+PDM_KERNEL_PRV_DEFINE(16)
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+/* Dispatch table: one kernel set per PCM width of pdm_pcm_width_t */
+static pdm_kernel_t const g_pdm_kernels[] =
+{
+    PDM_KERNEL_PRV_ENTRY(20),
+    PDM_KERNEL_PRV_ENTRY(16),
+};
+
+#define PDM_KERNEL_PRV_COUNT    (sizeof(g_pdm_kernels) / sizeof(g_pdm_kernels[0]))
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+pdm_kernel_t const * pdm_kernel_select(uint32_t pcm_bits)
+{
+    for (uint32_t i = 0U; i < PDM_KERNEL_PRV_COUNT; i++)
+    {
+        if (g_pdm_kernels[i].pcm_bits == pcm_bits)
+        {
+            return &g_pdm_kernels[i];
+        }
+    }
+
+    return NULL;
+}
+
+pdm_kernel_t const * pdm_kernel_get(uint32_t index)
+{
+    return (index < PDM_KERNEL_PRV_COUNT) ? &g_pdm_kernels[index] : NULL;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file pdm_kernel.h
+ * @brief Sample conversion kernels specialized per PCM width, picked from a dispatch table when the PDM starts
+ * @details The FIFO words hold 20-bit or 16-bit two's complement samples, depending on the pdm_pcm_width_t of the
+ *          channel. Every kernel set is generated from the same macros for one width, with the width, the output
+ *          format and the gain case fixed at compile time, and works through PDM_KERNEL_BLOCK samples at a time in an
+ *          unrolled loop whose trip count is a constant; only the tail of a call runs a variable-length loop.
+ *
+ *          Signed samples always come out on the 20-bit scale (16-bit samples are shifted up by 4), so levels,
+ *          detection thresholds and PCM16 mean the same thing whatever the width. Raw words keep the FIFO layout of
+ *          the width: at unity gain every set stores them exactly as read, and a gain is applied on the 20-bit scale
+ *          and scaled back to the width. The input edge (pdm_input_data_edge_t) does not change the data format and
+ *          needs no kernel of its own.
+ */
+
+#ifndef PDM_KERNEL_H
+#define PDM_KERNEL_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Samples per unrolled pass, a multiple of 4 */
+#ifndef PDM_KERNEL_BLOCK
+ #define PDM_KERNEL_BLOCK         (64U)
+#endif
+
+/** Gain of pdm_kernel_store_t that leaves the samples as they are (Q8) */
+#define PDM_KERNEL_GAIN_UNITY     (256)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Stored sample formats, in the order of pdm_cmd_format_t */
+typedef enum e_pdm_kernel_format
+{
+    PDM_KERNEL_FORMAT_RAW20 = 0,       ///< FIFO words: two's complement of the PCM width in the low bits
+    PDM_KERNEL_FORMAT_PCM16,           ///< 16-bit two's complement in the low bits
+    PDM_KERNEL_FORMAT_COUNT,
+} pdm_kernel_format_t;
+
+/**
+ * @brief FIFO words to signed samples on the 20-bit scale
+ * @param[in]  p_raw   FIFO words (bits above the PCM width ignored)
+ * @param[out] p_out   Signed samples
+ * @param[in]  count   Number of samples
+ */
+typedef void (* pdm_kernel_convert_t)(uint32_t const * p_raw, int32_t * p_out, uint32_t count);
+
+/**
+ * @brief FIFO words to stored words, with a software gain clipped to the range of the width
+ * @param[in]  p_raw    FIFO words
+ * @param[out] p_out    Stored words (may be p_raw)
+ * @param[in]  count    Number of samples
+ * @param[in]  gain_q8  Gain, PDM_KERNEL_GAIN_UNITY = 0 dB
+ */
+typedef void (* pdm_kernel_store_t)(uint32_t const * p_raw, uint32_t * p_out, uint32_t count, int32_t gain_q8);
+
+/** Kernel set of one PCM width */
+typedef struct st_pdm_kernel
+{
+    char const         * p_name;                          ///< For reports
+    uint32_t             pcm_bits;                        ///< PCM width handled
+    pdm_kernel_convert_t convert;                         ///< FIFO words to signed samples
+    pdm_kernel_store_t   store[PDM_KERNEL_FORMAT_COUNT];  ///< FIFO words to stored words, per format
+} pdm_kernel_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Kernel set of a PCM width
+ * @param[in] pcm_bits  20 or 16
+ * @return Kernel set, NULL if there is none for this width
+ */
+pdm_kernel_t const * pdm_kernel_select(uint32_t pcm_bits);
+
+/**
+ * @brief Kernel set by table position, for benchmarks
+ * @param[in] index  0 ..
+ * @return Kernel set, NULL past the last one
+ */
+pdm_kernel_t const * pdm_kernel_get(uint32_t index);
+
+FSP_FOOTER
+
+#endif /* PDM_KERNEL_H */
@@ -0,0 +1,107 @@
+/**
+ * @file pdm_log.c
+ * @brief Binary deferred logging over RTT
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_log.h"
+#include "pdm_mem.h"
+#include "SEGGER_RTT/SEGGER_RTT.h"
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static char              g_pdm_log_buffer[PDM_CFG_LOG_RTT_BUFFER_SIZE] PDM_MEM_NOCACHE;
+static volatile uint32_t g_pdm_log_busy    = 0U;
+static volatile uint32_t g_pdm_log_dropped = 0U;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Build and write one record. Caller owns the writer. */
+static bool pdm_log_prv_emit(pdm_log_id_t id, uint32_t const * p_args, uint32_t nargs)
+{
+    uint32_t record[2U + PDM_LOG_MAX_ARGS];
+
+    record[0] = PDM_LOG_HEADER(id, nargs);
+    record[1] = pdm_port_cycles();
+
+    for (uint32_t i = 0U; i < nargs; i++)
+    {
+        record[2U + i] = p_args[i];
+    }
+
+    return 0U != SEGGER_RTT_WriteSkipNoLock(PDM_CFG_LOG_RTT_CHANNEL, record, (2U + nargs) * sizeof(uint32_t));
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_log_open(void)
+{
+    pdm_port_cycle_counter_init();
+
+    (void) SEGGER_RTT_ConfigUpBuffer(PDM_CFG_LOG_RTT_CHANNEL, "PdmLog", g_pdm_log_buffer, sizeof(g_pdm_log_buffer),
+                                     SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+bool pdm_log_write(pdm_log_id_t id, uint32_t const * p_args, uint32_t nargs)
+{
+    if (nargs > PDM_LOG_MAX_ARGS)
+    {
+        nargs = PDM_LOG_MAX_ARGS;
+    }
+
+    /* Preempted a writer: never wait in an interrupt, count the record instead */
+    if (0U != __atomic_exchange_n(&g_pdm_log_busy, 1U, __ATOMIC_ACQUIRE))
+    {
+        (void) __atomic_fetch_add(&g_pdm_log_dropped, 1U, __ATOMIC_RELAXED);
+
+        return false;
+    }
+
+    /* Report earlier losses first; if that does not fit, this record is lost too so the order stays right */
+    uint32_t dropped = __atomic_exchange_n(&g_pdm_log_dropped, 0U, __ATOMIC_RELAXED);
+    bool     written = true;
+
+    if (0U != dropped)
+    {
+        written = pdm_log_prv_emit(PDM_LOG_DROPPED, &dropped, 1U);
+        if (written)
+        {
+            dropped = 0U;
+        }
+    }
+
+    if (written)
+    {
+        written = pdm_log_prv_emit(id, p_args, nargs);
+    }
+
+    if (!written)
+    {
+        (void) __atomic_fetch_add(&g_pdm_log_dropped, dropped + 1U, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&g_pdm_log_busy, 0U, __ATOMIC_RELEASE);
+
+    return written;
+}
+
+bool pdm_log_fits(uint32_t nargs)
+{
+    /* A pending drop report goes out first: header, cycles and the count */
+    uint32_t words = ((0U != g_pdm_log_dropped) ? 3U : 0U) + 2U + nargs;
+
+    return SEGGER_RTT_GetAvailWriteSpace(PDM_CFG_LOG_RTT_CHANNEL) >= (words * sizeof(uint32_t));
+}
+
+uint32_t pdm_log_dropped(void)
+{
+    return g_pdm_log_dropped;
+}
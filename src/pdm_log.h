@@ -0,0 +1,100 @@
+/**
+ * @file pdm_log.h
+ * @brief Binary deferred logging over RTT
+ * @details A log call writes only a message ID, a timestamp and its raw 32-bit arguments into RTT up channel
+ *          PDM_CFG_LOG_RTT_CHANNEL with SEGGER_RTT_WriteSkipNoLock(): no formatting and no lock on the target. The host
+ *          tool tools/pdm_logdec expands the records with the format strings of pdm_log_ids.h.
+ *
+ *          Record layout (little endian, 32-bit words):
+ *          - word 0: PDM_LOG_SYNC | (argument count << 8) | (message ID << 16)
+ *          - word 1: pdm_port_cycles() at the call
+ *          - words 2..: arguments
+ *
+ *          Interrupt safety: the writer is claimed with an atomic exchange. A call that preempts another one in
+ *          progress does not wait; its record is dropped and counted, exactly like a record that does not fit in the
+ *          buffer. The next successful writer first emits a PDM_LOG_DROPPED record with the count, so the host always
+ *          knows that and how much is missing.
+ */
+
+#ifndef PDM_LOG_H
+#define PDM_LOG_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_cfg.h"
+#include "pdm_log_ids.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** First byte of every record */
+#define PDM_LOG_SYNC              (0xA5U)
+
+/** Largest argument count of one record */
+#define PDM_LOG_MAX_ARGS          (16U)
+
+/** Header word of a record */
+#define PDM_LOG_HEADER(id, nargs) (PDM_LOG_SYNC | ((uint32_t) (nargs) << 8) | ((uint32_t) (id) << 16))
+
+#define PDM_LOG0(id)                pdm_log_write((id), NULL, 0U)
+#define PDM_LOG1(id, a)             pdm_log_write((id), (uint32_t const[1]) {(uint32_t) (a)}, 1U)
+#define PDM_LOG2(id, a, b)          pdm_log_write((id), (uint32_t const[2]) {(uint32_t) (a), (uint32_t) (b)}, 2U)
+#define PDM_LOG3(id, a, b, c)                                                                         \
+    pdm_log_write((id), (uint32_t const[3]) {(uint32_t) (a), (uint32_t) (b), (uint32_t) (c)}, 3U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+#define PDM_LOG_PRV_ENUM(id, format)    id,
+
+/** Message IDs, see pdm_log_ids.h */
+typedef enum e_pdm_log_id
+{
+    PDM_LOG_MESSAGES(PDM_LOG_PRV_ENUM)
+    PDM_LOG_ID_COUNT,
+} pdm_log_id_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+#if PDM_PORT_TARGET
+
+/**
+ * @brief Configure the RTT up channel used for the records
+ */
+void pdm_log_open(void);
+
+/**
+ * @brief Write one record (any context)
+ * @param[in] id       Message ID
+ * @param[in] p_args   Arguments (may be NULL if nargs is 0)
+ * @param[in] nargs    Argument count, at most PDM_LOG_MAX_ARGS
+ * @return true if the record was written, false if it was dropped
+ */
+bool pdm_log_write(pdm_log_id_t id, uint32_t const * p_args, uint32_t nargs);
+
+/**
+ * @brief Whether a record fits the channel now, so a foreground writer can wait instead of dropping it
+ * @param[in] nargs    Argument count
+ * @return true if the host has drained enough of the channel
+ */
+bool pdm_log_fits(uint32_t nargs);
+
+/**
+ * @brief Number of records dropped and not yet reported with PDM_LOG_DROPPED
+ * @return Count
+ */
+uint32_t pdm_log_dropped(void);
+
+#endif
+
+FSP_FOOTER
+
+#endif /* PDM_LOG_H */
@@ -0,0 +1,84 @@
+/**
+ * @file pdm_log_ids.h
+ * @brief Message table of the binary logger
+ * @details Single source of truth for log IDs and their format strings. The target only uses the IDs (the strings
+ *          never reach the image); the host decoder (tools/pdm_logdec.c) is compiled against this same file, so its
+ *          string table always matches the firmware it decodes.
+ *
+ *          Formats are printf-style with one 32-bit argument per conversion (%u %d %x %X %c, with optional width and
+ *          flags). Text is printed verbatim, so a format that should end a line must end with "\n". A record may
+ *          carry fewer arguments than its format has conversions; output stops at the first unfilled conversion (and
+ *          still ends the line if the format does).
+ *
+ *          Append new messages at the end, so IDs in existing captures keep their meaning.
+ */
+
+#ifndef PDM_LOG_IDS_H
+#define PDM_LOG_IDS_H
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_LOG_PRV_RULE       "============================================================"
+#define PDM_LOG_PRV_HEX4       "%08X %08X %08X %08X"
+#define PDM_LOG_PRV_HEX16      PDM_LOG_PRV_HEX4 " " PDM_LOG_PRV_HEX4 " " PDM_LOG_PRV_HEX4 " " PDM_LOG_PRV_HEX4
+#define PDM_LOG_PRV_DECI7      " %d %d %d %d %d %d %d"
+
+/* X(id, format) */
+#define PDM_LOG_MESSAGES(X)                                                                                          \
+    X(PDM_LOG_DROPPED, "\n[%u log records dropped]\n")                                                               \
+    X(PDM_LOG_START, "\n=== PDM OPTIMIZED RECORDING START ===\n")                                                    \
+    X(PDM_LOG_OPEN_OK, "PDM Open: SUCCESS\n")                                                                        \
+    X(PDM_LOG_OPEN_FAILED, "PDM Open FAILED: 0x%X\n")                                                                \
+    X(PDM_LOG_SCHED_FAILED, "Scheduler open FAILED: 0x%X\n")                                                         \
+    X(PDM_LOG_DUAL_CORE, "Dual-core mode: core 1 stores the recording\n")                                            \
+    X(PDM_LOG_SETTLING, "Filter stabilizing...\n")                                                                   \
+    X(PDM_LOG_START_FAILED, "PDM Start FAILED: 0x%X\n")                                                              \
+    X(PDM_LOG_RECORDING, "Recording started! (%u ms)\nProgress.... ")                                                \
+    X(PDM_LOG_PROGRESS, ".")                                                                                         \
+    X(PDM_LOG_RECORDED, "\nRecording completed!\n")                                                                  \
+    X(PDM_LOG_DUMP_HEADER, "\n" PDM_LOG_PRV_RULE "\n=== COMPLETE AUDIO DATA DUMP ===\n"                              \
+      "Total collected samples: %u\nData format: 32-bit hex (20-bit effective)\n"                                    \
+      "Sample rate: 16000 Hz\nBit depth: 20-bit PDM -> 16-bit PCM\n")                                                \
+    X(PDM_LOG_DUMP_GAPS, "Gaps: %u\n")                                                                               \
+    X(PDM_LOG_DUMP_GAP, "GAP %u %u\n")                                                                               \
+    X(PDM_LOG_DUMP_DATA_START, "\n" PDM_LOG_PRV_RULE "\n\n*** PURE DATA OUTPUT START ***\n ")                        \
+    X(PDM_LOG_DUMP_DATA_FIRST, PDM_LOG_PRV_HEX16)                                                                    \
+    X(PDM_LOG_DUMP_DATA, "\n " PDM_LOG_PRV_HEX16)                                                                    \
+    X(PDM_LOG_DUMP_END, "\n*** PURE DATA OUTPUT END ***\n\n=== END COMPLETE DATA DUMP ===\n\n" PDM_LOG_PRV_RULE "\n") \
+    X(PDM_LOG_DUMP_ABORTED, "\n[dump aborted after %u samples: log channel not drained]\n")                          \
+    X(PDM_LOG_DUMP_FORMAT, "Stream format: %u (0: raw 20-bit, 1: PCM16), gain %u/256, PCM width %u\n")               \
+    X(PDM_LOG_SDET_FAILED, "Sound detection setup FAILED: 0x%X\n")                                                   \
+    X(PDM_LOG_CMD, "Command %u (seq %u): status %u\n")                                                               \
+    X(PDM_LOG_CMD_IDLE, "Waiting for commands on RTT channel %u\n")                                                  \
+    X(PDM_LOG_FILTER_SWAP, "Filter swap %u: new filters from sample %u, first valid sample %u "                      \
+      "(%u settling samples discarded), sincdec %u, %u cycles\n")                                                    \
+    X(PDM_LOG_FAST_START, "Fast start: first %u samples left out (mic startup %u us, filter settling %u us)\n")      \
+    X(PDM_LOG_FIRST_VALID, "First valid sample %u: captured %u us, delivered %u us after the start request\n")       \
+    X(PDM_LOG_DUMP_STAMPS, "Stamps: %u, %u samples per block, clock %u Hz, nominal rate %u Hz\n")                    \
+    X(PDM_LOG_DUMP_STAMP, "STAMP %u %u %08X%08X\n")                                                                  \
+    X(PDM_LOG_TRIGGER_FAILED, "Trigger setup FAILED: 0x%X\n")                                                        \
+    X(PDM_LOG_TRIGGER_ARMED, "Trigger armed: %u samples pre-roll, %u post-roll, level %d\n")                         \
+    X(PDM_LOG_TRIGGER, "Trigger from source %u (0: sound detection, 1: level) at sample %u: "                        \
+      "%u samples before, %u from it on\n")                                                                          \
+    X(PDM_LOG_TRIGGER_NONE, "No trigger within %u ms: nothing recorded\n")                                           \
+    X(PDM_LOG_DUMP_TRIGGER, "Trigger: source %u, data index %u of %u\n")                                             \
+    X(PDM_LOG_SEGMENT_FAILED, "Segment store setup FAILED: 0x%X\n")                                                  \
+    X(PDM_LOG_SEGMENT_ARMED, "Segment store: %u samples, %u entries, pre-roll %u, hold %u, longest %u samples, "     \
+      "level %d\n")                                                                                                  \
+    X(PDM_LOG_SEGMENT_INDEX, "Segments: %u stored, %u evicted, clock %u Hz, rate %u Hz\n")                           \
+    X(PDM_LOG_SEGMENT, "SEGMENT %u %u %u %u %u %u %08X%08X\n")                                                       \
+    X(PDM_LOG_SEGMENT_DATA, "\nSEGMENT DATA %u %u %u\n ")                                                            \
+    X(PDM_LOG_SEGMENT_DATA_END, "\nSEGMENT END %u\n")                                                                \
+    X(PDM_LOG_SEGMENT_EVICTED, "\nSEGMENT %u evicted while fetching, %u samples sent\n")                             \
+    X(PDM_LOG_LOUDNESS_FAILED, "Loudness meter setup FAILED: 0x%X\n")                                                \
+    X(PDM_LOG_LOUDNESS, "LOUDNESS %u ms: M %d S %d I %d TP %d (0.01 LUFS / dBTP)\n")                                 \
+    X(PDM_LOG_LOUDNESS_SUMMARY, "Loudness: integrated %d, max momentary %d, max short-term %d (0.01 LUFS), "         \
+      "true peak %d, sample peak %d (0.01 dB), %u gating blocks\n")                                                  \
+    X(PDM_LOG_SLM_FAILED, "Sound level meter setup FAILED: 0x%X\n")                                                  \
+    X(PDM_LOG_SLM, "SLM interval %u, %u ms: LAeq %d LCeq %d LZeq %d (0.1 dB)\n")                                     \
+    X(PDM_LOG_SLM_BANDS, "SLM bands %u.. step %u (0.1 dB):" PDM_LOG_PRV_DECI7 PDM_LOG_PRV_DECI7 "\n")                \
+    X(PDM_LOG_DUAL_CORE_STALLED, "Core 1 stalled: %u blocks not stored\n")
+
+#endif /* PDM_LOG_IDS_H */
@@ -0,0 +1,337 @@
+/**
+ * @file pdm_loudness.c
+ * @brief Streaming loudness meter (ITU-R BS.1770)
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_loudness.h"
+#include "pdm_math.h"
+#include <math.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/* K-weighting stage 1, high shelf: corner, Q and the gains of the shelf and of its band edge (BS.1770-4 Table 1
+ * reproduced from its analog prototype, so any rate can be designed) */
+#define PDM_LOUDNESS_PRV_SHELF_HZ       (1681.974450955533f)
+#define PDM_LOUDNESS_PRV_SHELF_Q        (0.7071752369554196f)
+#define PDM_LOUDNESS_PRV_SHELF_VH       (1.584864701130855f)    // 10^(3.999843853973347 dB / 20)
+#define PDM_LOUDNESS_PRV_SHELF_VB       (1.258720930232562f)    // VH^0.4996667741545416
+
+/* K-weighting stage 2, RLB high pass (BS.1770-4 Table 2) */
+#define PDM_LOUDNESS_PRV_RLB_HZ         (38.13547087602444f)
+#define PDM_LOUDNESS_PRV_RLB_Q          (0.5003270373238773f)
+
+/* Offset of the loudness formula, L = -0.691 + 10 log10(mean square) */
+#define PDM_LOUDNESS_PRV_OFFSET         (-0.691)
+
+#define PDM_LOUDNESS_PRV_STEPS_PER_S    (1000U / PDM_LOUDNESS_STEP_MS)
+#define PDM_LOUDNESS_PRV_TAPS           (PDM_LOUDNESS_OVERSAMPLING * PDM_LOUDNESS_PHASE_TAPS)
+
+#define PDM_LOUDNESS_PRV_MIN_RATE_HZ    (8000U)
+#define PDM_LOUDNESS_PRV_MAX_RATE_HZ    (384000U)
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_loudness_prv_design(pdm_dsp_biquad_coeffs_t * p_coeffs, uint32_t rate_hz)
+{
+    float s;
+    float c;
+
+    /* Bilinear transform with K = tan(pi f0 / fs) */
+    pdm_math_sincosf(PDM_MATH_PI * PDM_LOUDNESS_PRV_SHELF_HZ / (float) rate_hz, &s, &c);
+    float k  = s / c;
+    float kq = k / PDM_LOUDNESS_PRV_SHELF_Q;
+    float a0 = 1.0f + kq + (k * k);
+
+    p_coeffs[0].b0 = (PDM_LOUDNESS_PRV_SHELF_VH + (PDM_LOUDNESS_PRV_SHELF_VB * kq) + (k * k)) / a0;
+    p_coeffs[0].b1 = 2.0f * ((k * k) - PDM_LOUDNESS_PRV_SHELF_VH) / a0;
+    p_coeffs[0].b2 = (PDM_LOUDNESS_PRV_SHELF_VH - (PDM_LOUDNESS_PRV_SHELF_VB * kq) + (k * k)) / a0;
+    p_coeffs[0].a1 = 2.0f * ((k * k) - 1.0f) / a0;
+    p_coeffs[0].a2 = (1.0f - kq + (k * k)) / a0;
+
+    /* The standard keeps the numerator 1, -2, 1 (gain just above 1 in the pass band) */
+    pdm_math_sincosf(PDM_MATH_PI * PDM_LOUDNESS_PRV_RLB_HZ / (float) rate_hz, &s, &c);
+    k  = s / c;
+    kq = k / PDM_LOUDNESS_PRV_RLB_Q;
+    a0 = 1.0f + kq + (k * k);
+
+    p_coeffs[1].b0 = 1.0f;
+    p_coeffs[1].b1 = -2.0f;
+    p_coeffs[1].b2 = 1.0f;
+    p_coeffs[1].a1 = 2.0f * ((k * k) - 1.0f) / a0;
+    p_coeffs[1].a2 = (1.0f - kq + (k * k)) / a0;
+}
+
+static float pdm_loudness_prv_lufs(double mean_square)
+{
+    if (!(mean_square > 0.0))
+    {
+        return PDM_LOUDNESS_FLOOR;
+    }
+
+    double l = PDM_LOUDNESS_PRV_OFFSET + (10.0 * log10(mean_square));
+
+    return (l > (double) PDM_LOUDNESS_FLOOR) ? (float) l : PDM_LOUDNESS_FLOOR;
+}
+
+static float pdm_loudness_prv_db(float linear)
+{
+    return (linear > 0.0f) ? fmaxf(20.0f * log10f(linear), PDM_LOUDNESS_FLOOR) : PDM_LOUDNESS_FLOOR;
+}
+
+/* Mean square over the newest steps of the ring */
+static float pdm_loudness_prv_window(pdm_loudness_ctrl_t const * p_ctrl, uint32_t steps)
+{
+    float    sum   = 0.0f;
+    uint32_t count = 0U;
+
+    for (uint32_t i = 1U; i <= steps; i++)
+    {
+        uint32_t slot = (p_ctrl->steps - i) % PDM_LOUDNESS_SHORT_TERM_STEPS;
+        sum   += p_ctrl->ring_sum[slot];
+        count += p_ctrl->ring_count[slot];
+    }
+
+    return (0U != count) ? (sum / (float) count) : 0.0f;
+}
+
+/* Length of the next step: rate / 10 samples, one more every time the tenths add up */
+static void pdm_loudness_prv_step_begin(pdm_loudness_ctrl_t * p_ctrl)
+{
+    p_ctrl->step_remainder += p_ctrl->cfg.rate_hz % PDM_LOUDNESS_PRV_STEPS_PER_S;
+    p_ctrl->step_length     = p_ctrl->cfg.rate_hz / PDM_LOUDNESS_PRV_STEPS_PER_S;
+
+    if (p_ctrl->step_remainder >= PDM_LOUDNESS_PRV_STEPS_PER_S)
+    {
+        p_ctrl->step_remainder -= PDM_LOUDNESS_PRV_STEPS_PER_S;
+        p_ctrl->step_length++;
+    }
+
+    p_ctrl->step_fill = 0U;
+    p_ctrl->step_sum  = 0.0f;
+}
+
+/* A step is complete: it ends a gating block and the momentary and short-term windows */
+static void pdm_loudness_prv_step_end(pdm_loudness_ctrl_t * p_ctrl)
+{
+    uint32_t slot = p_ctrl->steps % PDM_LOUDNESS_SHORT_TERM_STEPS;
+
+    p_ctrl->ring_sum[slot]   = p_ctrl->step_sum;
+    p_ctrl->ring_count[slot] = p_ctrl->step_length;
+    p_ctrl->steps++;
+
+    if (p_ctrl->steps >= PDM_LOUDNESS_MOMENTARY_STEPS)
+    {
+        float block = pdm_loudness_prv_window(p_ctrl, PDM_LOUDNESS_MOMENTARY_STEPS);
+        float l     = pdm_loudness_prv_lufs((double) block);
+
+        p_ctrl->momentary_max = fmaxf(p_ctrl->momentary_max, block);
+
+        if (l > PDM_LOUDNESS_ABSOLUTE_GATE)
+        {
+            uint32_t bin = (uint32_t) ((l - PDM_LOUDNESS_ABSOLUTE_GATE) * (float) PDM_LOUDNESS_BINS_PER_LU);
+            bin = (bin < PDM_LOUDNESS_BINS) ? bin : (PDM_LOUDNESS_BINS - 1U);
+
+            p_ctrl->histogram_count[bin]++;
+            p_ctrl->histogram_sum[bin] += (double) block;
+            p_ctrl->gated_sum          += (double) block;
+            p_ctrl->gated_blocks++;
+        }
+    }
+
+    if (p_ctrl->steps >= PDM_LOUDNESS_SHORT_TERM_STEPS)
+    {
+        p_ctrl->short_term_max = fmaxf(p_ctrl->short_term_max,
+                                       pdm_loudness_prv_window(p_ctrl, PDM_LOUDNESS_SHORT_TERM_STEPS));
+    }
+
+    pdm_loudness_prv_step_begin(p_ctrl);
+}
+
+/* Sample and interpolated peaks of a chunk (unweighted) */
+static void pdm_loudness_prv_peaks(pdm_loudness_ctrl_t * p_ctrl, float const * p_in, uint32_t count)
+{
+    float    true_peak   = p_ctrl->true_peak;
+    float    sample_peak = p_ctrl->sample_peak;
+    uint32_t index       = p_ctrl->history_index;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        /* Newest sample first in the window */
+        index = (0U == index) ? (PDM_LOUDNESS_PHASE_TAPS - 1U) : (index - 1U);
+        p_ctrl->history[index]                           = p_in[i];
+        p_ctrl->history[index + PDM_LOUDNESS_PHASE_TAPS] = p_in[i];
+        sample_peak = fmaxf(sample_peak, fabsf(p_in[i]));
+
+        float const * p_window = &p_ctrl->history[index];
+        for (uint32_t phase = 0U; phase < PDM_LOUDNESS_OVERSAMPLING; phase++)
+        {
+            float const * p_taps = p_ctrl->phase_taps[phase];
+            float         acc    = 0.0f;
+
+            for (uint32_t k = 0U; k < PDM_LOUDNESS_PHASE_TAPS; k++)
+            {
+                acc += p_taps[k] * p_window[k];
+            }
+
+            true_peak = fmaxf(true_peak, fabsf(acc));
+        }
+    }
+
+    p_ctrl->true_peak     = fmaxf(true_peak, sample_peak);
+    p_ctrl->sample_peak   = sample_peak;
+    p_ctrl->history_index = index;
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_loudness_open(pdm_loudness_ctrl_t * p_ctrl, pdm_loudness_cfg_t const * p_cfg)
+{
+    if ((NULL == p_ctrl) || (NULL == p_cfg))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((p_cfg->rate_hz < PDM_LOUDNESS_PRV_MIN_RATE_HZ) || (p_cfg->rate_hz > PDM_LOUDNESS_PRV_MAX_RATE_HZ) ||
+        !(p_cfg->scale > 0.0f))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->cfg = *p_cfg;
+
+    pdm_dsp_biquad_coeffs_t coeffs[2];
+    pdm_loudness_prv_design(coeffs, p_cfg->rate_hz);
+    (void) pdm_dsp_biquad_init(&p_ctrl->k_weighting, coeffs, 2U);
+
+    /* Interpolator: low pass at the input Nyquist frequency on the oversampled rate, split into its phases; the gain of
+     * the oversampling factor makes every phase pass DC at unity */
+    float taps[PDM_LOUDNESS_PRV_TAPS];
+    (void) pdm_dsp_fir_lowpass(taps, PDM_LOUDNESS_PRV_TAPS, 0.5f, (float) PDM_LOUDNESS_OVERSAMPLING);
+    for (uint32_t phase = 0U; phase < PDM_LOUDNESS_OVERSAMPLING; phase++)
+    {
+        for (uint32_t k = 0U; k < PDM_LOUDNESS_PHASE_TAPS; k++)
+        {
+            p_ctrl->phase_taps[phase][k] = (float) PDM_LOUDNESS_OVERSAMPLING *
+                                           taps[phase + (k * PDM_LOUDNESS_OVERSAMPLING)];
+        }
+    }
+
+    pdm_loudness_prv_step_begin(p_ctrl);
+
+    return FSP_SUCCESS;
+}
+
+uint32_t pdm_loudness_process(pdm_loudness_ctrl_t * p_ctrl, int32_t const * p_samples, uint32_t count)
+{
+    uint32_t completed = 0U;
+
+    for (uint32_t done = 0U; done < count; done += PDM_LOUDNESS_CHUNK)
+    {
+        uint32_t n = ((count - done) < PDM_LOUDNESS_CHUNK) ? (count - done) : PDM_LOUDNESS_CHUNK;
+        float    x[PDM_LOUDNESS_CHUNK];
+
+        pdm_dsp_to_float(&p_samples[done], x, n, p_ctrl->cfg.scale);
+        pdm_loudness_prv_peaks(p_ctrl, x, n);
+        pdm_dsp_biquad_process(&p_ctrl->k_weighting, x, x, n);
+
+        /* Squares of the weighted signal, up to the end of each step */
+        for (uint32_t i = 0U; i < n;)
+        {
+            uint32_t m   = p_ctrl->step_length - p_ctrl->step_fill;
+            float    sum = 0.0f;
+
+            m = ((n - i) < m) ? (n - i) : m;
+            for (uint32_t j = i; j < (i + m); j++)
+            {
+                sum += x[j] * x[j];
+            }
+
+            p_ctrl->step_sum  += sum;
+            p_ctrl->step_fill += m;
+            i                 += m;
+
+            if (p_ctrl->step_fill == p_ctrl->step_length)
+            {
+                pdm_loudness_prv_step_end(p_ctrl);
+                completed++;
+            }
+        }
+    }
+
+    return completed;
+}
+
+void pdm_loudness_get(pdm_loudness_ctrl_t const * p_ctrl, pdm_loudness_result_t * p_result)
+{
+    uint32_t steps = p_ctrl->steps;
+
+    p_result->momentary = (steps >= PDM_LOUDNESS_MOMENTARY_STEPS) ?
+                          pdm_loudness_prv_lufs((double) pdm_loudness_prv_window(p_ctrl,
+                                                                                 PDM_LOUDNESS_MOMENTARY_STEPS)) :
+                          PDM_LOUDNESS_FLOOR;
+    p_result->short_term = (steps >= PDM_LOUDNESS_SHORT_TERM_STEPS) ?
+                           pdm_loudness_prv_lufs((double) pdm_loudness_prv_window(p_ctrl,
+                                                                                  PDM_LOUDNESS_SHORT_TERM_STEPS)) :
+                           PDM_LOUDNESS_FLOOR;
+    p_result->momentary_max  = pdm_loudness_prv_lufs((double) p_ctrl->momentary_max);
+    p_result->short_term_max = pdm_loudness_prv_lufs((double) p_ctrl->short_term_max);
+    p_result->true_peak      = pdm_loudness_prv_db(p_ctrl->true_peak);
+    p_result->sample_peak    = pdm_loudness_prv_db(p_ctrl->sample_peak);
+    p_result->steps          = steps;
+    p_result->gated_blocks   = p_ctrl->gated_blocks;
+    p_result->integrated     = PDM_LOUDNESS_FLOOR;
+
+    if (0U == p_ctrl->gated_blocks)
+    {
+        return;
+    }
+
+    /* Relative gate from the absolutely gated mean; the bin holding it counts as above it */
+    float relative = pdm_loudness_prv_lufs(p_ctrl->gated_sum / (double) p_ctrl->gated_blocks) +
+                     PDM_LOUDNESS_RELATIVE_GATE;
+    uint32_t first = 0U;
+    if (relative > PDM_LOUDNESS_ABSOLUTE_GATE)
+    {
+        first = (uint32_t) ((relative - PDM_LOUDNESS_ABSOLUTE_GATE) * (float) PDM_LOUDNESS_BINS_PER_LU);
+        first = (first < PDM_LOUDNESS_BINS) ? first : (PDM_LOUDNESS_BINS - 1U);
+    }
+
+    double   sum   = 0.0;
+    uint32_t count = 0U;
+    for (uint32_t bin = first; bin < PDM_LOUDNESS_BINS; bin++)
+    {
+        sum   += p_ctrl->histogram_sum[bin];
+        count += p_ctrl->histogram_count[bin];
+    }
+
+    p_result->integrated = (0U != count) ? pdm_loudness_prv_lufs(sum / (double) count) : PDM_LOUDNESS_FLOOR;
+}
+
+fsp_err_t pdm_loudness_rate_set(pdm_loudness_ctrl_t * p_ctrl, uint32_t rate_hz)
+{
+    if ((rate_hz < PDM_LOUDNESS_PRV_MIN_RATE_HZ) || (rate_hz > PDM_LOUDNESS_PRV_MAX_RATE_HZ))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    /* New coefficients over the running state, so the filters do not start again from silence */
+    pdm_dsp_biquad_coeffs_t coeffs[2];
+    pdm_loudness_prv_design(coeffs, rate_hz);
+    memcpy(p_ctrl->k_weighting.coeffs, coeffs, sizeof(coeffs));
+
+    /* The step in progress keeps its length; the next ones follow the new rate */
+    p_ctrl->cfg.rate_hz = rate_hz;
+
+    return FSP_SUCCESS;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file pdm_loudness.h
+ * @brief Streaming loudness meter (ITU-R BS.1770): K-weighting, momentary, short-term, gated integrated, true peak
+ * @details One mono channel, metered block by block with constant memory:
+ *          - K-weighting: the BS.1770 pre-filter (high shelf) and RLB high pass as a pdm_dsp biquad cascade, designed
+ *            for the actual rate, so the 48 kHz coefficients of the standard are reproduced and other rates match
+ *          - the mean square of the weighted signal per 100 ms step; momentary loudness is the mean over the last
+ *            4 steps (400 ms), short-term over the last 30 (3 s)
+ *          - integrated loudness over every 400 ms gating block since open (75 % overlap), gated at -70 LUFS and
+ *            10 LU below the absolutely gated mean. Blocks go into a histogram of 0.1 LU bins that keeps their
+ *            energy sums, so the gate is exact to a bin and the gated mean is exact above it.
+ *          - true peak: 4x oversampling through a 48-tap polyphase interpolator (12 taps per phase), together with the
+ *            sample peak
+ *
+ *          Loudness is in LUFS (LU relative to full scale), with the channel weight of a front channel (1.0): a full
+ *          scale 997 Hz sine reads -3.01 LUFS. Values not available yet (less than 400 ms or 3 s metered, nothing
+ *          above the absolute gate) and silence read PDM_LOUDNESS_FLOOR. Samples are metered as one contiguous stream;
+ *          the caller leaves out what it does not want metered (settling after a filter swap).
+ *
+ *          All functions are foreground only.
+ */
+
+#ifndef PDM_LOUDNESS_H
+#define PDM_LOUDNESS_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_dsp.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Reading of a value not available yet, and of silence */
+#define PDM_LOUDNESS_FLOOR              (-200.0f)
+
+/** Measurement step, and the steps of the momentary and short-term windows */
+#define PDM_LOUDNESS_STEP_MS            (100U)
+#define PDM_LOUDNESS_MOMENTARY_STEPS    (4U)
+#define PDM_LOUDNESS_SHORT_TERM_STEPS   (30U)
+
+/** Gates of the integrated loudness */
+#define PDM_LOUDNESS_ABSOLUTE_GATE      (-70.0f)
+#define PDM_LOUDNESS_RELATIVE_GATE      (-10.0f)
+
+/** Histogram of the gating blocks: 0.1 LU bins from the absolute gate to +10 LUFS (blocks above go in the top bin) */
+#define PDM_LOUDNESS_BINS_PER_LU        (10U)
+#define PDM_LOUDNESS_BINS               (800U)
+
+/** True-peak interpolator */
+#define PDM_LOUDNESS_OVERSAMPLING       (4U)
+#define PDM_LOUDNESS_PHASE_TAPS         (12U)
+
+/** Samples filtered per pass (stack buffers) */
+#define PDM_LOUDNESS_CHUNK              (64U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Input settings */
+typedef struct st_pdm_loudness_cfg
+{
+    uint32_t rate_hz;                  ///< Sample rate
+    float    scale;                    ///< Sample to full scale 1.0, e.g. 1/2^19 for 20-bit samples
+} pdm_loudness_cfg_t;
+
+/** Readings, in LUFS and dBTP */
+typedef struct st_pdm_loudness_result
+{
+    float    momentary;                ///< Last 400 ms
+    float    short_term;               ///< Last 3 s
+    float    integrated;               ///< Gated, since open
+    float    momentary_max;            ///< Largest momentary loudness since open
+    float    short_term_max;           ///< Largest short-term loudness since open
+    float    true_peak;                ///< Largest interpolated |sample| since open, dBTP
+    float    sample_peak;              ///< Largest |sample| since open, dBFS
+    uint32_t steps;                    ///< 100 ms steps metered since open
+    uint32_t gated_blocks;             ///< Gating blocks above the absolute gate
+} pdm_loudness_result_t;
+
+/** Instance */
+typedef struct st_pdm_loudness_ctrl
+{
+    pdm_loudness_cfg_t cfg;
+    pdm_dsp_biquad_t   k_weighting;
+
+    /* 100 ms steps; their lengths alternate so the steps keep to the rate on average */
+    uint32_t           step_length;    ///< Samples of the current step
+    uint32_t           step_fill;      ///< Samples of it metered
+    uint32_t           step_remainder; ///< Bresenham phase of the step lengths, in tenths of a sample
+    float              step_sum;       ///< Sum of squares of the current step
+    float              ring_sum[PDM_LOUDNESS_SHORT_TERM_STEPS];     ///< Sums of squares of the last steps
+    uint32_t           ring_count[PDM_LOUDNESS_SHORT_TERM_STEPS];   ///< Their lengths
+    uint32_t           steps;          ///< Steps completed
+
+    /* Integrated loudness */
+    uint32_t           histogram_count[PDM_LOUDNESS_BINS];
+    double             histogram_sum[PDM_LOUDNESS_BINS];            ///< Mean squares of the blocks of each bin
+    double             gated_sum;      ///< Mean squares of all blocks above the absolute gate
+    uint32_t           gated_blocks;
+
+    /* Maxima */
+    float              momentary_max;  ///< Mean square
+    float              short_term_max; ///< Mean square
+    float              true_peak;      ///< Linear
+    float              sample_peak;    ///< Linear
+
+    /* True-peak interpolator: phase p, tap k applies to the k-th newest sample */
+    float              phase_taps[PDM_LOUDNESS_OVERSAMPLING][PDM_LOUDNESS_PHASE_TAPS];
+    float              history[2U * PDM_LOUDNESS_PHASE_TAPS];       ///< Mirrored, so no wrap in the inner loop
+    uint32_t           history_index;  ///< Position of the newest sample
+} pdm_loudness_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Start metering from silence
+ * @param[out] p_ctrl  Instance
+ * @param[in]  p_cfg   Input settings
+ * @retval FSP_SUCCESS               Ready
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Rate below 8 kHz or above 384 kHz, or scale not positive
+ */
+fsp_err_t pdm_loudness_open(pdm_loudness_ctrl_t * p_ctrl, pdm_loudness_cfg_t const * p_cfg);
+
+/**
+ * @brief Meter a block
+ * @param[in,out] p_ctrl     Instance
+ * @param[in]     p_samples  Signed samples
+ * @param[in]     count      Samples
+ * @return 100 ms steps completed in this block: new momentary and short-term readings
+ */
+uint32_t pdm_loudness_process(pdm_loudness_ctrl_t * p_ctrl, int32_t const * p_samples, uint32_t count);
+
+/**
+ * @brief Current readings
+ * @param[in]  p_ctrl    Instance
+ * @param[out] p_result  Readings
+ */
+void pdm_loudness_get(pdm_loudness_ctrl_t const * p_ctrl, pdm_loudness_result_t * p_result);
+
+/**
+ * @brief Follow a rate change (live filter swap): the K-weighting is redesigned, readings and filter state are kept
+ * @param[in,out] p_ctrl   Instance
+ * @param[in]     rate_hz  New rate, in the range of pdm_loudness_open()
+ * @retval FSP_SUCCESS               Changed
+ * @retval FSP_ERR_INVALID_ARGUMENT  Rate out of range
+ */
+fsp_err_t pdm_loudness_rate_set(pdm_loudness_ctrl_t * p_ctrl, uint32_t rate_hz);
+
+FSP_FOOTER
+
+#endif /* PDM_LOUDNESS_H */
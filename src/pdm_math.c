@@ -0,0 +1,266 @@
+/**
+ * @file pdm_math.c
+ * @brief Block trigonometry, window generation and benchmark for the math facade
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_math.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_MATH_BENCH_POINTS    (256U)  /**< Inputs per benchmark sweep */
+#define PDM_MATH_BENCH_RANGE     (64.0f) /**< Angle sweep is [-range, range] radians */
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+/* Keeps the benchmark loops from being optimized away */
+static volatile float g_pdm_math_sink;
+
+static float g_pdm_math_bench_x[PDM_MATH_BENCH_POINTS];
+static float g_pdm_math_bench_y[PDM_MATH_BENCH_POINTS];
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_math_sincos_block(float const * p_angle, float * p_sin, float * p_cos, uint32_t count)
+{
+    float s;
+    float c;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        pdm_math_sincosf(p_angle[i], &s, &c);
+
+        if (NULL != p_sin)
+        {
+            p_sin[i] = s;
+        }
+
+        if (NULL != p_cos)
+        {
+            p_cos[i] = c;
+        }
+    }
+}
+
+void pdm_math_polar_block(float const * p_re, float const * p_im, float * p_phase, float * p_magnitude,
+                          uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (NULL != p_phase)
+        {
+            p_phase[i] = pdm_math_atan2f(p_im[i], p_re[i]);
+        }
+
+        if (NULL != p_magnitude)
+        {
+            p_magnitude[i] = pdm_math_hypotf(p_re[i], p_im[i]);
+        }
+    }
+}
+
+void pdm_math_window(pdm_math_window_t window, float * p_window, uint32_t length)
+{
+    if (length < 2U)
+    {
+        if (1U == length)
+        {
+            p_window[0] = 1.0f;
+        }
+
+        return;
+    }
+
+    float step = PDM_MATH_TWO_PI / (float) (length - 1U);
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        float c1 = pdm_math_cosf(step * (float) i);
+
+        switch (window)
+        {
+            case PDM_MATH_WINDOW_HAMMING:
+            {
+                p_window[i] = 0.54f - 0.46f * c1;
+                break;
+            }
+
+            case PDM_MATH_WINDOW_BLACKMAN:
+            {
+                /* cos(2x) = 2cos^2(x) - 1 saves a second evaluation */
+                p_window[i] = 0.42f - 0.5f * c1 + 0.08f * (2.0f * c1 * c1 - 1.0f);
+                break;
+            }
+
+            case PDM_MATH_WINDOW_HANN:
+            default:
+            {
+                p_window[i] = 0.5f - 0.5f * c1;
+                break;
+            }
+        }
+    }
+}
+
+uint32_t pdm_math_benchmark(pdm_math_bench_t * p_results, uint32_t max_results)
+{
+    uint32_t n = 0;
+    uint32_t start;
+    float    acc;
+    float    err;
+
+    pdm_port_cycle_counter_init();
+
+    for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+    {
+        float t = ((float) i / (float) (PDM_MATH_BENCH_POINTS - 1U)) * 2.0f - 1.0f;
+        g_pdm_math_bench_x[i] = t * PDM_MATH_BENCH_RANGE;
+        g_pdm_math_bench_y[i] = (1.0f - t) * 3.0f - 2.5f;
+    }
+
+    /* sin */
+    if (n < max_results)
+    {
+        acc   = 0.0f;
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += pdm_math_sinf(g_pdm_math_bench_x[i]);
+        }
+
+        p_results[n].cycles_fast = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += sinf(g_pdm_math_bench_x[i]);
+        }
+
+        p_results[n].cycles_libm = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+        g_pdm_math_sink          = acc;
+
+        err = 0.0f;
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            float e = fabsf((float) ((double) pdm_math_sinf(g_pdm_math_bench_x[i]) -
+                                     sin((double) g_pdm_math_bench_x[i])));
+            err = (e > err) ? e : err;
+        }
+
+        p_results[n].p_name        = "sin";
+        p_results[n].max_abs_error = err;
+        n++;
+    }
+
+    /* cos */
+    if (n < max_results)
+    {
+        acc   = 0.0f;
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += pdm_math_cosf(g_pdm_math_bench_x[i]);
+        }
+
+        p_results[n].cycles_fast = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += cosf(g_pdm_math_bench_x[i]);
+        }
+
+        p_results[n].cycles_libm = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+        g_pdm_math_sink          = acc;
+
+        err = 0.0f;
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            float e = fabsf((float) ((double) pdm_math_cosf(g_pdm_math_bench_x[i]) -
+                                     cos((double) g_pdm_math_bench_x[i])));
+            err = (e > err) ? e : err;
+        }
+
+        p_results[n].p_name        = "cos";
+        p_results[n].max_abs_error = err;
+        n++;
+    }
+
+    /* atan2 */
+    if (n < max_results)
+    {
+        acc   = 0.0f;
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += pdm_math_atan2f(g_pdm_math_bench_y[i], g_pdm_math_bench_x[i]);
+        }
+
+        p_results[n].cycles_fast = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += atan2f(g_pdm_math_bench_y[i], g_pdm_math_bench_x[i]);
+        }
+
+        p_results[n].cycles_libm = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+        g_pdm_math_sink          = acc;
+
+        err = 0.0f;
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            float e = fabsf((float) ((double) pdm_math_atan2f(g_pdm_math_bench_y[i], g_pdm_math_bench_x[i]) -
+                                     atan2((double) g_pdm_math_bench_y[i], (double) g_pdm_math_bench_x[i])));
+            err = (e > err) ? e : err;
+        }
+
+        p_results[n].p_name        = "atan2";
+        p_results[n].max_abs_error = err;
+        n++;
+    }
+
+    /* hypot */
+    if (n < max_results)
+    {
+        acc   = 0.0f;
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += pdm_math_hypotf(g_pdm_math_bench_x[i], g_pdm_math_bench_y[i]);
+        }
+
+        p_results[n].cycles_fast = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+
+        start = pdm_port_cycles();
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            acc += hypotf(g_pdm_math_bench_x[i], g_pdm_math_bench_y[i]);
+        }
+
+        p_results[n].cycles_libm = (pdm_port_cycles() - start) / PDM_MATH_BENCH_POINTS;
+        g_pdm_math_sink          = acc;
+
+        err = 0.0f;
+        for (uint32_t i = 0; i < PDM_MATH_BENCH_POINTS; i++)
+        {
+            float e = fabsf((float) ((double) pdm_math_hypotf(g_pdm_math_bench_x[i], g_pdm_math_bench_y[i]) -
+                                     hypot((double) g_pdm_math_bench_x[i], (double) g_pdm_math_bench_y[i])));
+            err = (e > err) ? e : err;
+        }
+
+        p_results[n].p_name        = "hypot";
+        p_results[n].max_abs_error = err;
+        n++;
+    }
+
+    return n;
+}
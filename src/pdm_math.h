@@ -0,0 +1,258 @@
+/**
+ * @file pdm_math.h
+ * @brief Trigonometry facade for the audio path (fast software)
+ * @details sin/cos/atan2/hypot used by phase, angle and window computations. A range-reduced minimax polynomial is
+ *          used, which gives the same results on target and host. The RA8P1 has no Trigonometric Function Unit
+ *          (BSP_FEATURE_TFU_SUPPORTED is 0), so there is no bsp_tfu.h route.
+ *
+ *          Accuracy of the software path (measured against double precision, see pdm_math_benchmark()):
+ *          - sin/cos : |err| <= 1.0e-7 for |angle| <= 4096 rad
+ *          - atan2   : |err| <= 2.0e-6 rad
+ *          - hypot   : relative error <= 1 ulp (single sqrt)
+ */
+
+#ifndef PDM_MATH_H
+#define PDM_MATH_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include <math.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_MATH_PI           (3.14159265358979f)
+#define PDM_MATH_TWO_PI       (6.28318530717959f)
+#define PDM_MATH_HALF_PI      (1.57079632679490f)
+
+/** Three-part Cody-Waite split of pi/2; quadrant * PIO2_A is exact for |quadrant| < 2^15 */
+#define PDM_MATH_PRV_PIO2_A          (1.5703125f)
+#define PDM_MATH_PRV_PIO2_B          (4.837512969970703125e-4f)
+#define PDM_MATH_PRV_PIO2_C          (7.54978995489188216e-8f)
+#define PDM_MATH_PRV_TWO_OVER_PI     (0.63661977236758134f)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Window shapes supported by pdm_math_window() */
+typedef enum e_pdm_math_window
+{
+    PDM_MATH_WINDOW_HANN,              ///< 0.5 - 0.5 cos
+    PDM_MATH_WINDOW_HAMMING,           ///< 0.54 - 0.46 cos
+    PDM_MATH_WINDOW_BLACKMAN,          ///< 0.42 - 0.5 cos + 0.08 cos(2x)
+} pdm_math_window_t;
+
+/** One line of the benchmark report produced by pdm_math_benchmark() */
+typedef struct st_pdm_math_bench
+{
+    char const * p_name;               ///< Function name
+    uint32_t     cycles_fast;          ///< Cycles per call through the facade
+    uint32_t     cycles_libm;          ///< Cycles per call through libm
+    float        max_abs_error;        ///< Largest absolute error of the facade against double precision
+} pdm_math_bench_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Sine and cosine of a block of angles
+ * @param[in]  p_angle  Angles in radians
+ * @param[out] p_sin    Sine output (may be NULL)
+ * @param[out] p_cos    Cosine output (may be NULL)
+ * @param[in]  count    Number of angles
+ */
+void pdm_math_sincos_block(float const * p_angle, float * p_sin, float * p_cos, uint32_t count);
+
+/**
+ * @brief Phase and magnitude of a block of complex values (e.g. FFT bins)
+ * @param[in]  p_re        Real parts
+ * @param[in]  p_im        Imaginary parts
+ * @param[out] p_phase     atan2(im, re) in radians (may be NULL)
+ * @param[out] p_magnitude hypot(re, im) (may be NULL)
+ * @param[in]  count       Number of values
+ */
+void pdm_math_polar_block(float const * p_re, float const * p_im, float * p_phase, float * p_magnitude,
+                          uint32_t count);
+
+/**
+ * @brief Generate a symmetric analysis window
+ * @param[in]  window    Window shape
+ * @param[out] p_window  Output coefficients
+ * @param[in]  length    Window length (>= 2)
+ */
+void pdm_math_window(pdm_math_window_t window, float * p_window, uint32_t length);
+
+/**
+ * @brief Measure cycles per call and accuracy of the facade against libm
+ * @param[out] p_results    Result table
+ * @param[in]  max_results  Entries available in p_results
+ * @return Number of entries written
+ */
+uint32_t pdm_math_benchmark(pdm_math_bench_t * p_results, uint32_t max_results);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/**
+ * @brief Sine/cosine kernel shared by the software path
+ * @param[in]  angle  Angle in radians
+ * @param[out] p_sin  Sine
+ * @param[out] p_cos  Cosine
+ */
+static inline void pdm_math_prv_sincos_poly(float angle, float * p_sin, float * p_cos)
+{
+    /* Reduce to [-pi/4, pi/4] and a quadrant */
+    float   q        = angle * PDM_MATH_PRV_TWO_OVER_PI;
+    int32_t quadrant = (int32_t) (q + ((q >= 0.0f) ? 0.5f : -0.5f));
+    float   fq       = (float) quadrant;
+    float   r        = ((angle - fq * PDM_MATH_PRV_PIO2_A) - fq * PDM_MATH_PRV_PIO2_B) - fq * PDM_MATH_PRV_PIO2_C;
+    float   r2       = r * r;
+
+    /* Minimax polynomials on [-pi/4, pi/4] */
+    float s = r + (r * r2) * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    float c = 1.0f - 0.5f * r2 +
+              (r2 * r2) * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    switch ((uint32_t) quadrant & 3U)
+    {
+        case 0U:
+        {
+            *p_sin = s;
+            *p_cos = c;
+            break;
+        }
+
+        case 1U:
+        {
+            *p_sin = c;
+            *p_cos = -s;
+            break;
+        }
+
+        case 2U:
+        {
+            *p_sin = -s;
+            *p_cos = -c;
+            break;
+        }
+
+        default:
+        {
+            *p_sin = -c;
+            *p_cos = s;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Arc tangent kernel shared by the software path
+ * @param[in] y  Y coordinate
+ * @param[in] x  X coordinate
+ * @return atan2(y, x) in radians
+ */
+static inline float pdm_math_prv_atan2_poly(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float mx = (ax > ay) ? ax : ay;
+    float mn = (ax > ay) ? ay : ax;
+
+    /* Both zero: 0 or pi by the sign of x, as atan2 */
+    if (!(mx > 0.0f))
+    {
+        return copysignf(signbit(x) ? PDM_MATH_PI : 0.0f, y);
+    }
+
+    /* atan on [0, 1] */
+    float a = mn / mx;
+    float s = a * a;
+    float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s *
+                                                          (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+
+    if (ay > ax)
+    {
+        r = PDM_MATH_HALF_PI - r;
+    }
+
+    if (x < 0.0f)
+    {
+        r = PDM_MATH_PI - r;
+    }
+
+    /* Sign of y, -0 included: atan2(-0, x < 0) is -pi */
+    return copysignf(r, y);
+}
+
+/**
+ * @brief Sine and cosine of one angle
+ * @param[in]  angle  Angle in radians
+ * @param[out] p_sin  Sine
+ * @param[out] p_cos  Cosine
+ */
+static inline void pdm_math_sincosf(float angle, float * p_sin, float * p_cos)
+{
+    pdm_math_prv_sincos_poly(angle, p_sin, p_cos);
+}
+
+/**
+ * @brief Sine of one angle
+ * @param[in] angle  Angle in radians
+ * @return Sine
+ */
+static inline float pdm_math_sinf(float angle)
+{
+    float s;
+    float c;
+    pdm_math_prv_sincos_poly(angle, &s, &c);
+
+    return s;
+}
+
+/**
+ * @brief Cosine of one angle
+ * @param[in] angle  Angle in radians
+ * @return Cosine
+ */
+static inline float pdm_math_cosf(float angle)
+{
+    float s;
+    float c;
+    pdm_math_prv_sincos_poly(angle, &s, &c);
+
+    return c;
+}
+
+/**
+ * @brief Arc tangent of y/x using the signs of both to pick the quadrant
+ * @param[in] y  Y coordinate
+ * @param[in] x  X coordinate
+ * @return Angle in radians, [-pi, pi]
+ */
+static inline float pdm_math_atan2f(float y, float x)
+{
+    return pdm_math_prv_atan2_poly(y, x);
+}
+
+/**
+ * @brief Euclidean distance sqrt(x*x + y*y)
+ * @param[in] x  X coordinate
+ * @param[in] y  Y coordinate
+ * @return Hypotenuse
+ */
+static inline float pdm_math_hypotf(float x, float y)
+{
+    return sqrtf((x * x) + (y * y));
+}
+
+FSP_FOOTER
+
+#endif /* PDM_MATH_H */
@@ -0,0 +1,90 @@
+/**
+ * @file pdm_mem.c
+ * @brief Memory placement of the capture path (TCM, cache, DMA buffers)
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_mem.h"
+
+#if PDM_PORT_TARGET
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Granule of an Armv8-M MPU region */
+ #define PDM_MEM_PRV_MPU_GRANULE    (32U)
+
+/** MAIR attribute index of normal non-cacheable memory */
+ #define PDM_MEM_PRV_MPU_NOCACHE    (0U)
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Map the BSP's non-cacheable sections as bsp_init_mpu() does when the BSP "Data cache" property is enabled; that
+ * code is compiled out here, since BSP_CFG_DCACHE_ENABLED is 0 */
+static void pdm_mem_prv_nocache_map(void)
+{
+    /* Already mapped by the BSP startup (or an earlier call) */
+    if (0U != (MPU->CTRL & MPU_CTRL_ENABLE_Msk))
+    {
+        return;
+    }
+
+    ARM_MPU_SetMemAttr(PDM_MEM_PRV_MPU_NOCACHE, ARM_MPU_ATTR(ARM_MPU_ATTR_NON_CACHEABLE, ARM_MPU_ATTR_NON_CACHEABLE));
+
+    for (uint32_t i = 0U; i < g_init_info.nocache_count; i++)
+    {
+        uint32_t base  = (uint32_t) (uintptr_t) g_init_info.p_nocache_list[i].p_base;
+        uint32_t limit = (uint32_t) (uintptr_t) g_init_info.p_nocache_list[i].p_limit;
+
+        /* Empty sections (no SDRAM or OSPI use) get no region */
+        if (limit <= base)
+        {
+            continue;
+        }
+
+        ARM_MPU_SetRegion(i, ARM_MPU_RBAR(base, ARM_MPU_SH_NON, 0U, 0U, 1U),
+                          ARM_MPU_RLAR(limit - PDM_MEM_PRV_MPU_GRANULE, PDM_MEM_PRV_MPU_NOCACHE));
+    }
+
+    /* Default memory map for everything else, as the BSP does */
+    ARM_MPU_Enable(MPU_CTRL_PRIVDEFENA_Msk);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_mem_dcache_enable(void)
+{
+    if (0U != (SCB->CCR & SCB_CCR_DC_Msk))
+    {
+        return;
+    }
+
+    pdm_mem_prv_nocache_map();
+    SCB_EnableDCache();
+}
+
+void pdm_mem_init(void)
+{
+ #if PDM_CFG_DCACHE_ENABLE
+    pdm_mem_dcache_enable();
+ #endif
+}
+
+#else
+
+void pdm_mem_dcache_enable(void)
+{
+}
+
+void pdm_mem_init(void)
+{
+}
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file pdm_mem.h
+ * @brief Memory placement of the capture path (TCM, cache, DMA buffers)
+ * @details With PDM_CFG_TCM_ENABLE the code that runs on every PDM interrupt goes to ITCM and the data it touches to
+ *          DTCM, both zero wait state and outside the data cache:
+ *          - PDM_MEM_FAST_CODE: our callback chain (.itcm_code_from_flash, copied by the BSP startup)
+ *          - PDM_MEM_FAST_DATA: capture ring, work queue and integrity state (.dtcm, zeroed by the BSP startup)
+ *          - The FSP driver's pdm_dat_isr (which inlines r_pdm_fifo_read) and pdm_err_isr: the same section, given by
+ *            declarations in pdm_mem_driver.h that the build force-includes into the generated driver source
+ *
+ *          With PDM_CFG_DCACHE_ENABLE, pdm_mem_init() turns the data cache on through pdm_mem_dcache_enable(), which
+ *          first maps the BSP's non-cacheable sections non-cacheable with the MPU (the BSP only does so when its own
+ *          "Data cache" property is enabled). Memory read behind the CPU's back must then bypass or be maintained
+ *          against the cache:
+ *          - RTT control block and buffers live in .ram_nocache (PDM_MEM_NOCACHE, SEGGER_RTT_SECTION), because the
+ *            debugger reads and writes them directly
+ *          - the IPC ring, and in dual-core mode the recording core 1 stores into, are in .ram_noinit_nocache
+ *          - a DMA ring must be PDM_MEM_DMA_BUFFER aligned, a whole number of cache lines, and maintained with
+ *            pdm_mem_dma_to_device() / pdm_mem_dma_from_device(). TCM needs no maintenance.
+ *
+ *          On host all placement macros are empty.
+ */
+
+#ifndef PDM_MEM_H
+#define PDM_MEM_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_cfg.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Data cache line of the Cortex-M85 */
+#define PDM_MEM_CACHE_LINE    (32U)
+
+#if PDM_PORT_TARGET && PDM_CFG_TCM_ENABLE
+ #define PDM_MEM_FAST_CODE    BSP_PLACE_IN_SECTION(".itcm_code_from_flash")
+ #define PDM_MEM_FAST_DATA    BSP_PLACE_IN_SECTION(".dtcm")
+#else
+ #define PDM_MEM_FAST_CODE
+ #define PDM_MEM_FAST_DATA
+#endif
+
+#if PDM_PORT_TARGET
+ #define PDM_MEM_NOCACHE      BSP_PLACE_IN_SECTION(".ram_nocache")
+ #define PDM_MEM_DMA_BUFFER   BSP_ALIGN_VARIABLE(PDM_MEM_CACHE_LINE)
+#else
+ #define PDM_MEM_NOCACHE
+ #define PDM_MEM_DMA_BUFFER
+#endif
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Apply PDM_CFG_DCACHE_ENABLE
+ * @details Call once at startup, before RTT is used (R_BSP_WarmStart, BSP_WARM_START_POST_C).
+ */
+void pdm_mem_init(void);
+
+/**
+ * @brief Map the non-cacheable sections (.ram_nocache, .ram_noinit_nocache and their SDRAM and OSPI peers) with the
+ *        MPU unless it is already on, then turn the data cache on
+ * @details Does nothing if the cache is already on. SCB_DisableDCache() turns it off again; the mapping stays.
+ */
+void pdm_mem_dcache_enable(void);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/**
+ * @brief Make CPU writes to a DMA buffer visible to the DMA (clean)
+ * @param[in] p_buffer  PDM_MEM_DMA_BUFFER aligned buffer
+ * @param[in] bytes     Size, a multiple of PDM_MEM_CACHE_LINE
+ */
+static inline void pdm_mem_dma_to_device(void const * p_buffer, uint32_t bytes)
+{
+#if PDM_PORT_TARGET
+    if (0U != (SCB->CCR & SCB_CCR_DC_Msk))
+    {
+        SCB_CleanDCache_by_Addr((volatile void *) p_buffer, (int32_t) bytes);
+    }
+#else
+    FSP_PARAMETER_NOT_USED(p_buffer);
+    FSP_PARAMETER_NOT_USED(bytes);
+#endif
+}
+
+/**
+ * @brief Drop cached copies of a buffer the DMA has written (invalidate)
+ * @param[in] p_buffer  PDM_MEM_DMA_BUFFER aligned buffer
+ * @param[in] bytes     Size, a multiple of PDM_MEM_CACHE_LINE
+ */
+static inline void pdm_mem_dma_from_device(void * p_buffer, uint32_t bytes)
+{
+#if PDM_PORT_TARGET
+    if (0U != (SCB->CCR & SCB_CCR_DC_Msk))
+    {
+        SCB_InvalidateDCache_by_Addr(p_buffer, (int32_t) bytes);
+    }
+#else
+    FSP_PARAMETER_NOT_USED(p_buffer);
+    FSP_PARAMETER_NOT_USED(bytes);
+#endif
+}
+
+FSP_FOOTER
+
+#endif /* PDM_MEM_H */
@@ -0,0 +1,30 @@
+/**
+ * @file pdm_mem_driver.h
+ * @brief Placement of the FSP PDM driver's interrupt handlers
+ * @details Force-included ahead of the generated driver source (-include pdm_mem_driver.h on ra/fsp/src/r_pdm/r_pdm.c
+ *          in .cproject), so the driver is not edited. The declarations below carry PDM_MEM_FAST_CODE, and the compiler
+ *          applies a section attribute of an earlier declaration to the definition: pdm_dat_isr (which inlines
+ *          r_pdm_fifo_read) and pdm_err_isr land in the BSP's .itcm_code_from_flash input section, copied to ITCM by
+ *          the BSP startup like the rest of PDM_MEM_FAST_CODE. With PDM_CFG_TCM_ENABLE 0 they stay in flash.
+ */
+
+#ifndef PDM_MEM_DRIVER_H
+#define PDM_MEM_DRIVER_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_mem.h"
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+PDM_MEM_FAST_CODE void pdm_dat_isr(void);
+PDM_MEM_FAST_CODE void pdm_err_isr(void);
+
+FSP_FOOTER
+
+#endif /* PDM_MEM_DRIVER_H */
@@ -0,0 +1,145 @@
+/**
+ * @file pdm_port.h
+ * @brief Target/host portability layer for the PDM audio path
+ * @details Lets the processing modules under src/ build both for the RA8P1 (FSP/CMSIS) and for a Linux host.
+ *          On target the FSP headers are used directly. On host a minimal mirror of the FSP types is provided and
+ *          the cycle counter is backed by the monotonic clock (one "cycle" == one nanosecond).
+ */
+
+#ifndef PDM_PORT_H
+#define PDM_PORT_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_RENESAS_RA_)
+ #define PDM_PORT_TARGET    (1)
+ #include "bsp_api.h"
+#else
+ #define PDM_PORT_TARGET    (0)
+ #include <time.h>
+#endif
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#if !PDM_PORT_TARGET
+
+/** Host builds: same semantics as the FSP macros of the same name */
+ #define FSP_PARAMETER_NOT_USED(p)    (void) ((p))
+ #if defined(__cplusplus)
+  #define FSP_CPP_HEADER    extern "C" {
+  #define FSP_CPP_FOOTER    }
+ #else
+  #define FSP_CPP_HEADER
+  #define FSP_CPP_FOOTER
+ #endif
+ #define FSP_HEADER                   FSP_CPP_HEADER
+ #define FSP_FOOTER                   FSP_CPP_FOOTER
+ #define BSP_ALIGN_VARIABLE(V)        __attribute__((aligned(V)))
+#endif
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+#if !PDM_PORT_TARGET
+
+/** Host mirror of the FSP error codes used by the portable modules (values match fsp_common_api.h) */
+typedef enum e_fsp_err
+{
+    FSP_SUCCESS                = 0,
+    FSP_ERR_ASSERTION          = 1,
+    FSP_ERR_INVALID_POINTER    = 2,
+    FSP_ERR_INVALID_ARGUMENT   = 3,
+    FSP_ERR_INVALID_MODE       = 5,
+    FSP_ERR_UNSUPPORTED        = 6,
+    FSP_ERR_NOT_OPEN           = 7,
+    FSP_ERR_IN_USE             = 8,
+    FSP_ERR_OUT_OF_MEMORY      = 9,
+    FSP_ERR_OVERFLOW           = 12,
+    FSP_ERR_ALREADY_OPEN       = 14,
+    FSP_ERR_ABORTED            = 18,
+    FSP_ERR_TIMEOUT            = 20,
+    FSP_ERR_INVALID_SIZE       = 23,
+    FSP_ERR_INVALID_STATE      = 30,
+    FSP_ERR_NOT_INITIALIZED    = 33,
+    FSP_ERR_NOT_FOUND          = 34,
+    FSP_ERR_BUFFER_EMPTY       = 36,
+    FSP_ERR_INVALID_DATA       = 37,
+    FSP_ERR_INSUFFICIENT_SPACE = 205,
+    FSP_ERR_INVALID_ALIGNMENT  = 1003,
+    FSP_ERR_QUEUE_FULL         = 10000,
+    FSP_ERR_QUEUE_EMPTY        = 10001,
+} fsp_err_t;
+
+#endif
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/**
+ * @brief Enable the free-running cycle counter used by pdm_port_cycles()
+ * @details On target this turns on DWT CYCCNT. Safe to call more than once.
+ */
+static inline void pdm_port_cycle_counter_init(void)
+{
+#if PDM_PORT_TARGET
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief Read the free-running cycle counter
+ * @return Core cycles on target, nanoseconds on host (wraps at 32 bits in both cases)
+ */
+static inline uint32_t pdm_port_cycles(void)
+{
+#if PDM_PORT_TARGET
+    return DWT->CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec);
+#endif
+}
+
+/**
+ * @brief Frequency of the counter returned by pdm_port_cycles()
+ * @return Counts per second
+ */
+static inline uint32_t pdm_port_cycles_per_second(void)
+{
+#if PDM_PORT_TARGET
+    return SystemCoreClock;
+#else
+    return 1000000000U;
+#endif
+}
+
+/**
+ * @brief Full memory barrier between the producer and consumer side of a shared structure
+ * @details Orders plain stores/loads against each other, across cores on target and across threads on host.
+ */
+static inline void pdm_port_memory_barrier(void)
+{
+#if PDM_PORT_TARGET
+    __DMB();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+FSP_FOOTER
+
+#endif /* PDM_PORT_H */
@@ -0,0 +1,233 @@
+/**
+ * @file pdm_prof.c
+ * @brief DWT cycle-counter profiling of the PDM interrupts and callback
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_prof.h"
+
+#if PDM_CFG_PROF_ENABLE
+
+ #include "pdm_mem.h"
+ #include "SEGGER_RTT/SEGGER_RTT.h"
+ #include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/* Cortex exceptions plus the ICU entries allocated by the Configurator */
+ #define PDM_PROF_PRV_VECTOR_ENTRIES    (BSP_CORTEX_VECTOR_TABLE_ENTRIES + BSP_ICU_VECTOR_NUM_ENTRIES)
+
+/* VTOR needs the table aligned to its size rounded up to a power of two */
+ #define PDM_PROF_PRV_VECTOR_ALIGN      (512U)
+
+ #if (PDM_PROF_PRV_VECTOR_ENTRIES * 4U) > PDM_PROF_PRV_VECTOR_ALIGN
+  #error "Increase PDM_PROF_PRV_VECTOR_ALIGN for this vector table"
+ #endif
+
+/***********************************************************************************************************************
+ * Private function prototypes
+ **********************************************************************************************************************/
+
+static void pdm_prof_prv_dat_isr(void);
+static void pdm_prof_prv_err_isr(void);
+static void pdm_prof_prv_sdet_isr(void);
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+pdm_prof_stats_t g_pdm_prof_stats[PDM_PROF_POINT_COUNT];
+
+static char const * const g_pdm_prof_names[PDM_PROF_POINT_COUNT] =
+{
+    [PDM_PROF_POINT_DAT_ISR]   = "dat_isr",
+    [PDM_PROF_POINT_FIFO_READ] = "fifo_read",
+    [PDM_PROF_POINT_ERR_ISR]   = "err_isr",
+    [PDM_PROF_POINT_SDET_ISR]  = "sdet_isr",
+    [PDM_PROF_POINT_CALLBACK]  = "callback",
+};
+
+/* Wrappers and the handlers they call, indexed by point */
+static fsp_vector_t const g_pdm_prof_wrappers[PDM_PROF_POINT_COUNT] =
+{
+    [PDM_PROF_POINT_DAT_ISR]  = pdm_prof_prv_dat_isr,
+    [PDM_PROF_POINT_ERR_ISR]  = pdm_prof_prv_err_isr,
+    [PDM_PROF_POINT_SDET_ISR] = pdm_prof_prv_sdet_isr,
+};
+static fsp_vector_t g_pdm_prof_original[PDM_PROF_POINT_COUNT];
+
+static fsp_vector_t g_pdm_prof_vectors[PDM_PROF_PRV_VECTOR_ENTRIES] BSP_ALIGN_VARIABLE(PDM_PROF_PRV_VECTOR_ALIGN);
+static bool         g_pdm_prof_vectors_in_ram = false;
+
+static char g_pdm_prof_rtt_buffer[PDM_CFG_PROF_RTT_BUFFER_SIZE] PDM_MEM_NOCACHE;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Entry time against the nominal period grid of a periodic ISR */
+PDM_MEM_FAST_CODE static void pdm_prof_prv_entry(pdm_prof_stats_t * p_stats, uint32_t entry)
+{
+    uint32_t interval = entry - p_stats->last_entry;
+    p_stats->last_entry = entry;
+
+    /* Skip the first entry and gaps (capture stopped or a missed interrupt) */
+    if ((0U == p_stats->period) || (0U == p_stats->count) || (interval >= (p_stats->period * 2U)))
+    {
+        return;
+    }
+
+    uint32_t latency = (interval > p_stats->period) ? (interval - p_stats->period) : (p_stats->period - interval);
+
+    p_stats->latency_count++;
+    if (latency > p_stats->latency_max)
+    {
+        p_stats->latency_max = latency;
+    }
+
+    p_stats->hist_latency[pdm_prof_bucket(latency)]++;
+}
+
+PDM_MEM_FAST_CODE static void pdm_prof_prv_isr(pdm_prof_point_t point)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    pdm_prof_prv_entry(&g_pdm_prof_stats[point], start);
+    g_pdm_prof_original[point]();
+
+    pdm_prof_record(point, DWT->CYCCNT - start);
+}
+
+PDM_MEM_FAST_CODE static void pdm_prof_prv_dat_isr(void)
+{
+    uint32_t start     = DWT->CYCCNT;
+    uint32_t callbacks = g_pdm_prof_stats[PDM_PROF_POINT_CALLBACK].count;
+
+    pdm_prof_prv_entry(&g_pdm_prof_stats[PDM_PROF_POINT_DAT_ISR], start);
+    g_pdm_prof_original[PDM_PROF_POINT_DAT_ISR]();
+
+    uint32_t cycles    = DWT->CYCCNT - start;
+    uint32_t fifo_read = cycles;
+
+    /* The callback runs inside the data ISR once per block */
+    if (callbacks != g_pdm_prof_stats[PDM_PROF_POINT_CALLBACK].count)
+    {
+        uint32_t callback = g_pdm_prof_stats[PDM_PROF_POINT_CALLBACK].last;
+        fifo_read = (cycles > callback) ? (cycles - callback) : 0U;
+    }
+
+    pdm_prof_record(PDM_PROF_POINT_DAT_ISR, cycles);
+    pdm_prof_record(PDM_PROF_POINT_FIFO_READ, fifo_read);
+}
+
+PDM_MEM_FAST_CODE static void pdm_prof_prv_err_isr(void)
+{
+    pdm_prof_prv_isr(PDM_PROF_POINT_ERR_ISR);
+}
+
+static void pdm_prof_prv_sdet_isr(void)
+{
+    pdm_prof_prv_isr(PDM_PROF_POINT_SDET_ISR);
+}
+
+static void pdm_prof_prv_hist_export(char const * p_name, char const * p_kind, uint32_t const * p_hist)
+{
+    SEGGER_RTT_printf(PDM_CFG_PROF_RTT_CHANNEL, "hist,%s,%s", p_name, p_kind);
+
+    for (uint32_t b = 0U; b < PDM_PROF_HIST_BUCKETS; b++)
+    {
+        SEGGER_RTT_printf(PDM_CFG_PROF_RTT_CHANNEL, ",%u", p_hist[b]);
+    }
+
+    SEGGER_RTT_printf(PDM_CFG_PROF_RTT_CHANNEL, "\n");
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+void pdm_prof_open(void)
+{
+    pdm_port_cycle_counter_init();
+
+    (void) SEGGER_RTT_ConfigUpBuffer(PDM_CFG_PROF_RTT_CHANNEL, "PdmProf", g_pdm_prof_rtt_buffer,
+                                     sizeof(g_pdm_prof_rtt_buffer), SEGGER_RTT_MODE_NO_BLOCK_TRIM);
+
+    pdm_prof_reset();
+}
+
+fsp_err_t pdm_prof_isr_wrap(pdm_prof_point_t point, IRQn_Type irq)
+{
+    uint32_t entry = (uint32_t) ((int32_t) irq + (int32_t) BSP_CORTEX_VECTOR_TABLE_ENTRIES);
+
+    if ((point >= PDM_PROF_POINT_COUNT) || (NULL == g_pdm_prof_wrappers[point]) || ((int32_t) irq < 0) ||
+        (entry >= PDM_PROF_PRV_VECTOR_ENTRIES))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    FSP_CRITICAL_SECTION_DEFINE;
+    FSP_CRITICAL_SECTION_ENTER;
+
+    if (!g_pdm_prof_vectors_in_ram)
+    {
+        memcpy(g_pdm_prof_vectors, (void const *) SCB->VTOR, sizeof(g_pdm_prof_vectors));
+        __DSB();
+        SCB->VTOR = (uint32_t) g_pdm_prof_vectors;
+        __DSB();
+        __ISB();
+        g_pdm_prof_vectors_in_ram = true;
+    }
+
+    g_pdm_prof_original[point] = g_pdm_prof_vectors[entry];
+    g_pdm_prof_vectors[entry]  = g_pdm_prof_wrappers[point];
+    __DSB();
+
+    FSP_CRITICAL_SECTION_EXIT;
+
+    return FSP_SUCCESS;
+}
+
+void pdm_prof_period_set(pdm_prof_point_t point, uint32_t cycles)
+{
+    g_pdm_prof_stats[point].period = cycles;
+}
+
+void pdm_prof_reset(void)
+{
+    for (uint32_t p = 0U; p < PDM_PROF_POINT_COUNT; p++)
+    {
+        pdm_prof_stats_t * p_stats = &g_pdm_prof_stats[p];
+        uint32_t           period  = p_stats->period;
+
+        memset(p_stats, 0, sizeof(*p_stats));
+        p_stats->min    = UINT32_MAX;
+        p_stats->period = period;
+    }
+}
+
+void pdm_prof_export(void)
+{
+    for (uint32_t p = 0U; p < PDM_PROF_POINT_COUNT; p++)
+    {
+        pdm_prof_stats_t const * p_stats = &g_pdm_prof_stats[p];
+        uint32_t                 mean    = (0U != p_stats->count) ? (uint32_t) (p_stats->total / p_stats->count) : 0U;
+
+        SEGGER_RTT_printf(PDM_CFG_PROF_RTT_CHANNEL, "prof,%s,%u,%u,%u,%u,%u,%u\n", g_pdm_prof_names[p],
+                          p_stats->count, (0U != p_stats->count) ? p_stats->min : 0U, p_stats->max, mean,
+                          p_stats->latency_count, p_stats->latency_max);
+        pdm_prof_prv_hist_export(g_pdm_prof_names[p], "dur", p_stats->hist_duration);
+        pdm_prof_prv_hist_export(g_pdm_prof_names[p], "lat", p_stats->hist_latency);
+    }
+}
+
+pdm_prof_stats_t const * pdm_prof_stats_get(pdm_prof_point_t point)
+{
+    return &g_pdm_prof_stats[point];
+}
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * @file pdm_prof.h
+ * @brief DWT cycle-counter profiling of the PDM interrupts and callback
+ * @details Each profiling point keeps count/min/max/mean of its duration plus log2 histograms of duration and entry
+ *          latency, all in fixed memory. Recording is a handful of loads/stores and one CLZ, safe from any interrupt
+ *          as long as every point is recorded from a single interrupt priority.
+ *
+ *          The PDM ISRs live in the FSP driver, so they are measured without touching it: pdm_prof_isr_wrap()
+ *          moves the vector table to RAM and points the IRQ at a wrapper that reads CYCCNT around the original
+ *          handler. r_pdm_fifo_read() is static in the driver; its cost is reported as the data ISR time minus the
+ *          callback time of the same invocation.
+ *
+ *          Entry latency cannot be read back from the PDM peripheral. For a periodic interrupt the wrapper instead
+ *          measures how far each entry lands from the nominal period set with pdm_prof_period_set(), which captures
+ *          the latency variation (jitter) caused by masking and higher priority work.
+ *
+ *          Results are exported on demand as text lines on RTT up channel PDM_CFG_PROF_RTT_CHANNEL, away from the
+ *          terminal on channel 0.
+ *
+ *          Target only. With PDM_CFG_PROF_ENABLE set to 0 every PDM_PROF_* macro expands to nothing and pdm_prof.c
+ *          is empty.
+ */
+
+#ifndef PDM_PROF_H
+#define PDM_PROF_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_cfg.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Number of log2 histogram buckets: bucket b counts values in [2^(b-1), 2^b), bucket 0 counts zero */
+#define PDM_PROF_HIST_BUCKETS    (33U)
+
+#if PDM_CFG_PROF_ENABLE
+ #define PDM_PROF_OPEN()                     pdm_prof_open()
+ #define PDM_PROF_ISR_WRAP(point, irq)       pdm_prof_isr_wrap((point), (irq))
+ #define PDM_PROF_PERIOD_SET(point, cycles)  pdm_prof_period_set((point), (cycles))
+ #define PDM_PROF_RECORD(point, cycles)      pdm_prof_record((point), (cycles))
+ #define PDM_PROF_RESET()                    pdm_prof_reset()
+ #define PDM_PROF_EXPORT()                   pdm_prof_export()
+#else
+ #define PDM_PROF_OPEN()
+ #define PDM_PROF_ISR_WRAP(point, irq)
+ #define PDM_PROF_PERIOD_SET(point, cycles)
+ #define PDM_PROF_RECORD(point, cycles)
+ #define PDM_PROF_RESET()
+ #define PDM_PROF_EXPORT()
+#endif
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Profiling points */
+typedef enum e_pdm_prof_point
+{
+    PDM_PROF_POINT_DAT_ISR,            ///< pdm_dat_isr, whole handler
+    PDM_PROF_POINT_FIFO_READ,          ///< pdm_dat_isr minus pdm0_callback (FIFO drain and driver bookkeeping)
+    PDM_PROF_POINT_ERR_ISR,            ///< pdm_err_isr, whole handler
+    PDM_PROF_POINT_SDET_ISR,           ///< pdm_sdet_isr, whole handler
+    PDM_PROF_POINT_CALLBACK,           ///< pdm0_callback, data events (the ones that run inside pdm_dat_isr)
+    PDM_PROF_POINT_COUNT,
+} pdm_prof_point_t;
+
+/** Statistics of one point */
+typedef struct st_pdm_prof_stats
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t last;                                    ///< Most recent duration
+    uint32_t period;                                  ///< Nominal entry period, 0 if not periodic
+    uint32_t last_entry;                              ///< CYCCNT at the previous entry
+    uint32_t latency_count;
+    uint32_t latency_max;
+    uint32_t hist_duration[PDM_PROF_HIST_BUCKETS];
+    uint32_t hist_latency[PDM_PROF_HIST_BUCKETS];
+} pdm_prof_stats_t;
+
+#if PDM_CFG_PROF_ENABLE
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Start the cycle counter, configure the RTT export channel and clear all points
+ */
+void pdm_prof_open(void);
+
+/**
+ * @brief Route an IRQ through the profiling wrapper of an ISR point
+ * @param[in] point  PDM_PROF_POINT_DAT_ISR, PDM_PROF_POINT_ERR_ISR or PDM_PROF_POINT_SDET_ISR
+ * @param[in] irq    IRQ of the handler to measure
+ * @retval FSP_SUCCESS               Wrapper installed
+ * @retval FSP_ERR_INVALID_ARGUMENT  point has no wrapper or irq is out of range
+ */
+fsp_err_t pdm_prof_isr_wrap(pdm_prof_point_t point, IRQn_Type irq);
+
+/**
+ * @brief Set the nominal entry period of a periodic ISR point (enables the latency histogram)
+ * @param[in] point   Profiling point
+ * @param[in] cycles  Expected cycles between entries
+ */
+void pdm_prof_period_set(pdm_prof_point_t point, uint32_t cycles);
+
+/**
+ * @brief Clear the statistics of every point
+ */
+void pdm_prof_reset(void);
+
+/**
+ * @brief Write every point as text lines on the profiling RTT channel
+ * @details Line formats:
+ *          - `prof,<point>,<count>,<min>,<max>,<mean>,<latency count>,<latency max>`
+ *          - `hist,<point>,dur,<bucket 0>,...,<bucket 32>`
+ *          - `hist,<point>,lat,<bucket 0>,...,<bucket 32>`
+ */
+void pdm_prof_export(void);
+
+/**
+ * @brief Read the statistics of one point
+ * @param[in] point  Profiling point
+ * @return Statistics (live, may change while read)
+ */
+pdm_prof_stats_t const * pdm_prof_stats_get(pdm_prof_point_t point);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+extern pdm_prof_stats_t g_pdm_prof_stats[PDM_PROF_POINT_COUNT];
+
+/**
+ * @brief log2 bucket of a value
+ * @param[in] value  Cycles
+ * @return 0 for 0, otherwise floor(log2(value)) + 1
+ */
+static inline uint32_t pdm_prof_bucket(uint32_t value)
+{
+    return 32U - __CLZ(value);
+}
+
+/**
+ * @brief Add one duration to a point (call from the single priority that owns the point)
+ * @param[in] point   Profiling point
+ * @param[in] cycles  Duration
+ */
+static inline void pdm_prof_record(pdm_prof_point_t point, uint32_t cycles)
+{
+    pdm_prof_stats_t * p_stats = &g_pdm_prof_stats[point];
+
+    p_stats->count++;
+    p_stats->total += cycles;
+    p_stats->last   = cycles;
+
+    if (cycles < p_stats->min)
+    {
+        p_stats->min = cycles;
+    }
+
+    if (cycles > p_stats->max)
+    {
+        p_stats->max = cycles;
+    }
+
+    p_stats->hist_duration[pdm_prof_bucket(cycles)]++;
+}
+
+FSP_FOOTER
+
+#endif
+
+#endif /* PDM_PROF_H */
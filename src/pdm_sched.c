@@ -0,0 +1,283 @@
+/**
+ * @file pdm_sched.c
+ * @brief Event-driven main loop support (WFI sleep, SysTick timer, CPU load measurement)
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_sched.h"
+#include "pdm_mem.h"
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+void SysTick_Handler(void);
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static volatile uint32_t g_sched_pending       = 0U;
+static volatile uint32_t g_sched_ticks         = 0U;
+static volatile uint32_t g_sched_timer_ticks   = 0U; ///< Ticks left until PDM_SCHED_EVENT_TIMER, 0 when idle
+static uint32_t          g_sched_tick_hz       = 0U;
+static volatile bool     g_sched_tick_events   = false;
+
+/* Timestamp: core cycles at the start of the current SysTick period, only touched inside a critical section */
+static uint64_t g_sched_stamp_base = 0U;
+
+/* Load measurement, foreground only */
+static uint32_t g_sched_window_start_tick = 0U;
+static uint32_t g_sched_awake_since       = 0U;
+static uint64_t g_sched_busy_cycles       = 0U;
+static uint32_t g_sched_wakeups           = 0U;
+static uint32_t g_sched_work_count        = 0U;
+static uint32_t g_sched_work_max_cycles   = 0U;
+static uint64_t g_sched_work_total_cycles = 0U;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static uint32_t pdm_sched_prv_ms_to_ticks(uint32_t ms)
+{
+    uint64_t ticks = (((uint64_t) ms * g_sched_tick_hz) + 999U) / 1000U;
+
+    return (0U == ticks) ? 1U : (uint32_t) ticks;
+}
+
+/* WFI with the awake span accounted. Called with PRIMASK set. */
+static void pdm_sched_prv_sleep(void)
+{
+    g_sched_busy_cycles += (uint32_t) (pdm_port_cycles() - g_sched_awake_since);
+
+    __DSB();
+    __WFI();
+
+    g_sched_awake_since = pdm_port_cycles();
+    g_sched_wakeups++;
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_sched_open(uint32_t tick_hz)
+{
+    if ((0U == tick_hz) || (tick_hz > SystemCoreClock))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    g_sched_pending     = 0U;
+    g_sched_ticks       = 0U;
+    g_sched_timer_ticks = 0U;
+    g_sched_tick_hz     = tick_hz;
+
+    /* Lowest priority, so the tick never delays the PDM interrupts */
+    if (0U != SysTick_Config(SystemCoreClock / tick_hz))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Timestamps count from here; reading CTRL clears a stale COUNTFLAG */
+    g_sched_stamp_base = 0U;
+    (void) SysTick->CTRL;
+
+    pdm_port_cycle_counter_init();
+    pdm_sched_stats_reset();
+
+    return FSP_SUCCESS;
+}
+
+void pdm_sched_close(void)
+{
+    SysTick->CTRL       = 0U;
+    g_sched_timer_ticks = 0U;
+    g_sched_pending     = 0U;
+}
+
+PDM_MEM_FAST_CODE void pdm_sched_post(uint32_t events)
+{
+    /* Handlers of different priorities may post concurrently */
+    FSP_CRITICAL_SECTION_DEFINE;
+    FSP_CRITICAL_SECTION_ENTER;
+    g_sched_pending |= events;
+    FSP_CRITICAL_SECTION_EXIT;
+}
+
+uint32_t pdm_sched_wait(void)
+{
+    uint32_t events = 0U;
+
+    while (0U == events)
+    {
+        /* PRIMASK rather than the FSP critical section: an interrupt masked by BASEPRI would not wake WFI */
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        events          = g_sched_pending;
+        g_sched_pending = 0U;
+
+        if (0U == events)
+        {
+            pdm_sched_prv_sleep();
+        }
+
+        /* The handler that woke us runs here */
+        __set_PRIMASK(primask);
+    }
+
+    return events;
+}
+
+PDM_MEM_FAST_CODE uint64_t pdm_sched_timestamp(void)
+{
+    uint32_t period = SysTick->LOAD + 1U;
+
+    FSP_CRITICAL_SECTION_DEFINE;
+    FSP_CRITICAL_SECTION_ENTER;
+
+    /* COUNTFLAG is set by every wrap and cleared by reading CTRL; the second read catches a wrap during the VAL read */
+    if (0U != (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk))
+    {
+        g_sched_stamp_base += period;
+    }
+
+    uint32_t value = SysTick->VAL;
+
+    if (0U != (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk))
+    {
+        g_sched_stamp_base += period;
+        value               = SysTick->VAL;
+    }
+
+    uint64_t stamp = g_sched_stamp_base + (period - 1U - value);
+
+    FSP_CRITICAL_SECTION_EXIT;
+
+    return stamp;
+}
+
+uint32_t pdm_sched_ticks(void)
+{
+    return g_sched_ticks;
+}
+
+void pdm_sched_tick_events(bool enable)
+{
+    g_sched_tick_events = enable;
+}
+
+void pdm_sched_timer_start(uint32_t ms)
+{
+    g_sched_timer_ticks = pdm_sched_prv_ms_to_ticks(ms);
+}
+
+void pdm_sched_sleep_ms(uint32_t ms)
+{
+    uint32_t start    = g_sched_ticks;
+    uint32_t duration = pdm_sched_prv_ms_to_ticks(ms);
+    uint32_t deferred = 0U;
+
+    /* Elapsed ticks, not a deadline, so a tick counter wrap is harmless */
+    while ((g_sched_ticks - start) < duration)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        deferred       |= g_sched_pending;
+        g_sched_pending = 0U;
+
+        if ((g_sched_ticks - start) < duration)
+        {
+            pdm_sched_prv_sleep();
+        }
+
+        __set_PRIMASK(primask);
+    }
+
+    if (0U != deferred)
+    {
+        pdm_sched_post(deferred);
+    }
+}
+
+void pdm_sched_work_account(uint32_t cycles)
+{
+    g_sched_work_count++;
+    g_sched_work_total_cycles += cycles;
+
+    if (cycles > g_sched_work_max_cycles)
+    {
+        g_sched_work_max_cycles = cycles;
+    }
+}
+
+void pdm_sched_stats_get(pdm_sched_stats_t * p_stats)
+{
+    uint32_t now = pdm_port_cycles();
+
+    /* Close the current awake span without starting a new window */
+    g_sched_busy_cycles += (uint32_t) (now - g_sched_awake_since);
+    g_sched_awake_since  = now;
+
+    p_stats->ticks             = g_sched_ticks - g_sched_window_start_tick;
+    p_stats->wall_cycles       = (uint64_t) p_stats->ticks * (SystemCoreClock / g_sched_tick_hz);
+    p_stats->busy_cycles       = g_sched_busy_cycles;
+    p_stats->wakeups           = g_sched_wakeups;
+    p_stats->work_count        = g_sched_work_count;
+    p_stats->work_max_cycles   = g_sched_work_max_cycles;
+    p_stats->work_total_cycles = g_sched_work_total_cycles;
+
+    if ((0U == p_stats->wall_cycles) || (p_stats->busy_cycles >= p_stats->wall_cycles))
+    {
+        p_stats->idle_permille = 0U;
+    }
+    else
+    {
+        p_stats->idle_permille =
+            (uint32_t) (1000U - ((p_stats->busy_cycles * 1000U) / p_stats->wall_cycles));
+    }
+}
+
+void pdm_sched_stats_reset(void)
+{
+    g_sched_window_start_tick = g_sched_ticks;
+    g_sched_awake_since       = pdm_port_cycles();
+    g_sched_busy_cycles       = 0U;
+    g_sched_wakeups           = 0U;
+    g_sched_work_count        = 0U;
+    g_sched_work_max_cycles   = 0U;
+    g_sched_work_total_cycles = 0U;
+}
+
+/*******************************************************************************************************************//**
+ * SysTick interrupt. Overrides the weak default from startup.c; advances the tick and the one-shot timer.
+ **********************************************************************************************************************/
+void SysTick_Handler(void)
+{
+    g_sched_ticks++;
+
+    /* One read per period keeps the timestamp from missing a wrap, whoever else reads it */
+    (void) pdm_sched_timestamp();
+
+    if (g_sched_tick_events)
+    {
+        pdm_sched_post(PDM_SCHED_EVENT_TICK);
+    }
+
+    uint32_t remaining = g_sched_timer_ticks;
+    if (0U != remaining)
+    {
+        remaining--;
+        g_sched_timer_ticks = remaining;
+
+        if (0U == remaining)
+        {
+            pdm_sched_post(PDM_SCHED_EVENT_TIMER);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * @file pdm_sched.h
+ * @brief Event-driven main loop support: WFI sleep between interrupts, software timer, CPU load measurement
+ * @details Interrupt handlers post event bits with pdm_sched_post(). The foreground calls pdm_sched_wait(), which
+ *          sleeps with WFI until at least one event is pending and then returns (and clears) the pending set.
+ *
+ *          The sleep is entered with PRIMASK set, so an interrupt that becomes pending between the last check and
+ *          WFI still wakes the core; its handler runs as soon as PRIMASK is cleared again.
+ *
+ *          Load measurement: the cycle counter is only sampled while the core is awake (from wake-up to the next
+ *          WFI, interrupt handlers included), so the result does not depend on whether DWT keeps counting in sleep.
+ *          Wall time comes from the SysTick tick, which keeps running in sleep mode.
+ *
+ *          Timestamps: pdm_sched_timestamp() extends the SysTick down-counter to a monotonic 64-bit count of core
+ *          cycles (ticks times the reload period, plus the count into the current period). Unlike DWT CYCCNT it keeps
+ *          running in sleep, and it never wraps in practice. The wrap of the counter is detected with COUNTFLAG,
+ *          which nothing else in the application reads; the tick handler reads the timestamp once per period, so no
+ *          wrap goes unseen. A read is a bounded sequence of register accesses inside a short critical section, so
+ *          interrupt handlers can stamp events with it.
+ */
+
+#ifndef PDM_SCHED_H
+#define PDM_SCHED_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Event bits, posted from interrupt context */
+#define PDM_SCHED_EVENT_BLOCK      (1U << 0)   ///< A PDM block completed
+#define PDM_SCHED_EVENT_SOUND      (1U << 1)   ///< Sound detection fired
+#define PDM_SCHED_EVENT_ERROR      (1U << 2)   ///< PDM error interrupt
+#define PDM_SCHED_EVENT_TIMER      (1U << 3)   ///< Timer started with pdm_sched_timer_start() expired
+#define PDM_SCHED_EVENT_WORK       (1U << 4)   ///< Deferred work queued (pdm_work)
+#define PDM_SCHED_EVENT_TICK       (1U << 5)   ///< Every tick, while enabled with pdm_sched_tick_events()
+
+/** First event bit free for application use */
+#define PDM_SCHED_EVENT_USER       (1U << 8)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** CPU load over the measurement window (since pdm_sched_open() or the last pdm_sched_stats_reset()) */
+typedef struct st_pdm_sched_stats
+{
+    uint32_t ticks;                    ///< Window length in ticks
+    uint64_t wall_cycles;              ///< Window length in core cycles
+    uint64_t busy_cycles;              ///< Cycles spent awake (foreground and interrupts)
+    uint32_t idle_permille;            ///< 1000 * (1 - busy / wall)
+    uint32_t wakeups;                  ///< Number of WFI wake-ups
+    uint32_t work_count;               ///< Jobs reported with pdm_sched_work_account()
+    uint32_t work_max_cycles;          ///< Longest single job
+    uint64_t work_total_cycles;        ///< Sum of all jobs
+} pdm_sched_stats_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Start the tick and reset the load measurement
+ * @param[in] tick_hz  SysTick frequency; SystemCoreClock / tick_hz must fit the 24-bit reload register
+ * @retval FSP_SUCCESS               Tick running
+ * @retval FSP_ERR_INVALID_ARGUMENT  Tick frequency out of range
+ */
+fsp_err_t pdm_sched_open(uint32_t tick_hz);
+
+/**
+ * @brief Stop the tick. Pending events are discarded.
+ */
+void pdm_sched_close(void);
+
+/**
+ * @brief Mark events as pending (interrupt safe)
+ * @param[in] events  PDM_SCHED_EVENT_* bits
+ */
+void pdm_sched_post(uint32_t events);
+
+/**
+ * @brief Sleep until at least one event is pending
+ * @return Pending event bits; they are cleared
+ */
+uint32_t pdm_sched_wait(void);
+
+/**
+ * @brief Monotonic timestamp (interrupt safe, constant time)
+ * @return Core cycles since pdm_sched_open()
+ */
+uint64_t pdm_sched_timestamp(void);
+
+/**
+ * @brief Ticks since pdm_sched_open()
+ * @return Tick count
+ */
+uint32_t pdm_sched_ticks(void);
+
+/**
+ * @brief Post PDM_SCHED_EVENT_TICK on every tick, for polling work that has no interrupt (RTT down channels)
+ * @param[in] enable  true to post, false to stop
+ */
+void pdm_sched_tick_events(bool enable);
+
+/**
+ * @brief Post PDM_SCHED_EVENT_TIMER once, after a delay. Restarting cancels the previous timeout.
+ * @param[in] ms  Delay in milliseconds (rounded up to whole ticks)
+ */
+void pdm_sched_timer_start(uint32_t ms);
+
+/**
+ * @brief Sleep for a delay, keeping interrupts serviced. Other events posted meanwhile stay pending.
+ * @param[in] ms  Delay in milliseconds (rounded up to whole ticks)
+ */
+void pdm_sched_sleep_ms(uint32_t ms);
+
+/**
+ * @brief Report the duration of one foreground job (for headroom reporting)
+ * @param[in] cycles  Cycles measured with pdm_port_cycles()
+ */
+void pdm_sched_work_account(uint32_t cycles);
+
+/**
+ * @brief Snapshot the load measurement
+ * @param[out] p_stats  Statistics
+ */
+void pdm_sched_stats_get(pdm_sched_stats_t * p_stats);
+
+/**
+ * @brief Restart the measurement window
+ */
+void pdm_sched_stats_reset(void);
+
+FSP_FOOTER
+
+#endif /* PDM_SCHED_H */
@@ -0,0 +1,255 @@
+/**
+ * @file pdm_segment.c
+ * @brief Event-segmented long-term store
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_segment.h"
+#include <math.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static pdm_segment_entry_t * pdm_segment_prv_entry(pdm_segment_ctrl_t const * p_ctrl, uint32_t id)
+{
+    return &p_ctrl->cfg.p_index[id % p_ctrl->cfg.entries];
+}
+
+/* Write one sample at the end of the log; the oldest segments whose data it overwrites are evicted */
+static void pdm_segment_prv_put(pdm_segment_ctrl_t * p_ctrl, uint32_t word)
+{
+    /* pre_samples + max_samples fit the pool, so the open segment never overwrites itself */
+    while ((p_ctrl->oldest_id != p_ctrl->next_id) &&
+           ((pdm_segment_prv_entry(p_ctrl, p_ctrl->oldest_id)->position + p_ctrl->cfg.capacity) <= p_ctrl->written))
+    {
+        p_ctrl->oldest_id++;
+        p_ctrl->evicted++;
+    }
+
+    p_ctrl->cfg.p_pool[p_ctrl->head] = word;
+    p_ctrl->head = (p_ctrl->head + 1U < p_ctrl->cfg.capacity) ? (p_ctrl->head + 1U) : 0U;
+    p_ctrl->written++;
+}
+
+static void pdm_segment_prv_preroll_put(pdm_segment_ctrl_t * p_ctrl, uint32_t word)
+{
+    uint32_t pre = p_ctrl->cfg.pre_samples;
+
+    if (0U != pre)
+    {
+        p_ctrl->cfg.p_preroll[p_ctrl->pre_head] = word;
+        p_ctrl->pre_head  = (p_ctrl->pre_head + 1U < pre) ? (p_ctrl->pre_head + 1U) : 0U;
+        p_ctrl->pre_count = (p_ctrl->pre_count < pre) ? (p_ctrl->pre_count + 1U) : pre;
+    }
+}
+
+/* New entry starting with the pre-roll; index is the stream index of the sample that opened it */
+static void pdm_segment_prv_open(pdm_segment_ctrl_t * p_ctrl, uint64_t index, uint64_t timestamp, uint32_t source)
+{
+    uint32_t pre = p_ctrl->cfg.pre_samples;
+
+    if (pdm_segment_count(p_ctrl) == p_ctrl->cfg.entries)
+    {
+        p_ctrl->oldest_id++;
+        p_ctrl->evicted++;
+    }
+
+    pdm_segment_entry_t * p_entry = pdm_segment_prv_entry(p_ctrl, p_ctrl->next_id);
+    p_entry->id        = p_ctrl->next_id;
+    p_entry->source    = source;
+    p_entry->start     = index - p_ctrl->pre_count;
+    p_entry->timestamp = timestamp -
+                         (((uint64_t) p_ctrl->pre_count * p_ctrl->cfg.clock_hz) / p_ctrl->cfg.rate_hz);
+    p_entry->position  = p_ctrl->written;
+    p_entry->length    = p_ctrl->pre_count;
+    p_entry->peak      = 0U;
+    p_entry->rms       = 0U;
+
+    p_ctrl->next_id++;
+    p_ctrl->open        = true;
+    p_ctrl->quiet       = 0U;
+    p_ctrl->peak        = 0U;
+    p_ctrl->sum_squares = 0U;
+    p_ctrl->active      = 0U;
+
+    /* Oldest pre-roll sample first */
+    uint32_t slot = (p_ctrl->pre_head + pre - p_ctrl->pre_count) % ((0U != pre) ? pre : 1U);
+    for (uint32_t i = 0U; i < p_ctrl->pre_count; i++)
+    {
+        pdm_segment_prv_put(p_ctrl, p_ctrl->cfg.p_preroll[slot]);
+        slot = (slot + 1U < pre) ? (slot + 1U) : 0U;
+    }
+
+    p_ctrl->pre_count = 0U;
+}
+
+static void pdm_segment_prv_close(pdm_segment_ctrl_t * p_ctrl)
+{
+    pdm_segment_entry_t * p_entry = pdm_segment_prv_entry(p_ctrl, p_ctrl->next_id - 1U);
+
+    p_entry->peak = p_ctrl->peak;
+    p_entry->rms  = (0U != p_ctrl->active) ?
+                    (uint32_t) sqrt((double) p_ctrl->sum_squares / (double) p_ctrl->active) : 0U;
+    p_ctrl->open = false;
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_segment_open(pdm_segment_ctrl_t * p_ctrl, pdm_segment_cfg_t const * p_cfg)
+{
+    if ((NULL == p_ctrl) || (NULL == p_cfg) || (NULL == p_cfg->p_pool) || (NULL == p_cfg->p_index) ||
+        ((0U != p_cfg->pre_samples) && (NULL == p_cfg->p_preroll)))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((0U == p_cfg->entries) || (0U == p_cfg->max_samples) || (0U == p_cfg->rate_hz) ||
+        (0U == p_cfg->clock_hz) || (p_cfg->pre_samples > p_cfg->capacity) ||
+        (p_cfg->max_samples > (p_cfg->capacity - p_cfg->pre_samples)))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->cfg = *p_cfg;
+
+    return FSP_SUCCESS;
+}
+
+void pdm_segment_append(pdm_segment_ctrl_t * p_ctrl, uint64_t index, uint64_t timestamp, uint32_t const * p_words,
+                        int32_t const * p_samples, uint32_t count)
+{
+    int32_t level = p_ctrl->cfg.level;
+
+    /* Samples are missing: neither the open segment nor the pre-roll may run across the hole */
+    if (index != p_ctrl->next_index)
+    {
+        if (p_ctrl->open)
+        {
+            pdm_segment_prv_close(p_ctrl);
+        }
+
+        p_ctrl->pre_count = 0U;
+    }
+
+    p_ctrl->next_index = index + count;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        int32_t  x      = p_samples[i];
+        uint32_t source = PDM_SEGMENT_SOURCE_LEVEL;
+        bool     hit    = (0 != level) && ((x >= level) || (x <= -level));
+
+        if (p_ctrl->marked && ((index + i) >= p_ctrl->mark))
+        {
+            p_ctrl->marked = false;
+            source         = hit ? source : PDM_SEGMENT_SOURCE_SOUND_DETECTION;
+            hit            = true;
+        }
+
+        if (!p_ctrl->open)
+        {
+            if (!hit)
+            {
+                pdm_segment_prv_preroll_put(p_ctrl, p_words[i]);
+                continue;
+            }
+
+            pdm_segment_prv_open(p_ctrl, index + i,
+                                 timestamp + (((uint64_t) i * p_ctrl->cfg.clock_hz) / p_ctrl->cfg.rate_hz), source);
+        }
+        else if (hit)
+        {
+            p_ctrl->quiet = 0U;
+        }
+        else if (++p_ctrl->quiet >= p_ctrl->cfg.hold_samples)
+        {
+            /* The hold ran out: this sample is the first of the next pre-roll */
+            pdm_segment_prv_close(p_ctrl);
+            pdm_segment_prv_preroll_put(p_ctrl, p_words[i]);
+            continue;
+        }
+        else
+        {
+            /* Still holding */
+        }
+
+        if (pdm_segment_prv_entry(p_ctrl, p_ctrl->next_id - 1U)->length >= p_ctrl->cfg.max_samples)
+        {
+            uint32_t quiet = p_ctrl->quiet;
+
+            pdm_segment_prv_close(p_ctrl);
+            pdm_segment_prv_open(p_ctrl, index + i,
+                                 timestamp + (((uint64_t) i * p_ctrl->cfg.clock_hz) / p_ctrl->cfg.rate_hz),
+                                 PDM_SEGMENT_SOURCE_CONTINUED);
+            p_ctrl->quiet = quiet;
+        }
+
+        uint32_t magnitude = (x < 0) ? (0U - (uint32_t) x) : (uint32_t) x;
+        p_ctrl->peak         = (magnitude > p_ctrl->peak) ? magnitude : p_ctrl->peak;
+        p_ctrl->sum_squares += (uint64_t) magnitude * magnitude;
+        p_ctrl->active++;
+
+        pdm_segment_prv_put(p_ctrl, p_words[i]);
+        pdm_segment_prv_entry(p_ctrl, p_ctrl->next_id - 1U)->length++;
+    }
+}
+
+void pdm_segment_mark(pdm_segment_ctrl_t * p_ctrl, uint64_t index)
+{
+    if (!p_ctrl->marked || (index < p_ctrl->mark))
+    {
+        p_ctrl->mark   = index;
+        p_ctrl->marked = true;
+    }
+}
+
+void pdm_segment_close(pdm_segment_ctrl_t * p_ctrl)
+{
+    if (p_ctrl->open)
+    {
+        pdm_segment_prv_close(p_ctrl);
+    }
+
+    p_ctrl->marked = false;
+}
+
+fsp_err_t pdm_segment_find(pdm_segment_ctrl_t const * p_ctrl, uint32_t id, pdm_segment_entry_t * p_entry)
+{
+    /* IDs below the oldest one have been evicted: continue with the oldest */
+    uint32_t first = ((int32_t) (id - p_ctrl->oldest_id) < 0) ? p_ctrl->oldest_id : id;
+    uint32_t end   = p_ctrl->open ? (p_ctrl->next_id - 1U) : p_ctrl->next_id;
+
+    if ((int32_t) (end - first) <= 0)
+    {
+        return FSP_ERR_NOT_FOUND;
+    }
+
+    *p_entry = *pdm_segment_prv_entry(p_ctrl, first);
+
+    return FSP_SUCCESS;
+}
+
+uint32_t pdm_segment_read(pdm_segment_ctrl_t const * p_ctrl, pdm_segment_entry_t const * p_entry, uint32_t offset,
+                          uint32_t const ** pp_span)
+{
+    /* The entry is a copy: it is only good while its ID is still stored */
+    if (((p_entry->id - p_ctrl->oldest_id) >= pdm_segment_count(p_ctrl)) || (offset >= p_entry->length))
+    {
+        return 0U;
+    }
+
+    uint32_t slot  = (uint32_t) ((p_entry->position + offset) % p_ctrl->cfg.capacity);
+    uint32_t count = p_entry->length - offset;
+    uint32_t room  = p_ctrl->cfg.capacity - slot;
+
+    *pp_span = &p_ctrl->cfg.p_pool[slot];
+
+    return (count < room) ? count : room;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file pdm_segment.h
+ * @brief Event-segmented long-term store: only active stretches of the stream are kept, with an index table
+ * @details Collected samples pass through an activity detector; while it is active they are appended to a segment in
+ *          a fixed-size sample pool, otherwise they only feed a short pre-roll that becomes the head of the next
+ *          segment. Activity starts at a sample whose magnitude reaches the level, or at a stream position marked by
+ *          the caller (the PDM sound detector), and ends after hold_samples without either. Activity longer than
+ *          max_samples continues in a new segment, and a jump in the stream index (lost blocks) ends the segment, so
+ *          every segment is one contiguous stretch of the stream.
+ *
+ *          Every segment has an index entry: stream index and time of its first sample, length, peak and RMS. The
+ *          pool is written as a log and the index is a ring, so when either is full the oldest segments are evicted
+ *          first; the newest ones are always complete. Readers get a segment by ID, as at most two spans of the pool
+ *          when it wraps, and are told when it was evicted meanwhile.
+ *
+ *          Levels are in the units of the detector samples (20-bit, before any gain). All functions are foreground
+ *          only.
+ */
+
+#ifndef PDM_SEGMENT_H
+#define PDM_SEGMENT_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** What opened a segment */
+#define PDM_SEGMENT_SOURCE_SOUND_DETECTION    (0U)   ///< pdm_segment_mark()
+#define PDM_SEGMENT_SOURCE_LEVEL              (1U)   ///< A sample reached the level
+#define PDM_SEGMENT_SOURCE_CONTINUED          (2U)   ///< Activity went on past max_samples
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Index entry of one segment */
+typedef struct st_pdm_segment_entry
+{
+    uint32_t id;                       ///< Increasing from 0 since open
+    uint32_t source;                   ///< PDM_SEGMENT_SOURCE_*
+    uint64_t start;                    ///< Stream index of the first sample (pre-roll included)
+    uint64_t timestamp;                ///< Time of the first sample, on the caller's time base
+    uint64_t position;                 ///< Pool position of the first sample
+    uint32_t length;                   ///< Samples
+    uint32_t peak;                     ///< Largest |sample| from the start of activity on (the pre-roll is quiet)
+    uint32_t rms;                      ///< RMS over the same samples
+} pdm_segment_entry_t;
+
+/** Storage and detector settings */
+typedef struct st_pdm_segment_cfg
+{
+    uint32_t            * p_pool;        ///< Sample pool, one word per sample
+    uint32_t              capacity;      ///< Pool length, at least pre_samples + max_samples
+    pdm_segment_entry_t * p_index;       ///< Index ring
+    uint32_t              entries;       ///< Index ring length
+    uint32_t            * p_preroll;     ///< Pre-roll ring of pre_samples words, NULL if pre_samples is 0
+    uint32_t              pre_samples;   ///< Samples kept before the start of activity
+    uint32_t              hold_samples;  ///< Inactive samples that end a segment
+    uint32_t              max_samples;   ///< Longest segment, at least 1
+    int32_t               level;         ///< Threshold on |sample|, 0: marks only
+    uint32_t              rate_hz;       ///< Sample rate, to date the pre-roll
+    uint32_t              clock_hz;      ///< Rate of the caller's time base
+} pdm_segment_cfg_t;
+
+/** Instance */
+typedef struct st_pdm_segment_ctrl
+{
+    pdm_segment_cfg_t cfg;
+    uint64_t          written;         ///< Samples written to the pool, the position of the next one
+    uint32_t          head;            ///< Pool slot of the next sample
+    uint64_t          next_index;      ///< Stream index expected in the next append
+    uint64_t          mark;            ///< Pending mark, valid when marked is set
+    bool              marked;
+    bool              open;            ///< The newest entry is still growing
+    uint32_t          quiet;           ///< Inactive samples since the last detection
+    uint32_t          next_id;         ///< ID of the next entry
+    uint32_t          oldest_id;       ///< Oldest entry still stored
+    uint32_t          pre_count;       ///< Samples in the pre-roll ring
+    uint32_t          pre_head;        ///< Pre-roll slot of the next sample
+    uint32_t          peak;            ///< Largest |sample| of the open segment
+    uint64_t          sum_squares;     ///< Sum of squares of the open segment
+    uint32_t          active;          ///< Samples in sum_squares
+    uint32_t          evicted;         ///< Segments evicted since open
+} pdm_segment_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Start an empty store
+ * @param[out] p_ctrl  Instance
+ * @param[in]  p_cfg   Storage and detector settings
+ * @retval FSP_SUCCESS               Ready
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  No index or segment length, no time base, or pre plus max exceed the pool
+ */
+fsp_err_t pdm_segment_open(pdm_segment_ctrl_t * p_ctrl, pdm_segment_cfg_t const * p_cfg);
+
+/**
+ * @brief Run the detector over collected samples and store the active ones
+ * @param[in,out] p_ctrl     Instance
+ * @param[in]     index      Stream index of the first sample; a jump from the previous call ends the open segment
+ * @param[in]     timestamp  Time of the first sample
+ * @param[in]     p_words    Samples as they are stored
+ * @param[in]     p_samples  The same samples signed, for the detector and the levels
+ * @param[in]     count      Samples
+ */
+void pdm_segment_append(pdm_segment_ctrl_t * p_ctrl, uint64_t index, uint64_t timestamp, uint32_t const * p_words,
+                        int32_t const * p_samples, uint32_t count);
+
+/**
+ * @brief Mark activity at a stream position (sound detection)
+ * @details A position already appended opens a segment with the next append; the pre-roll covers the onset.
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     index   Stream index
+ */
+void pdm_segment_mark(pdm_segment_ctrl_t * p_ctrl, uint64_t index);
+
+/**
+ * @brief End the capture: the open segment is closed as it is
+ * @param[in,out] p_ctrl  Instance
+ */
+void pdm_segment_close(pdm_segment_ctrl_t * p_ctrl);
+
+/**
+ * @brief Closed segment with the lowest ID at or after id
+ * @param[in]  p_ctrl   Instance
+ * @param[in]  id       First ID to look at
+ * @param[out] p_entry  Index entry
+ * @retval FSP_SUCCESS        Entry returned
+ * @retval FSP_ERR_NOT_FOUND  No such segment stored
+ */
+fsp_err_t pdm_segment_find(pdm_segment_ctrl_t const * p_ctrl, uint32_t id, pdm_segment_entry_t * p_entry);
+
+/**
+ * @brief Contiguous samples of a segment
+ * @param[in]  p_ctrl    Instance
+ * @param[in]  p_entry   Entry from pdm_segment_find()
+ * @param[in]  offset    First sample, relative to the segment
+ * @param[out] pp_span   Samples from offset on
+ * @return Samples at *pp_span, up to the end of the segment or of the pool; 0 if the segment has been evicted
+ */
+uint32_t pdm_segment_read(pdm_segment_ctrl_t const * p_ctrl, pdm_segment_entry_t const * p_entry, uint32_t offset,
+                          uint32_t const ** pp_span);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/** Segments stored (closed ones and an open one) */
+static inline uint32_t pdm_segment_count(pdm_segment_ctrl_t const * p_ctrl)
+{
+    return p_ctrl->next_id - p_ctrl->oldest_id;
+}
+
+/** Follow a live rate change, so the pre-roll of later segments is dated correctly */
+static inline void pdm_segment_rate_set(pdm_segment_ctrl_t * p_ctrl, uint32_t rate_hz)
+{
+    p_ctrl->cfg.rate_hz = rate_hz;
+}
+
+FSP_FOOTER
+
+#endif /* PDM_SEGMENT_H */
@@ -0,0 +1,298 @@
+/**
+ * @file pdm_session.c
+ * @brief One capture session per PDM unit/channel
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_session.h"
+#include "pdm_mem.h"
+#include <string.h>
+#if PDM_PORT_TARGET
+ #include "hal_data.h"
+#endif
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+#if PDM_PORT_TARGET
+
+static fsp_err_t pdm_session_prv_r_pdm_open(void * p_ctrl, void const * p_cfg)
+{
+    return R_PDM_Open((pdm_ctrl_t *) p_ctrl, (pdm_cfg_t const *) p_cfg);
+}
+
+static fsp_err_t pdm_session_prv_r_pdm_start(void * p_ctrl, uint32_t * p_ring, uint32_t ring_samples,
+                                             uint32_t block_samples)
+{
+    return R_PDM_Start((pdm_ctrl_t *) p_ctrl, p_ring, ring_samples * sizeof(uint32_t), block_samples);
+}
+
+static fsp_err_t pdm_session_prv_r_pdm_stop(void * p_ctrl)
+{
+    return R_PDM_Stop((pdm_ctrl_t *) p_ctrl);
+}
+
+static fsp_err_t pdm_session_prv_r_pdm_close(void * p_ctrl)
+{
+    return R_PDM_Close((pdm_ctrl_t *) p_ctrl);
+}
+
+#endif
+
+/***********************************************************************************************************************
+ * Global variables
+ **********************************************************************************************************************/
+
+#if PDM_PORT_TARGET
+
+pdm_session_driver_t const g_pdm_session_driver_r_pdm =
+{
+    .p_open  = pdm_session_prv_r_pdm_open,
+    .p_start = pdm_session_prv_r_pdm_start,
+    .p_stop  = pdm_session_prv_r_pdm_stop,
+    .p_close = pdm_session_prv_r_pdm_close,
+};
+
+#endif
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_session_open(pdm_session_t * p_session, pdm_session_cfg_t const * p_cfg)
+{
+    if ((NULL == p_session) || (NULL == p_cfg) || (NULL == p_cfg->p_driver) || (NULL == p_cfg->p_ring) ||
+        (NULL == p_cfg->p_slot_storage) || (NULL == p_cfg->p_slot_info) || (NULL == p_cfg->p_timestamp) ||
+        (NULL == p_cfg->p_block))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if (PDM_SESSION_STATE_CLOSED != p_session->state)
+    {
+        return FSP_ERR_ALREADY_OPEN;
+    }
+
+    if ((0U == p_cfg->block_samples) || (0U != (p_cfg->ring_samples % p_cfg->block_samples)) ||
+        ((p_cfg->ring_samples / p_cfg->block_samples) < 2U) || (p_cfg->slots < 2U) ||
+        (p_cfg->slots > PDM_SLOT_MAX_SLOTS) || (0U == p_cfg->cycles_per_second))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    if (NULL != p_cfg->p_driver->p_open)
+    {
+        fsp_err_t err = p_cfg->p_driver->p_open(p_cfg->p_driver_ctrl, p_cfg->p_driver_cfg);
+        if (FSP_SUCCESS != err)
+        {
+            return err;
+        }
+    }
+
+    memset(p_session, 0, sizeof(*p_session));
+    p_session->cfg   = *p_cfg;
+    p_session->state = PDM_SESSION_STATE_OPEN;
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_session_start(pdm_session_t * p_session, uint32_t sample_rate_hz)
+{
+    pdm_session_cfg_t const * p_cfg = &p_session->cfg;
+
+    if (PDM_SESSION_STATE_OPEN != p_session->state)
+    {
+        return (PDM_SESSION_STATE_RUNNING == p_session->state) ? FSP_ERR_IN_USE : FSP_ERR_NOT_OPEN;
+    }
+
+    p_session->callbacks        = 0U;
+    p_session->errors           = 0U;
+    p_session->sound_detections = 0U;
+    p_session->processed        = 0U;
+    p_session->drops_seen       = 0U;
+    p_session->overwritten      = 0U;
+
+    pdm_integrity_cfg_t const integrity_cfg =
+    {
+        .samples_per_block = p_cfg->block_samples,
+        .sample_rate_hz    = sample_rate_hz,
+        .cycles_per_second = p_cfg->cycles_per_second,
+    };
+    fsp_err_t err = pdm_integrity_open(&p_session->integrity, &integrity_cfg);
+    if (FSP_SUCCESS != err)
+    {
+        return err;
+    }
+
+    pdm_slot_cfg_t const slot_cfg =
+    {
+        .p_storage    = p_cfg->p_slot_storage,
+        .slot_samples = p_cfg->block_samples,
+        .slots        = p_cfg->slots,
+    };
+    err = pdm_slot_open(&p_session->slots, &slot_cfg);
+    if (FSP_SUCCESS != err)
+    {
+        return err;
+    }
+
+    /* Running before the driver starts: its first callback may come at once */
+    p_session->state = PDM_SESSION_STATE_RUNNING;
+    pdm_integrity_start(&p_session->integrity, (uint32_t) p_cfg->p_timestamp());
+
+    err = p_cfg->p_driver->p_start(p_cfg->p_driver_ctrl, p_cfg->p_ring, p_cfg->ring_samples, p_cfg->block_samples);
+    if (FSP_SUCCESS != err)
+    {
+        p_session->state = PDM_SESSION_STATE_OPEN;
+    }
+
+    return err;
+}
+
+fsp_err_t pdm_session_stop(pdm_session_t * p_session)
+{
+    if (PDM_SESSION_STATE_RUNNING != p_session->state)
+    {
+        return FSP_ERR_INVALID_STATE;
+    }
+
+    p_session->state = PDM_SESSION_STATE_OPEN;
+
+    return (NULL != p_session->cfg.p_driver->p_stop) ? p_session->cfg.p_driver->p_stop(p_session->cfg.p_driver_ctrl)
+                                                       : FSP_SUCCESS;
+}
+
+fsp_err_t pdm_session_close(pdm_session_t * p_session)
+{
+    if (PDM_SESSION_STATE_CLOSED == p_session->state)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if (PDM_SESSION_STATE_RUNNING == p_session->state)
+    {
+        (void) pdm_session_stop(p_session);
+    }
+
+    p_session->state = PDM_SESSION_STATE_CLOSED;
+
+    return (NULL != p_session->cfg.p_driver->p_close) ? p_session->cfg.p_driver->p_close(p_session->cfg.p_driver_ctrl)
+                                                        : FSP_SUCCESS;
+}
+
+PDM_MEM_FAST_CODE void pdm_session_isr(pdm_session_t * p_session, pdm_session_event_type_t type, uint32_t errors)
+{
+    pdm_session_cfg_t const * p_cfg = &p_session->cfg;
+
+    /* Taken first so every block is stamped at the same point of the interrupt */
+    pdm_session_event_t event =
+    {
+        .type      = type,
+        .timestamp = p_cfg->p_timestamp(),
+        .position  = 0U,
+        .slot      = PDM_SLOT_NONE,
+        .errors    = errors,
+    };
+
+    switch (type)
+    {
+        case PDM_SESSION_EVENT_BLOCK:
+        {
+            pdm_integrity_block_t info;
+            pdm_integrity_block(&p_session->integrity, event.timestamp, &info);
+            event.position = info.sample_index;
+
+            /* Only the ticket: which driver block the slot stands for. The foreground copies the block out of the
+             * ring, where it stays put for ring blocks - 1 more periods; with no free slot the block is dropped here
+             * and shows up as a gap */
+            uint32_t slot = pdm_slot_fill_begin(&p_session->slots);
+            if (PDM_SLOT_NONE != slot)
+            {
+                p_session->slot_block[slot] = p_session->callbacks;
+                p_cfg->p_slot_info[slot]    = info;
+                pdm_slot_fill_end(&p_session->slots, slot);
+            }
+
+            event.slot           = slot;
+            p_session->callbacks = p_session->callbacks + 1U;
+            break;
+        }
+
+        case PDM_SESSION_EVENT_SOUND:
+        {
+            event.position              = pdm_integrity_position(&p_session->integrity, (uint32_t) event.timestamp);
+            p_session->sound_detections = p_session->sound_detections + 1U;
+            break;
+        }
+
+        case PDM_SESSION_EVENT_ERROR:
+        default:
+        {
+            pdm_integrity_error(&p_session->integrity, (uint32_t) event.timestamp, errors);
+            p_session->errors = p_session->errors + 1U;
+            break;
+        }
+    }
+
+    if (NULL != p_cfg->p_notify)
+    {
+        p_cfg->p_notify(p_session, &event, p_cfg->p_context);
+    }
+}
+
+uint32_t pdm_session_process(pdm_session_t * p_session)
+{
+    pdm_slot_ctrl_t * p_slots = &p_session->slots;
+    uint32_t          handled = 0U;
+
+    /* Blocks the data interrupt had no free slot for */
+    uint32_t dropped = p_slots->dropped;
+    while (p_session->drops_seen != dropped)
+    {
+        p_session->drops_seen++;
+        pdm_integrity_drop(&p_session->integrity);
+    }
+
+    uint32_t ring_blocks = p_session->cfg.ring_samples / p_session->cfg.block_samples;
+
+    for (uint32_t slot = pdm_slot_borrow(p_slots); PDM_SLOT_NONE != slot; slot = pdm_slot_borrow(p_slots))
+    {
+        uint32_t   block = p_session->slot_block[slot];
+        uint32_t * p_dst = pdm_slot_data(p_slots, slot);
+
+        memcpy(p_dst, &p_session->cfg.p_ring[(block % ring_blocks) * p_session->cfg.block_samples],
+               p_session->cfg.block_samples * sizeof(uint32_t));
+
+        /* The driver starts overwriting the block once ring blocks more have completed: a copy that may have read
+         * the next lap is dropped like a block that found no slot */
+        pdm_port_memory_barrier();
+        if ((p_session->callbacks - block) >= ring_blocks)
+        {
+            p_session->overwritten++;
+            pdm_integrity_drop(&p_session->integrity);
+        }
+        else
+        {
+            p_session->processed++;
+            p_session->cfg.p_block(p_session, p_dst, &p_session->cfg.p_slot_info[slot], p_session->cfg.p_context);
+            handled++;
+        }
+
+        (void) pdm_slot_release(p_slots, slot);
+    }
+
+    return handled;
+}
+
+void pdm_session_stats_get(pdm_session_t const * p_session, pdm_session_stats_t * p_stats)
+{
+    p_stats->callbacks        = p_session->callbacks;
+    p_stats->processed        = p_session->processed;
+    p_stats->dropped          = p_session->slots.dropped + p_session->overwritten;
+    p_stats->errors           = p_session->errors;
+    p_stats->sound_detections = p_session->sound_detections;
+    p_stats->slot_high_water  = p_session->slots.high_water;
+}
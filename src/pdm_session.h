@@ -0,0 +1,236 @@
+/**
+ * @file pdm_session.h
+ * @brief One capture session per PDM unit/channel: driver ring, block slots, stream integrity and counters
+ * @details A session owns everything between the driver and the processing chain of one channel, so several
+ *          channels can record at the same time, each from its own statically allocated storage:
+ *          - the driver ring the PDM fills, split into blocks of block_samples
+ *          - the block slots (pdm_slot): the data interrupt only queues which ring block completed, the foreground
+ *            copies it out of the ring into the slot before the block hook sees it
+ *          - the stream integrity tracker (pdm_integrity) that numbers and stamps every block
+ *          - the capture counters
+ *
+ *          The application forwards the driver callback to pdm_session_isr(), which does the bookkeeping and then
+ *          calls the notify hook (interrupt context, e.g. to post foreground work). pdm_session_process() runs in the
+ *          foreground and hands every completed block, in capture order, to the block hook.
+ *
+ *          The driver is reached through a pdm_session_driver_t, so the session is portable: on target
+ *          g_pdm_session_driver_r_pdm wraps r_pdm, on host a test double can feed blocks through pdm_session_isr().
+ */
+
+#ifndef PDM_SESSION_H
+#define PDM_SESSION_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_integrity.h"
+#include "pdm_slot.h"
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Driver events forwarded to pdm_session_isr() */
+typedef enum e_pdm_session_event_type
+{
+    PDM_SESSION_EVENT_BLOCK = 0,       ///< A block of the ring is complete
+    PDM_SESSION_EVENT_SOUND,           ///< Sound detection
+    PDM_SESSION_EVENT_ERROR,           ///< Error interrupt
+} pdm_session_event_type_t;
+
+/** Life cycle */
+typedef enum e_pdm_session_state
+{
+    PDM_SESSION_STATE_CLOSED = 0,
+    PDM_SESSION_STATE_OPEN,            ///< Driver open, not capturing
+    PDM_SESSION_STATE_RUNNING,         ///< Capturing
+} pdm_session_state_t;
+
+/** Event passed to the notify hook, after the session's own bookkeeping */
+typedef struct st_pdm_session_event
+{
+    pdm_session_event_type_t type;
+    uint64_t                 timestamp;    ///< Event time from the timestamp hook
+    uint64_t                 position;     ///< BLOCK: stream index of its first sample; SOUND: index being captured
+    uint32_t                 slot;         ///< BLOCK: slot the block is queued in, PDM_SLOT_NONE if it was dropped
+    uint32_t                 errors;       ///< ERROR: pdm_error_t bits
+} pdm_session_event_t;
+
+struct st_pdm_session;
+
+/** Interrupt context: called for every event forwarded to pdm_session_isr() */
+typedef void (* pdm_session_notify_t)(struct st_pdm_session * p_session, pdm_session_event_t const * p_event,
+                                      void * p_context);
+
+/** Foreground: one completed block, valid until the hook returns */
+typedef void (* pdm_session_block_t)(struct st_pdm_session * p_session, uint32_t * p_samples,
+                                     pdm_integrity_block_t const * p_info, void * p_context);
+
+/** Driver operations; p_ctrl and p_cfg are the driver's own control and configuration structures */
+typedef struct st_pdm_session_driver
+{
+    fsp_err_t (* p_open)(void * p_ctrl, void const * p_cfg);
+    fsp_err_t (* p_start)(void * p_ctrl, uint32_t * p_ring, uint32_t ring_samples, uint32_t block_samples);
+    fsp_err_t (* p_stop)(void * p_ctrl);
+    fsp_err_t (* p_close)(void * p_ctrl);
+} pdm_session_driver_t;
+
+/** Channel, storage and hooks of a session */
+typedef struct st_pdm_session_cfg
+{
+    pdm_session_driver_t const * p_driver;
+    void                       * p_driver_ctrl;   ///< pdm_instance_ctrl_t on target
+    void const                 * p_driver_cfg;    ///< pdm_cfg_t on target
+
+    uint32_t                   * p_ring;          ///< Driver ring, ring_samples words
+    uint32_t                     ring_samples;    ///< A multiple of block_samples, at least two blocks
+    uint32_t                     block_samples;   ///< Samples per data callback
+
+    uint32_t                   * p_slot_storage;  ///< slots * block_samples words
+    pdm_integrity_block_t      * p_slot_info;     ///< slots entries
+    uint32_t                     slots;           ///< 2 .. PDM_SLOT_MAX_SLOTS
+
+    uint64_t                  (* p_timestamp)(void); ///< Event time base, interrupt safe
+    uint32_t                     cycles_per_second;  ///< Rate of p_timestamp
+
+    pdm_session_notify_t         p_notify;        ///< May be NULL
+    pdm_session_block_t          p_block;
+    void                       * p_context;       ///< Passed to both hooks
+} pdm_session_cfg_t;
+
+/** Counters of the current or last capture */
+typedef struct st_pdm_session_stats
+{
+    uint32_t callbacks;                ///< Blocks delivered by the driver
+    uint32_t processed;                ///< Blocks handed to the block hook
+    uint32_t dropped;                  ///< Blocks that found no free slot or were overwritten before the copy
+    uint32_t errors;                   ///< Error events
+    uint32_t sound_detections;         ///< Sound detection events
+    uint32_t slot_high_water;          ///< Most slots READY or CONSUMING at once
+} pdm_session_stats_t;
+
+/** Instance */
+typedef struct st_pdm_session
+{
+    pdm_session_cfg_t    cfg;
+    pdm_session_state_t  state;
+    pdm_integrity_ctrl_t integrity;
+    pdm_slot_ctrl_t      slots;
+
+    /* Interrupt side */
+    volatile uint32_t callbacks;
+    volatile uint32_t errors;
+    volatile uint32_t sound_detections;
+    uint32_t          slot_block[PDM_SLOT_MAX_SLOTS]; ///< Driver block (callback number) each queued slot stands for
+
+    /* Foreground side */
+    uint32_t processed;
+    uint32_t drops_seen;               ///< Slot drops already reported to the integrity tracker
+    uint32_t overwritten;              ///< Queued blocks the driver overwrote before the copy
+} pdm_session_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Exported global variables
+ **********************************************************************************************************************/
+
+#if PDM_PORT_TARGET
+
+/** r_pdm: p_driver_ctrl is a pdm_instance_ctrl_t, p_driver_cfg a pdm_cfg_t */
+extern pdm_session_driver_t const g_pdm_session_driver_r_pdm;
+
+#endif
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Open the driver of a channel and take over its storage
+ * @param[out] p_session  Instance
+ * @param[in]  p_cfg      Channel, storage and hooks
+ * @retval FSP_SUCCESS               Open, not capturing
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_ALREADY_OPEN      Already open
+ * @retval FSP_ERR_INVALID_ARGUMENT  Ring or slot sizes out of range
+ * @retval Other                     Error of the driver open
+ */
+fsp_err_t pdm_session_open(pdm_session_t * p_session, pdm_session_cfg_t const * p_cfg);
+
+/**
+ * @brief Reset the counters, slots and integrity tracker, then start the driver
+ * @param[in,out] p_session       Instance
+ * @param[in]     sample_rate_hz  Actual PCM rate of the filters in use
+ * @retval FSP_SUCCESS         Capturing
+ * @retval FSP_ERR_NOT_OPEN    Not open
+ * @retval FSP_ERR_IN_USE      Already capturing
+ * @retval Other               Error of the driver start
+ */
+fsp_err_t pdm_session_start(pdm_session_t * p_session, uint32_t sample_rate_hz);
+
+/**
+ * @brief Stop the driver; blocks already copied stay available to pdm_session_process()
+ * @param[in,out] p_session  Instance
+ * @retval FSP_SUCCESS             Stopped
+ * @retval FSP_ERR_INVALID_STATE   Not capturing
+ * @retval Other                   Error of the driver stop
+ */
+fsp_err_t pdm_session_stop(pdm_session_t * p_session);
+
+/**
+ * @brief Stop if needed and close the driver
+ * @param[in,out] p_session  Instance
+ * @retval FSP_SUCCESS         Closed
+ * @retval FSP_ERR_NOT_OPEN    Not open
+ * @retval Other               Error of the driver close
+ */
+fsp_err_t pdm_session_close(pdm_session_t * p_session);
+
+/**
+ * @brief Interrupt context: account one driver event and call the notify hook; constant time, a block is only queued
+ * @param[in,out] p_session  Instance
+ * @param[in]     type       Event
+ * @param[in]     errors     ERROR: pdm_error_t bits, otherwise ignored
+ */
+void pdm_session_isr(pdm_session_t * p_session, pdm_session_event_type_t type, uint32_t errors);
+
+/**
+ * @brief Foreground: copy every queued block out of the driver ring and hand it to the block hook, oldest first
+ * @details Must keep up within ring blocks - 1 block periods: a block the driver has started to overwrite is dropped.
+ * @param[in,out] p_session  Instance
+ * @return Blocks handled
+ */
+uint32_t pdm_session_process(pdm_session_t * p_session);
+
+/**
+ * @brief Counters of the current or last capture
+ * @param[in]  p_session  Instance
+ * @param[out] p_stats    Counters
+ */
+void pdm_session_stats_get(pdm_session_t const * p_session, pdm_session_stats_t * p_stats);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/**
+ * @brief Interrupt safe: the PCM rate changes from the next block on (live filter swaps)
+ * @param[in,out] p_session       Instance
+ * @param[in]     sample_rate_hz  New rate
+ */
+static inline void pdm_session_rate_set(pdm_session_t * p_session, uint32_t sample_rate_hz)
+{
+    pdm_integrity_rate_set(&p_session->integrity, sample_rate_hz);
+}
+
+/** Stream integrity tracker of the session, for telemetry and the error log */
+static inline pdm_integrity_ctrl_t const * pdm_session_integrity(pdm_session_t const * p_session)
+{
+    return &p_session->integrity;
+}
+
+FSP_FOOTER
+
+#endif /* PDM_SESSION_H */
@@ -0,0 +1,557 @@
+/**
+ * @file pdm_slm.c
+ * @brief Sound level meter: fractional-octave band levels and A/C-weighted Leq
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_slm.h"
+#include "pdm_math.h"
+#include <math.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/* Poles of the A and C weightings (IEC 61672-1 Annex E) */
+#define PDM_SLM_PRV_F1_HZ           (20.598997f)
+#define PDM_SLM_PRV_F2_HZ           (107.65265f)
+#define PDM_SLM_PRV_F3_HZ           (737.86223f)
+#define PDM_SLM_PRV_F4_HZ           (12194.217f)
+
+/* Frequency of the bilinear transform of the 12.2 kHz pole pair, relative to the rate: errors stay inside the class 1
+ * tolerances (largest +1.4 dB at 8 kHz and -2.5 dB at 12.5 kHz for 32 kHz) */
+#define PDM_SLM_PRV_F4_MATCH        (0.35f)
+
+/* Frequency at which both weightings are 0 dB */
+#define PDM_SLM_PRV_REFERENCE_HZ    (1000.0f)
+
+/* Highest upper band edge, relative to the rate */
+#define PDM_SLM_PRV_TOP_EDGE        (0.45f)
+
+#define PDM_SLM_PRV_MIN_RATE_HZ     (8000U)
+#define PDM_SLM_PRV_MAX_RATE_HZ     (96000U)
+#define PDM_SLM_PRV_MIN_BAND        (10U)
+#define PDM_SLM_PRV_MIN_INTERVAL_MS (100U)
+#define PDM_SLM_PRV_MAX_INTERVAL_MS (3600000U)
+
+#define PDM_SLM_PRV_HALFBAND_CENTER ((PDM_SLM_HALFBAND_TAPS - 1U) / 2U)
+#define PDM_SLM_PRV_HALFBAND_PAIRS  ((PDM_SLM_HALFBAND_TAPS + 1U) / 4U)
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Exact midband of band number n */
+static float pdm_slm_prv_midband_hz(uint32_t band)
+{
+    return powf(10.0f, (float) band / 10.0f);
+}
+
+/* Ratio of the upper band edge to the midband, G^(1/2b) */
+static float pdm_slm_prv_half_width(pdm_slm_bands_t bands)
+{
+    return powf(10.0f, 0.15f / (float) bands);
+}
+
+/* Stage whose octave holds a midband: the input rate above rate / 16, then (rate / 2^(j + 4), rate / 2^(j + 3)] */
+static uint32_t pdm_slm_prv_stage(float midband_hz, uint32_t rate_hz)
+{
+    uint32_t stage = 0U;
+
+    while (((stage + 1U) < PDM_SLM_MAX_STAGES) && ((midband_hz * (float) (16U << stage)) <= (float) rate_hz))
+    {
+        stage++;
+    }
+
+    return stage;
+}
+
+/* Number of bands of a setting, 0 if it is out of range */
+static uint32_t pdm_slm_prv_band_count(pdm_slm_cfg_t const * p_cfg)
+{
+    if ((p_cfg->rate_hz < PDM_SLM_PRV_MIN_RATE_HZ) || (p_cfg->rate_hz > PDM_SLM_PRV_MAX_RATE_HZ) ||
+        !(p_cfg->scale > 0.0f) || ((PDM_SLM_BANDS_OCTAVE != p_cfg->bands) &&
+                                   (PDM_SLM_BANDS_THIRD_OCTAVE != p_cfg->bands)) ||
+        (p_cfg->low_band < PDM_SLM_PRV_MIN_BAND) ||
+        ((PDM_SLM_BANDS_OCTAVE == p_cfg->bands) && (0U != (p_cfg->low_band % 3U))) ||
+        (p_cfg->interval_ms < PDM_SLM_PRV_MIN_INTERVAL_MS) || (p_cfg->interval_ms > PDM_SLM_PRV_MAX_INTERVAL_MS))
+    {
+        return 0U;
+    }
+
+    /* The lowest band must sit in the octave of the last stage */
+    float low_hz = pdm_slm_prv_midband_hz(p_cfg->low_band);
+    if ((low_hz * (float) (16U << (PDM_SLM_MAX_STAGES - 1U))) <= (float) p_cfg->rate_hz)
+    {
+        return 0U;
+    }
+
+    float    half_width = pdm_slm_prv_half_width(p_cfg->bands);
+    uint32_t step       = 3U / (uint32_t) p_cfg->bands;
+    uint32_t count      = 0U;
+
+    while ((count < PDM_SLM_MAX_BANDS) &&
+           ((pdm_slm_prv_midband_hz(p_cfg->low_band + (count * step)) * half_width) <=
+            (PDM_SLM_PRV_TOP_EDGE * (float) p_cfg->rate_hz)))
+    {
+        count++;
+    }
+
+    return count;
+}
+
+/* Third-order Butterworth band pass between the edges of a band: each pole of the low-pass prototype (-1 and
+ * -1/2 +- j sqrt(3)/2) becomes a pole pair of s^2 - p B s + w0^2, and each pair one section B s / (s - q)(s - q*),
+ * all through the bilinear transform with the edges prewarped */
+static void pdm_slm_prv_bandpass(pdm_dsp_biquad_coeffs_t * p_coeffs, float midband_hz, float half_width,
+                                 float rate_hz)
+{
+    float s;
+    float c;
+
+    pdm_math_sincosf(PDM_MATH_PI * midband_hz / (half_width * rate_hz), &s, &c);
+    float w1 = s / c;
+    pdm_math_sincosf(PDM_MATH_PI * midband_hz * half_width / rate_hz, &s, &c);
+    float w2 = s / c;
+
+    float bandwidth = w2 - w1;
+    float center_sq = w1 * w2;
+
+    /* Denominators s^2 + a s + b: the real prototype pole, then both roots of the complex one */
+    float a[3];
+    float b[3];
+
+    a[0] = bandwidth;
+    b[0] = center_sq;
+
+    float pr = -0.5f * bandwidth;
+    float pi = 0.8660254f * bandwidth;
+
+    /* Square root of (p B)^2 - 4 w0^2 */
+    float dr = (pr * pr) - (pi * pi) - (4.0f * center_sq);
+    float di = 2.0f * pr * pi;
+    float r  = sqrtf((dr * dr) + (di * di));
+    float sr = sqrtf(0.5f * (r + dr));
+    float si = copysignf(sqrtf(0.5f * (r - dr)), di);
+
+    float q1r = 0.5f * (pr + sr);
+    float q1i = 0.5f * (pi + si);
+    float q2r = 0.5f * (pr - sr);
+    float q2i = 0.5f * (pi - si);
+
+    a[1] = -2.0f * q1r;
+    b[1] = (q1r * q1r) + (q1i * q1i);
+    a[2] = -2.0f * q2r;
+    b[2] = (q2r * q2r) + (q2i * q2i);
+
+    for (uint32_t i = 0U; i < 3U; i++)
+    {
+        float a0 = 1.0f + a[i] + b[i];
+
+        p_coeffs[i].b0 = bandwidth / a0;
+        p_coeffs[i].b1 = 0.0f;
+        p_coeffs[i].b2 = -bandwidth / a0;
+        p_coeffs[i].a1 = 2.0f * (b[i] - 1.0f) / a0;
+        p_coeffs[i].a2 = (1.0f - a[i] + b[i]) / a0;
+    }
+}
+
+/* Section with the real poles -a and -b (bilinear constant 1): s^2 / (s + a)(s + b), or 1 / (s + a)(s + b) */
+static void pdm_slm_prv_real_poles(pdm_dsp_biquad_coeffs_t * p_coeffs, float a, float b, bool highpass)
+{
+    float a0 = (1.0f + a) * (1.0f + b);
+    float n1 = highpass ? -2.0f : 2.0f;
+
+    p_coeffs->b0 = 1.0f / a0;
+    p_coeffs->b1 = n1 / a0;
+    p_coeffs->b2 = 1.0f / a0;
+    p_coeffs->a1 = 2.0f * ((a * b) - 1.0f) / a0;
+    p_coeffs->a2 = (1.0f - a) * (1.0f - b) / a0;
+}
+
+/* Gain of a cascade at a frequency */
+static float pdm_slm_prv_gain(pdm_dsp_biquad_coeffs_t const * p_coeffs, uint32_t stages, float frequency_hz,
+                              float rate_hz)
+{
+    float s1;
+    float c1;
+    float s2;
+    float c2;
+    float gain = 1.0f;
+
+    pdm_math_sincosf(PDM_MATH_TWO_PI * frequency_hz / rate_hz, &s1, &c1);
+    pdm_math_sincosf(2.0f * PDM_MATH_TWO_PI * frequency_hz / rate_hz, &s2, &c2);
+
+    for (uint32_t i = 0U; i < stages; i++)
+    {
+        float nr = p_coeffs[i].b0 + (p_coeffs[i].b1 * c1) + (p_coeffs[i].b2 * c2);
+        float ni = (p_coeffs[i].b1 * s1) + (p_coeffs[i].b2 * s2);
+        float dr = 1.0f + (p_coeffs[i].a1 * c1) + (p_coeffs[i].a2 * c2);
+        float di = (p_coeffs[i].a1 * s1) + (p_coeffs[i].a2 * s2);
+
+        gain *= sqrtf(((nr * nr) + (ni * ni)) / ((dr * dr) + (di * di)));
+    }
+
+    return gain;
+}
+
+/* A weighting (3 sections) or C weighting (2 sections), 0 dB at the reference frequency. The low poles take the
+ * plain bilinear transform; the plain transform would pull the 12.2 kHz pair far down at 32 kHz (-10 dB at 12.5 kHz),
+ * so it is matched at the lower of itself and PDM_SLM_PRV_F4_MATCH times the rate instead. */
+static uint32_t pdm_slm_prv_weighting(pdm_dsp_biquad_coeffs_t * p_coeffs, bool a_weighting, float rate_hz)
+{
+    float    k      = PDM_MATH_PI / rate_hz;
+    float    match  = fminf(PDM_SLM_PRV_F4_HZ, PDM_SLM_PRV_F4_MATCH * rate_hz);
+    float    s;
+    float    c;
+    uint32_t stages = 0U;
+
+    pdm_math_sincosf(k * match, &s, &c);
+    float f4 = PDM_SLM_PRV_F4_HZ * (s / c) / match;
+
+    pdm_slm_prv_real_poles(&p_coeffs[stages++], k * PDM_SLM_PRV_F1_HZ, k * PDM_SLM_PRV_F1_HZ, true);
+    if (a_weighting)
+    {
+        pdm_slm_prv_real_poles(&p_coeffs[stages++], k * PDM_SLM_PRV_F2_HZ, k * PDM_SLM_PRV_F3_HZ, true);
+    }
+
+    pdm_slm_prv_real_poles(&p_coeffs[stages++], f4, f4, false);
+
+    float gain = 1.0f / pdm_slm_prv_gain(p_coeffs, stages, PDM_SLM_PRV_REFERENCE_HZ, rate_hz);
+    p_coeffs[0].b0 *= gain;
+    p_coeffs[0].b1 *= gain;
+    p_coeffs[0].b2 *= gain;
+
+    return stages;
+}
+
+/* Half-band low pass of the decimators: Blackman-windowed sinc, whose taps at even distances from the center are 0 */
+static void pdm_slm_prv_halfband(float * p_taps)
+{
+    float window[PDM_SLM_HALFBAND_TAPS + 2U];
+    float sum = 0.0f;
+
+    /* The window ends are 0, so it is two taps longer than the filter */
+    pdm_math_window(PDM_MATH_WINDOW_BLACKMAN, window, PDM_SLM_HALFBAND_TAPS + 2U);
+
+    for (uint32_t k = 0U; k < PDM_SLM_PRV_HALFBAND_PAIRS; k++)
+    {
+        uint32_t distance = (2U * k) + 1U;
+        float    sinc     = ((0U == (k & 1U)) ? 1.0f : -1.0f) / (PDM_MATH_PI * (float) distance);
+
+        p_taps[k] = window[PDM_SLM_PRV_HALFBAND_CENTER + 1U + distance] * sinc;
+        sum      += p_taps[k];
+    }
+
+    /* Unity DC gain: the center tap is 0.5 and both sides add up to the other half */
+    for (uint32_t k = 0U; k < PDM_SLM_PRV_HALFBAND_PAIRS; k++)
+    {
+        p_taps[k] *= 0.25f / sum;
+    }
+}
+
+/* Filters of the bank and the weightings for cfg.rate_hz, all from silence */
+static void pdm_slm_prv_design(pdm_slm_ctrl_t * p_ctrl, uint32_t band_count)
+{
+    float                   rate_hz    = (float) p_ctrl->cfg.rate_hz;
+    float                   half_width = pdm_slm_prv_half_width(p_ctrl->cfg.bands);
+    uint32_t                step       = 3U / (uint32_t) p_ctrl->cfg.bands;
+    pdm_dsp_biquad_coeffs_t coeffs[3];
+
+    uint32_t stages = pdm_slm_prv_weighting(coeffs, true, rate_hz);
+    (void) pdm_dsp_biquad_init(&p_ctrl->a_weighting, coeffs, stages);
+    stages = pdm_slm_prv_weighting(coeffs, false, rate_hz);
+    (void) pdm_dsp_biquad_init(&p_ctrl->c_weighting, coeffs, stages);
+
+    memset(p_ctrl->band, 0, sizeof(p_ctrl->band));
+    memset(p_ctrl->stage, 0, sizeof(p_ctrl->stage));
+    p_ctrl->band_count  = band_count;
+    p_ctrl->stage_count = 0U;
+
+    /* Highest band first, so each stage ends up with the lowest of its bands as the first one */
+    for (uint32_t i = band_count; i-- > 0U;)
+    {
+        float    midband_hz = pdm_slm_prv_midband_hz(p_ctrl->cfg.low_band + (i * step));
+        uint32_t stage      = pdm_slm_prv_stage(midband_hz, p_ctrl->cfg.rate_hz);
+
+        pdm_slm_prv_bandpass(coeffs, midband_hz, half_width, rate_hz / (float) (1U << stage));
+        (void) pdm_dsp_biquad_init(&p_ctrl->band[i].filter, coeffs, 3U);
+
+        p_ctrl->stage[stage].first_band = i;
+        p_ctrl->stage[stage].bands++;
+        p_ctrl->stage_count = stage + 1U;
+    }
+}
+
+static float pdm_slm_prv_db(pdm_slm_ctrl_t const * p_ctrl, double mean_square)
+{
+    if (!(mean_square > 0.0))
+    {
+        return PDM_SLM_FLOOR;
+    }
+
+    /* A full scale sine has a mean square of 1/2 */
+    double l = (double) p_ctrl->cfg.full_scale_db + (10.0 * log10(2.0 * mean_square));
+
+    return (l > (double) PDM_SLM_FLOOR) ? (float) l : PDM_SLM_FLOOR;
+}
+
+static float pdm_slm_prv_energy(float const * p_in, uint32_t count)
+{
+    float sum = 0.0f;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        sum += p_in[i] * p_in[i];
+    }
+
+    return sum;
+}
+
+/* Half the rate of a block into the next stage (in place); returns the samples out */
+static uint32_t pdm_slm_prv_decimate(pdm_slm_stage_t * p_stage, float const * p_taps, float * p_buf, uint32_t count)
+{
+    uint32_t index = p_stage->history_index;
+    uint32_t phase = p_stage->phase;
+    uint32_t out   = 0U;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        /* Newest sample first in the window */
+        index = (0U == index) ? (PDM_SLM_HALFBAND_TAPS - 1U) : (index - 1U);
+        p_stage->history[index]                         = p_buf[i];
+        p_stage->history[index + PDM_SLM_HALFBAND_TAPS] = p_buf[i];
+
+        if (0U != phase)
+        {
+            float const * p_window = &p_stage->history[index];
+            float         acc      = 0.5f * p_window[PDM_SLM_PRV_HALFBAND_CENTER];
+
+            for (uint32_t k = 0U; k < PDM_SLM_PRV_HALFBAND_PAIRS; k++)
+            {
+                uint32_t distance = (2U * k) + 1U;
+                acc += p_taps[k] * (p_window[PDM_SLM_PRV_HALFBAND_CENTER - distance] +
+                                    p_window[PDM_SLM_PRV_HALFBAND_CENTER + distance]);
+            }
+
+            /* out <= i, so the sample is already in the window */
+            p_buf[out++] = acc;
+        }
+
+        phase ^= 1U;
+    }
+
+    p_stage->history_index = index;
+    p_stage->phase         = phase;
+
+    return out;
+}
+
+/* Length of the next interval: rate * interval_ms / 1000 samples, one more every time the thousandths add up */
+static void pdm_slm_prv_interval_begin(pdm_slm_ctrl_t * p_ctrl)
+{
+    uint64_t total = (uint64_t) p_ctrl->cfg.rate_hz * p_ctrl->cfg.interval_ms;
+
+    p_ctrl->interval_remainder += (uint32_t) (total % 1000U);
+    p_ctrl->interval_length     = (uint32_t) (total / 1000U);
+
+    if (p_ctrl->interval_remainder >= 1000U)
+    {
+        p_ctrl->interval_remainder -= 1000U;
+        p_ctrl->interval_length++;
+    }
+
+    p_ctrl->interval_fill = 0U;
+    p_ctrl->sum_a         = 0.0;
+    p_ctrl->sum_c         = 0.0;
+    p_ctrl->sum_z         = 0.0;
+
+    for (uint32_t i = 0U; i < p_ctrl->band_count; i++)
+    {
+        p_ctrl->band[i].sum = 0.0;
+    }
+
+    for (uint32_t j = 0U; j < p_ctrl->stage_count; j++)
+    {
+        p_ctrl->stage[j].count = 0U;
+    }
+}
+
+/* Levels of the interval so far into the result */
+static void pdm_slm_prv_interval_end(pdm_slm_ctrl_t * p_ctrl)
+{
+    pdm_slm_result_t * p_result = &p_ctrl->result;
+    double             fill     = (double) p_ctrl->interval_fill;
+
+    p_ctrl->intervals++;
+    p_result->interval    = p_ctrl->intervals;
+    p_result->duration_ms = (uint32_t) ((((uint64_t) p_ctrl->interval_fill * 1000U) + (p_ctrl->cfg.rate_hz / 2U)) /
+                                        p_ctrl->cfg.rate_hz);
+    p_result->laeq = pdm_slm_prv_db(p_ctrl, p_ctrl->sum_a / fill);
+    p_result->lceq = pdm_slm_prv_db(p_ctrl, p_ctrl->sum_c / fill);
+    p_result->lzeq = pdm_slm_prv_db(p_ctrl, p_ctrl->sum_z / fill);
+
+    p_result->low_band   = p_ctrl->cfg.low_band;
+    p_result->band_step  = 3U / (uint32_t) p_ctrl->cfg.bands;
+    p_result->band_count = p_ctrl->band_count;
+
+    for (uint32_t j = 0U; j < p_ctrl->stage_count; j++)
+    {
+        pdm_slm_stage_t const * p_stage = &p_ctrl->stage[j];
+
+        for (uint32_t i = p_stage->first_band; i < (p_stage->first_band + p_stage->bands); i++)
+        {
+            p_result->band[i] = (0U != p_stage->count) ?
+                                pdm_slm_prv_db(p_ctrl, p_ctrl->band[i].sum / (double) p_stage->count) :
+                                PDM_SLM_FLOOR;
+        }
+    }
+}
+
+/* Broadband sums of a chunk: unweighted, A and C */
+static void pdm_slm_prv_weighted(pdm_slm_ctrl_t * p_ctrl, float const * p_in, float * p_work, uint32_t count)
+{
+    p_ctrl->sum_z += (double) pdm_slm_prv_energy(p_in, count);
+
+    pdm_dsp_biquad_process(&p_ctrl->a_weighting, p_in, p_work, count);
+    p_ctrl->sum_a += (double) pdm_slm_prv_energy(p_work, count);
+
+    pdm_dsp_biquad_process(&p_ctrl->c_weighting, p_in, p_work, count);
+    p_ctrl->sum_c += (double) pdm_slm_prv_energy(p_work, count);
+}
+
+/* Band sums of a chunk, stage by stage down the rates (p_in is decimated in place) */
+static void pdm_slm_prv_bands(pdm_slm_ctrl_t * p_ctrl, float * p_in, float * p_work, uint32_t count)
+{
+    for (uint32_t j = 0U; (j < p_ctrl->stage_count) && (0U != count); j++)
+    {
+        pdm_slm_stage_t * p_stage = &p_ctrl->stage[j];
+
+        p_stage->count += count;
+
+        for (uint32_t i = p_stage->first_band; i < (p_stage->first_band + p_stage->bands); i++)
+        {
+            pdm_dsp_biquad_process(&p_ctrl->band[i].filter, p_in, p_work, count);
+            p_ctrl->band[i].sum += (double) pdm_slm_prv_energy(p_work, count);
+        }
+
+        if ((j + 1U) < p_ctrl->stage_count)
+        {
+            count = pdm_slm_prv_decimate(p_stage, p_ctrl->halfband, p_in, count);
+        }
+    }
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_slm_open(pdm_slm_ctrl_t * p_ctrl, pdm_slm_cfg_t const * p_cfg)
+{
+    if ((NULL == p_ctrl) || (NULL == p_cfg))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    uint32_t band_count = pdm_slm_prv_band_count(p_cfg);
+    if (0U == band_count)
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->cfg = *p_cfg;
+
+    pdm_slm_prv_halfband(p_ctrl->halfband);
+    pdm_slm_prv_design(p_ctrl, band_count);
+
+    p_ctrl->result.low_band   = p_cfg->low_band;
+    p_ctrl->result.band_step  = 3U / (uint32_t) p_cfg->bands;
+    p_ctrl->result.band_count = band_count;
+    p_ctrl->result.laeq       = PDM_SLM_FLOOR;
+    p_ctrl->result.lceq       = PDM_SLM_FLOOR;
+    p_ctrl->result.lzeq       = PDM_SLM_FLOOR;
+    for (uint32_t i = 0U; i < PDM_SLM_MAX_BANDS; i++)
+    {
+        p_ctrl->result.band[i] = PDM_SLM_FLOOR;
+    }
+
+    pdm_slm_prv_interval_begin(p_ctrl);
+
+    return FSP_SUCCESS;
+}
+
+uint32_t pdm_slm_process(pdm_slm_ctrl_t * p_ctrl, int32_t const * p_samples, uint32_t count)
+{
+    uint32_t completed = 0U;
+
+    for (uint32_t done = 0U; done < count;)
+    {
+        /* Chunks end at the interval end, so every stage sample falls in one interval */
+        uint32_t n = p_ctrl->interval_length - p_ctrl->interval_fill;
+        n = ((count - done) < n) ? (count - done) : n;
+        n = (PDM_SLM_CHUNK < n) ? PDM_SLM_CHUNK : n;
+
+        float x[PDM_SLM_CHUNK];
+        float work[PDM_SLM_CHUNK];
+
+        pdm_dsp_to_float(&p_samples[done], x, n, p_ctrl->cfg.scale);
+        pdm_slm_prv_weighted(p_ctrl, x, work, n);
+        pdm_slm_prv_bands(p_ctrl, x, work, n);
+
+        p_ctrl->interval_fill += n;
+        done                  += n;
+
+        if (p_ctrl->interval_fill == p_ctrl->interval_length)
+        {
+            pdm_slm_prv_interval_end(p_ctrl);
+            pdm_slm_prv_interval_begin(p_ctrl);
+            completed++;
+        }
+    }
+
+    return completed;
+}
+
+void pdm_slm_get(pdm_slm_ctrl_t const * p_ctrl, pdm_slm_result_t * p_result)
+{
+    *p_result = p_ctrl->result;
+}
+
+uint32_t pdm_slm_flush(pdm_slm_ctrl_t * p_ctrl)
+{
+    if (0U == p_ctrl->interval_fill)
+    {
+        return 0U;
+    }
+
+    pdm_slm_prv_interval_end(p_ctrl);
+    pdm_slm_prv_interval_begin(p_ctrl);
+
+    return 1U;
+}
+
+fsp_err_t pdm_slm_rate_set(pdm_slm_ctrl_t * p_ctrl, uint32_t rate_hz)
+{
+    pdm_slm_cfg_t cfg = p_ctrl->cfg;
+    cfg.rate_hz = rate_hz;
+
+    uint32_t band_count = pdm_slm_prv_band_count(&cfg);
+    if (0U == band_count)
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Band levels of two rates do not mix: what was metered at the old one is an interval of its own */
+    (void) pdm_slm_flush(p_ctrl);
+
+    p_ctrl->cfg                = cfg;
+    p_ctrl->interval_remainder = 0U;
+    pdm_slm_prv_design(p_ctrl, band_count);
+    pdm_slm_prv_interval_begin(p_ctrl);
+
+    return FSP_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file pdm_slm.h
+ * @brief Sound level meter: octave or third-octave band levels and A/C-weighted Leq over fixed intervals
+ * @details One mono channel, metered block by block with constant memory, for continuous noise monitoring:
+ *          - band filters: IEC 61260 base-10 bands (midband 10^(n/10) Hz for band number n, so band 30 is 1 kHz), each
+ *            a third-order Butterworth band pass (three pdm_dsp biquads) with its edges at G^(-1/2b) and G^(1/2b)
+ *            times the midband, G = 10^0.3 and b = 1 or 3 bands per octave
+ *          - multirate: the bands above rate / 16 run at the input rate; the signal is then halved in rate by a
+ *            half-band FIR for every octave below, and each stage filters the bands of its octave at its own rate.
+ *            Every band below the first stage runs at 8 to 16 times its midband, so the bilinear transform hardly
+ *            warps its shape, its coefficients are well conditioned, and the whole bank costs about as much as four
+ *            octaves of it at the input rate.
+ *          - A and C weighting: the IEC 61672-1 analog poles through the bilinear transform, the 12.2 kHz pole pair
+ *            with its own frequency match so both stay inside the class 1 tolerances up to the top band from 16 kHz
+ *            to 48 kHz. Both are exactly 0 dB at 1 kHz.
+ *          - Leq: the mean square of every band and of the A, C and Z (unweighted) signals over each interval, so only
+ *            the levels of an interval leave the meter
+ *
+ *          The highest band is the last one whose upper edge is below 0.45 times the rate. Levels are in dB, a full
+ *          scale sine reading cfg.full_scale_db: with the sound pressure level of a full scale sine there (94 dB minus
+ *          the microphone sensitivity in dBFS) they read in dB SPL, with 0 in dB relative to full scale. Silence
+ *          reads PDM_SLM_FLOOR.
+ *
+ *          All functions are foreground only.
+ */
+
+#ifndef PDM_SLM_H
+#define PDM_SLM_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+#include "pdm_dsp.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Reading of silence */
+#define PDM_SLM_FLOOR                (-200.0f)
+
+/** Largest band count: third-octave bands from band 10 (10 Hz) at 96 kHz */
+#define PDM_SLM_MAX_BANDS            (36U)
+
+/** Largest number of rate stages, the input rate included */
+#define PDM_SLM_MAX_STAGES           (12U)
+
+/** Taps of the half-band decimator between two stages (4k - 1, so every second tap but the center is zero) */
+#define PDM_SLM_HALFBAND_TAPS        (23U)
+
+/** Samples filtered per pass (stack buffers) */
+#define PDM_SLM_CHUNK                (64U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Band widths */
+typedef enum e_pdm_slm_bands
+{
+    PDM_SLM_BANDS_OCTAVE       = 1,    ///< Octave bands, band numbers a multiple of 3
+    PDM_SLM_BANDS_THIRD_OCTAVE = 3,    ///< Third-octave bands
+} pdm_slm_bands_t;
+
+/** Input settings */
+typedef struct st_pdm_slm_cfg
+{
+    uint32_t        rate_hz;           ///< Sample rate, 8 kHz to 96 kHz
+    float           scale;             ///< Sample to full scale 1.0, e.g. 1/2^19 for 20-bit samples
+    float           full_scale_db;     ///< Level reported for a full scale sine
+    pdm_slm_bands_t bands;             ///< Band width
+    uint32_t        low_band;          ///< Band number of the lowest band, at least 10 (10 Hz)
+    uint32_t        interval_ms;       ///< Leq interval, 100 ms to 1 h
+} pdm_slm_cfg_t;
+
+/** Levels of one interval, in dB */
+typedef struct st_pdm_slm_result
+{
+    uint32_t interval;                 ///< Intervals completed since open, this one included
+    uint32_t duration_ms;              ///< Length of the interval (shorter than cfg.interval_ms if flushed early)
+    float    laeq;                     ///< A-weighted
+    float    lceq;                     ///< C-weighted
+    float    lzeq;                     ///< Unweighted
+    uint32_t low_band;                 ///< Band number of band[0]
+    uint32_t band_step;                ///< Band number step: 1 for third-octave, 3 for octave bands
+    uint32_t band_count;               ///< Bands in use
+    float    band[PDM_SLM_MAX_BANDS];  ///< Band levels, lowest first
+} pdm_slm_result_t;
+
+/** One band filter */
+typedef struct st_pdm_slm_band
+{
+    pdm_dsp_biquad_t filter;           ///< Band pass, at the rate of its stage
+    double           sum;              ///< Sum of squares in the current interval
+} pdm_slm_band_t;
+
+/** One rate stage: the input, or the input decimated by 2^stage */
+typedef struct st_pdm_slm_stage
+{
+    uint32_t first_band;               ///< Bands of this stage: band[first_band] up to band[first_band + bands - 1]
+    uint32_t bands;
+    uint32_t count;                    ///< Samples of this stage in the current interval
+    float    history[2U * PDM_SLM_HALFBAND_TAPS];  ///< Input of the decimator into the next stage, mirrored
+    uint32_t history_index;            ///< Position of the newest sample
+    uint32_t phase;                    ///< 1 when the next sample gives an output sample
+} pdm_slm_stage_t;
+
+/** Instance */
+typedef struct st_pdm_slm_ctrl
+{
+    pdm_slm_cfg_t    cfg;
+    pdm_dsp_biquad_t a_weighting;
+    pdm_dsp_biquad_t c_weighting;
+    float            halfband[(PDM_SLM_HALFBAND_TAPS + 1U) / 4U];  ///< Decimator taps at distances 1, 3, 5, ..
+                                                                   ///< from the center (whose tap is 0.5)
+    uint32_t         band_count;
+    uint32_t         stage_count;
+    pdm_slm_band_t   band[PDM_SLM_MAX_BANDS];                      ///< Lowest first
+    pdm_slm_stage_t  stage[PDM_SLM_MAX_STAGES];                    ///< Input rate first
+
+    /* Intervals; their lengths alternate so the intervals keep to the rate on average */
+    uint32_t         interval_length;  ///< Samples of the current interval
+    uint32_t         interval_fill;    ///< Samples of it metered
+    uint32_t         interval_remainder;   ///< Bresenham phase of the lengths, in thousandths of a sample
+    double           sum_a;            ///< Sums of squares in the current interval
+    double           sum_c;
+    double           sum_z;
+    uint32_t         intervals;        ///< Intervals completed
+    pdm_slm_result_t result;           ///< Levels of the last one
+} pdm_slm_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Design the filter bank and start the first interval from silence
+ * @param[out] p_ctrl  Instance
+ * @param[in]  p_cfg   Input settings
+ * @retval FSP_SUCCESS               Ready
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Setting out of range, an octave band number not a multiple of 3, or no band fits
+ *                                   the rate
+ */
+fsp_err_t pdm_slm_open(pdm_slm_ctrl_t * p_ctrl, pdm_slm_cfg_t const * p_cfg);
+
+/**
+ * @brief Meter a block
+ * @param[in,out] p_ctrl     Instance
+ * @param[in]     p_samples  Signed samples
+ * @param[in]     count      Samples
+ * @return Intervals completed in this block. pdm_slm_get() returns the last one only, so blocks should be shorter
+ *         than an interval.
+ */
+uint32_t pdm_slm_process(pdm_slm_ctrl_t * p_ctrl, int32_t const * p_samples, uint32_t count);
+
+/**
+ * @brief Levels of the last completed interval
+ * @param[in]  p_ctrl    Instance
+ * @param[out] p_result  Levels (interval 0 and PDM_SLM_FLOOR until the first interval completes)
+ */
+void pdm_slm_get(pdm_slm_ctrl_t const * p_ctrl, pdm_slm_result_t * p_result);
+
+/**
+ * @brief End the interval in progress early as a short one, e.g. at the end of a recording; the next one starts there
+ * @param[in,out] p_ctrl  Instance
+ * @return 1 if it had samples and pdm_slm_get() now returns it, else 0
+ */
+uint32_t pdm_slm_flush(pdm_slm_ctrl_t * p_ctrl);
+
+/**
+ * @brief Follow a rate change (live filter swap): the interval in progress ends there as a short one, then the bank is
+ *        designed for the new rate and the next interval starts from silence
+ * @param[in,out] p_ctrl   Instance
+ * @param[in]     rate_hz  New rate, in the range of pdm_slm_open()
+ * @retval FSP_SUCCESS               Changed; pdm_slm_get() returns the short interval if it had any samples
+ * @retval FSP_ERR_INVALID_ARGUMENT  Rate out of range or no band fits it; the meter is left as it was
+ */
+fsp_err_t pdm_slm_rate_set(pdm_slm_ctrl_t * p_ctrl, uint32_t rate_hz);
+
+FSP_FOOTER
+
+#endif /* PDM_SLM_H */
@@ -0,0 +1,71 @@
+/**
+ * @file pdm_slot.c
+ * @brief Block slots with explicit ownership
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_slot.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_slot_open(pdm_slot_ctrl_t * p_ctrl, pdm_slot_cfg_t const * p_cfg)
+{
+    if ((NULL == p_ctrl) || (NULL == p_cfg) || (NULL == p_cfg->p_storage))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((p_cfg->slots < 2U) || (p_cfg->slots > PDM_SLOT_MAX_SLOTS) || (0U == p_cfg->slot_samples))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->cfg = *p_cfg;
+    pdm_port_memory_barrier();
+
+    return FSP_SUCCESS;
+}
+
+uint32_t pdm_slot_borrow(pdm_slot_ctrl_t * p_ctrl)
+{
+    uint32_t slot = p_ctrl->consume_slot;
+
+    if (PDM_SLOT_STATE_READY != p_ctrl->state[slot])
+    {
+        return PDM_SLOT_NONE;
+    }
+
+    /* State must be observed before the block contents */
+    pdm_port_memory_barrier();
+    p_ctrl->state[slot] = (uint8_t) PDM_SLOT_STATE_CONSUMING;
+
+    uint32_t backlog = p_ctrl->filled - p_ctrl->consumed;
+    if (backlog > p_ctrl->high_water)
+    {
+        p_ctrl->high_water = backlog;
+    }
+
+    return slot;
+}
+
+fsp_err_t pdm_slot_release(pdm_slot_ctrl_t * p_ctrl, uint32_t slot)
+{
+    if ((slot != p_ctrl->consume_slot) || (PDM_SLOT_STATE_CONSUMING != p_ctrl->state[slot]))
+    {
+        return FSP_ERR_INVALID_STATE;
+    }
+
+    /* Done reading before the producer may write again */
+    pdm_port_memory_barrier();
+    p_ctrl->state[slot]  = (uint8_t) PDM_SLOT_STATE_FREE;
+    p_ctrl->consumed     = p_ctrl->consumed + 1U;
+    p_ctrl->consume_slot = ((slot + 1U) < p_ctrl->cfg.slots) ? (slot + 1U) : 0U;
+
+    return FSP_SUCCESS;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file pdm_slot.h
+ * @brief Block slots with explicit ownership between the data interrupt and a slower consumer
+ * @details A pool of N block-sized slots, each in one of four states:
+ *          - FREE: owned by nobody, the producer may take it
+ *          - FILLING: owned by the producer (the data interrupt) while it writes the block
+ *          - READY: complete, waiting for the consumer
+ *          - CONSUMING: borrowed by the consumer (the foreground) until it releases it
+ *
+ *          The producer only ever writes a FREE slot; when the next slot in order is not free the block is refused
+ *          and counted as dropped, so a consumer that falls behind loses whole blocks but never reads a slot that is
+ *          being overwritten. Slots are filled and consumed in the same round-robin order, so blocks come out in
+ *          capture order. N is the latency/safety tradeoff: up to N blocks may wait for or be in processing before
+ *          blocks are dropped, at N blocks of memory and up to N block periods of latency.
+ *
+ *          One producer (an interrupt, which never preempts itself) and one consumer; no locks.
+ */
+
+#ifndef PDM_SLOT_H
+#define PDM_SLOT_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Largest pool */
+#define PDM_SLOT_MAX_SLOTS    (8U)
+
+/** No slot available */
+#define PDM_SLOT_NONE         (UINT32_MAX)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Owner of a slot */
+typedef enum e_pdm_slot_state
+{
+    PDM_SLOT_STATE_FREE = 0,           ///< Nobody
+    PDM_SLOT_STATE_FILLING,            ///< Producer
+    PDM_SLOT_STATE_READY,              ///< Nobody, waiting for the consumer
+    PDM_SLOT_STATE_CONSUMING,          ///< Consumer
+} pdm_slot_state_t;
+
+/** Pool storage */
+typedef struct st_pdm_slot_cfg
+{
+    uint32_t * p_storage;              ///< slots * slot_samples words
+    uint32_t   slot_samples;           ///< Samples per slot
+    uint32_t   slots;                  ///< 2 .. PDM_SLOT_MAX_SLOTS
+} pdm_slot_cfg_t;
+
+/** Instance. fill is written by the producer only, consume by the consumer only. */
+typedef struct st_pdm_slot_ctrl
+{
+    pdm_slot_cfg_t    cfg;
+    volatile uint8_t  state[PDM_SLOT_MAX_SLOTS];   ///< pdm_slot_state_t per slot
+    volatile uint32_t filled;          ///< Blocks made READY
+    volatile uint32_t dropped;         ///< Blocks refused because the next slot was not FREE
+    volatile uint32_t consumed;        ///< Blocks released
+    uint32_t          fill_slot;       ///< Next slot of the producer
+    uint32_t          consume_slot;    ///< Next slot of the consumer
+    uint32_t          high_water;      ///< Most slots READY or CONSUMING seen by the consumer
+} pdm_slot_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Make every slot FREE (while no producer runs)
+ * @param[out] p_ctrl  Instance
+ * @param[in]  p_cfg   Pool storage
+ * @retval FSP_SUCCESS               Ready
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  Slot count out of range or empty slots
+ */
+fsp_err_t pdm_slot_open(pdm_slot_ctrl_t * p_ctrl, pdm_slot_cfg_t const * p_cfg);
+
+/**
+ * @brief Consumer: borrow the oldest READY slot
+ * @param[in,out] p_ctrl  Instance
+ * @return Slot, now CONSUMING, or PDM_SLOT_NONE if nothing is ready
+ */
+uint32_t pdm_slot_borrow(pdm_slot_ctrl_t * p_ctrl);
+
+/**
+ * @brief Consumer: hand a borrowed slot back to the producer
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     slot    Slot from pdm_slot_borrow()
+ * @retval FSP_SUCCESS             Slot FREE
+ * @retval FSP_ERR_INVALID_STATE   Not the borrowed slot
+ */
+fsp_err_t pdm_slot_release(pdm_slot_ctrl_t * p_ctrl, uint32_t slot);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/** Samples of a slot */
+static inline uint32_t * pdm_slot_data(pdm_slot_ctrl_t const * p_ctrl, uint32_t slot)
+{
+    return &p_ctrl->cfg.p_storage[slot * p_ctrl->cfg.slot_samples];
+}
+
+/**
+ * @brief Producer: take the next slot for a block (interrupt safe, constant time)
+ * @param[in,out] p_ctrl  Instance
+ * @return Slot, now FILLING, or PDM_SLOT_NONE if the consumer still owns it (the block is counted as dropped)
+ */
+static inline uint32_t pdm_slot_fill_begin(pdm_slot_ctrl_t * p_ctrl)
+{
+    uint32_t slot = p_ctrl->fill_slot;
+
+    if (PDM_SLOT_STATE_FREE != p_ctrl->state[slot])
+    {
+        p_ctrl->dropped = p_ctrl->dropped + 1U;
+
+        return PDM_SLOT_NONE;
+    }
+
+    p_ctrl->state[slot] = (uint8_t) PDM_SLOT_STATE_FILLING;
+
+    return slot;
+}
+
+/**
+ * @brief Producer: publish a filled slot
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     slot    Slot from pdm_slot_fill_begin()
+ */
+static inline void pdm_slot_fill_end(pdm_slot_ctrl_t * p_ctrl, uint32_t slot)
+{
+    /* Block contents before the state that hands them over */
+    pdm_port_memory_barrier();
+    p_ctrl->state[slot] = (uint8_t) PDM_SLOT_STATE_READY;
+    p_ctrl->filled      = p_ctrl->filled + 1U;
+    p_ctrl->fill_slot   = ((slot + 1U) < p_ctrl->cfg.slots) ? (slot + 1U) : 0U;
+}
+
+FSP_FOOTER
+
+#endif /* PDM_SLOT_H */
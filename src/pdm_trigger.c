@@ -0,0 +1,153 @@
+/**
+ * @file pdm_trigger.c
+ * @brief Pre-trigger ring recorder
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_trigger.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_trigger_open(pdm_trigger_ctrl_t * p_ctrl, pdm_trigger_cfg_t const * p_cfg)
+{
+    if ((NULL == p_ctrl) || (NULL == p_cfg) || (NULL == p_cfg->p_buffer))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if ((0U == p_cfg->post_samples) || (p_cfg->pre_samples > p_cfg->capacity) ||
+        (p_cfg->post_samples > (p_cfg->capacity - p_cfg->pre_samples)))
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    p_ctrl->cfg   = *p_cfg;
+    p_ctrl->state = PDM_TRIGGER_STATE_ARMED;
+
+    return FSP_SUCCESS;
+}
+
+uint32_t pdm_trigger_reserve(pdm_trigger_ctrl_t * p_ctrl, uint32_t ** pp_span)
+{
+    uint32_t offset = (uint32_t) (p_ctrl->written % p_ctrl->cfg.capacity);
+    uint32_t room   = p_ctrl->cfg.capacity - offset;
+
+    if (PDM_TRIGGER_STATE_FROZEN == p_ctrl->state)
+    {
+        return 0U;
+    }
+
+    /* The post-roll ends with the record, so the pre-roll behind it is never overwritten */
+    if ((PDM_TRIGGER_STATE_POST_ROLL == p_ctrl->state) && ((p_ctrl->end - p_ctrl->written) < room))
+    {
+        room = (uint32_t) (p_ctrl->end - p_ctrl->written);
+    }
+
+    *pp_span = &p_ctrl->cfg.p_buffer[offset];
+
+    return room;
+}
+
+void pdm_trigger_commit(pdm_trigger_ctrl_t * p_ctrl, uint32_t count)
+{
+    p_ctrl->written += count;
+
+    if ((p_ctrl->written - p_ctrl->oldest) > p_ctrl->cfg.capacity)
+    {
+        p_ctrl->oldest = p_ctrl->written - p_ctrl->cfg.capacity;
+    }
+
+    if ((PDM_TRIGGER_STATE_POST_ROLL == p_ctrl->state) && (p_ctrl->written >= p_ctrl->end))
+    {
+        p_ctrl->state = PDM_TRIGGER_STATE_FROZEN;
+    }
+}
+
+fsp_err_t pdm_trigger_fire(pdm_trigger_ctrl_t * p_ctrl, uint64_t position, uint32_t source)
+{
+    if (PDM_TRIGGER_STATE_ARMED != p_ctrl->state)
+    {
+        p_ctrl->ignored++;
+
+        return FSP_ERR_INVALID_STATE;
+    }
+
+    /* A late trigger cannot reach back further than the ring */
+    position = (position < p_ctrl->oldest) ? p_ctrl->oldest : position;
+
+    uint64_t first = (position > p_ctrl->cfg.pre_samples) ? (position - p_ctrl->cfg.pre_samples) : 0U;
+
+    p_ctrl->source  = source;
+    p_ctrl->trigger = position;
+    p_ctrl->first   = (first < p_ctrl->oldest) ? p_ctrl->oldest : first;
+    p_ctrl->end     = position + p_ctrl->cfg.post_samples;
+    p_ctrl->state   = (p_ctrl->written >= p_ctrl->end) ? PDM_TRIGGER_STATE_FROZEN : PDM_TRIGGER_STATE_POST_ROLL;
+    p_ctrl->triggers++;
+
+    return FSP_SUCCESS;
+}
+
+bool pdm_trigger_detect(pdm_trigger_ctrl_t * p_ctrl, int32_t const * p_samples, uint32_t count)
+{
+    int32_t level = p_ctrl->cfg.level;
+
+    if ((0 == level) || (PDM_TRIGGER_STATE_ARMED != p_ctrl->state))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        if ((p_samples[i] >= level) || (p_samples[i] <= -level))
+        {
+            return FSP_SUCCESS == pdm_trigger_fire(p_ctrl, p_ctrl->written + i, PDM_TRIGGER_SOURCE_LEVEL);
+        }
+    }
+
+    return false;
+}
+
+void pdm_trigger_stop(pdm_trigger_ctrl_t * p_ctrl)
+{
+    if (PDM_TRIGGER_STATE_POST_ROLL == p_ctrl->state)
+    {
+        p_ctrl->end   = (p_ctrl->written > p_ctrl->first) ? p_ctrl->written : p_ctrl->first;
+        p_ctrl->state = PDM_TRIGGER_STATE_FROZEN;
+    }
+}
+
+fsp_err_t pdm_trigger_event_get(pdm_trigger_ctrl_t const * p_ctrl, pdm_trigger_event_t * p_event)
+{
+    if (PDM_TRIGGER_STATE_FROZEN != p_ctrl->state)
+    {
+        return FSP_ERR_NOT_FOUND;
+    }
+
+    uint32_t offset = (uint32_t) (p_ctrl->first % p_ctrl->cfg.capacity);
+    uint32_t length = (uint32_t) (p_ctrl->end - p_ctrl->first);
+    uint32_t head   = p_ctrl->cfg.capacity - offset;
+
+    p_event->source     = p_ctrl->source;
+    p_event->first      = p_ctrl->first;
+    p_event->trigger    = p_ctrl->trigger;
+    p_event->length     = length;
+    p_event->p_head     = &p_ctrl->cfg.p_buffer[offset];
+    p_event->head_count = (length < head) ? length : head;
+    p_event->p_tail     = p_ctrl->cfg.p_buffer;
+    p_event->tail_count = length - p_event->head_count;
+
+    return FSP_SUCCESS;
+}
+
+void pdm_trigger_rearm(pdm_trigger_ctrl_t * p_ctrl)
+{
+    /* The samples dropped while frozen break the stream: the new pre-roll starts empty */
+    p_ctrl->oldest = p_ctrl->written;
+    p_ctrl->state  = PDM_TRIGGER_STATE_ARMED;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file pdm_trigger.h
+ * @brief Pre-trigger ring recorder: continuous pre-roll, triggered event record with post-roll
+ * @details Collected samples are appended to a ring instead of a linear buffer. Until a trigger arrives the ring only
+ *          keeps the most recent samples; a trigger fixes the event record at [trigger - pre, trigger + post) and the
+ *          ring keeps filling until the post-roll is complete, then freezes. The pre-roll is never copied: the record
+ *          is a view of the ring (at most two spans when it wraps), valid until pdm_trigger_rearm().
+ *
+ *          Positions count the samples appended since pdm_trigger_open() (the "stored" domain). Anything the caller
+ *          leaves out of the ring (lost blocks, filter settling) is not counted, so a trigger position derived from the
+ *          stream index is correct up to those gaps; the caller records them next to the data.
+ *
+ *          Triggers come from a hardware event (the PDM sound detector, translated to a position by the caller) or
+ *          from the level detector, pdm_trigger_detect(), run over samples just before they are appended. The first
+ *          trigger wins; later ones are ignored until the record has been consumed.
+ *
+ *          The capacity must hold pre + post samples; the pre-roll is shorter if the ring has not been filled that far
+ *          since the start or the last rearm. All functions are foreground only.
+ */
+
+#ifndef PDM_TRIGGER_H
+#define PDM_TRIGGER_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Trigger sources */
+#define PDM_TRIGGER_SOURCE_SOUND_DETECTION    (0U)   ///< PDM_EVENT_SOUND_DETECTION
+#define PDM_TRIGGER_SOURCE_LEVEL              (1U)   ///< pdm_trigger_detect()
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Recorder state */
+typedef enum e_pdm_trigger_state
+{
+    PDM_TRIGGER_STATE_ARMED = 0,       ///< Keeping the pre-roll, waiting for a trigger
+    PDM_TRIGGER_STATE_POST_ROLL,       ///< Triggered, appending the post-roll
+    PDM_TRIGGER_STATE_FROZEN,          ///< Record complete; appends are refused until pdm_trigger_rearm()
+} pdm_trigger_state_t;
+
+/** Ring and record lengths */
+typedef struct st_pdm_trigger_cfg
+{
+    uint32_t * p_buffer;               ///< Ring storage, one word per sample
+    uint32_t   capacity;               ///< Ring length in samples, at least pre_samples + post_samples
+    uint32_t   pre_samples;            ///< Samples kept before the trigger
+    uint32_t   post_samples;           ///< Samples recorded from the trigger on, at least 1
+    int32_t    level;                  ///< pdm_trigger_detect() threshold on |sample|, 0: level trigger off
+} pdm_trigger_cfg_t;
+
+/** Frozen event record */
+typedef struct st_pdm_trigger_event
+{
+    uint32_t         source;           ///< PDM_TRIGGER_SOURCE_*
+    uint64_t         first;            ///< Stored position of the first sample of the record
+    uint64_t         trigger;          ///< Stored position of the trigger
+    uint32_t         length;           ///< Samples in the record
+    uint32_t const * p_head;           ///< Record start in the ring
+    uint32_t         head_count;       ///< Samples at p_head
+    uint32_t const * p_tail;           ///< Continuation from the start of the ring when the record wraps
+    uint32_t         tail_count;       ///< Samples at p_tail, 0 if the record does not wrap
+} pdm_trigger_event_t;
+
+/** Instance */
+typedef struct st_pdm_trigger_ctrl
+{
+    pdm_trigger_cfg_t   cfg;
+    pdm_trigger_state_t state;
+    uint32_t            source;        ///< Source of the pending or frozen record
+    uint64_t            written;       ///< Samples appended, the stored position of the next one
+    uint64_t            oldest;        ///< Oldest position still in the ring
+    uint64_t            trigger;       ///< Trigger position
+    uint64_t            first;         ///< First position of the record
+    uint64_t            end;           ///< Position after the record
+    uint32_t            triggers;      ///< Triggers accepted since open
+    uint32_t            ignored;       ///< Triggers that arrived while a record was pending
+} pdm_trigger_ctrl_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Start an empty, armed ring
+ * @param[out] p_ctrl  Instance
+ * @param[in]  p_cfg   Ring and record lengths
+ * @retval FSP_SUCCESS               Armed
+ * @retval FSP_ERR_ASSERTION         NULL pointer
+ * @retval FSP_ERR_INVALID_ARGUMENT  No post-roll, or pre plus post samples exceed the capacity
+ */
+fsp_err_t pdm_trigger_open(pdm_trigger_ctrl_t * p_ctrl, pdm_trigger_cfg_t const * p_cfg);
+
+/**
+ * @brief Contiguous room at the write position
+ * @details In the post-roll the room ends with the record; when frozen there is none.
+ * @param[in]  p_ctrl   Instance
+ * @param[out] pp_span  Where the next samples go
+ * @return Samples that may be written at *pp_span, then passed to pdm_trigger_commit()
+ */
+uint32_t pdm_trigger_reserve(pdm_trigger_ctrl_t * p_ctrl, uint32_t ** pp_span);
+
+/**
+ * @brief Append samples written into the span of pdm_trigger_reserve()
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     count   Samples, at most the reserved room
+ */
+void pdm_trigger_commit(pdm_trigger_ctrl_t * p_ctrl, uint32_t count);
+
+/**
+ * @brief Trigger an event record
+ * @param[in,out] p_ctrl    Instance
+ * @param[in]     position  Stored position of the trigger; clamped to what the ring still holds
+ * @param[in]     source    PDM_TRIGGER_SOURCE_*
+ * @retval FSP_SUCCESS             Record started (frozen at once if its post-roll is already stored)
+ * @retval FSP_ERR_INVALID_STATE   A record is pending or frozen; the trigger is counted as ignored
+ */
+fsp_err_t pdm_trigger_fire(pdm_trigger_ctrl_t * p_ctrl, uint64_t position, uint32_t source);
+
+/**
+ * @brief Level detector over samples that are about to be appended
+ * @param[in,out] p_ctrl     Instance
+ * @param[in]     p_samples  Signed samples, the first one goes to pdm_trigger_position()
+ * @param[in]     count      Samples
+ * @return true if a sample reached the level and started a record
+ */
+bool pdm_trigger_detect(pdm_trigger_ctrl_t * p_ctrl, int32_t const * p_samples, uint32_t count);
+
+/**
+ * @brief End the capture: a record still in its post-roll is frozen as it is
+ * @param[in,out] p_ctrl  Instance
+ */
+void pdm_trigger_stop(pdm_trigger_ctrl_t * p_ctrl);
+
+/**
+ * @brief Frozen record
+ * @param[in]  p_ctrl   Instance
+ * @param[out] p_event  Record, a view of the ring
+ * @retval FSP_SUCCESS        Record returned
+ * @retval FSP_ERR_NOT_FOUND  Not frozen (no trigger yet, or the post-roll is still running)
+ */
+fsp_err_t pdm_trigger_event_get(pdm_trigger_ctrl_t const * p_ctrl, pdm_trigger_event_t * p_event);
+
+/**
+ * @brief Release the record and collect a new pre-roll from the next appended sample on
+ * @param[in,out] p_ctrl  Instance
+ */
+void pdm_trigger_rearm(pdm_trigger_ctrl_t * p_ctrl);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/** Stored position of the next appended sample */
+static inline uint64_t pdm_trigger_position(pdm_trigger_ctrl_t const * p_ctrl)
+{
+    return p_ctrl->written;
+}
+
+/** Current state */
+static inline pdm_trigger_state_t pdm_trigger_state(pdm_trigger_ctrl_t const * p_ctrl)
+{
+    return p_ctrl->state;
+}
+
+FSP_FOOTER
+
+#endif /* PDM_TRIGGER_H */
@@ -0,0 +1,192 @@
+/**
+ * @file pdm_work.c
+ * @brief Deferred work queue and priority dispatcher
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_work.h"
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_WORK_PRV_INDEX_MASK    (PDM_WORK_LANE_DEPTH - 1U)
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+/* Benchmark instance, kept out of the caller's stack */
+static pdm_work_ctrl_t g_pdm_work_bench_ctrl;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_work_prv_bench_handler(pdm_work_item_t const * p_item, void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_item);
+    FSP_PARAMETER_NOT_USED(p_context);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+fsp_err_t pdm_work_open(pdm_work_ctrl_t * p_ctrl)
+{
+    if (NULL == p_ctrl)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    memset(p_ctrl, 0, sizeof(*p_ctrl));
+    pdm_port_memory_barrier();
+
+    return FSP_SUCCESS;
+}
+
+fsp_err_t pdm_work_handler_set(pdm_work_ctrl_t * p_ctrl, uint32_t type, pdm_work_handler_t handler,
+                               void * p_context)
+{
+    if (type >= PDM_WORK_TYPES)
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    p_ctrl->handlers[type]   = handler;
+    p_ctrl->p_contexts[type] = p_context;
+
+    return FSP_SUCCESS;
+}
+
+uint32_t pdm_work_dispatch(pdm_work_ctrl_t * p_ctrl)
+{
+    uint32_t count = 0U;
+    uint32_t lane  = 0U;
+
+    while (lane < PDM_WORK_LANES)
+    {
+        pdm_work_lane_t * p_lane  = &p_ctrl->lanes[lane];
+        uint32_t          tail    = p_lane->tail;
+        uint32_t          backlog = p_lane->head - tail;
+
+        if (0U == backlog)
+        {
+            lane++;
+            continue;
+        }
+
+        if (backlog > p_lane->high_water)
+        {
+            p_lane->high_water = backlog;
+        }
+
+        /* Head must be observed before the item */
+        pdm_port_memory_barrier();
+        pdm_work_item_t item = p_lane->items[tail & PDM_WORK_PRV_INDEX_MASK];
+
+        /* Copied out, the slot can go back to the producer before the handler runs */
+        pdm_port_memory_barrier();
+        p_lane->tail = tail + 1U;
+
+        if ((item.type < PDM_WORK_TYPES) && (NULL != p_ctrl->handlers[item.type]))
+        {
+            p_ctrl->handlers[item.type](&item, p_ctrl->p_contexts[item.type]);
+        }
+        else
+        {
+            p_ctrl->unhandled++;
+        }
+
+        count++;
+
+        /* Work posted to a higher priority lane meanwhile goes first */
+        lane = 0U;
+    }
+
+    return count;
+}
+
+bool pdm_work_pending(pdm_work_ctrl_t const * p_ctrl)
+{
+    for (uint32_t lane = 0U; lane < PDM_WORK_LANES; lane++)
+    {
+        if (p_ctrl->lanes[lane].head != p_ctrl->lanes[lane].tail)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void pdm_work_stats_get(pdm_work_ctrl_t const * p_ctrl, uint32_t lane, pdm_work_stats_t * p_stats)
+{
+    pdm_work_lane_t const * p_lane = &p_ctrl->lanes[lane];
+
+    p_stats->posted     = p_lane->head;
+    p_stats->dispatched = p_lane->tail;
+    p_stats->dropped    = p_lane->dropped;
+    p_stats->high_water = p_lane->high_water;
+}
+
+void pdm_work_benchmark(pdm_work_bench_t * p_bench, uint32_t iterations)
+{
+    pdm_work_ctrl_t * p_ctrl = &g_pdm_work_bench_ctrl;
+    uint64_t          post_total     = 0U;
+    uint64_t          dispatch_total = 0U;
+    uint32_t          done           = 0U;
+
+    p_bench->post_min = UINT32_MAX;
+    p_bench->post_max = 0U;
+
+    pdm_port_cycle_counter_init();
+    (void) pdm_work_open(p_ctrl);
+    (void) pdm_work_handler_set(p_ctrl, 0U, pdm_work_prv_bench_handler, NULL);
+
+    while (done < iterations)
+    {
+        /* Fill the lane, then drain it, so every post sees the same conditions as in an interrupt */
+        uint32_t batch = iterations - done;
+        if (batch > PDM_WORK_LANE_DEPTH)
+        {
+            batch = PDM_WORK_LANE_DEPTH;
+        }
+
+        for (uint32_t i = 0U; i < batch; i++)
+        {
+            uint32_t start  = pdm_port_cycles();
+            (void) pdm_work_post(p_ctrl, 0U, 0U, i);
+            uint32_t cycles = pdm_port_cycles() - start;
+
+            post_total += cycles;
+            if (cycles < p_bench->post_min)
+            {
+                p_bench->post_min = cycles;
+            }
+
+            if (cycles > p_bench->post_max)
+            {
+                p_bench->post_max = cycles;
+            }
+        }
+
+        uint32_t start = pdm_port_cycles();
+        (void) pdm_work_dispatch(p_ctrl);
+        dispatch_total += (uint32_t) (pdm_port_cycles() - start);
+
+        done += batch;
+    }
+
+    if (0U == iterations)
+    {
+        p_bench->post_min = 0U;
+    }
+
+    p_bench->post_mean     = (0U != iterations) ? (uint32_t) (post_total / iterations) : 0U;
+    p_bench->dispatch_mean = (0U != iterations) ? (uint32_t) (dispatch_total / iterations) : 0U;
+}
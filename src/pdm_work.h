@@ -0,0 +1,197 @@
+/**
+ * @file pdm_work.h
+ * @brief Deferred work: interrupt handlers queue fixed-size items, the foreground runs the registered handlers
+ * @details Each lane is a lock-free single-producer/single-consumer ring. Give every interrupt priority that posts
+ *          work its own lane (an interrupt never preempts itself, so it is the only producer of that lane); the
+ *          foreground dispatcher is the only consumer.
+ *
+ *          Lanes double as dispatch priorities: pdm_work_dispatch() always takes the next item from the lowest
+ *          numbered non-empty lane, re-checking after every item, so urgent work (errors) overtakes bulk work
+ *          (blocks) that was queued earlier.
+ *
+ *          Posting is a bounds check, a 16-byte store and an index update; it has no loops and no locks, so its
+ *          cost is constant. pdm_work_benchmark() measures it.
+ */
+
+#ifndef PDM_WORK_H
+#define PDM_WORK_H
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_port.h"
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Number of lanes (dispatch priorities, lane 0 first) */
+#ifndef PDM_WORK_LANES
+ #define PDM_WORK_LANES          (3U)
+#endif
+
+/** Items per lane (power of two) */
+#ifndef PDM_WORK_LANE_DEPTH
+ #define PDM_WORK_LANE_DEPTH     (16U)
+#endif
+
+/** Number of distinct item types that can have a handler */
+#ifndef PDM_WORK_TYPES
+ #define PDM_WORK_TYPES          (8U)
+#endif
+
+#if (PDM_WORK_LANE_DEPTH & (PDM_WORK_LANE_DEPTH - 1U)) != 0U
+ #error "PDM_WORK_LANE_DEPTH must be a power of two"
+#endif
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** One unit of deferred work */
+typedef struct st_pdm_work_item
+{
+    uint16_t type;                     ///< Selects the handler, < PDM_WORK_TYPES
+    uint16_t lane;                     ///< Lane the item was posted to
+    uint32_t arg;                      ///< Type specific (block number, error bits, ...)
+    uint32_t sequence;                 ///< Per-lane post counter, gaps mean dropped items
+    uint32_t cycles;                   ///< pdm_port_cycles() when posted
+} pdm_work_item_t;
+
+/** Work handler, runs in the foreground */
+typedef void (* pdm_work_handler_t)(pdm_work_item_t const * p_item, void * p_context);
+
+/** One lane. head is written by the producer only, tail by the consumer only. */
+typedef struct st_pdm_work_lane
+{
+    volatile uint32_t head;            ///< Items posted
+    volatile uint32_t dropped;         ///< Items rejected because the lane was full
+    volatile uint32_t tail;            ///< Items dispatched
+    uint32_t          high_water;      ///< Deepest backlog seen by the dispatcher
+    pdm_work_item_t   items[PDM_WORK_LANE_DEPTH];
+} pdm_work_lane_t;
+
+/** Deferred work instance */
+typedef struct st_pdm_work_ctrl
+{
+    pdm_work_lane_t    lanes[PDM_WORK_LANES];
+    pdm_work_handler_t handlers[PDM_WORK_TYPES];
+    void             * p_contexts[PDM_WORK_TYPES];
+    uint32_t           unhandled;      ///< Items dispatched with no handler registered
+} pdm_work_ctrl_t;
+
+/** Per-lane counters */
+typedef struct st_pdm_work_stats
+{
+    uint32_t posted;
+    uint32_t dispatched;
+    uint32_t dropped;
+    uint32_t high_water;
+} pdm_work_stats_t;
+
+/** Cost of the queue operations, in pdm_port_cycles() units */
+typedef struct st_pdm_work_bench
+{
+    uint32_t post_min;
+    uint32_t post_max;
+    uint32_t post_mean;
+    uint32_t dispatch_mean;            ///< Per item, empty handler included
+} pdm_work_bench_t;
+
+FSP_HEADER
+
+/***********************************************************************************************************************
+ * Function Declarations
+ **********************************************************************************************************************/
+
+/**
+ * @brief Reset all lanes and clear the handler table
+ * @param[out] p_ctrl  Instance
+ * @retval FSP_SUCCESS        Ready
+ * @retval FSP_ERR_ASSERTION  p_ctrl is NULL
+ */
+fsp_err_t pdm_work_open(pdm_work_ctrl_t * p_ctrl);
+
+/**
+ * @brief Register the handler for one item type (foreground, before posting starts)
+ * @param[in,out] p_ctrl     Instance
+ * @param[in]     type       Item type
+ * @param[in]     handler    Handler, NULL to unregister
+ * @param[in]     p_context  Passed to handler
+ * @retval FSP_SUCCESS               Registered
+ * @retval FSP_ERR_INVALID_ARGUMENT  type out of range
+ */
+fsp_err_t pdm_work_handler_set(pdm_work_ctrl_t * p_ctrl, uint32_t type, pdm_work_handler_t handler,
+                               void * p_context);
+
+/**
+ * @brief Run queued items, highest priority lane first, until every lane is empty
+ * @param[in,out] p_ctrl  Instance
+ * @return Number of items run
+ */
+uint32_t pdm_work_dispatch(pdm_work_ctrl_t * p_ctrl);
+
+/**
+ * @brief Check whether any lane holds work
+ * @param[in] p_ctrl  Instance
+ * @return true if pdm_work_dispatch() has something to do
+ */
+bool pdm_work_pending(pdm_work_ctrl_t const * p_ctrl);
+
+/**
+ * @brief Snapshot the counters of one lane
+ * @param[in]  p_ctrl   Instance
+ * @param[in]  lane     Lane index
+ * @param[out] p_stats  Counters
+ */
+void pdm_work_stats_get(pdm_work_ctrl_t const * p_ctrl, uint32_t lane, pdm_work_stats_t * p_stats);
+
+/**
+ * @brief Measure post and dispatch cost on a private instance
+ * @param[out] p_bench     Results
+ * @param[in]  iterations  Items to post and dispatch
+ */
+void pdm_work_benchmark(pdm_work_bench_t * p_bench, uint32_t iterations);
+
+/***********************************************************************************************************************
+ * Inline Utility Functions
+ **********************************************************************************************************************/
+
+/**
+ * @brief Queue one item (interrupt safe, one producer per lane)
+ * @param[in,out] p_ctrl  Instance
+ * @param[in]     lane    Lane owned by the caller
+ * @param[in]     type    Item type
+ * @param[in]     arg     Item argument
+ * @retval FSP_SUCCESS         Queued
+ * @retval FSP_ERR_QUEUE_FULL  Lane full, item dropped and counted
+ */
+static inline fsp_err_t pdm_work_post(pdm_work_ctrl_t * p_ctrl, uint32_t lane, uint32_t type, uint32_t arg)
+{
+    pdm_work_lane_t * p_lane = &p_ctrl->lanes[lane];
+    uint32_t          head   = p_lane->head;
+
+    if ((head - p_lane->tail) >= PDM_WORK_LANE_DEPTH)
+    {
+        p_lane->dropped = p_lane->dropped + 1U;
+
+        return FSP_ERR_QUEUE_FULL;
+    }
+
+    pdm_work_item_t * p_item = &p_lane->items[head & (PDM_WORK_LANE_DEPTH - 1U)];
+    p_item->type     = (uint16_t) type;
+    p_item->lane     = (uint16_t) lane;
+    p_item->arg      = arg;
+    p_item->sequence = head + p_lane->dropped;
+    p_item->cycles   = pdm_port_cycles();
+
+    /* Item must be complete before it is published */
+    pdm_port_memory_barrier();
+    p_lane->head = head + 1U;
+
+    return FSP_SUCCESS;
+}
+
+FSP_FOOTER
+
+#endif /* PDM_WORK_H */
@@ -0,0 +1,283 @@
+/**
+ * @file pdm_bench_host.c
+ * @brief Host runner of the audio kernel benchmark suite (src/pdm_bench.c)
+ * @details Prints the suite's CSV report on stdout. With -c the report is also compared against an earlier one
+ *          (for example from the last release) and every case that got slower by more than the tolerance is listed
+ *          on stderr; the exit status is then 1, so the check can gate a build.
+ *
+ *          Usage: pdm_bench [-k kernel] [-s signal] [-b min] [-B max] [-t min_time_us] [-r repeats]
+ *                           [-p platform] [-c baseline.csv] [-x tolerance_percent] [-l]
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_BENCH_HOST_MAX_BASELINE    (4096U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** One case of a report: kernel,signal,block,align identify it */
+typedef struct st_pdm_bench_host_case
+{
+    char     kernel[32];
+    char     signal[32];
+    unsigned block;
+    unsigned align;
+    double   ns_per_sample;
+} pdm_bench_host_case_t;
+
+typedef struct st_pdm_bench_host
+{
+    pdm_bench_host_case_t * p_baseline;
+    uint32_t                baseline_count;
+    double                  tolerance;
+    uint32_t                compared;
+    uint32_t                regressions;
+} pdm_bench_host_t;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Parse a report line; false for comments, the header and malformed lines */
+static bool pdm_bench_host_parse(char const * p_line, pdm_bench_host_case_t * p_case)
+{
+    char     platform[32];
+    unsigned iterations;
+    double   ticks;
+
+    if ('#' == p_line[0])
+    {
+        return false;
+    }
+
+    return 8 == sscanf(p_line, "%31[^,],%31[^,],%31[^,],%u,%u,%u,%lf,%lf", platform, p_case->kernel, p_case->signal,
+                       &p_case->block, &p_case->align, &iterations, &ticks, &p_case->ns_per_sample);
+}
+
+static void pdm_bench_host_output(char const * p_line, void * p_context)
+{
+    pdm_bench_host_t    * p_host = (pdm_bench_host_t *) p_context;
+    pdm_bench_host_case_t current;
+
+    fputs(p_line, stdout);
+
+    if ((0U == p_host->baseline_count) || !pdm_bench_host_parse(p_line, &current))
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < p_host->baseline_count; i++)
+    {
+        pdm_bench_host_case_t const * p_base = &p_host->p_baseline[i];
+
+        if ((0 != strcmp(p_base->kernel, current.kernel)) || (0 != strcmp(p_base->signal, current.signal)) ||
+            (p_base->block != current.block) || (p_base->align != current.align))
+        {
+            continue;
+        }
+
+        p_host->compared++;
+
+        if (current.ns_per_sample > (p_base->ns_per_sample * (1.0 + p_host->tolerance / 100.0)))
+        {
+            p_host->regressions++;
+            fprintf(stderr, "REGRESSION %s,%s,%u,%u: %.3f -> %.3f ns/sample (%+.1f%%)\n", current.kernel,
+                    current.signal, current.block, current.align, p_base->ns_per_sample, current.ns_per_sample,
+                    100.0 * (current.ns_per_sample / p_base->ns_per_sample - 1.0));
+        }
+
+        break;
+    }
+}
+
+static int pdm_bench_host_load(pdm_bench_host_t * p_host, char const * p_path)
+{
+    FILE * p_file = fopen(p_path, "r");
+    char   line[PDM_BENCH_LINE_MAX];
+
+    if (NULL == p_file)
+    {
+        perror(p_path);
+
+        return -1;
+    }
+
+    p_host->p_baseline = calloc(PDM_BENCH_HOST_MAX_BASELINE, sizeof(pdm_bench_host_case_t));
+    if (NULL == p_host->p_baseline)
+    {
+        fclose(p_file);
+
+        return -1;
+    }
+
+    while ((NULL != fgets(line, sizeof(line), p_file)) && (p_host->baseline_count < PDM_BENCH_HOST_MAX_BASELINE))
+    {
+        if (pdm_bench_host_parse(line, &p_host->p_baseline[p_host->baseline_count]))
+        {
+            p_host->baseline_count++;
+        }
+    }
+
+    fclose(p_file);
+
+    return 0;
+}
+
+static void pdm_bench_host_usage(char const * p_name)
+{
+    fprintf(stderr,
+            "usage: %s [-k kernel] [-s signal] [-b min_block] [-B max_block] [-t min_time_us] [-r repeats]\n"
+            "          [-p platform] [-c baseline.csv] [-x tolerance_percent] [-l]\n",
+            p_name);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    pdm_bench_host_t host   = {.tolerance = 10.0};
+    char const     * p_base = NULL;
+    pdm_bench_cfg_t  cfg    =
+    {
+        .p_platform  = "host",
+        .p_kernel    = NULL,
+        .p_signal    = NULL,
+        .block_min   = PDM_BENCH_MIN_BLOCK,
+        .block_max   = PDM_BENCH_MAX_BLOCK,
+        .min_time_us = 2000U,
+        .repeats     = 5U,
+        .p_output    = pdm_bench_host_output,
+        .p_context   = &host,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        char const * p_value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+
+        if (0 == strcmp(argv[i], "-l"))
+        {
+            for (uint32_t k = 0; NULL != pdm_bench_kernel_name(k); k++)
+            {
+                printf("kernel %s\n", pdm_bench_kernel_name(k));
+            }
+
+            for (uint32_t s = 0; NULL != pdm_bench_signal_name(s); s++)
+            {
+                printf("signal %s\n", pdm_bench_signal_name(s));
+            }
+
+            return 0;
+        }
+
+        if ((NULL == p_value) || ('-' != argv[i][0]) || ('\0' == argv[i][1]) || ('\0' != argv[i][2]))
+        {
+            pdm_bench_host_usage(argv[0]);
+
+            return 2;
+        }
+
+        switch (argv[i][1])
+        {
+            case 'k':
+            {
+                cfg.p_kernel = p_value;
+                break;
+            }
+
+            case 's':
+            {
+                cfg.p_signal = p_value;
+                break;
+            }
+
+            case 'b':
+            {
+                cfg.block_min = (uint32_t) strtoul(p_value, NULL, 0);
+                break;
+            }
+
+            case 'B':
+            {
+                cfg.block_max = (uint32_t) strtoul(p_value, NULL, 0);
+                break;
+            }
+
+            case 't':
+            {
+                cfg.min_time_us = (uint32_t) strtoul(p_value, NULL, 0);
+                break;
+            }
+
+            case 'r':
+            {
+                cfg.repeats = (uint32_t) strtoul(p_value, NULL, 0);
+                break;
+            }
+
+            case 'p':
+            {
+                cfg.p_platform = p_value;
+                break;
+            }
+
+            case 'c':
+            {
+                p_base = p_value;
+                break;
+            }
+
+            case 'x':
+            {
+                host.tolerance = strtod(p_value, NULL);
+                break;
+            }
+
+            default:
+            {
+                pdm_bench_host_usage(argv[0]);
+
+                return 2;
+            }
+        }
+
+        i++;
+    }
+
+    if ((NULL != p_base) && (0 != pdm_bench_host_load(&host, p_base)))
+    {
+        return 2;
+    }
+
+    fsp_err_t err = pdm_bench_run(&cfg);
+    if (FSP_SUCCESS != err)
+    {
+        fprintf(stderr, "pdm_bench: invalid selection (error %d), see -l and the block range %u..%u\n", (int) err,
+                (unsigned) PDM_BENCH_MIN_BLOCK, (unsigned) PDM_BENCH_MAX_BLOCK);
+
+        return 2;
+    }
+
+    if (NULL != p_base)
+    {
+        fprintf(stderr, "pdm_bench: %u cases compared, %u slower than baseline by more than %.1f%%\n",
+                (unsigned) host.compared, (unsigned) host.regressions, host.tolerance);
+    }
+
+    free(host.p_baseline);
+
+    return (0U != host.regressions) ? 1 : 0;
+}
@@ -0,0 +1,644 @@
+/**
+ * @file pdm_coefgen.cpp
+ * @brief Host designer of PDM filter sets: emits a pdm_extended_cfg_t header for a target rate and filter spec
+ * @details Replaces the configurator's fixed tables in ra_gen/hal_data.c when the passband or the HPF cutoff has to
+ *          move. For a PDM clock, a target PCM rate and a sinc order it
+ *          1. picks sincdec (PDM clock / (2 * rate), the half-band LPF decimates by 2) and sincrng (pdm_model.hpp)
+ *          2. designs the 39-tap half-band LPF with a Kaiser window whose beta follows from the transition band left
+ *             between the passband edge and the band that aliases onto it
+ *          3. designs the 11-tap compensation FIR by weighted least squares against the inverse of the sinc droop and
+ *             the LPF's own passband roll-off, up to the passband edge
+ *          4. sets the HPF to a first-order high-pass with the requested -3 dB frequency (bilinear transform)
+ *          5. quantizes everything to the register formats, with the DC gain of both FIRs restored exactly
+ *          6. checks the result: passband ripple, alias rejection and HPF corner from the quantized response, and
+ *             test tones through the fixed-point model (tools/pdm_model.hpp) against that response
+ *
+ *          The report goes to stderr; the exit status is 1 when a check fails, 2 on a usage error. The header is
+ *          written to stdout or to the -o file. Its clock divider, detection and threshold settings are those of
+ *          g_pdm0_cfg_extend, so the set can also be handed to pdm_filter_stage() (src/pdm_filter.h) at run time.
+ *
+ *          Usage: pdm_coefgen [-c pdm_clock_hz] [-r rate_hz] [-N sinc_order] [-p passband_hz] [-H hpf_hz]
+ *                             [-n name] [-o file]
+ *
+ *          Example: pdm_coefgen -r 16000 -p 7000 -H 80 -n voice -o ../src/pdm_coef_voice.h
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_model.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/* Least-squares grid of the compensation design, points over 0..pi at the sinc rate */
+#define PDM_COEFGEN_GRID            (2048U)
+
+/* Weights of the compensation's gain above the aliasing edge, tried in turn: a larger one keeps the taps small
+ * (that band only costs headroom, the LPF removes it), a smaller one flattens the passband */
+static double const g_pdm_coefgen_stop_weights[] = {1e-2, 3e-3, 1e-3, 3e-4, 1e-4, 3e-5, 1e-5};
+
+/* Test tone amplitude (relative to +-1 PDM) and length */
+#define PDM_COEFGEN_TONE_AMPLITUDE  (0.5)
+#define PDM_COEFGEN_TONE_SAMPLES    (4096U)
+
+/* Largest tolerated difference between the simulated and the analytic tone gain */
+#define PDM_COEFGEN_TONE_TOLERANCE_DB (0.2)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+namespace
+{
+
+/** Design inputs */
+struct pdm_coefgen_spec
+{
+    double      pdm_clock_hz = 4000000.0;
+    double      rate_hz      = 32258.0;
+    unsigned    sinc_order   = 4U;
+    double      passband_hz  = 0.0;            ///< 0: 40 % of the rate
+    double      hpf_hz       = 100.0;          ///< 0: HPF bypassed
+    std::string name         = "custom";
+};
+
+/** Quantized response figures */
+struct pdm_coefgen_report
+{
+    double rate_hz        = 0.0;
+    double ripple_db      = 0.0;
+    double rejection_db   = 0.0;
+    double hpf_corner_hz  = 0.0;
+    double kaiser_beta    = 0.0;
+    double tone_error_db  = 0.0;
+    double peak_fraction  = 0.0;               ///< Largest FIR output for a full-scale input, of the 20-bit range
+    unsigned settling     = 0U;
+    uint64_t saturations  = 0U;
+};
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Zeroth-order modified Bessel function of the first kind, for the Kaiser window */
+double pdm_coefgen_bessel_i0(double x)
+{
+    double sum  = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum  += term;
+        if (term < (sum * 1e-12))
+        {
+            break;
+        }
+    }
+
+    return sum;
+}
+
+/* Compensation FIR: symmetric, h[5] the centre. Target 1 / (sinc droop * LPF) over 0..wp, near zero above ws. */
+bool pdm_coefgen_compensation(pdm_coefgen_spec const & spec, unsigned sincdec, double wp, double ws,
+                              double stop_weight, std::array<double, pdm_model::lpf_taps> const & lpf,
+                              std::array<double, pdm_model::comp_taps> & h)
+{
+    constexpr size_t half = (pdm_model::comp_taps - 1U) / 2U;
+    std::vector<std::vector<double>> a(half + 1U, std::vector<double>(half + 1U, 0.0));
+    std::vector<double>              b(half + 1U, 0.0);
+    double                           fs_sinc = spec.pdm_clock_hz / sincdec;
+
+    for (unsigned g = 0U; g <= PDM_COEFGEN_GRID; g++)
+    {
+        double w = pdm_model::pi * g / PDM_COEFGEN_GRID;
+        double weight;
+        double target;
+
+        if (w <= wp)
+        {
+            std::complex<double> l = 0.0;
+            for (size_t n = 0U; n < lpf.size(); n++)
+            {
+                l += lpf[n] * std::polar(1.0, -w * (double) n);
+            }
+
+            weight = 1.0;
+            target = 1.0 / (pdm_model::sinc_gain(spec.sinc_order, sincdec, w * fs_sinc / (2.0 * pdm_model::pi),
+                                                 spec.pdm_clock_hz) * std::abs(l));
+        }
+        else if (w >= ws)
+        {
+            weight = stop_weight;
+            target = 0.0;
+        }
+        else
+        {
+            continue;
+        }
+
+        double basis[half + 1U];
+        basis[0] = 1.0;
+        for (size_t k = 1U; k <= half; k++)
+        {
+            basis[k] = 2.0 * std::cos(w * (double) k);
+        }
+
+        for (size_t i = 0U; i <= half; i++)
+        {
+            for (size_t j = 0U; j <= half; j++)
+            {
+                a[i][j] += weight * basis[i] * basis[j];
+            }
+
+            b[i] += weight * basis[i] * target;
+        }
+    }
+
+    if (!pdm_model::solve(a, b))
+    {
+        return false;
+    }
+
+    h[half] = b[0];
+    for (size_t k = 1U; k <= half; k++)
+    {
+        h[half - k] = b[k];
+        h[half + k] = b[k];
+    }
+
+    return true;
+}
+
+/* Half-band LPF: Kaiser-windowed ideal half-band; the window is as narrow as the transition band allows */
+void pdm_coefgen_lpf(double transition, std::array<double, pdm_model::lpf_taps> & h, double & beta)
+{
+    constexpr int centre = (int) pdm_model::lpf_h1 - 1;
+
+    /* Kaiser's estimate inverted for the fixed length: attenuation reachable with this transition width */
+    double attenuation = (14.36 * (pdm_model::lpf_taps - 1U) * transition) + 7.95;
+    if (attenuation > 50.0)
+    {
+        beta = 0.1102 * (attenuation - 8.7);
+    }
+    else if (attenuation > 21.0)
+    {
+        beta = (0.5842 * std::pow(attenuation - 21.0, 0.4)) + (0.07886 * (attenuation - 21.0));
+    }
+    else
+    {
+        beta = 0.0;
+    }
+
+    double norm = pdm_coefgen_bessel_i0(beta);
+    for (int n = -centre; n <= centre; n++)
+    {
+        double r      = (double) n / centre;
+        double window = pdm_coefgen_bessel_i0(beta * std::sqrt(1.0 - (r * r))) / norm;
+        double ideal  = (0 == n) ? 0.5 : std::sin(pdm_model::pi * n / 2.0) / (pdm_model::pi * n);
+
+        h[(size_t) (n + centre)] = ideal * window;
+    }
+}
+
+/* Round to Q11 and fix the centre tap(s) so the DC gain stays exactly 1 */
+bool pdm_coefgen_quantize(pdm_coefgen_spec const & spec, unsigned sincdec,
+                          std::array<double, pdm_model::comp_taps> const & comp,
+                          std::array<double, pdm_model::lpf_taps> const & lpf, pdm_model::filters & f)
+{
+    constexpr int32_t one = 1 << pdm_model::fir_q;
+
+    f.sinc_order = spec.sinc_order;
+    f.sincdec    = sincdec;
+    f.sincrng    = pdm_model::sincrng_for(spec.sinc_order, sincdec);
+
+    std::array<int32_t, pdm_model::comp_taps> c;
+    int32_t                                   sum = 0;
+    for (size_t k = 0U; k < c.size(); k++)
+    {
+        c[k] = (int32_t) std::lround(comp[k] * one);
+        sum += c[k];
+    }
+
+    c[c.size() / 2U] += one - sum;
+
+    for (size_t k = 0U; k < c.size(); k++)
+    {
+        if (!pdm_model::reg13_put(c[k], f.comp[k]))
+        {
+            return false;
+        }
+    }
+
+    /* h1 holds the odd taps; the two innermost carry the DC correction */
+    std::array<int32_t, pdm_model::lpf_h1> h1;
+    int32_t                                half_sum = 0;
+    for (size_t i = 0U; i < h1.size(); i++)
+    {
+        h1[i] = (int32_t) std::lround(lpf[2U * i] * one);
+        half_sum += (i < (h1.size() / 2U)) ? h1[i] : 0;
+    }
+
+    int32_t correction = (one / 4) - half_sum;
+    h1[(h1.size() / 2U) - 1U] += correction;
+    h1[h1.size() / 2U]        += correction;
+
+    for (size_t i = 0U; i < h1.size(); i++)
+    {
+        if (!pdm_model::reg13_put(h1[i], f.lpf[i]))
+        {
+            return false;
+        }
+    }
+
+    return pdm_model::reg13_put(one / 2, f.lpf_h0);
+}
+
+/* First-order HPF, -3 dB at hpf_hz: k1 = (1 - tan(wc / 2)) / (1 + tan(wc / 2)), s0 = (1 + k1) / 2, h = {1, -1} */
+bool pdm_coefgen_hpf(double hpf_hz, double rate_hz, pdm_model::filters & f)
+{
+    constexpr double one = (double) (1 << pdm_model::hpf_q);
+
+    if (hpf_hz <= 0.0)
+    {
+        f.hpf_s0 = (uint16_t) one;
+        f.hpf_k1 = 0U;
+        f.hpf_h  = {{(uint16_t) one, 0U}};
+
+        return true;
+    }
+
+    double t  = std::tan(pdm_model::pi * hpf_hz / rate_hz);
+    double k1 = (1.0 - t) / (1.0 + t);
+
+    f.hpf_h = {{(uint16_t) one, (uint16_t) (int16_t) -one}};
+
+    return pdm_model::reg16_put((int32_t) std::lround(k1 * one), f.hpf_k1) &&
+           pdm_model::reg16_put((int32_t) std::lround(((1.0 + k1) / 2.0) * one), f.hpf_s0);
+}
+
+/* Passband ripple of the quantized set, HPF left out */
+double pdm_coefgen_ripple(pdm_model::filters const & f, double passband_hz, double fs)
+{
+    pdm_model::filters flat = f;
+    flat.hpf_s0 = 0x4000U;
+    flat.hpf_k1 = 0U;
+    flat.hpf_h  = {{0x4000U, 0U}};
+
+    double lo = 1e9;
+    double hi = 0.0;
+    for (unsigned i = 0U; i <= 512U; i++)
+    {
+        double g = pdm_model::chain_gain(flat, passband_hz * i / 512.0, fs);
+        lo       = std::min(lo, g);
+        hi       = std::max(hi, g);
+    }
+
+    return 20.0 * std::log10(hi / lo);
+}
+
+/* Quantized response figures and the fixed-point tone check */
+void pdm_coefgen_check(pdm_coefgen_spec const & spec, pdm_model::filters const & f, double passband_hz,
+                       pdm_coefgen_report & report)
+{
+    double fs   = spec.pdm_clock_hz;
+    double rate = report.rate_hz;
+
+    report.ripple_db = pdm_coefgen_ripple(f, passband_hz, fs);
+
+    /* Input frequencies that fold onto the passband at the 2:1 decimation */
+    double alias = 0.0;
+    for (unsigned i = 0U; i <= 512U; i++)
+    {
+        double f_hz = (rate - passband_hz) + (passband_hz * i / 512.0);
+        double fs_sinc = fs / f.sincdec;
+        double w = 2.0 * pdm_model::pi * f_hz / fs_sinc;
+        double g = pdm_model::sinc_gain(f.sinc_order, f.sincdec, f_hz, fs) * std::abs(pdm_model::comp_response(f, w)) *
+                   std::abs(pdm_model::lpf_response(f, w));
+        alias = std::max(alias, g);
+    }
+
+    report.rejection_db = -20.0 * std::log10(alias);
+
+    /* HPF corner: bisect the -3 dB point of the quantized section */
+    report.hpf_corner_hz = 0.0;
+    if (0U != f.hpf_k1)
+    {
+        double a = 0.01;
+        double b = rate / 4.0;
+        for (int i = 0; i < 60; i++)
+        {
+            double m = 0.5 * (a + b);
+            double g = std::abs(pdm_model::hpf_response(f, 2.0 * pdm_model::pi * m / rate));
+            ((g < std::sqrt(0.5)) ? a : b) = m;
+        }
+
+        report.hpf_corner_hz = 0.5 * (a + b);
+    }
+
+    /* Worst-case FIR outputs for a full-scale sinc output */
+    double comp_peak = 0.0;
+    for (uint16_t c : f.comp)
+    {
+        comp_peak += std::fabs((double) pdm_model::reg13(c));
+    }
+
+    double lpf_peak = 0.0;
+    for (int32_t c : pdm_model::lpf_impulse(f))
+    {
+        lpf_peak += std::fabs((double) c);
+    }
+
+    comp_peak /= (1 << pdm_model::fir_q);
+    lpf_peak /= (1 << pdm_model::fir_q);
+    report.peak_fraction = (pdm_model::scale(f) * comp_peak * lpf_peak) / (double) (1 << (pdm_model::pcm_bits - 1));
+
+    /* Tones through the fixed-point chain against the analytic response */
+    double const tones[] = {1000.0, passband_hz / 2.0, passband_hz * 0.9};
+    report.tone_error_db = 0.0;
+    report.saturations   = 0U;
+    for (double tone : tones)
+    {
+        size_t               settle = 64U;
+        size_t               bits   = (PDM_COEFGEN_TONE_SAMPLES + settle) * 2U * f.sincdec;
+        pdm_model::chain     chain(f);
+        std::vector<int32_t> pcm = chain.run(pdm_model::modulate_sine(PDM_COEFGEN_TONE_AMPLITUDE, tone, fs, bits));
+
+        double measured = pdm_model::fit_sine(pcm, settle, tone, rate);
+        double expected = PDM_COEFGEN_TONE_AMPLITUDE * pdm_model::scale(f) * pdm_model::chain_gain(f, tone, fs);
+        double error    = std::fabs(20.0 * std::log10(measured / expected));
+
+        report.tone_error_db = std::max(report.tone_error_db, error);
+        report.saturations  += chain.saturations();
+    }
+
+    report.settling = (f.sinc_order + (pdm_model::comp_taps - 1U) + (pdm_model::lpf_taps - 1U) + 1U) / 2U;
+}
+
+/* C identifier parts of the set name */
+std::string pdm_coefgen_ident(std::string const & name, bool upper)
+{
+    std::string out;
+    for (char c : name)
+    {
+        unsigned char u = (unsigned char) c;
+        out += (std::isalnum(u) != 0) ? (char) (upper ? std::toupper(u) : std::tolower(u)) : '_';
+    }
+
+    return out;
+}
+
+void pdm_coefgen_emit(FILE * p_out, pdm_coefgen_spec const & spec, pdm_model::filters const & f,
+                      double passband_hz, pdm_coefgen_report const & report, std::string const & command)
+{
+    std::string lower = pdm_coefgen_ident(spec.name, false);
+    std::string upper = pdm_coefgen_ident(spec.name, true);
+
+    fprintf(p_out, "/**\n");
+    fprintf(p_out, " * @file pdm_coef_%s.h\n", lower.c_str());
+    fprintf(p_out, " * @brief PDM filter set \"%s\", generated by tools/pdm_coefgen - do not edit\n", spec.name.c_str());
+    fprintf(p_out, " * @details %s\n", command.c_str());
+    fprintf(p_out, " *          PDM clock %.0f Hz, sinc order %u, sincdec %u, sincrng %u: %.2f Hz PCM\n",
+            spec.pdm_clock_hz, f.sinc_order, f.sincdec, f.sincrng, report.rate_hz);
+    fprintf(p_out, " *          Passband 0..%.0f Hz, ripple %.3f dB; alias rejection %.1f dB; HPF -3 dB at %.1f Hz\n",
+            passband_hz, report.ripple_db, report.rejection_db, report.hpf_corner_hz);
+    fprintf(p_out, " *          Use in place of g_pdm0_cfg_extend, or stage at run time with pdm_filter_stage().\n");
+    fprintf(p_out, " */\n\n");
+    fprintf(p_out, "#ifndef PDM_COEF_%s_H\n#define PDM_COEF_%s_H\n\n", upper.c_str(), upper.c_str());
+    fprintf(p_out, "#include \"hal_data.h\"\n\n");
+    fprintf(p_out, "#define PDM_COEF_%s_SAMPLE_RATE_HZ       (%luU)\n", upper.c_str(),
+            (unsigned long) std::lround(report.rate_hz));
+    fprintf(p_out, "#define PDM_COEF_%s_SETTLING_SAMPLES     (%uU)\n", upper.c_str(), report.settling);
+    fprintf(p_out, "#define PDM_COEF_%s_SETTLING_TIME_US     (%luU)\n\n", upper.c_str(),
+            (unsigned long) std::ceil(report.settling * 1e6 / report.rate_hz));
+
+    fprintf(p_out, "static const pdm_extended_cfg_t g_pdm_coef_%s =\n", lower.c_str());
+    fprintf(p_out, "{ .clock_div = PDM_CLOCK_DIV_4,\n\n");
+    fprintf(p_out, "  /** Function Settings. */\n");
+    fprintf(p_out, "  .short_circuit_detection_enable = PDM_SHORT_CIRCUIT_DISABLED,\n");
+    fprintf(p_out, "  .over_voltage_lower_limit_detection_enable = PDM_OVERVOLTAGE_LOWER_LIMIT_DISABLED,\n");
+    fprintf(p_out, "  .over_voltage_upper_limit_detection_enable = PDM_OVERVOLTAGE_UPPER_LIMIT_DISABLED,\n");
+    fprintf(p_out, "  .buffer_overwrite_detection_enable = PDM_BUFFER_OVERWRITE_DETECTION_ENABLED,\n\n");
+    fprintf(p_out, "  /** Filter Settings. */\n");
+    fprintf(p_out, "  .moving_average_mode = PDM_MOVING_AVERAGE_MODE_1_ORDER,\n");
+    fprintf(p_out, "  .low_pass_filter_shift = PDM_LPF_RIGHT_SHIFT_%u,\n", f.lpf_shift);
+    fprintf(p_out, "  .compensation_filter_shift = PDM_COMPENSATION_FILTER_RIGHT_SHIFT_%u,\n", f.comp_shift);
+    fprintf(p_out, "  .high_pass_filter_shift = PDM_HPF_RIGHT_SHIFT_%u,\n", f.hpf_shift);
+    fprintf(p_out, "  .sinc_filter_mode = PDM_SINC_FILTER_MODE_%u,\n", f.sinc_order);
+    fprintf(p_out, "  .sincrng = %u,\n", f.sincrng);
+    fprintf(p_out, "  .sincdec = %u,\n", f.sincdec);
+    fprintf(p_out, "  .hpf_coefficient_s0 = 0x%04X,\n", f.hpf_s0);
+    fprintf(p_out, "  .hpf_coefficient_k1 = 0x%04X,\n", f.hpf_k1);
+    fprintf(p_out, "  .hpf_coefficient_h =\n  { 0x%04X, 0x%04X },\n", f.hpf_h[0], f.hpf_h[1]);
+    fprintf(p_out, "  .compensation_filter_coefficient_h =\n  {");
+    for (size_t k = 0U; k < f.comp.size(); k++)
+    {
+        fprintf(p_out, "%s 0x%04X", (0U == k) ? "" : ",", f.comp[k]);
+    }
+
+    fprintf(p_out, " },\n");
+    fprintf(p_out, "  .lpf_coefficient_h0 = 0x%04X,\n", f.lpf_h0);
+    fprintf(p_out, "  .lpf_coefficient_h1 =\n  {");
+    for (size_t i = 0U; i < f.lpf.size(); i++)
+    {
+        fprintf(p_out, "%s 0x%04X", (0U == i) ? "" : ",\n   ", f.lpf[i]);
+    }
+
+    fprintf(p_out, " },\n\n");
+    fprintf(p_out, "  /** Data Threshold. */\n");
+    fprintf(p_out, "  .interrupt_threshold = PDM_INTERRUPT_THRESHOLD_16,\n\n");
+    fprintf(p_out, "  /** Short-Circuit Detection. */\n");
+    fprintf(p_out, "  .short_circuit_count_h = 0,\n");
+    fprintf(p_out, "  .short_circuit_count_l = 0,\n\n");
+    fprintf(p_out, "  /** Overvoltage Detection. */\n");
+    fprintf(p_out, "  .overvoltage_detection_lower_limit = 0x00000,\n");
+    fprintf(p_out, "  .overvoltage_detection_upper_limit = 0x00000, };\n\n");
+    fprintf(p_out, "#endif /* PDM_COEF_%s_H */\n", upper.c_str());
+}
+
+void pdm_coefgen_usage(char const * p_name)
+{
+    fprintf(stderr,
+            "usage: %s [-c pdm_clock_hz] [-r rate_hz] [-N sinc_order] [-p passband_hz] [-H hpf_hz (0: off)]\n"
+            "          [-n name] [-o file]\n",
+            p_name);
+}
+
+} // namespace
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    pdm_coefgen_spec spec;
+    char const     * p_path  = NULL;
+    std::string      command = "Command line: pdm_coefgen";
+
+    for (int i = 1; i < argc; i++)
+    {
+        char const * p_value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+
+        if ((NULL == p_value) || ('-' != argv[i][0]) || ('\0' == argv[i][1]) || ('\0' != argv[i][2]))
+        {
+            pdm_coefgen_usage(argv[0]);
+
+            return 2;
+        }
+
+        command += std::string(" ") + argv[i] + " " + p_value;
+
+        switch (argv[i][1])
+        {
+            case 'c':
+            {
+                spec.pdm_clock_hz = strtod(p_value, NULL);
+                break;
+            }
+
+            case 'r':
+            {
+                spec.rate_hz = strtod(p_value, NULL);
+                break;
+            }
+
+            case 'N':
+            {
+                spec.sinc_order = (unsigned) strtoul(p_value, NULL, 0);
+                break;
+            }
+
+            case 'p':
+            {
+                spec.passband_hz = strtod(p_value, NULL);
+                break;
+            }
+
+            case 'H':
+            {
+                spec.hpf_hz = strtod(p_value, NULL);
+                break;
+            }
+
+            case 'n':
+            {
+                spec.name = p_value;
+                break;
+            }
+
+            case 'o':
+            {
+                p_path = p_value;
+                break;
+            }
+
+            default:
+            {
+                pdm_coefgen_usage(argv[0]);
+
+                return 2;
+            }
+        }
+
+        i++;
+    }
+
+    long sincdec = std::lround(spec.pdm_clock_hz / (2.0 * spec.rate_hz));
+    if ((spec.sinc_order < 1U) || (spec.sinc_order > 4U) || (sincdec < 1) || (sincdec > 255))
+    {
+        fprintf(stderr, "sinc order must be 1..4 and PDM clock / (2 * rate) 1..255 (is %ld)\n", sincdec);
+
+        return 2;
+    }
+
+    pdm_coefgen_report report;
+    report.rate_hz = spec.pdm_clock_hz / (2.0 * (double) sincdec);
+
+    double passband_hz = (spec.passband_hz > 0.0) ? spec.passband_hz : 0.4 * report.rate_hz;
+    if ((passband_hz >= (report.rate_hz / 2.0)) || (spec.hpf_hz >= passband_hz))
+    {
+        fprintf(stderr, "passband edge must lie between the HPF corner and %.0f Hz\n", report.rate_hz / 2.0);
+
+        return 2;
+    }
+
+    /* At the sinc rate: passband edge and the first frequency that aliases onto it after the 2:1 decimation */
+    double fs_sinc = spec.pdm_clock_hz / (double) sincdec;
+    double wp      = 2.0 * pdm_model::pi * passband_hz / fs_sinc;
+    double ws      = 2.0 * pdm_model::pi * (report.rate_hz - passband_hz) / fs_sinc;
+
+    std::array<double, pdm_model::comp_taps> comp;
+    std::array<double, pdm_model::lpf_taps>  lpf;
+    pdm_model::filters                       f;
+    double                                   best_ripple = -1.0;
+
+    pdm_coefgen_lpf((ws - wp) / (2.0 * pdm_model::pi), lpf, report.kaiser_beta);
+
+    /* Flattest passband among the compensation designs that fit the 13-bit taps */
+    for (double weight : g_pdm_coefgen_stop_weights)
+    {
+        pdm_model::filters candidate;
+        if (!pdm_coefgen_compensation(spec, (unsigned) sincdec, wp, ws, weight, lpf, comp) ||
+            !pdm_coefgen_quantize(spec, (unsigned) sincdec, comp, lpf, candidate))
+        {
+            continue;
+        }
+
+        double ripple = pdm_coefgen_ripple(candidate, passband_hz, spec.pdm_clock_hz);
+        if ((best_ripple < 0.0) || (ripple < best_ripple))
+        {
+            best_ripple = ripple;
+            f           = candidate;
+        }
+    }
+
+    if ((best_ripple < 0.0) || !pdm_coefgen_hpf(spec.hpf_hz, report.rate_hz, f))
+    {
+        fprintf(stderr, "coefficients do not fit the register formats (passband too close to the sinc nulls?)\n");
+
+        return 1;
+    }
+
+    pdm_coefgen_check(spec, f, passband_hz, report);
+
+    fprintf(stderr, "rate         %.2f Hz (sincdec %u, sincrng %u, order %u)\n", report.rate_hz, f.sincdec, f.sincrng,
+            f.sinc_order);
+    fprintf(stderr, "passband     0..%.0f Hz, ripple %.3f dB\n", passband_hz, report.ripple_db);
+    fprintf(stderr, "alias        %.1f dB rejection (Kaiser beta %.2f)\n", report.rejection_db, report.kaiser_beta);
+    fprintf(stderr, "hpf          -3 dB at %.1f Hz\n", report.hpf_corner_hz);
+    fprintf(stderr, "headroom     FIR worst case %.1f %% of the 20-bit range\n", 100.0 * report.peak_fraction);
+    fprintf(stderr, "model        tone error %.3f dB, %llu saturations\n", report.tone_error_db,
+            (unsigned long long) report.saturations);
+    fprintf(stderr, "settling     %u samples\n", report.settling);
+
+    FILE * p_out = (NULL != p_path) ? fopen(p_path, "w") : stdout;
+    if (NULL == p_out)
+    {
+        perror(p_path);
+
+        return 1;
+    }
+
+    pdm_coefgen_emit(p_out, spec, f, passband_hz, report, command);
+    if (stdout != p_out)
+    {
+        fclose(p_out);
+    }
+
+    bool ok = (report.tone_error_db <= PDM_COEFGEN_TONE_TOLERANCE_DB) && (0U == report.saturations) &&
+              (report.peak_fraction < 1.0);
+    if (!ok)
+    {
+        fprintf(stderr, "check failed\n");
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,540 @@
+/**
+ * @file pdm_ctl.c
+ * @brief Host command line client of the RTT command protocol (src/pdm_cmd.h)
+ * @details Connects over TCP to a bridge of RTT channel PDM_CFG_CMD_RTT_CHANNEL (both directions), for example
+ *          OpenOCD `rtt server start 19023 3` or pyOCD's RTT server, sends each command of the command line in turn
+ *          and waits for its acknowledgement. Framing and checksums come from src/pdm_cmd.c, so the tool always
+ *          matches the firmware it was built with.
+ *
+ *          Usage: pdm_ctl [-H host] [-p port] [-t timeout_ms] [-n] command [args] [command [args] ...]
+ *            -n  print the request frames in hex instead of sending them
+ *
+ *          Commands:
+ *            ping | start | stop | stats | config
+ *            duration <ms>
+ *            sdet off | sdet on <upper> <lower>     (20-bit signed fixed point limits, decimal or 0x hex)
+ *            gain <dB>                              (software gain, -48..+48 dB)
+ *            format raw | pcm16
+ *            sinc <dec> <rng>                       (sinc decimation and range, swapped live while recording)
+ *            segment <id>                           (index entry of the first stored segment >= id)
+ *            index                                  (every stored index entry, one request each)
+ *            fetch <first> <last>                   (send segments first..last on the log channel)
+ *
+ *          With PDM_CFG_SEGMENT_ENABLE, read the index first and fetch only the segments of interest; their data
+ *          arrives on the log channel as "SEGMENT DATA <id> <start> <length>" blocks, decoded by pdm_logdec.
+ *
+ *          Example: pdm_ctl duration 5000 format pcm16 gain 6 start
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_cmd.h"
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_CTL_DEFAULT_HOST          "127.0.0.1"
+#define PDM_CTL_DEFAULT_PORT          "19023"
+#define PDM_CTL_DEFAULT_TIMEOUT_MS    (2000)
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static char const * const g_status_names[] =
+{
+    [PDM_CMD_STATUS_OK]      = "ok",
+    [PDM_CMD_STATUS_UNKNOWN] = "unknown command",
+    [PDM_CMD_STATUS_LENGTH]  = "bad length",
+    [PDM_CMD_STATUS_RANGE]   = "out of range",
+    [PDM_CMD_STATUS_BUSY]    = "busy",
+    [PDM_CMD_STATUS_FAILED]  = "failed",
+};
+
+static char const * const g_state_names[] =
+{
+    [PDM_CMD_STATE_IDLE]      = "idle",
+    [PDM_CMD_STATE_RECORDING] = "recording",
+    [PDM_CMD_STATE_DUMPING]   = "dumping",
+};
+
+/* Reply word names, in the order of pdm_cmd_stats_t and pdm_cmd_config_t */
+static char const * const g_stats_names[] =
+{
+    "state", "recordings", "elapsed_ms", "callbacks", "blocks", "errors", "overruns", "sound_detections", "samples",
+    "samples_lost", "first_valid_us",
+};
+
+static char const * const g_config_names[] =
+{
+    "duration_ms", "sound_detection", "sound_upper", "sound_lower", "gain_q8", "format", "sincdec", "sincrng",
+    "sample_rate_hz",
+};
+
+static char const * const g_segment_names[] =
+{
+    "id", "source", "start_low", "start_high", "length", "peak", "rms", "timestamp_low", "timestamp_high",
+};
+
+static char const * const g_ping_names[] =
+{
+    "version", "sample_rate_hz", "max_samples",
+};
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_ctl_usage(char const * p_name)
+{
+    fprintf(stderr,
+            "usage: %s [-H host] [-p port] [-t timeout_ms] [-n] command [args] ...\n"
+            "commands: ping | start | stop | stats | config | duration <ms> | sdet off | sdet on <upper> <lower>\n"
+            "          gain <dB> | format raw|pcm16 | sinc <dec> <rng> | segment <id> | index | fetch <first> <last>\n",
+            p_name);
+}
+
+static int pdm_ctl_connect(char const * p_host, char const * p_port)
+{
+    struct addrinfo   hints = {0};
+    struct addrinfo * p_list;
+
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int err = getaddrinfo(p_host, p_port, &hints, &p_list);
+    if (0 != err)
+    {
+        fprintf(stderr, "pdm_ctl: %s:%s: %s\n", p_host, p_port, gai_strerror(err));
+
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo * p = p_list; (NULL != p) && (fd < 0); p = p->ai_next)
+    {
+        fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if ((fd >= 0) && (0 != connect(fd, p->ai_addr, p->ai_addrlen)))
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    freeaddrinfo(p_list);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "pdm_ctl: cannot connect to %s:%s\n", p_host, p_port);
+    }
+
+    return fd;
+}
+
+/* Parse an unsigned 32-bit argument (decimal or 0x hex) */
+static bool pdm_ctl_u32(char const * p_text, uint32_t * p_value)
+{
+    char             * p_end;
+    unsigned long long value;
+
+    errno = 0;
+    value = strtoull(p_text, &p_end, 0);
+
+    if ((0 != errno) || ('\0' == *p_text) || ('\0' != *p_end) || (value > 0xFFFFFFFFULL))
+    {
+        return false;
+    }
+
+    *p_value = (uint32_t) value;
+
+    return true;
+}
+
+/*
+ * Build the request for argv[*p_index] and its arguments; advances *p_index past them.
+ * Returns false on a usage error.
+ */
+static bool pdm_ctl_build(int argc, char ** argv, int * p_index, pdm_cmd_frame_t * p_frame)
+{
+    char const * p_cmd = argv[(*p_index)++];
+    int          left  = argc - *p_index;
+
+    p_frame->length = 0U;
+
+    if (0 == strcmp(p_cmd, "ping"))
+    {
+        p_frame->id = PDM_CMD_PING;
+    }
+    else if (0 == strcmp(p_cmd, "start"))
+    {
+        p_frame->id = PDM_CMD_START;
+    }
+    else if (0 == strcmp(p_cmd, "stop"))
+    {
+        p_frame->id = PDM_CMD_STOP;
+    }
+    else if (0 == strcmp(p_cmd, "stats"))
+    {
+        p_frame->id = PDM_CMD_GET_STATS;
+    }
+    else if (0 == strcmp(p_cmd, "config"))
+    {
+        p_frame->id = PDM_CMD_GET_CONFIG;
+    }
+    else if ((0 == strcmp(p_cmd, "duration")) && (left >= 1))
+    {
+        uint32_t ms;
+        if (!pdm_ctl_u32(argv[(*p_index)++], &ms))
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_SET_DURATION;
+        pdm_cmd_u32_put(p_frame, ms);
+    }
+    else if ((0 == strcmp(p_cmd, "sdet")) && (left >= 1))
+    {
+        char const * p_mode = argv[(*p_index)++];
+        uint32_t     enable = 0U;
+        uint32_t     upper  = 0U;
+        uint32_t     lower  = 0U;
+
+        if ((0 == strcmp(p_mode, "on")) && (left >= 3))
+        {
+            enable = 1U;
+            if (!pdm_ctl_u32(argv[(*p_index)++], &upper) || !pdm_ctl_u32(argv[(*p_index)++], &lower))
+            {
+                return false;
+            }
+        }
+        else if (0 != strcmp(p_mode, "off"))
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_SET_SOUND_DETECTION;
+        pdm_cmd_u32_put(p_frame, enable);
+        pdm_cmd_u32_put(p_frame, upper);
+        pdm_cmd_u32_put(p_frame, lower);
+    }
+    else if ((0 == strcmp(p_cmd, "gain")) && (left >= 1))
+    {
+        char * p_end;
+        double db = strtod(argv[(*p_index)++], &p_end);
+        double q8 = floor((PDM_CMD_GAIN_UNITY * pow(10.0, db / 20.0)) + 0.5);
+
+        if (('\0' != *p_end) || (q8 < 1.0) || (q8 > PDM_CMD_GAIN_MAX))
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_SET_GAIN;
+        pdm_cmd_u32_put(p_frame, (uint32_t) q8);
+    }
+    else if ((0 == strcmp(p_cmd, "format")) && (left >= 1))
+    {
+        char const * p_format = argv[(*p_index)++];
+        uint32_t     format;
+
+        if (0 == strcmp(p_format, "raw"))
+        {
+            format = PDM_CMD_FORMAT_RAW20;
+        }
+        else if (0 == strcmp(p_format, "pcm16"))
+        {
+            format = PDM_CMD_FORMAT_PCM16;
+        }
+        else
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_SET_FORMAT;
+        pdm_cmd_u32_put(p_frame, format);
+    }
+    else if ((0 == strcmp(p_cmd, "sinc")) && (left >= 2))
+    {
+        uint32_t sincdec;
+        uint32_t sincrng;
+
+        if (!pdm_ctl_u32(argv[(*p_index)++], &sincdec) || !pdm_ctl_u32(argv[(*p_index)++], &sincrng))
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_SET_SINC;
+        pdm_cmd_u32_put(p_frame, sincdec);
+        pdm_cmd_u32_put(p_frame, sincrng);
+    }
+    else if (((0 == strcmp(p_cmd, "segment")) && (left >= 1)) || (0 == strcmp(p_cmd, "index")))
+    {
+        uint32_t id = 0U;
+
+        if (('s' == p_cmd[0]) && !pdm_ctl_u32(argv[(*p_index)++], &id))
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_GET_SEGMENT;
+        pdm_cmd_u32_put(p_frame, id);
+    }
+    else if ((0 == strcmp(p_cmd, "fetch")) && (left >= 2))
+    {
+        uint32_t first;
+        uint32_t last;
+
+        if (!pdm_ctl_u32(argv[(*p_index)++], &first) || !pdm_ctl_u32(argv[(*p_index)++], &last))
+        {
+            return false;
+        }
+
+        p_frame->id = PDM_CMD_FETCH_SEGMENTS;
+        pdm_cmd_u32_put(p_frame, first);
+        pdm_cmd_u32_put(p_frame, last);
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/* Wait for the acknowledgement of one sequence number; other bytes are skipped */
+static bool pdm_ctl_receive(int fd, pdm_cmd_parser_t * p_parser, uint8_t sequence, int timeout_ms)
+{
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+
+    while (poll(&pfd, 1, timeout_ms) > 0)
+    {
+        uint8_t chunk[256];
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count <= 0)
+        {
+            return false;
+        }
+
+        for (ssize_t i = 0; i < count; i++)
+        {
+            if (pdm_cmd_parse(p_parser, chunk[i]) && (sequence == p_parser->frame.sequence))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void pdm_ctl_print(pdm_cmd_frame_t const * p_ack)
+{
+    uint32_t status = (p_ack->length > 0U) ? p_ack->payload[0] : PDM_CMD_STATUS_FAILED;
+
+    if (status < (sizeof(g_status_names) / sizeof(g_status_names[0])))
+    {
+        printf("%s", g_status_names[status]);
+    }
+    else
+    {
+        printf("status %u", status);
+    }
+
+    char const * const * p_names = NULL;
+    uint32_t             names   = 0U;
+
+    if (PDM_CMD_STATUS_OK == status)
+    {
+        if (PDM_CMD_PING == p_ack->id)
+        {
+            p_names = g_ping_names;
+            names   = sizeof(g_ping_names) / sizeof(g_ping_names[0]);
+        }
+        else if (PDM_CMD_GET_STATS == p_ack->id)
+        {
+            p_names = g_stats_names;
+            names   = sizeof(g_stats_names) / sizeof(g_stats_names[0]);
+        }
+        else if (PDM_CMD_GET_CONFIG == p_ack->id)
+        {
+            p_names = g_config_names;
+            names   = sizeof(g_config_names) / sizeof(g_config_names[0]);
+        }
+        else if (PDM_CMD_GET_SEGMENT == p_ack->id)
+        {
+            p_names = g_segment_names;
+            names   = sizeof(g_segment_names) / sizeof(g_segment_names[0]);
+        }
+    }
+
+    for (uint32_t offset = 1U, word = 0U; (offset + 4U) <= p_ack->length; offset += 4U, word++)
+    {
+        uint32_t value = pdm_cmd_u32_get(&p_ack->payload[offset]);
+
+        if ((PDM_CMD_GET_STATS == p_ack->id) && (0U == word) &&
+            (value < (sizeof(g_state_names) / sizeof(g_state_names[0]))))
+        {
+            printf(" state=%s", g_state_names[value]);
+        }
+        else if (word < names)
+        {
+            printf(" %s=%u", p_names[word], value);
+        }
+        else
+        {
+            printf(" 0x%08X", value);
+        }
+    }
+
+    printf("\n");
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    char const * p_host     = PDM_CTL_DEFAULT_HOST;
+    char const * p_port     = PDM_CTL_DEFAULT_PORT;
+    int          timeout_ms = PDM_CTL_DEFAULT_TIMEOUT_MS;
+    bool         dry_run    = false;
+    int          i          = 1;
+
+    for (; (i < argc) && ('-' == argv[i][0]); i++)
+    {
+        if ((0 == strcmp(argv[i], "-H")) && ((i + 1) < argc))
+        {
+            p_host = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "-p")) && ((i + 1) < argc))
+        {
+            p_port = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "-t")) && ((i + 1) < argc))
+        {
+            timeout_ms = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "-n"))
+        {
+            dry_run = true;
+        }
+        else
+        {
+            pdm_ctl_usage(argv[0]);
+
+            return 2;
+        }
+    }
+
+    if (i >= argc)
+    {
+        pdm_ctl_usage(argv[0]);
+
+        return 2;
+    }
+
+    int fd = dry_run ? -1 : pdm_ctl_connect(p_host, p_port);
+    if (!dry_run && (fd < 0))
+    {
+        return 1;
+    }
+
+    pdm_cmd_parser_t parser;
+    pdm_cmd_parser_init(&parser, PDM_CMD_ACK_SYNC);
+
+    uint8_t sequence = (uint8_t) getpid();
+    int     result   = 0;
+
+    while ((i < argc) && (0 == result))
+    {
+        char const    * p_cmd = argv[i];
+        pdm_cmd_frame_t request;
+
+        if (!pdm_ctl_build(argc, argv, &i, &request))
+        {
+            fprintf(stderr, "pdm_ctl: bad command or arguments: %s\n", p_cmd);
+            pdm_ctl_usage(argv[0]);
+            result = 2;
+            break;
+        }
+
+        /* index repeats GET_SEGMENT from the ID after the last reply until the firmware runs out of entries */
+        bool index = (0 == strcmp(p_cmd, "index"));
+        bool more  = true;
+
+        while (more && (0 == result))
+        {
+            request.sequence = sequence++;
+
+            uint8_t  frame[PDM_CMD_FRAME_MAX];
+            uint32_t length = pdm_cmd_encode(&request, PDM_CMD_SYNC, frame);
+
+            if (dry_run)
+            {
+                printf("%-8s", p_cmd);
+                for (uint32_t b = 0U; b < length; b++)
+                {
+                    printf(" %02X", frame[b]);
+                }
+
+                printf("\n");
+                break;
+            }
+
+            if ((ssize_t) length != write(fd, frame, length))
+            {
+                perror("pdm_ctl: write");
+                result = 1;
+                break;
+            }
+
+            if (!pdm_ctl_receive(fd, &parser, request.sequence, timeout_ms))
+            {
+                fprintf(stderr, "pdm_ctl: %s: no acknowledgement within %d ms\n", p_cmd, timeout_ms);
+                result = 1;
+                break;
+            }
+
+            uint32_t status = parser.frame.payload[0];
+            more = index && (PDM_CMD_STATUS_OK == status) && (parser.frame.length >= 5U);
+
+            if (index && (PDM_CMD_STATUS_RANGE == status))
+            {
+                break;
+            }
+
+            printf("%-8s ", p_cmd);
+            pdm_ctl_print(&parser.frame);
+
+            if (PDM_CMD_STATUS_OK != status)
+            {
+                result = 1;
+            }
+
+            if (more)
+            {
+                request.length = 0U;
+                pdm_cmd_u32_put(&request, pdm_cmd_u32_get(&parser.frame.payload[1]) + 1U);
+            }
+        }
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    return result;
+}
@@ -0,0 +1,322 @@
+/**
+ * @file pdm_drift.c
+ * @brief Host estimator of the effective sample clock from the block timestamps of a dump
+ * @details Reads decoded dumps (the text pdm_logdec prints) from files or stdin, takes the "Stamps:" header and the
+ *          "STAMP <sequence> <index> <timestamp>" lines, and fits the completion time of every block against the
+ *          stream index of its last sample by least squares. Per capture it reports:
+ *          - the effective sample clock, its error against the nominal rate in ppm, with the standard error of the fit
+ *          - the offset: local time of stream sample 0 on the board's timestamp base
+ *          - the interrupt jitter: RMS and largest deviation of the stamps from the fitted line
+ *
+ *          A live decimation change (SET_SINC) changes the rate mid capture; the stamps are split into segments where
+ *          the local block rate jumps by more than 1 %, and each segment is fitted on its own. The time base is the
+ *          core clock named in the header; -c replaces it with a measured value (for example a frequency counter
+ *          reading of the crystal), -r replaces the nominal rate.
+ *
+ *          With several captures, each rate is also given against the first one: the ratio a resampler needs to put
+ *          the recordings of several boards on a common sample clock.
+ *
+ *          Usage: pdm_drift [-c clock_hz] [-r nominal_hz] [-v] [file ...]
+ *            -v  print the residual of every stamp
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_DRIFT_MAX_STAMPS      (65536U)
+#define PDM_DRIFT_MAX_FILES       (16U)
+
+/** Relative change of the block rate that starts a new segment */
+#define PDM_DRIFT_SEGMENT_STEP    (0.01)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+typedef struct st_pdm_drift_stamp
+{
+    uint32_t sequence;
+    uint64_t index;                    ///< Stream index of the last sample of the block
+    uint64_t timestamp;                ///< Completion time in clock cycles
+} pdm_drift_stamp_t;
+
+typedef struct st_pdm_drift_capture
+{
+    uint32_t          samples_per_block;
+    double            clock_hz;
+    double            nominal_hz;
+    uint32_t          count;
+    pdm_drift_stamp_t stamps[PDM_DRIFT_MAX_STAMPS];
+} pdm_drift_capture_t;
+
+typedef struct st_pdm_drift_fit
+{
+    double rate_hz;                    ///< Effective sample clock
+    double rate_error_hz;              ///< Standard error of rate_hz
+    double offset_s;                   ///< Time of stream sample 0
+    double jitter_rms_s;
+    double jitter_max_s;
+} pdm_drift_fit_t;
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static pdm_drift_capture_t g_captures[PDM_DRIFT_MAX_FILES];
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_drift_usage(char const * p_name)
+{
+    fprintf(stderr, "usage: %s [-c clock_hz] [-r nominal_hz] [-v] [file ...]\n", p_name);
+}
+
+/* Collect the stamps of one decoded dump; the last dump in the stream wins */
+static bool pdm_drift_read(FILE * p_in, pdm_drift_capture_t * p_capture)
+{
+    char line[256];
+    bool header = false;
+
+    while (NULL != fgets(line, sizeof(line), p_in))
+    {
+        unsigned count;
+        unsigned block;
+        unsigned clock;
+        unsigned rate;
+        unsigned sequence;
+        unsigned index;
+        char     hex[17];
+
+        if (4 == sscanf(line, "Stamps: %u, %u samples per block, clock %u Hz, nominal rate %u Hz", &count, &block,
+                        &clock, &rate))
+        {
+            header                       = true;
+            p_capture->count             = 0U;
+            p_capture->samples_per_block = block;
+            p_capture->clock_hz          = clock;
+            p_capture->nominal_hz        = rate;
+        }
+        else if (header && (3 == sscanf(line, "STAMP %u %u %16s", &sequence, &index, hex)) &&
+                 (p_capture->count < PDM_DRIFT_MAX_STAMPS))
+        {
+            pdm_drift_stamp_t * p_stamp = &p_capture->stamps[p_capture->count++];
+            p_stamp->sequence  = sequence;
+            p_stamp->index     = (uint64_t) index + p_capture->samples_per_block;
+            p_stamp->timestamp = strtoull(hex, NULL, 16);
+        }
+    }
+
+    return header && (p_capture->count >= 2U);
+}
+
+/* Least-squares line time = offset + index / rate over stamps[first, first + n) */
+static void pdm_drift_fit(pdm_drift_capture_t const * p_capture, uint32_t first, uint32_t n, pdm_drift_fit_t * p_fit)
+{
+    pdm_drift_stamp_t const * p   = &p_capture->stamps[first];
+    long double               x0  = (long double) p[0].index;
+    long double               t0  = (long double) p[0].timestamp;
+    long double               sx  = 0.0L;
+    long double               st  = 0.0L;
+    long double               sxx = 0.0L;
+    long double               sxt = 0.0L;
+
+    /* Relative to the first stamp, so the 64-bit counts do not eat the precision */
+    for (uint32_t i = 0U; i < n; i++)
+    {
+        long double x = (long double) p[i].index - x0;
+        long double t = ((long double) p[i].timestamp - t0) / p_capture->clock_hz;
+        sx  += x;
+        st  += t;
+        sxx += x * x;
+        sxt += x * t;
+    }
+
+    long double d     = (n * sxx) - (sx * sx);
+    long double slope = (d > 0.0L) ? (((n * sxt) - (sx * st)) / d) : 0.0L;
+    long double cut   = (st - (slope * sx)) / n;
+    long double sum   = 0.0L;
+    long double worst = 0.0L;
+
+    for (uint32_t i = 0U; i < n; i++)
+    {
+        long double x = (long double) p[i].index - x0;
+        long double t = ((long double) p[i].timestamp - t0) / p_capture->clock_hz;
+        long double r = t - (cut + (slope * x));
+        sum  += r * r;
+        worst = (fabsl(r) > worst) ? fabsl(r) : worst;
+    }
+
+    long double sigma2 = (n > 2U) ? (sum / (n - 2U)) : 0.0L;
+    long double se     = (d > 0.0L) ? sqrtl((sigma2 * n) / d) : 0.0L;
+
+    p_fit->rate_hz       = (slope > 0.0L) ? (double) (1.0L / slope) : 0.0;
+    p_fit->rate_error_hz = (slope > 0.0L) ? (double) (se / (slope * slope)) : 0.0;
+    p_fit->offset_s      = (double) ((t0 / p_capture->clock_hz) + cut - (slope * x0));
+    p_fit->jitter_rms_s  = (double) sqrtl(sum / n);
+    p_fit->jitter_max_s  = (double) worst;
+}
+
+/* Block rate between stamps i - 1 and i, in samples per second */
+static double pdm_drift_local_rate(pdm_drift_capture_t const * p_capture, uint32_t i)
+{
+    double dt = (double) (p_capture->stamps[i].timestamp - p_capture->stamps[i - 1U].timestamp) / p_capture->clock_hz;
+
+    return (dt > 0.0) ? ((double) (p_capture->stamps[i].index - p_capture->stamps[i - 1U].index) / dt) : 0.0;
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    double   clock_hz   = 0.0;
+    double   nominal_hz = 0.0;
+    bool     verbose    = false;
+    int      i          = 1;
+    uint32_t files      = 0U;
+    double   reference  = 0.0;
+
+    for (; (i < argc) && ('-' == argv[i][0]) && ('\0' != argv[i][1]); i++)
+    {
+        if ((0 == strcmp(argv[i], "-c")) && ((i + 1) < argc))
+        {
+            clock_hz = strtod(argv[++i], NULL);
+        }
+        else if ((0 == strcmp(argv[i], "-r")) && ((i + 1) < argc))
+        {
+            nominal_hz = strtod(argv[++i], NULL);
+        }
+        else if (0 == strcmp(argv[i], "-v"))
+        {
+            verbose = true;
+        }
+        else
+        {
+            pdm_drift_usage(argv[0]);
+
+            return 2;
+        }
+    }
+
+    do
+    {
+        char const * p_path = (i < argc) ? argv[i] : "-";
+        FILE       * p_in   = (0 == strcmp(p_path, "-")) ? stdin : fopen(p_path, "r");
+
+        if (files >= PDM_DRIFT_MAX_FILES)
+        {
+            fprintf(stderr, "pdm_drift: at most %u captures\n", PDM_DRIFT_MAX_FILES);
+
+            return 2;
+        }
+
+        if (NULL == p_in)
+        {
+            fprintf(stderr, "pdm_drift: cannot open %s\n", p_path);
+
+            return 1;
+        }
+
+        pdm_drift_capture_t * p_capture = &g_captures[files++];
+        bool                  ok        = pdm_drift_read(p_in, p_capture);
+
+        if (stdin != p_in)
+        {
+            fclose(p_in);
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "pdm_drift: %s: no block timestamps (need a dump with at least two STAMP lines)\n", p_path);
+
+            return 1;
+        }
+
+        p_capture->clock_hz   = (clock_hz > 0.0) ? clock_hz : p_capture->clock_hz;
+        p_capture->nominal_hz = (nominal_hz > 0.0) ? nominal_hz : p_capture->nominal_hz;
+
+        /* Split where the block rate jumps (live decimation change) */
+        uint32_t first   = 0U;
+        uint32_t segment = 0U;
+        for (uint32_t s = 1U; s <= p_capture->count; s++)
+        {
+            if ((s < p_capture->count) && ((s - first) < 2U ||
+                                           (fabs((pdm_drift_local_rate(p_capture, s) /
+                                                  pdm_drift_local_rate(p_capture, first + 1U)) - 1.0) <=
+                                            PDM_DRIFT_SEGMENT_STEP)))
+            {
+                continue;
+            }
+
+            uint32_t n = s - first;
+            if (n < 2U)
+            {
+                first = s;
+                continue;
+            }
+
+            pdm_drift_fit_t fit;
+            pdm_drift_fit(p_capture, first, n, &fit);
+
+            /* The nominal rate of the header belongs to the last segment; earlier ones report against their own */
+            double nominal = (s == p_capture->count) ? p_capture->nominal_hz : 0.0;
+            printf("%s: segment %u, blocks %u..%u, samples %llu..%llu\n", p_path, segment,
+                   p_capture->stamps[first].sequence, p_capture->stamps[s - 1U].sequence,
+                   (unsigned long long) (p_capture->stamps[first].index - p_capture->samples_per_block),
+                   (unsigned long long) p_capture->stamps[s - 1U].index);
+            printf("  rate %.4f Hz +- %.4f", fit.rate_hz, fit.rate_error_hz);
+            if (nominal > 0.0)
+            {
+                printf(", %+.2f ppm +- %.2f against %.0f Hz", ((fit.rate_hz / nominal) - 1.0) * 1e6,
+                       (fit.rate_error_hz / nominal) * 1e6, nominal);
+            }
+
+            if ((0.0 != reference) && (nominal > 0.0))
+            {
+                printf(", %+.2f ppm against the first capture", ((fit.rate_hz / reference) - 1.0) * 1e6);
+            }
+
+            printf("\n  offset %.9f s, jitter rms %.2f us, max %.2f us\n", fit.offset_s, fit.jitter_rms_s * 1e6,
+                   fit.jitter_max_s * 1e6);
+
+            if ((0.0 == reference) && (nominal > 0.0))
+            {
+                reference = fit.rate_hz;
+            }
+
+            if (verbose)
+            {
+                printf("  # sequence,index,timestamp,residual_us\n");
+                for (uint32_t k = first; k < s; k++)
+                {
+                    pdm_drift_stamp_t const * p_stamp = &p_capture->stamps[k];
+                    double                    t       = (double) p_stamp->timestamp / p_capture->clock_hz;
+                    printf("  %u,%llu,%llu,%.3f\n", p_stamp->sequence, (unsigned long long) p_stamp->index,
+                           (unsigned long long) p_stamp->timestamp,
+                           (t - fit.offset_s - ((double) p_stamp->index / fit.rate_hz)) * 1e6);
+                }
+            }
+
+            first = s;
+            segment++;
+        }
+
+        i++;
+    } while (i < argc);
+
+    return 0;
+}
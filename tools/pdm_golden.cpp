@@ -0,0 +1,958 @@
+/**
+ * @file pdm_golden.cpp
+ * @brief Golden-vector regression of the processing stages: bit-exact outputs, declared tolerances for float paths
+ * @details Runs canned input through every processing stage at several block sizes and compares the output against
+ *          the golden vectors checked in as tools/pdm_golden.txt:
+ *          - PDM: a delta-sigma bit stream through the fixed-point model of the PDM filters (pdm_model.hpp), with the
+ *            register set of ra_gen/hal_data.c frozen in this file
+ *          - PCM: 20-bit FIFO words (with garbage above the PCM width) through pdm_dsp, every pdm_kernel width, format
+ *            and gain case, the session pipeline (driver ring, slots, integrity, kernel store; also as shipped, with
+ *            16-bit words stored raw at unity gain, which must pass through unchanged), the segment store and the
+ *            pre-trigger ring
+ *          - float: pdm_dsp filters and FFT, the pdm_math block functions and atan2 on the axes and signed zeros
+ *
+ *          Integer stages must match bit for bit; they are stored as a CRC-32 of the output words. Float stages are
+ *          stored value by value and must match within the absolute tolerance declared with the stage, which leaves
+ *          room for contraction into FMA or another summation order. The output of a stage must not depend on the
+ *          block size: a mismatch between two block sizes is reported at the first sample that differs.
+ *
+ *          The canned input is generated with integer arithmetic only, so it is the same on every host. `make golden`
+ *          builds the tool and the modules under test at -O0, -O2 and -O3 and checks each build; -u rewrites the
+ *          golden file after an intended change of output, which then shows up in review as a diff of that file.
+ *
+ *          Usage: pdm_golden [-u] [-v] [golden_file]
+ *            -u  write the golden file from this build instead of checking it
+ *            -v  report every block size
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_model.hpp"
+#include "pdm_cfg.h"
+#include "pdm_dsp.h"
+#include "pdm_kernel.h"
+#include "pdm_math.h"
+#include "pdm_segment.h"
+#include "pdm_session.h"
+#include "pdm_trigger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_GOLDEN_FORMAT_VERSION   (1U)
+
+/* Samples of the integer and of the float stages */
+#define PDM_GOLDEN_PCM_SAMPLES      (2048U)
+#define PDM_GOLDEN_FLOAT_SAMPLES    (256U)
+
+/* Nominal rate of the stages that need one */
+#define PDM_GOLDEN_RATE_HZ          (16000U)
+
+/* Tolerance value of the bit-exact stages */
+#define PDM_GOLDEN_EXACT            (-1.0)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+namespace
+{
+
+/** Output of one stage run: words (bit-exact stages) or values (float stages) */
+struct pdm_golden_output
+{
+    std::vector<uint32_t> words;
+    std::vector<float>    values;
+};
+
+/** One stage; run() processes the whole canned input in calls of at most block samples */
+struct pdm_golden_case
+{
+    std::string                                            name;
+    double                                                 tolerance;   ///< PDM_GOLDEN_EXACT or absolute
+    bool                                                   blocked;     ///< false: one call, block sizes do not apply
+    std::function<void(uint32_t, pdm_golden_output &)>     run;
+};
+
+/** Golden vectors of one stage as read from the file */
+struct pdm_golden_entry
+{
+    uint32_t           count = 0U;
+    uint32_t           crc   = 0U;
+    std::vector<float> values;
+};
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+/* Block sizes: single samples, odd sizes that leave a tail in every kernel pass, the firmware's callback size */
+uint32_t const g_block_sizes[] = {1U, 7U, 64U, 100U, 1024U};
+
+/* Canned input, built once */
+std::vector<uint32_t> g_pcm_words;     ///< FIFO words, PCM in the low 20 bits
+std::vector<int32_t>  g_pcm;           ///< The same samples signed
+std::vector<uint8_t>  g_pdm_bits;
+std::vector<uint32_t> g_chain_words;   ///< g_pdm_bits through the PDM filter model, as FIFO words
+std::vector<float>    g_float;         ///< Float stage input, +-1
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+void pdm_golden_usage(char const * p_name)
+{
+    fprintf(stderr, "usage: %s [-u] [-v] [golden_file]\n", p_name);
+}
+
+uint32_t pdm_golden_lcg(uint32_t & state)
+{
+    state = (state * 1664525U) + 1013904223U;
+
+    return state;
+}
+
+/* Parabolic sine of a 32-bit phase, +-2^19 full scale, integer only */
+int32_t pdm_golden_sine(uint32_t phase)
+{
+    int64_t x = (int64_t) (int32_t) phase >> 12;             // [-2^19, 2^19): [-pi, pi)
+    int64_t a = (x < 0) ? -x : x;
+
+    return (int32_t) ((x * (524288 - a)) >> 17);
+}
+
+/* Register set of g_pdm0_cfg_extend (ra_gen/hal_data.c) at the time the golden vectors were made */
+pdm_model::filters pdm_golden_filters()
+{
+    pdm_model::filters f;
+    f.sinc_order = 4U;
+    f.sincdec    = 62U;
+    f.sincrng    = 9U;
+    f.hpf_s0     = 0x3F61U;
+    f.hpf_k1     = 0x3EC1U;
+    f.hpf_h      = {{0x4000U, 0xC000U}};
+    f.comp       = {{0x1FE8U, 0x0039U, 0x003CU, 0x1E56U, 0x01DCU, 0x06E1U, 0x01DCU, 0x1E56U, 0x003CU, 0x0039U, 0x1FE8U}};
+    f.lpf_h0     = 0x0400U;
+    f.lpf        = {{0x1FF8U, 0x000AU, 0x1FF0U, 0x0018U, 0x1FDCU, 0x0034U, 0x1FB3U, 0x0076U, 0x1F2EU, 0x0289U,
+                     0x0289U, 0x1F2EU, 0x0076U, 0x1FB3U, 0x0034U, 0x1FDCU, 0x0018U, 0x1FF0U, 0x000AU, 0x1FF8U}};
+
+    return f;
+}
+
+/* Canned input: a chirp, noise over a tone, a full-scale stretch that hits both 20-bit limits, near silence, and an
+ * offset tone; the bits above the PCM width are noise */
+void pdm_golden_input()
+{
+    uint32_t seed  = 0x2545F491U;
+    uint32_t phase = 0U;
+
+    for (uint32_t i = 0U; i < PDM_GOLDEN_PCM_SAMPLES; i++)
+    {
+        int32_t x;
+
+        if (i < 512U)
+        {
+            phase += 0x00200000U + (i * 0x00040000U);
+            x      = pdm_golden_sine(phase) / 2;
+        }
+        else if (i < 1024U)
+        {
+            phase += 0x04000000U;
+            x      = (pdm_golden_sine(phase) / 8) + ((int32_t) (pdm_golden_lcg(seed) >> 15) - 65536);
+        }
+        else if (i < 1280U)
+        {
+            phase += 0x03000000U;
+            x      = pdm_golden_sine(phase);
+            x      = (x > 0x7FFFF) ? 0x7FFFF : x;
+            x      = ((i % 64U) == 5U) ? -0x80000 : x;
+        }
+        else if (i < 1536U)
+        {
+            x = (int32_t) (pdm_golden_lcg(seed) >> 30) - 2;
+        }
+        else
+        {
+            phase += 0x01000000U;
+            x      = (pdm_golden_sine(phase) / 4) + 20000;
+        }
+
+        g_pcm.push_back(x);
+        g_pcm_words.push_back(((uint32_t) x & 0x000FFFFFU) | (pdm_golden_lcg(seed) & 0xFFF00000U));
+    }
+
+    /* PDM: a tone at half scale sweeping up, one PCM sample every 2 * sincdec bits */
+    pdm_model::filters const f    = pdm_golden_filters();
+    size_t const             bits = (size_t) PDM_GOLDEN_PCM_SAMPLES * 2U * f.sincdec;
+    uint32_t                 pdm_phase = 0U;
+
+    g_pdm_bits = pdm_model::modulate([&](size_t n) {
+        pdm_phase += 0x00004000U + (uint32_t) (n >> 6);
+
+        return (double) pdm_golden_sine(pdm_phase) / 1048576.0;
+    }, bits);
+
+    pdm_model::chain chain(f);
+    for (int32_t y : chain.run(g_pdm_bits))
+    {
+        g_chain_words.push_back((uint32_t) y & 0x000FFFFFU);
+    }
+
+    for (uint32_t i = 0U; i < PDM_GOLDEN_FLOAT_SAMPLES; i++)
+    {
+        g_float.push_back((float) g_pcm[(i * 7U) % PDM_GOLDEN_PCM_SAMPLES] / 524288.0f);
+    }
+}
+
+/* Calls of at most block samples over count samples */
+void pdm_golden_blocks(uint32_t count, uint32_t block, std::function<void(uint32_t, uint32_t)> const & step)
+{
+    for (uint32_t done = 0U; done < count; done += block)
+    {
+        step(done, std::min(block, count - done));
+    }
+}
+
+uint32_t pdm_golden_crc(std::vector<uint32_t> const & words)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+
+    for (uint32_t word : words)
+    {
+        for (uint32_t b = 0U; b < 4U; b++)
+        {
+            crc ^= (word >> (8U * b)) & 0xFFU;
+            for (uint32_t k = 0U; k < 8U; k++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+            }
+        }
+    }
+
+    return ~crc;
+}
+
+void pdm_golden_push64(std::vector<uint32_t> & words, uint64_t value)
+{
+    words.push_back((uint32_t) value);
+    words.push_back((uint32_t) (value >> 32));
+}
+
+/***********************************************************************************************************************
+ * Stages
+ **********************************************************************************************************************/
+
+/* Session pipeline: the PDM model output as driver blocks, through the session and a kernel store */
+struct pdm_golden_session
+{
+    pdm_kernel_t const *  p_kernel;
+    pdm_kernel_format_t   format;
+    int32_t               gain_q8;
+    uint32_t              block;
+    uint64_t              valid_until;
+    pdm_golden_output   * p_out;
+};
+
+uint64_t g_session_clock;
+
+uint64_t pdm_golden_session_timestamp()
+{
+    return g_session_clock;
+}
+
+fsp_err_t pdm_golden_session_start(void * p_ctrl, uint32_t * p_ring, uint32_t ring_samples, uint32_t block_samples)
+{
+    FSP_PARAMETER_NOT_USED(p_ctrl);
+    FSP_PARAMETER_NOT_USED(p_ring);
+    FSP_PARAMETER_NOT_USED(ring_samples);
+    FSP_PARAMETER_NOT_USED(block_samples);
+
+    return FSP_SUCCESS;
+}
+
+void pdm_golden_session_block(pdm_session_t * p_session, uint32_t * p_samples, pdm_integrity_block_t const * p_info,
+                              void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_session);
+
+    pdm_golden_session * p_ctx = static_cast<pdm_golden_session *>(p_context);
+    uint64_t             end   = std::min(p_ctx->valid_until, p_info->sample_index + p_ctx->block);
+    uint32_t             count = (uint32_t) (end - p_info->sample_index);
+    std::vector<uint32_t> words(count);
+
+    p_ctx->p_kernel->store[p_ctx->format](p_samples, words.data(), count, p_ctx->gain_q8);
+    p_ctx->p_out->words.insert(p_ctx->p_out->words.end(), words.begin(), words.end());
+}
+
+void pdm_golden_run_session(uint32_t pcm_bits, pdm_kernel_format_t format, int32_t gain_q8, uint32_t block,
+                            pdm_golden_output & out)
+{
+    static pdm_session_driver_t const driver = {NULL, pdm_golden_session_start, NULL, NULL};
+
+    std::vector<uint32_t>              ring(4U * block);
+    std::vector<uint32_t>              slots(PDM_CFG_BLOCK_SLOTS * block);
+    std::vector<pdm_integrity_block_t> info(PDM_CFG_BLOCK_SLOTS);
+    pdm_golden_session                 ctx = {pdm_kernel_select(pcm_bits), format, gain_q8, block, UINT64_MAX, &out};
+
+    pdm_session_cfg_t cfg = {};
+    cfg.p_driver          = &driver;
+    cfg.p_ring            = ring.data();
+    cfg.ring_samples      = 4U * block;
+    cfg.block_samples     = block;
+    cfg.p_slot_storage    = slots.data();
+    cfg.p_slot_info       = info.data();
+    cfg.slots             = PDM_CFG_BLOCK_SLOTS;
+    cfg.p_timestamp       = pdm_golden_session_timestamp;
+    cfg.cycles_per_second = PDM_GOLDEN_RATE_HZ;
+    cfg.p_block           = pdm_golden_session_block;
+    cfg.p_context         = &ctx;
+
+    pdm_session_t session = {};
+    g_session_clock = 0U;
+    (void) pdm_session_open(&session, &cfg);
+    (void) pdm_session_start(&session, PDM_GOLDEN_RATE_HZ);
+
+    uint32_t count = (uint32_t) g_chain_words.size();
+    pdm_golden_blocks(count, block, [&](uint32_t first, uint32_t n) {
+        /* The tail goes out as a padded block the hook trims */
+        uint32_t * p_dst = &ring[(session.callbacks % 4U) * block];
+        std::fill(p_dst, p_dst + block, 0U);
+        std::copy(&g_chain_words[first], &g_chain_words[first] + n, p_dst);
+        ctx.valid_until = (n < block) ? (first + n) : UINT64_MAX;
+
+        g_session_clock += block;
+        pdm_session_isr(&session, PDM_SESSION_EVENT_BLOCK, 0U);
+        (void) pdm_session_process(&session);
+    });
+
+    (void) pdm_session_close(&session);
+}
+
+/* Segment store: index entries and the stored samples of every segment */
+void pdm_golden_run_segment(uint32_t block, pdm_golden_output & out)
+{
+    std::vector<uint32_t>            pool(4096U);
+    std::vector<uint32_t>            preroll(64U);
+    std::vector<pdm_segment_entry_t> index(16U);
+    pdm_kernel_t const *             p_kernel = pdm_kernel_select(20U);
+
+    pdm_segment_cfg_t cfg = {};
+    cfg.p_pool            = pool.data();
+    cfg.capacity          = (uint32_t) pool.size();
+    cfg.p_index           = index.data();
+    cfg.entries           = (uint32_t) index.size();
+    cfg.p_preroll         = preroll.data();
+    cfg.pre_samples       = (uint32_t) preroll.size();
+    cfg.hold_samples      = 96U;
+    cfg.max_samples       = 400U;
+    cfg.level             = 120000;
+    cfg.rate_hz           = PDM_GOLDEN_RATE_HZ;
+    cfg.clock_hz          = PDM_GOLDEN_RATE_HZ;
+
+    pdm_segment_ctrl_t ctrl;
+    (void) pdm_segment_open(&ctrl, &cfg);
+
+    pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+        std::vector<int32_t>  samples(n);
+        std::vector<uint32_t> words(n);
+        p_kernel->convert(&g_pcm_words[first], samples.data(), n);
+        p_kernel->store[PDM_KERNEL_FORMAT_RAW20](&g_pcm_words[first], words.data(), n, PDM_KERNEL_GAIN_UNITY);
+        pdm_segment_append(&ctrl, first, first, words.data(), samples.data(), n);
+    });
+
+    pdm_segment_close(&ctrl);
+
+    pdm_segment_entry_t entry;
+    for (uint32_t id = 0U; FSP_SUCCESS == pdm_segment_find(&ctrl, id, &entry); id = entry.id + 1U)
+    {
+        out.words.push_back(entry.id);
+        out.words.push_back(entry.source);
+        pdm_golden_push64(out.words, entry.start);
+        pdm_golden_push64(out.words, entry.timestamp);
+        out.words.push_back(entry.length);
+        out.words.push_back(entry.peak);
+        out.words.push_back(entry.rms);
+
+        uint32_t const * p_span;
+        for (uint32_t done = 0U, n; done < entry.length; done += n)
+        {
+            n = pdm_segment_read(&ctrl, &entry, done, &p_span);
+            if (0U == n)
+            {
+                break;
+            }
+
+            out.words.insert(out.words.end(), p_span, p_span + n);
+        }
+    }
+
+    out.words.push_back(ctrl.evicted);
+}
+
+/* Pre-trigger ring with a level trigger, as the recorder feeds it */
+void pdm_golden_run_trigger(uint32_t block, pdm_golden_output & out)
+{
+    std::vector<uint32_t> ring(1000U);
+    pdm_kernel_t const *  p_kernel = pdm_kernel_select(20U);
+
+    pdm_trigger_cfg_t cfg = {};
+    cfg.p_buffer          = ring.data();
+    cfg.capacity          = (uint32_t) ring.size();
+    cfg.pre_samples       = 300U;
+    cfg.post_samples      = 500U;
+    cfg.level             = 400000;
+
+    pdm_trigger_ctrl_t ctrl;
+    (void) pdm_trigger_open(&ctrl, &cfg);
+
+    pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+        if (PDM_TRIGGER_STATE_ARMED == pdm_trigger_state(&ctrl))
+        {
+            std::vector<int32_t> samples(n);
+            p_kernel->convert(&g_pcm_words[first], samples.data(), n);
+            (void) pdm_trigger_detect(&ctrl, samples.data(), n);
+        }
+
+        for (uint32_t done = 0U; done < n;)
+        {
+            uint32_t * p_span;
+            uint32_t   room = pdm_trigger_reserve(&ctrl, &p_span);
+            if (0U == room)
+            {
+                break;
+            }
+
+            room = std::min(room, n - done);
+            p_kernel->store[PDM_KERNEL_FORMAT_RAW20](&g_pcm_words[first + done], p_span, room, PDM_KERNEL_GAIN_UNITY);
+            pdm_trigger_commit(&ctrl, room);
+            done += room;
+        }
+    });
+
+    pdm_trigger_stop(&ctrl);
+
+    pdm_trigger_event_t event;
+    if (FSP_SUCCESS == pdm_trigger_event_get(&ctrl, &event))
+    {
+        out.words.push_back(event.source);
+        pdm_golden_push64(out.words, event.first);
+        pdm_golden_push64(out.words, event.trigger);
+        out.words.push_back(event.length);
+        out.words.insert(out.words.end(), event.p_head, event.p_head + event.head_count);
+        out.words.insert(out.words.end(), event.p_tail, event.p_tail + event.tail_count);
+    }
+}
+
+/* Every stage, in report order */
+std::vector<pdm_golden_case> pdm_golden_cases()
+{
+    std::vector<pdm_golden_case> cases;
+
+    cases.push_back({"pdm_chain", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_model::filters const f = pdm_golden_filters();
+        pdm_model::chain         chain(f);
+        std::vector<int32_t>     pcm;
+        size_t                   step = (size_t) block * 2U * f.sincdec;
+
+        for (size_t done = 0U; done < g_pdm_bits.size(); done += step)
+        {
+            size_t end = std::min(g_pdm_bits.size(), done + step);
+            for (size_t i = done; i < end; i++)
+            {
+                chain.push(g_pdm_bits[i], pcm);
+            }
+        }
+
+        for (int32_t y : pcm)
+        {
+            out.words.push_back((uint32_t) y);
+        }
+
+        out.words.push_back((uint32_t) chain.saturations());
+    }});
+
+    cases.push_back({"dsp_convert_20bit", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        out.words.resize(PDM_GOLDEN_PCM_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_convert_20bit(&g_pcm_words[first], (int32_t *) &out.words[first], n);
+        });
+    }});
+
+    cases.push_back({"dsp_pack_pcm16", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        std::vector<int16_t> pcm(PDM_GOLDEN_PCM_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_pack_pcm16(&g_pcm[first], &pcm[first], n);
+        });
+
+        for (int16_t y : pcm)
+        {
+            out.words.push_back((uint16_t) y);
+        }
+    }});
+
+    cases.push_back({"dsp_dc_block", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_dsp_dc_block_t dc;
+        (void) pdm_dsp_dc_block_init(&dc, PDM_DSP_DC_BLOCK_POLE_Q15);
+        out.words.resize(PDM_GOLDEN_PCM_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_dc_block(&dc, &g_pcm[first], (int32_t *) &out.words[first], n);
+        });
+    }});
+
+    cases.push_back({"dsp_stats", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_dsp_stats_t stats;
+        pdm_dsp_stats_reset(&stats);
+        pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_stats_update(&stats, &g_pcm[first], n);
+        });
+
+        out.words = {(uint32_t) stats.min, (uint32_t) stats.max, stats.clipped, stats.count,
+                     pdm_dsp_stats_rms(&stats)};
+        pdm_golden_push64(out.words, (uint64_t) stats.sum);
+        pdm_golden_push64(out.words, stats.sum_squares);
+    }});
+
+    /* Every kernel set: convert, then each stored format at unity, an attenuating and a clipping gain */
+    for (uint32_t k = 0U; NULL != pdm_kernel_get(k); k++)
+    {
+        pdm_kernel_t const * p_kernel = pdm_kernel_get(k);
+        std::string          prefix   = std::string("kernel_") + p_kernel->p_name;
+
+        cases.push_back({prefix + "_convert", PDM_GOLDEN_EXACT, true,
+                         [p_kernel](uint32_t block, pdm_golden_output & out) {
+            out.words.resize(PDM_GOLDEN_PCM_SAMPLES);
+            pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+                p_kernel->convert(&g_pcm_words[first], (int32_t *) &out.words[first], n);
+            });
+        }});
+
+        for (uint32_t format = 0U; format < PDM_KERNEL_FORMAT_COUNT; format++)
+        {
+            for (int32_t gain : {PDM_KERNEL_GAIN_UNITY, 77, 700})
+            {
+                std::string name = prefix + ((PDM_KERNEL_FORMAT_PCM16 == format) ? "_pcm16_g" : "_raw20_g") +
+                                   std::to_string(gain);
+
+                cases.push_back({name, PDM_GOLDEN_EXACT, true,
+                                 [p_kernel, format, gain](uint32_t block, pdm_golden_output & out) {
+                    out.words.resize(PDM_GOLDEN_PCM_SAMPLES);
+                    pdm_golden_blocks(PDM_GOLDEN_PCM_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+                        p_kernel->store[format](&g_pcm_words[first], &out.words[first], n, gain);
+                    });
+                }});
+            }
+        }
+    }
+
+    cases.push_back({"session_pipeline", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_golden_run_session(20U, PDM_KERNEL_FORMAT_PCM16, 384, block, out);
+    }});
+
+    /* The shipped configuration (16-bit FIFO words, raw at unity gain): the words must come out as captured */
+    cases.push_back({"session_pipeline_w16_raw", PDM_GOLDEN_EXACT, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_golden_run_session(16U, PDM_KERNEL_FORMAT_RAW20, PDM_KERNEL_GAIN_UNITY, block, out);
+    }});
+    cases.push_back({"segment_store", PDM_GOLDEN_EXACT, true, pdm_golden_run_segment});
+    cases.push_back({"trigger_ring", PDM_GOLDEN_EXACT, true, pdm_golden_run_trigger});
+
+    /* Float paths */
+    cases.push_back({"dsp_to_float", 1e-9, true, [](uint32_t block, pdm_golden_output & out) {
+        out.values.resize(PDM_GOLDEN_FLOAT_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_FLOAT_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_to_float(&g_pcm[first], &out.values[first], n, 1.0f / 524288.0f);
+        });
+    }});
+
+    cases.push_back({"dsp_biquad_lp_hp", 1e-5, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_dsp_biquad_coeffs_t coeffs[2];
+        pdm_dsp_biquad_t        biquad;
+        (void) pdm_dsp_biquad_design(&coeffs[0], PDM_DSP_BIQUAD_LOWPASS, 3000.0f, 0.7071f, 16000.0f);
+        (void) pdm_dsp_biquad_design(&coeffs[1], PDM_DSP_BIQUAD_HIGHPASS, 100.0f, 0.7071f, 16000.0f);
+        (void) pdm_dsp_biquad_init(&biquad, coeffs, 2U);
+        out.values.resize(PDM_GOLDEN_FLOAT_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_FLOAT_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_biquad_process(&biquad, &g_float[first], &out.values[first], n);
+        });
+    }});
+
+    cases.push_back({"dsp_biquad_bandpass", 1e-5, true, [](uint32_t block, pdm_golden_output & out) {
+        pdm_dsp_biquad_coeffs_t coeffs;
+        pdm_dsp_biquad_t        biquad;
+        (void) pdm_dsp_biquad_design(&coeffs, PDM_DSP_BIQUAD_BANDPASS, 1000.0f, 2.0f, 16000.0f);
+        (void) pdm_dsp_biquad_init(&biquad, &coeffs, 1U);
+        out.values.resize(PDM_GOLDEN_FLOAT_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_FLOAT_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_biquad_process(&biquad, &g_float[first], &out.values[first], n);
+        });
+    }});
+
+    cases.push_back({"dsp_fir_lowpass", 1e-5, true, [](uint32_t block, pdm_golden_output & out) {
+        float         taps[31];
+        float         state[62];
+        pdm_dsp_fir_t fir;
+        (void) pdm_dsp_fir_lowpass(taps, 31U, 2000.0f, 16000.0f);
+        (void) pdm_dsp_fir_init(&fir, taps, state, 31U);
+        out.values.resize(PDM_GOLDEN_FLOAT_SAMPLES);
+        pdm_golden_blocks(PDM_GOLDEN_FLOAT_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_dsp_fir_process(&fir, &g_float[first], &out.values[first], n);
+        });
+    }});
+
+    cases.push_back({"dsp_fft_256", 1e-3, false, [](uint32_t block, pdm_golden_output & out) {
+        FSP_PARAMETER_NOT_USED(block);
+
+        std::vector<float> twiddle(PDM_GOLDEN_FLOAT_SAMPLES);
+        std::vector<float> in(2U * PDM_GOLDEN_FLOAT_SAMPLES, 0.0f);
+        pdm_dsp_fft_t      fft;
+        (void) pdm_dsp_fft_init(&fft, twiddle.data(), PDM_GOLDEN_FLOAT_SAMPLES);
+        for (uint32_t i = 0U; i < PDM_GOLDEN_FLOAT_SAMPLES; i++)
+        {
+            in[2U * i] = g_float[i];
+        }
+
+        out.values.resize(2U * PDM_GOLDEN_FLOAT_SAMPLES);
+        pdm_dsp_fft(&fft, in.data(), out.values.data());
+    }});
+
+    cases.push_back({"math_sincos_block", 1e-6, true, [](uint32_t block, pdm_golden_output & out) {
+        std::vector<float> angle(PDM_GOLDEN_FLOAT_SAMPLES);
+        std::vector<float> s(PDM_GOLDEN_FLOAT_SAMPLES);
+        std::vector<float> c(PDM_GOLDEN_FLOAT_SAMPLES);
+        for (uint32_t i = 0U; i < PDM_GOLDEN_FLOAT_SAMPLES; i++)
+        {
+            angle[i] = g_float[i] * 4.0f * PDM_MATH_PI;
+        }
+
+        pdm_golden_blocks(PDM_GOLDEN_FLOAT_SAMPLES, block, [&](uint32_t first, uint32_t n) {
+            pdm_math_sincos_block(&angle[first], &s[first], &c[first], n);
+        });
+
+        out.values = s;
+        out.values.insert(out.values.end(), c.begin(), c.end());
+    }});
+
+    cases.push_back({"math_polar_block", 1e-5, true, [](uint32_t block, pdm_golden_output & out) {
+        uint32_t const     half = PDM_GOLDEN_FLOAT_SAMPLES / 2U;
+        std::vector<float> phase(half);
+        std::vector<float> magnitude(half);
+        pdm_golden_blocks(half, block, [&](uint32_t first, uint32_t n) {
+            pdm_math_polar_block(&g_float[first], &g_float[half + first], &phase[first], &magnitude[first], n);
+        });
+
+        out.values = phase;
+        out.values.insert(out.values.end(), magnitude.begin(), magnitude.end());
+    }});
+
+    /* Axes and signed zeros, where the quadrant comes from the signs alone: atan2(-0, x < 0) is -pi */
+    cases.push_back({"math_atan2_signs", 1e-6, false, [](uint32_t block, pdm_golden_output & out) {
+        FSP_PARAMETER_NOT_USED(block);
+
+        float const coords[] = {0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -2.0f};
+        for (float y : coords)
+        {
+            for (float x : coords)
+            {
+                out.values.push_back(pdm_math_atan2f(y, x));
+            }
+        }
+    }});
+
+    for (pdm_math_window_t window : {PDM_MATH_WINDOW_HANN, PDM_MATH_WINDOW_HAMMING, PDM_MATH_WINDOW_BLACKMAN})
+    {
+        char const * p_name = (PDM_MATH_WINDOW_HANN == window) ? "math_window_hann" :
+                              (PDM_MATH_WINDOW_HAMMING == window) ? "math_window_hamming" : "math_window_blackman";
+
+        cases.push_back({p_name, 1e-6, false, [window](uint32_t block, pdm_golden_output & out) {
+            FSP_PARAMETER_NOT_USED(block);
+
+            out.values.resize(PDM_GOLDEN_FLOAT_SAMPLES);
+            pdm_math_window(window, out.values.data(), PDM_GOLDEN_FLOAT_SAMPLES);
+        }});
+    }
+
+    return cases;
+}
+
+/***********************************************************************************************************************
+ * Golden file
+ **********************************************************************************************************************/
+
+/* Format: "exact <name> <words> <crc32>", or "float <name> <values> <tolerance>" and the values on the lines below */
+bool pdm_golden_load(char const * p_path, std::map<std::string, pdm_golden_entry> & entries)
+{
+    std::ifstream in(p_path);
+    if (!in)
+    {
+        fprintf(stderr, "cannot read %s\n", p_path);
+
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream words(line);
+        std::string        kind;
+        std::string        name;
+        pdm_golden_entry   entry;
+
+        if (!(words >> kind) || ('#' == kind[0]))
+        {
+            continue;
+        }
+
+        if (("exact" == kind) && (words >> name >> entry.count >> std::hex >> entry.crc))
+        {
+            entries[name] = entry;
+        }
+        else if (("float" == kind) && (words >> name >> entry.count))
+        {
+            float value;
+            while ((entry.values.size() < entry.count) && (in >> value))
+            {
+                entry.values.push_back(value);
+            }
+
+            if (entry.values.size() != entry.count)
+            {
+                fprintf(stderr, "%s: %s is cut short\n", p_path, name.c_str());
+
+                return false;
+            }
+
+            entries[name] = entry;
+        }
+        else
+        {
+            fprintf(stderr, "%s: cannot parse \"%s\"\n", p_path, line.c_str());
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool pdm_golden_save(char const * p_path, std::vector<pdm_golden_case> const & cases,
+                     std::vector<pdm_golden_output> const & outputs)
+{
+    FILE * p_out = fopen(p_path, "w");
+    if (NULL == p_out)
+    {
+        perror(p_path);
+
+        return false;
+    }
+
+    fprintf(p_out, "# pdm_golden format %u: written by pdm_golden -u, do not edit\n", PDM_GOLDEN_FORMAT_VERSION);
+    fprintf(p_out, "# exact <stage> <words> <crc32>\n# float <stage> <values> <tolerance>, then the values\n");
+
+    for (size_t c = 0U; c < cases.size(); c++)
+    {
+        pdm_golden_output const & out = outputs[c];
+
+        if (cases[c].tolerance < 0.0)
+        {
+            fprintf(p_out, "exact %s %zu %08x\n", cases[c].name.c_str(), out.words.size(), pdm_golden_crc(out.words));
+            continue;
+        }
+
+        fprintf(p_out, "float %s %zu %g\n", cases[c].name.c_str(), out.values.size(), cases[c].tolerance);
+        for (size_t i = 0U; i < out.values.size(); i++)
+        {
+            fprintf(p_out, "%.9g", (double) out.values[i]);
+            fputc(((7U == (i % 8U)) || ((i + 1U) == out.values.size())) ? '\n' : ' ', p_out);
+        }
+    }
+
+    return 0 == fclose(p_out);
+}
+
+/* First sample where two outputs of a stage differ beyond its tolerance; SIZE_MAX if none */
+size_t pdm_golden_diff(pdm_golden_case const & c, pdm_golden_output const & a, pdm_golden_output const & b)
+{
+    if (c.tolerance < 0.0)
+    {
+        size_t n = std::min(a.words.size(), b.words.size());
+        for (size_t i = 0U; i < n; i++)
+        {
+            if (a.words[i] != b.words[i])
+            {
+                return i;
+            }
+        }
+
+        return (a.words.size() == b.words.size()) ? SIZE_MAX : n;
+    }
+
+    size_t n = std::min(a.values.size(), b.values.size());
+    for (size_t i = 0U; i < n; i++)
+    {
+        if (!(std::fabs((double) a.values[i] - (double) b.values[i]) <= c.tolerance))
+        {
+            return i;
+        }
+    }
+
+    return (a.values.size() == b.values.size()) ? SIZE_MAX : n;
+}
+
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    bool         update  = false;
+    bool         verbose = false;
+    char const * p_path  = "pdm_golden.txt";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "-u"))
+        {
+            update = true;
+        }
+        else if (0 == strcmp(argv[i], "-v"))
+        {
+            verbose = true;
+        }
+        else if ('-' != argv[i][0])
+        {
+            p_path = argv[i];
+        }
+        else
+        {
+            pdm_golden_usage(argv[0]);
+
+            return 2;
+        }
+    }
+
+    std::map<std::string, pdm_golden_entry> golden;
+    if (!update && !pdm_golden_load(p_path, golden))
+    {
+        return 1;
+    }
+
+    pdm_golden_input();
+
+    std::vector<pdm_golden_case> const cases = pdm_golden_cases();
+    std::vector<pdm_golden_output>     outputs(cases.size());
+    uint32_t                           failed = 0U;
+
+    for (size_t c = 0U; c < cases.size(); c++)
+    {
+        pdm_golden_case const & stage = cases[c];
+        size_t                  sizes = stage.blocked ? (sizeof(g_block_sizes) / sizeof(g_block_sizes[0])) : 1U;
+        bool                    ok    = true;
+
+        /* Every block size against the first one */
+        stage.run(g_block_sizes[0], outputs[c]);
+        for (size_t s = 1U; s < sizes; s++)
+        {
+            pdm_golden_output out;
+            stage.run(g_block_sizes[s], out);
+
+            size_t at = pdm_golden_diff(stage, outputs[c], out);
+            if (SIZE_MAX != at)
+            {
+                printf("FAIL %-26s block %u differs from block %u at word %zu\n", stage.name.c_str(),
+                       g_block_sizes[s], g_block_sizes[0], at);
+                ok = false;
+            }
+            else if (verbose)
+            {
+                printf("     %-26s block %u matches block %u\n", stage.name.c_str(), g_block_sizes[s],
+                       g_block_sizes[0]);
+            }
+        }
+
+        pdm_golden_output const & out = outputs[c];
+        size_t const              n   = (stage.tolerance < 0.0) ? out.words.size() : out.values.size();
+
+        if (update)
+        {
+            /* Nothing to compare with */
+        }
+        else if (golden.end() == golden.find(stage.name))
+        {
+            printf("FAIL %-26s no golden vector\n", stage.name.c_str());
+            ok = false;
+        }
+        else if (stage.tolerance < 0.0)
+        {
+            pdm_golden_entry const & entry = golden[stage.name];
+            uint32_t                 crc   = pdm_golden_crc(out.words);
+            if ((entry.count != n) || (entry.crc != crc))
+            {
+                printf("FAIL %-26s %zu words, crc %08x; golden %u words, crc %08x\n", stage.name.c_str(), n, crc,
+                       entry.count, entry.crc);
+                ok = false;
+            }
+        }
+        else
+        {
+            pdm_golden_output reference;
+            reference.values = golden[stage.name].values;
+
+            double worst = 0.0;
+            for (size_t i = 0U; i < std::min(n, reference.values.size()); i++)
+            {
+                worst = std::max(worst, std::fabs((double) out.values[i] - (double) reference.values[i]));
+            }
+
+            size_t at = pdm_golden_diff(stage, reference, out);
+            if (SIZE_MAX != at)
+            {
+                printf("FAIL %-26s value %zu off by more than %g (largest error %g)\n", stage.name.c_str(), at,
+                       stage.tolerance, worst);
+                ok = false;
+            }
+            else if (verbose)
+            {
+                printf("     %-26s largest error %g, tolerance %g\n", stage.name.c_str(), worst, stage.tolerance);
+            }
+        }
+
+        if (ok)
+        {
+            printf("ok   %-26s %zu %s, %zu block size%s\n", stage.name.c_str(), n,
+                   (stage.tolerance < 0.0) ? "words" : "values", sizes, (1U == sizes) ? "" : "s");
+        }
+        else
+        {
+            failed++;
+        }
+    }
+
+    printf("%zu stages, %u failed\n", cases.size(), failed);
+
+    if (update)
+    {
+        if (0U != failed)
+        {
+            fprintf(stderr, "%s not written: outputs depend on the block size\n", p_path);
+
+            return 1;
+        }
+
+        return pdm_golden_save(p_path, cases, outputs) ? 0 : 1;
+    }
+
+    return (0U == failed) ? 0 : 1;
+}
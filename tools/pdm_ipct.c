@@ -0,0 +1,402 @@
+/**
+ * @file pdm_ipct.c
+ * @brief Host check of the inter-core block handoff (src/pdm_ipc.c) with a producer and a consumer thread
+ * @details The IPC semaphore and doorbell are emulated with atomics on host, so the ring protocol runs unchanged
+ *          between two threads. Checks, in order:
+ *          - stall: with the consumer not draining, the ring takes PDM_IPC_RING_SLOTS blocks and counts every later
+ *            one as dropped; once drained, the next block's sequence jumps by the drops
+ *          - wakeups: the work pending flag is set once per publish and cleared by one take; a doorbell is raised only
+ *            on the empty -> non-empty transition, and only once the consumer has attached
+ *          - stream: pdm_ipc_consumer_run on its own thread against a producer pushing bursts (which overrun the
+ *            ring) and pauses (which let it run empty). Every block must arrive once, in order, intact (length,
+ *            parameters and samples), the sequence gaps must add up to the drops, produced + dropped must equal the
+ *            pushes, and the ring must empty after the last push (no lost wakeup).
+ *
+ *          The consumer thread of the stream check never returns, like core 1, so that check runs last.
+ *
+ *          Usage: pdm_ipct [-n blocks] [-v]
+ *            -n  blocks pushed by the stream check (default 20000)
+ *            -v  print the counters of every check
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_ipc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_IPCT_BLOCKS           (20000U)
+#define PDM_IPCT_BURST_MAX        (3U * PDM_IPC_RING_SLOTS)  // Longest burst, long enough to overrun the ring
+#define PDM_IPCT_IDLE_TIMEOUT_S   (5U)                       // Longest wait for the consumer to empty the ring
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** What the consumer thread saw; written by that thread only */
+typedef struct st_pdm_ipct_seen
+{
+    volatile uint32_t blocks;          ///< Blocks handled
+    volatile uint32_t gaps;            ///< Blocks missing between them, by sequence
+    volatile uint32_t order;           ///< Blocks with a sequence not above the previous one
+    volatile uint32_t corrupt;         ///< Blocks with a wrong length, parameter or sample
+    uint32_t          next;            ///< Sequence expected next
+} pdm_ipct_seen_t;
+
+/** Producer thread */
+typedef struct st_pdm_ipct_producer
+{
+    pdm_ipc_ring_t * p_ring;
+    uint32_t         blocks;
+    uint32_t         published;        ///< Pushes that returned FSP_SUCCESS
+    uint32_t         full;             ///< Pushes that returned FSP_ERR_QUEUE_FULL
+} pdm_ipct_producer_t;
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static pdm_ipc_ring_t g_pdm_ipct_ring;
+static uint32_t       g_pdm_ipct_checks = 0U;
+static uint32_t       g_pdm_ipct_failed = 0U;
+static bool           g_pdm_ipct_verbose = false;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_ipct_usage(char const * p_name)
+{
+    fprintf(stderr, "usage: %s [-n blocks] [-v]\n", p_name);
+}
+
+static void pdm_ipct_check(bool ok, char const * p_what, uint32_t value, uint32_t expected)
+{
+    g_pdm_ipct_checks++;
+
+    if (!ok)
+    {
+        g_pdm_ipct_failed++;
+    }
+
+    if (!ok || g_pdm_ipct_verbose)
+    {
+        printf("  %s %s: %u (expected %u)\n", ok ? "ok  " : "FAIL", p_what, value, expected);
+    }
+}
+
+static void pdm_ipct_equal(char const * p_what, uint32_t value, uint32_t expected)
+{
+    pdm_ipct_check(value == expected, p_what, value, expected);
+}
+
+/* Content of a block is a function of its sequence, so the consumer can check it without sharing state */
+static uint32_t pdm_ipct_length(uint32_t sequence)
+{
+    return 1U + ((sequence * 37U) % PDM_IPC_BLOCK_SAMPLES);
+}
+
+static uint32_t pdm_ipct_word(uint32_t sequence, uint32_t index)
+{
+    uint32_t x = (sequence * 0x9E3779B9U) ^ (index * 0x85EBCA6BU);
+
+    return x ^ (x >> 15);
+}
+
+static fsp_err_t pdm_ipct_push(pdm_ipc_ring_t * p_ring, uint32_t sequence)
+{
+    uint32_t samples[PDM_IPC_BLOCK_SAMPLES];
+    uint32_t args[PDM_IPC_BLOCK_ARGS];
+    uint32_t count = pdm_ipct_length(sequence);
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        samples[i] = pdm_ipct_word(sequence, i);
+    }
+
+    for (uint32_t i = 0U; i < PDM_IPC_BLOCK_ARGS; i++)
+    {
+        args[i] = ~pdm_ipct_word(sequence, i);
+    }
+
+    return pdm_ipc_push(p_ring, samples, count, args);
+}
+
+static bool pdm_ipct_intact(pdm_ipc_block_t const * p_block)
+{
+    uint32_t sequence = p_block->sequence;
+
+    if (pdm_ipct_length(sequence) != p_block->sample_count)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < PDM_IPC_BLOCK_ARGS; i++)
+    {
+        if (~pdm_ipct_word(sequence, i) != p_block->args[i])
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0U; i < p_block->sample_count; i++)
+    {
+        if (pdm_ipct_word(sequence, i) != p_block->samples[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Consumer handler: order, gaps and content of every block */
+static void pdm_ipct_handler(pdm_ipc_block_t const * p_block, void * p_context)
+{
+    pdm_ipct_seen_t * p_seen = (pdm_ipct_seen_t *) p_context;
+
+    if (p_block->sequence < p_seen->next)
+    {
+        p_seen->order = p_seen->order + 1U;
+    }
+    else
+    {
+        p_seen->gaps = p_seen->gaps + (p_block->sequence - p_seen->next);
+        p_seen->next = p_block->sequence + 1U;
+    }
+
+    if (!pdm_ipct_intact(p_block))
+    {
+        p_seen->corrupt = p_seen->corrupt + 1U;
+    }
+
+    pdm_port_memory_barrier();
+    p_seen->blocks = p_seen->blocks + 1U;
+}
+
+/* Wait for the consumer thread to empty the ring; false after PDM_IPCT_IDLE_TIMEOUT_S */
+static bool pdm_ipct_wait_idle(pdm_ipc_ring_t const * p_ring)
+{
+    for (uint32_t s = 0U; s < PDM_IPCT_IDLE_TIMEOUT_S; s++)
+    {
+        uint32_t start = pdm_port_cycles();
+
+        while ((pdm_port_cycles() - start) < pdm_port_cycles_per_second())
+        {
+            if (pdm_ipc_idle(p_ring))
+            {
+                return true;
+            }
+
+            sched_yield();
+        }
+    }
+
+    return false;
+}
+
+static void pdm_ipct_stall(void)
+{
+    pdm_ipc_ring_t * p_ring = &g_pdm_ipct_ring;
+    pdm_ipct_seen_t  seen   = {0};
+    uint32_t const   extra  = 5U;
+    uint32_t         full   = 0U;
+    pdm_ipc_stats_t  stats;
+
+    printf("stall\n");
+    (void) pdm_ipc_producer_open(p_ring, NULL);
+
+    for (uint32_t s = 0U; s < (PDM_IPC_RING_SLOTS + extra); s++)
+    {
+        full += (FSP_ERR_QUEUE_FULL == pdm_ipct_push(p_ring, s)) ? 1U : 0U;
+    }
+
+    pdm_ipc_stats_get(p_ring, &stats);
+    pdm_ipct_equal("published while stalled", stats.produced, PDM_IPC_RING_SLOTS);
+    pdm_ipct_equal("dropped while stalled", stats.dropped, extra);
+    pdm_ipct_equal("pushes refused", full, extra);
+
+    pdm_ipct_equal("blocks drained", pdm_ipc_drain(p_ring, pdm_ipct_handler, &seen), PDM_IPC_RING_SLOTS);
+    pdm_ipct_equal("gaps before the drops", seen.gaps, 0U);
+    pdm_ipct_equal("corrupt blocks", seen.corrupt, 0U);
+
+    /* The first block after the overrun carries the sequence of a ring that never dropped */
+    pdm_ipct_equal("push after draining", (uint32_t) pdm_ipct_push(p_ring, PDM_IPC_RING_SLOTS + extra), FSP_SUCCESS);
+    pdm_ipct_equal("blocks drained after it", pdm_ipc_drain(p_ring, pdm_ipct_handler, &seen), 1U);
+    pdm_ipct_equal("sequence gap", seen.gaps, extra);
+    pdm_ipct_equal("out of order", seen.order, 0U);
+    pdm_ipct_equal("corrupt blocks", seen.corrupt, 0U);
+
+    pdm_ipc_stats_get(p_ring, &stats);
+    pdm_ipct_equal("produced + dropped", stats.produced + stats.dropped, PDM_IPC_RING_SLOTS + extra + 1U);
+    pdm_ipct_equal("consumed", stats.consumed, stats.produced);
+}
+
+static void pdm_ipct_wakeups(void)
+{
+    pdm_ipc_ring_t * p_ring = &g_pdm_ipct_ring;
+    pdm_ipct_seen_t  seen   = {0};
+    pdm_ipc_stats_t  stats;
+
+    printf("wakeups\n");
+    (void) pdm_ipc_producer_open(p_ring, &seen);
+    pdm_ipct_equal("pending after open", pdm_ipc_work_pending(p_ring), false);
+
+    /* No doorbell before the consumer attaches, but the work is flagged */
+    (void) pdm_ipct_push(p_ring, 0U);
+    pdm_ipc_stats_get(p_ring, &stats);
+    pdm_ipct_equal("doorbells before attach", stats.doorbells, 0U);
+    pdm_ipct_equal("shared object", pdm_ipc_shared_get(p_ring) == &seen, true);
+    pdm_ipct_equal("attach", (uint32_t) pdm_ipc_consumer_attach(p_ring), FSP_SUCCESS);
+    pdm_ipct_equal("pending after a push", pdm_ipc_work_pending(p_ring), true);
+    pdm_ipct_equal("pending after the take", pdm_ipc_work_pending(p_ring), false);
+    (void) pdm_ipc_drain(p_ring, pdm_ipct_handler, &seen);
+
+    /* Empty -> non-empty rings once; pushes onto a non-empty ring do not */
+    (void) pdm_ipct_push(p_ring, 1U);
+    (void) pdm_ipct_push(p_ring, 2U);
+    (void) pdm_ipct_push(p_ring, 3U);
+    pdm_ipc_stats_get(p_ring, &stats);
+    pdm_ipct_equal("doorbells for a burst", stats.doorbells, 1U);
+    pdm_ipct_equal("pending after a burst", pdm_ipc_work_pending(p_ring), true);
+    pdm_ipct_equal("blocks drained", pdm_ipc_drain(p_ring, pdm_ipct_handler, &seen), 3U);
+    pdm_ipct_equal("idle after draining", pdm_ipc_idle(p_ring), true);
+
+    (void) pdm_ipct_push(p_ring, 4U);
+    pdm_ipc_stats_get(p_ring, &stats);
+    pdm_ipct_equal("doorbells after running empty", stats.doorbells, 2U);
+    pdm_ipct_equal("idle with a block queued", pdm_ipc_idle(p_ring), false);
+    (void) pdm_ipc_drain(p_ring, pdm_ipct_handler, &seen);
+
+    pdm_ipct_equal("blocks seen", seen.blocks, 5U);
+    pdm_ipct_equal("out of order", seen.order, 0U);
+    pdm_ipct_equal("corrupt blocks", seen.corrupt, 0U);
+}
+
+static void * pdm_ipct_consumer_thread(void * p_context)
+{
+    pdm_ipc_consumer_run(&g_pdm_ipct_ring, pdm_ipct_handler, p_context);
+
+    return NULL;
+}
+
+static void * pdm_ipct_producer_thread(void * p_context)
+{
+    pdm_ipct_producer_t * p_producer = (pdm_ipct_producer_t *) p_context;
+    uint32_t              seed       = 0x2545F491U;
+    uint32_t              sequence   = 0U;
+
+    while (sequence < p_producer->blocks)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        uint32_t burst = 1U + ((seed >> 8) % PDM_IPCT_BURST_MAX);
+
+        for (uint32_t i = 0U; (i < burst) && (sequence < p_producer->blocks); i++, sequence++)
+        {
+            if (FSP_SUCCESS == pdm_ipct_push(p_producer->p_ring, sequence))
+            {
+                p_producer->published++;
+            }
+            else
+            {
+                p_producer->full++;
+            }
+        }
+
+        /* Every other pause lets the consumer run the ring empty, so the next burst needs a wake-up */
+        if (0U != (seed & 0x10000U))
+        {
+            while (!pdm_ipc_idle(p_producer->p_ring))
+            {
+                sched_yield();
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void pdm_ipct_stream(uint32_t blocks)
+{
+    static pdm_ipct_seen_t seen;
+    pdm_ipct_producer_t    producer = {&g_pdm_ipct_ring, blocks, 0U, 0U};
+    pthread_t              consumer_thread;
+    pthread_t              producer_thread;
+    pdm_ipc_stats_t        stats;
+
+    printf("stream: %u blocks\n", blocks);
+    (void) pdm_ipc_producer_open(&g_pdm_ipct_ring, NULL);
+
+    if ((0 != pthread_create(&consumer_thread, NULL, pdm_ipct_consumer_thread, &seen)) ||
+        (0 != pthread_create(&producer_thread, NULL, pdm_ipct_producer_thread, &producer)))
+    {
+        fprintf(stderr, "cannot start the threads\n");
+        exit(2);
+    }
+
+    (void) pthread_detach(consumer_thread);
+    (void) pthread_join(producer_thread, NULL);
+
+    bool idle = pdm_ipct_wait_idle(&g_pdm_ipct_ring);
+    pdm_port_memory_barrier();
+    pdm_ipc_stats_get(&g_pdm_ipct_ring, &stats);
+
+    pdm_ipct_equal("ring empty after the last push", idle, true);
+    pdm_ipct_equal("produced + dropped", stats.produced + stats.dropped, blocks);
+    pdm_ipct_equal("produced", stats.produced, producer.published);
+    pdm_ipct_equal("dropped", stats.dropped, producer.full);
+    pdm_ipct_equal("consumed", stats.consumed, stats.produced);
+    pdm_ipct_equal("blocks seen", seen.blocks, stats.consumed);
+    pdm_ipct_equal("sequence gaps", seen.gaps + (blocks - seen.next), stats.dropped);
+    pdm_ipct_equal("out of order", seen.order, 0U);
+    pdm_ipct_equal("corrupt blocks", seen.corrupt, 0U);
+    pdm_ipct_check((stats.doorbells > 0U) && (stats.doorbells <= stats.produced), "doorbells", stats.doorbells,
+                   stats.produced);
+
+    printf("  %u produced, %u dropped, %u consumed, %u doorbells\n", stats.produced, stats.dropped, stats.consumed,
+           stats.doorbells);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    uint32_t blocks = PDM_IPCT_BLOCKS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "-n")) && ((i + 1) < argc))
+        {
+            blocks = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if (0 == strcmp(argv[i], "-v"))
+        {
+            g_pdm_ipct_verbose = true;
+        }
+        else
+        {
+            pdm_ipct_usage(argv[0]);
+
+            return 2;
+        }
+    }
+
+    pdm_ipct_stall();
+    pdm_ipct_wakeups();
+    pdm_ipct_stream(blocks);
+
+    printf("%u checks, %u failed\n", g_pdm_ipct_checks, g_pdm_ipct_failed);
+
+    /* The consumer thread is still waiting for work; exit() ends it */
+    return (0U == g_pdm_ipct_failed) ? 0 : 1;
+}
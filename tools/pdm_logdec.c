@@ -0,0 +1,229 @@
+/**
+ * @file pdm_logdec.c
+ * @brief Host decoder for the binary log records written by src/pdm_log.c
+ * @details Reads the raw bytes of the log RTT channel (for example captured with
+ *          `JLinkRTTLogger -RTTChannel 2 log.bin`) from a file or stdin and prints the expanded text. The string
+ *          table is built from src/pdm_log_ids.h at compile time, so rebuild the decoder whenever that file changes.
+ *
+ *          Usage: pdm_logdec [-t hz] [file]
+ *            -t hz  prefix each record with its timestamp in seconds, hz being the target core clock
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+#define PDM_LOGDEC_PRV_FORMAT(id, format)    [id] = format,
+
+static char const * const g_formats[PDM_LOG_ID_COUNT] =
+{
+    PDM_LOG_MESSAGES(PDM_LOGDEC_PRV_FORMAT)
+};
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static uint32_t pdm_logdec_u32(uint8_t const * p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* printf-like expansion with one 32-bit argument per conversion; stops at the first conversion without argument,
+ * still ending the line if the format does */
+static void pdm_logdec_print(FILE * p_out, char const * p_format, uint32_t const * p_args, uint32_t nargs)
+{
+    uint32_t arg = 0U;
+
+    while ('\0' != *p_format)
+    {
+        if ('%' != *p_format)
+        {
+            fputc(*p_format++, p_out);
+            continue;
+        }
+
+        if ('%' == p_format[1])
+        {
+            fputc('%', p_out);
+            p_format += 2;
+            continue;
+        }
+
+        /* Collect flags and width, drop length modifiers: every argument is 32 bits */
+        char   spec[16] = "%";
+        size_t len      = 1U;
+        p_format++;
+        while ((NULL != strchr("-+ #0123456789", *p_format)) && ('\0' != *p_format) && (len < (sizeof(spec) - 3U)))
+        {
+            spec[len++] = *p_format++;
+        }
+
+        while (('l' == *p_format) || ('h' == *p_format))
+        {
+            p_format++;
+        }
+
+        char conversion = *p_format;
+        if ('\0' == conversion)
+        {
+            break;
+        }
+
+        p_format++;
+
+        if (arg >= nargs)
+        {
+            size_t const rest = strlen(p_format);
+            if ((rest > 0U) && ('\n' == p_format[rest - 1U]))
+            {
+                fputc('\n', p_out);
+            }
+
+            return;
+        }
+
+        spec[len++] = conversion;
+        spec[len]   = '\0';
+
+        switch (conversion)
+        {
+            case 'd':
+            case 'i':
+            {
+                fprintf(p_out, spec, (int) (int32_t) p_args[arg]);
+                break;
+            }
+
+            case 'c':
+            {
+                fprintf(p_out, spec, (int) (p_args[arg] & 0xFFU));
+                break;
+            }
+
+            default:
+            {
+                fprintf(p_out, spec, (unsigned int) p_args[arg]);
+                break;
+            }
+        }
+
+        arg++;
+    }
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    double clock_hz = 0.0;
+    FILE * p_in     = stdin;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "-t")) && ((i + 1) < argc))
+        {
+            clock_hz = strtod(argv[++i], NULL);
+        }
+        else if ('-' == argv[i][0])
+        {
+            fprintf(stderr, "usage: %s [-t core_clock_hz] [file]\n", argv[0]);
+
+            return 2;
+        }
+        else
+        {
+            p_in = fopen(argv[i], "rb");
+            if (NULL == p_in)
+            {
+                perror(argv[i]);
+
+                return 1;
+            }
+        }
+    }
+
+    uint8_t  word[4];
+    uint32_t args[PDM_LOG_MAX_ARGS];
+    uint32_t resyncs = 0U;
+
+    /* Records are written whole or not at all, so the stream stays aligned; resync only on corrupt input */
+    int c;
+    while (EOF != (c = fgetc(p_in)))
+    {
+        if (PDM_LOG_SYNC != (uint32_t) c)
+        {
+            resyncs++;
+            continue;
+        }
+
+        word[0] = (uint8_t) c;
+        if (3U != fread(&word[1], 1U, 3U, p_in))
+        {
+            break;
+        }
+
+        uint32_t header = pdm_logdec_u32(word);
+        uint32_t nargs  = (header >> 8) & 0xFFU;
+        uint32_t id     = header >> 16;
+
+        if ((nargs > PDM_LOG_MAX_ARGS) || (id >= PDM_LOG_ID_COUNT))
+        {
+            resyncs++;
+            continue;
+        }
+
+        if (1U != fread(word, sizeof(word), 1U, p_in))
+        {
+            break;
+        }
+
+        uint32_t timestamp = pdm_logdec_u32(word);
+        bool     complete  = true;
+
+        for (uint32_t i = 0U; i < nargs; i++)
+        {
+            if (1U != fread(word, sizeof(word), 1U, p_in))
+            {
+                complete = false;
+                break;
+            }
+
+            args[i] = pdm_logdec_u32(word);
+        }
+
+        if (!complete)
+        {
+            break;
+        }
+
+        if (clock_hz > 0.0)
+        {
+            printf("[%12.6f] ", (double) timestamp / clock_hz);
+        }
+
+        pdm_logdec_print(stdout, g_formats[id], args, nargs);
+    }
+
+    if (0U != resyncs)
+    {
+        fprintf(stderr, "pdm_logdec: skipped %u bytes of unrecognized data\n", resyncs);
+    }
+
+    if (stdin != p_in)
+    {
+        fclose(p_in);
+    }
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file pdm_lufs.c
+ * @brief Host conformance check of the loudness meter (src/pdm_loudness.c)
+ * @details Runs the meter over synthetic reference signals and compares its readings with the expected values:
+ *          - the K-weighting coefficients at 48 kHz against BS.1770-4 Tables 1 and 2
+ *          - the EBU Tech 3341 minimum requirement signals 1 to 5 (1 kHz tones, steady and in gated sequences):
+ *            momentary, short-term and integrated loudness within +-0.1 LU
+ *          - true peak of tones at fs/4 and fs/6 sampled off their peaks, within +0.2/-0.4 dB
+ *
+ *          Tech 3341 specifies stereo signals; the meter is mono with a front channel weight, so every tone is played
+ *          3.01 dB hotter (the sum of two equal channels) to read the stereo value. Signals fade in over 20 ms, so the
+ *          ringing of an abrupt onset does not count as a peak. Every signal is metered at each rate in a list that
+ *          includes the PDM rate, in calls of pseudo-random length (1 to 2048 samples) as data callbacks would deliver
+ *          them. The cost of the meter is reported in ns per sample and as a share of real time.
+ *
+ *          Usage: pdm_lufs [-r rate_hz] [-v]
+ *            -r  meter at this rate only
+ *            -v  print every reading, not only failures
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_loudness.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_LUFS_FULL_SCALE       (524288.0)         // 20-bit samples
+#define PDM_LUFS_MAX_TONES        (5U)
+#define PDM_LUFS_MAX_CALL         (2048U)
+#define PDM_LUFS_STEREO_DB        (3.0103)           // A mono tone this much hotter reads as the stereo one
+#define PDM_LUFS_PI               (3.14159265358979323846)
+#define PDM_LUFS_FADE_S           (0.02)             // Raised-cosine fade-in: an abrupt onset rings in the interpolator
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** One tone of a signal; frequency_hz 0 with divisor n means fs / n */
+typedef struct st_pdm_lufs_tone
+{
+    double   frequency_hz;
+    uint32_t divisor;
+    double   level_db;                 ///< Peak level, dBFS
+    double   phase_deg;                ///< Phase of the first sample
+    double   seconds;
+} pdm_lufs_tone_t;
+
+/** Reading checked after a signal */
+typedef enum e_pdm_lufs_reading
+{
+    PDM_LUFS_MOMENTARY,
+    PDM_LUFS_SHORT_TERM,
+    PDM_LUFS_INTEGRATED,
+    PDM_LUFS_TRUE_PEAK,
+} pdm_lufs_reading_t;
+
+typedef struct st_pdm_lufs_check
+{
+    pdm_lufs_reading_t reading;
+    double             expected;
+    double             below;          ///< Tolerance under the expected value
+    double             above;          ///< Tolerance over it
+} pdm_lufs_check_t;
+
+typedef struct st_pdm_lufs_case
+{
+    char const       * p_name;
+    bool               stereo;         ///< Tone levels are per channel of a stereo signal
+    pdm_lufs_tone_t    tones[PDM_LUFS_MAX_TONES];
+    pdm_lufs_check_t   checks[3];
+    uint32_t           check_count;
+} pdm_lufs_case_t;
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static char const * const g_pdm_lufs_readings[] = {"momentary", "short-term", "integrated", "true peak"};
+
+static uint32_t const g_pdm_lufs_rates[] = {48000U, 44100U, 32258U, 16000U};
+
+#define PDM_LUFS_LU(r, v)    {(r), (v), 0.1, 0.1}
+#define PDM_LUFS_TP(v)       {PDM_LUFS_TRUE_PEAK, (v), 0.4, 0.2}
+
+static pdm_lufs_case_t const g_pdm_lufs_cases[] =
+{
+    {"3341-1 1 kHz -23 dBFS 20 s", true, {{1000.0, 0U, -23.0, 0.0, 20.0}},
+     {PDM_LUFS_LU(PDM_LUFS_MOMENTARY, -23.0), PDM_LUFS_LU(PDM_LUFS_SHORT_TERM, -23.0),
+      PDM_LUFS_LU(PDM_LUFS_INTEGRATED, -23.0)}, 3U},
+    {"3341-2 1 kHz -33 dBFS 20 s", true, {{1000.0, 0U, -33.0, 0.0, 20.0}},
+     {PDM_LUFS_LU(PDM_LUFS_MOMENTARY, -33.0), PDM_LUFS_LU(PDM_LUFS_SHORT_TERM, -33.0),
+      PDM_LUFS_LU(PDM_LUFS_INTEGRATED, -33.0)}, 3U},
+    {"3341-3 -36/-23/-36 dBFS", true,
+     {{1000.0, 0U, -36.0, 0.0, 10.0}, {1000.0, 0U, -23.0, 0.0, 60.0}, {1000.0, 0U, -36.0, 0.0, 10.0}},
+     {PDM_LUFS_LU(PDM_LUFS_INTEGRATED, -23.0)}, 1U},
+    {"3341-4 -72/-36/-23/-36/-72 dBFS", true,
+     {{1000.0, 0U, -72.0, 0.0, 10.0}, {1000.0, 0U, -36.0, 0.0, 10.0}, {1000.0, 0U, -23.0, 0.0, 60.0},
+      {1000.0, 0U, -36.0, 0.0, 10.0}, {1000.0, 0U, -72.0, 0.0, 10.0}},
+     {PDM_LUFS_LU(PDM_LUFS_INTEGRATED, -23.0)}, 1U},
+    {"3341-5 -26/-20/-26 dBFS", true,
+     {{1000.0, 0U, -26.0, 0.0, 20.0}, {1000.0, 0U, -20.0, 0.0, 20.1}, {1000.0, 0U, -26.0, 0.0, 20.0}},
+     {PDM_LUFS_LU(PDM_LUFS_INTEGRATED, -23.0)}, 1U},
+    {"true peak fs/4 -6 dBFS, sampled on peak", false, {{0.0, 4U, -6.0, 90.0, 1.0}}, {PDM_LUFS_TP(-6.0)}, 1U},
+    {"true peak fs/4 -6 dBFS, 45 deg off", false, {{0.0, 4U, -6.0, 45.0, 1.0}}, {PDM_LUFS_TP(-6.0)}, 1U},
+    {"true peak fs/6 -1 dBFS, sampled on peak", false, {{0.0, 6U, -1.0, 30.0, 1.0}}, {PDM_LUFS_TP(-1.0)}, 1U},
+    {"true peak fs/6 -1 dBFS, 30 deg off", false, {{0.0, 6U, -1.0, 0.0, 1.0}}, {PDM_LUFS_TP(-1.0)}, 1U},
+};
+
+static uint32_t g_pdm_lufs_seed = 0x9E3779B9U;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_lufs_usage(char const * p_name)
+{
+    fprintf(stderr, "usage: %s [-r rate_hz] [-v]\n", p_name);
+}
+
+static uint32_t pdm_lufs_call_length(void)
+{
+    g_pdm_lufs_seed = (g_pdm_lufs_seed * 1664525U) + 1013904223U;
+
+    return 1U + ((g_pdm_lufs_seed >> 8) % PDM_LUFS_MAX_CALL);
+}
+
+static double pdm_lufs_reading(pdm_loudness_result_t const * p_result, pdm_lufs_reading_t reading)
+{
+    switch (reading)
+    {
+        case PDM_LUFS_MOMENTARY:
+        {
+            return (double) p_result->momentary;
+        }
+
+        case PDM_LUFS_SHORT_TERM:
+        {
+            return (double) p_result->short_term;
+        }
+
+        case PDM_LUFS_INTEGRATED:
+        {
+            return (double) p_result->integrated;
+        }
+
+        case PDM_LUFS_TRUE_PEAK:
+        default:
+        {
+            return (double) p_result->true_peak;
+        }
+    }
+}
+
+/* Meter one signal; returns the failed checks, adds the time spent in the meter */
+static uint32_t pdm_lufs_run(pdm_lufs_case_t const * p_case, uint32_t rate_hz, bool verbose, uint64_t * p_ns,
+                             uint64_t * p_samples)
+{
+    pdm_loudness_ctrl_t *    p_meter = malloc(sizeof(*p_meter));
+    pdm_loudness_cfg_t const cfg     = {.rate_hz = rate_hz, .scale = (float) (1.0 / PDM_LUFS_FULL_SCALE)};
+    int32_t                  block[PDM_LUFS_MAX_CALL];
+    uint32_t                 fill    = 0U;
+
+    if ((NULL == p_meter) || (FSP_SUCCESS != pdm_loudness_open(p_meter, &cfg)))
+    {
+        fprintf(stderr, "cannot open the meter at %u Hz\n", rate_hz);
+        free(p_meter);
+
+        return 1U;
+    }
+
+    uint32_t call = pdm_lufs_call_length();
+    for (uint32_t tone = 0U; (tone < PDM_LUFS_MAX_TONES) && (p_case->tones[tone].seconds > 0.0); tone++)
+    {
+        pdm_lufs_tone_t const * p_tone    = &p_case->tones[tone];
+        double                  frequency = (0U != p_tone->divisor) ? ((double) rate_hz / p_tone->divisor) :
+                                            p_tone->frequency_hz;
+        double                  level     = p_tone->level_db + (p_case->stereo ? PDM_LUFS_STEREO_DB : 0.0);
+        double                  amplitude = pow(10.0, level / 20.0) * PDM_LUFS_FULL_SCALE;
+        uint64_t                count     = (uint64_t) llround(p_tone->seconds * rate_hz);
+
+        for (uint64_t n = 0U; n < count; n++)
+        {
+            double t = (double) n / rate_hz;
+            double x = amplitude * sin((2.0 * PDM_LUFS_PI * frequency * t) + (p_tone->phase_deg * PDM_LUFS_PI / 180.0));
+            if ((0U == tone) && (t < PDM_LUFS_FADE_S))
+            {
+                x *= 0.5 - (0.5 * cos(PDM_LUFS_PI * t / PDM_LUFS_FADE_S));
+            }
+
+            int64_t q = llround(x);
+            q = (q > 524287) ? 524287 : q;
+            q = (q < -524288) ? -524288 : q;
+
+            block[fill++] = (int32_t) q;
+            if (fill == call)
+            {
+                uint32_t start = pdm_port_cycles();
+                (void) pdm_loudness_process(p_meter, block, fill);
+                *p_ns      += pdm_port_cycles() - start;
+                *p_samples += fill;
+                fill        = 0U;
+                call        = pdm_lufs_call_length();
+            }
+        }
+    }
+
+    (void) pdm_loudness_process(p_meter, block, fill);
+    *p_samples += fill;
+
+    pdm_loudness_result_t result;
+    pdm_loudness_get(p_meter, &result);
+    free(p_meter);
+
+    uint32_t failed = 0U;
+    for (uint32_t c = 0U; c < p_case->check_count; c++)
+    {
+        pdm_lufs_check_t const * p_check = &p_case->checks[c];
+        double                   value   = pdm_lufs_reading(&result, p_check->reading);
+        bool                     ok      = (value >= (p_check->expected - p_check->below)) &&
+                                           (value <= (p_check->expected + p_check->above));
+
+        if (!ok || verbose)
+        {
+            printf("%-4s %-40s %6u Hz  %-10s %8.2f, expected %6.1f (-%.1f/+%.1f)\n", ok ? "ok" : "FAIL",
+                   p_case->p_name, rate_hz, g_pdm_lufs_readings[p_check->reading], value, p_check->expected,
+                   p_check->below, p_check->above);
+        }
+
+        failed += ok ? 0U : 1U;
+    }
+
+    return failed;
+}
+
+/* K-weighting at 48 kHz against BS.1770-4 Tables 1 and 2 */
+static uint32_t pdm_lufs_coefficients(bool verbose)
+{
+    static double const expected[2][5] =
+    {
+        {1.53512485958697, -2.69169618940638, 1.19839281085285, -1.69065929318241, 0.73248077421585},
+        {1.0, -2.0, 1.0, -1.99004745483398, 0.99007225036621},
+    };
+
+    pdm_loudness_ctrl_t *    p_meter = malloc(sizeof(*p_meter));
+    pdm_loudness_cfg_t const cfg     = {.rate_hz = 48000U, .scale = 1.0f};
+    uint32_t                 failed  = 0U;
+
+    if ((NULL == p_meter) || (FSP_SUCCESS != pdm_loudness_open(p_meter, &cfg)))
+    {
+        free(p_meter);
+
+        return 1U;
+    }
+
+    for (uint32_t s = 0U; s < 2U; s++)
+    {
+        pdm_dsp_biquad_coeffs_t const * p_c = &p_meter->k_weighting.coeffs[s];
+        double const actual[5] = {p_c->b0, p_c->b1, p_c->b2, p_c->a1, p_c->a2};
+        double       worst     = 0.0;
+
+        for (uint32_t i = 0U; i < 5U; i++)
+        {
+            worst = fmax(worst, fabs(actual[i] - expected[s][i]));
+        }
+
+        bool ok = (worst < 1e-5);
+        if (!ok || verbose)
+        {
+            printf("%-4s K-weighting stage %u at 48 kHz: largest coefficient error %.2e\n", ok ? "ok" : "FAIL",
+                   s + 1U, worst);
+        }
+
+        failed += ok ? 0U : 1U;
+    }
+
+    free(p_meter);
+
+    return failed;
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    uint32_t only    = 0U;
+    bool     verbose = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "-r")) && ((i + 1) < argc))
+        {
+            only = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if (0 == strcmp(argv[i], "-v"))
+        {
+            verbose = true;
+        }
+        else
+        {
+            pdm_lufs_usage(argv[0]);
+
+            return 2;
+        }
+    }
+
+    uint32_t failed = pdm_lufs_coefficients(verbose);
+    uint32_t checks = 2U;
+
+    for (uint32_t r = 0U; r < (sizeof(g_pdm_lufs_rates) / sizeof(g_pdm_lufs_rates[0])); r++)
+    {
+        uint32_t rate    = (0U != only) ? only : g_pdm_lufs_rates[r];
+        uint64_t ns      = 0U;
+        uint64_t samples = 0U;
+
+        for (uint32_t c = 0U; c < (sizeof(g_pdm_lufs_cases) / sizeof(g_pdm_lufs_cases[0])); c++)
+        {
+            failed += pdm_lufs_run(&g_pdm_lufs_cases[c], rate, verbose, &ns, &samples);
+            checks += g_pdm_lufs_cases[c].check_count;
+        }
+
+        double ns_per_sample = (double) ns / (double) samples;
+        printf("%6u Hz: meter %.1f ns per sample, %.3f %% of real time\n", rate, ns_per_sample,
+               ns_per_sample * rate / 1e7);
+
+        if (0U != only)
+        {
+            break;
+        }
+    }
+
+    printf("%u checks, %u failed\n", checks, failed);
+
+    return (0U == failed) ? 0 : 1;
+}
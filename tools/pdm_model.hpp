@@ -0,0 +1,569 @@
+/**
+ * @file pdm_model.hpp
+ * @brief Host model of the PDM filter chain: fixed-point simulation and analytic response of a register set
+ * @details Shared by the host tools that design or check filter sets. The chain as modelled:
+ *
+ *          PDM bits (+-1) -> sinc (order N, decimation R) -> >> SINCRNG -> compensation FIR (11 taps)
+ *                         -> half-band LPF (39 taps, decimation 2) -> first-order HPF -> 20-bit PCM
+ *
+ *          Register formats (pdm_extended_cfg_t):
+ *          - compensation h and LPF h0/h1: 13-bit two's complement, Q11 (0x0800 = 1.0)
+ *          - LPF h1: the odd taps, outermost first; the even taps other than h0 are zero (half-band)
+ *          - HPF s0, k1, h[2]: 16-bit two's complement, Q14; y = s0 * (h0 x + h1 x[-1]) + k1 y[-1]
+ *          - SINCRNG: right shift of the sinc output; the configurator picks the smallest one that brings the sinc's
+ *            full scale R^N into 16 bits (62, order 4 -> 9)
+ *          - the stage input shifts are plain arithmetic right shifts
+ *
+ *          Products are accumulated at full precision, rounded to the nearest integer at the stage output and
+ *          saturated to 20 bits. The hardware's rounding is not documented, so results can differ from the device in
+ *          the last bit; the analytic response is exact for the quantized coefficients.
+ */
+
+#ifndef PDM_MODEL_HPP
+#define PDM_MODEL_HPP
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace pdm_model
+{
+
+/***********************************************************************************************************************
+ * Constants
+ **********************************************************************************************************************/
+
+constexpr unsigned comp_taps  = 11U;
+constexpr unsigned lpf_h1     = 20U;
+constexpr unsigned lpf_taps   = (2U * lpf_h1) - 1U;
+constexpr int      fir_q      = 11;            ///< Compensation and LPF coefficient fraction bits
+constexpr int      hpf_q      = 14;            ///< HPF coefficient fraction bits
+constexpr int      sinc_bits  = 16;            ///< Signed width the sinc output is ranged into
+constexpr int      pcm_bits   = 20;            ///< Width of the data path and of the PCM output
+
+constexpr double   pi         = 3.14159265358979323846;
+
+/***********************************************************************************************************************
+ * Types
+ **********************************************************************************************************************/
+
+/** Filter fields of pdm_extended_cfg_t, in register format */
+struct filters
+{
+    unsigned                          sinc_order = 4U;
+    unsigned                          sincdec    = 62U;
+    unsigned                          sincrng    = 9U;
+    unsigned                          comp_shift = 0U;
+    unsigned                          lpf_shift  = 0U;
+    unsigned                          hpf_shift  = 0U;
+    std::array<uint16_t, comp_taps>   comp       = {};
+    uint16_t                          lpf_h0     = 0x0400U;
+    std::array<uint16_t, lpf_h1>      lpf        = {};
+    uint16_t                          hpf_s0     = 0x4000U;
+    uint16_t                          hpf_k1     = 0U;
+    std::array<uint16_t, 2>           hpf_h      = {{0x4000U, 0U}};
+};
+
+/***********************************************************************************************************************
+ * Register formats
+ **********************************************************************************************************************/
+
+/** Sign-extend a 13-bit coefficient */
+inline int32_t reg13(uint16_t value)
+{
+    return ((value & 0x1000U) != 0U) ? (int32_t) (value & 0x1FFFU) - 0x2000 : (int32_t) (value & 0x1FFFU);
+}
+
+/** Sign-extend a 16-bit coefficient */
+inline int32_t reg16(uint16_t value)
+{
+    return (int32_t) (int16_t) value;
+}
+
+/** Encode a 13-bit coefficient; false when it does not fit */
+inline bool reg13_put(int32_t value, uint16_t & out)
+{
+    if ((value < -4096) || (value > 4095))
+    {
+        return false;
+    }
+
+    out = (uint16_t) ((uint32_t) value & 0x1FFFU);
+
+    return true;
+}
+
+/** Encode a 16-bit coefficient; false when it does not fit */
+inline bool reg16_put(int32_t value, uint16_t & out)
+{
+    if ((value < INT16_MIN) || (value > INT16_MAX))
+    {
+        return false;
+    }
+
+    out = (uint16_t) (int16_t) value;
+
+    return true;
+}
+
+/** Full 39-tap LPF impulse response, Q11 */
+inline std::array<int32_t, lpf_taps> lpf_impulse(filters const & f)
+{
+    std::array<int32_t, lpf_taps> h = {};
+
+    h[lpf_h1 - 1U] = reg13(f.lpf_h0);
+    for (unsigned i = 0U; i < lpf_h1; i++)
+    {
+        /* h1[i] sits at offset 2 * i - 19 from the centre */
+        h[2U * i] = reg13(f.lpf[i]);
+    }
+
+    return h;
+}
+
+/** Bits needed for the magnitude of the sinc's full scale R^N, less the 16-bit range */
+inline unsigned sincrng_for(unsigned order, unsigned sincdec)
+{
+    uint64_t full_scale = 1U;
+    for (unsigned i = 0U; i < order; i++)
+    {
+        full_scale *= sincdec;
+    }
+
+    unsigned bits = 0U;
+    while ((full_scale >> bits) != 0U)
+    {
+        bits++;
+    }
+
+    return (bits > (unsigned) (sinc_bits - 1)) ? bits - (unsigned) (sinc_bits - 1) : 0U;
+}
+
+/***********************************************************************************************************************
+ * Analytic response
+ **********************************************************************************************************************/
+
+/** Sinc magnitude normalised to 1 at DC; f in Hz, fs the PDM clock */
+inline double sinc_gain(unsigned order, unsigned sincdec, double f, double fs)
+{
+    double w = pi * f / fs;
+    if (std::fabs(std::sin(w)) < 1e-12)
+    {
+        return 1.0;
+    }
+
+    double g = std::fabs(std::sin(w * sincdec) / (sincdec * std::sin(w)));
+
+    return std::pow(g, (double) order);
+}
+
+/** Gain of the sinc output stage for a +-1 input: R^N >> SINCRNG, and the stage input shifts */
+inline double scale(filters const & f)
+{
+    double full_scale = std::pow((double) f.sincdec, (double) f.sinc_order);
+
+    return full_scale / std::ldexp(1.0, (int) (f.sincrng + f.comp_shift + f.lpf_shift + f.hpf_shift));
+}
+
+/** Compensation FIR response at the sinc rate */
+inline std::complex<double> comp_response(filters const & f, double w)
+{
+    std::complex<double> h = 0.0;
+    for (unsigned k = 0U; k < comp_taps; k++)
+    {
+        h += (reg13(f.comp[k]) / std::ldexp(1.0, fir_q)) * std::polar(1.0, -w * k);
+    }
+
+    return h;
+}
+
+/** Half-band LPF response at the sinc rate */
+inline std::complex<double> lpf_response(filters const & f, double w)
+{
+    std::array<int32_t, lpf_taps> h = lpf_impulse(f);
+    std::complex<double>          r = 0.0;
+    for (unsigned k = 0U; k < lpf_taps; k++)
+    {
+        r += (h[k] / std::ldexp(1.0, fir_q)) * std::polar(1.0, -w * k);
+    }
+
+    return r;
+}
+
+/** HPF response at the PCM rate */
+inline std::complex<double> hpf_response(filters const & f, double w)
+{
+    double               one = std::ldexp(1.0, hpf_q);
+    std::complex<double> z1  = std::polar(1.0, -w);
+    std::complex<double> num = (reg16(f.hpf_s0) / one) * ((reg16(f.hpf_h[0]) / one) + (reg16(f.hpf_h[1]) / one) * z1);
+
+    return num / (1.0 - (reg16(f.hpf_k1) / one) * z1);
+}
+
+/**
+ * Filter magnitude from the PDM input to the PCM output, 1 at DC without the HPF; times scale() it gives PCM units
+ * per unit input amplitude.
+ * @param f_hz  Input frequency, below the PCM Nyquist frequency for a meaningful result
+ * @param fs    PDM clock
+ */
+inline double chain_gain(filters const & f, double f_hz, double fs)
+{
+    double fs_sinc = fs / f.sincdec;
+    double w_sinc  = 2.0 * pi * f_hz / fs_sinc;
+    double w_pcm   = 2.0 * w_sinc;
+
+    return sinc_gain(f.sinc_order, f.sincdec, f_hz, fs) * std::abs(comp_response(f, w_sinc)) *
+           std::abs(lpf_response(f, w_sinc)) * std::abs(hpf_response(f, w_pcm));
+}
+
+/**
+ * Complex response from the PDM input to the PCM output with the same normalisation as chain_gain(); the phase refers
+ * to the PDM bit that completes an output sample (pcm_time0()), as the causal stages see it.
+ */
+inline std::complex<double> chain_response(filters const & f, double f_hz, double fs)
+{
+    double fs_sinc = fs / f.sincdec;
+    double w_sinc  = 2.0 * pi * f_hz / fs_sinc;
+    double w_pdm   = 2.0 * pi * f_hz / fs;
+
+    /* CIC: N moving sums of R bits, delay N (R - 1) / 2 bits */
+    std::complex<double> sinc = std::polar(1.0, -w_pdm * f.sinc_order * (f.sincdec - 1.0) / 2.0);
+    if (std::fabs(std::sin(w_pdm / 2.0)) > 1e-12)
+    {
+        sinc *= std::pow(std::sin(w_pdm * f.sincdec / 2.0) / (f.sincdec * std::sin(w_pdm / 2.0)),
+                         (double) f.sinc_order);
+    }
+
+    return sinc * comp_response(f, w_sinc) * lpf_response(f, w_sinc) * hpf_response(f, 2.0 * w_sinc);
+}
+
+/***********************************************************************************************************************
+ * Fixed-point simulation
+ **********************************************************************************************************************/
+
+/** Round a scaled accumulator to the nearest integer (ties away from zero) */
+inline int64_t round_shift(int64_t acc, int shift)
+{
+    if (shift <= 0)
+    {
+        return acc;
+    }
+
+    int64_t half = (int64_t) 1 << (shift - 1);
+
+    return (acc >= 0) ? ((acc + half) >> shift) : -((-acc + half) >> shift);
+}
+
+/** Saturate to the 20-bit data path */
+inline int32_t sat20(int64_t value)
+{
+    constexpr int64_t max = (1 << (pcm_bits - 1)) - 1;
+    constexpr int64_t min = -(1 << (pcm_bits - 1));
+
+    return (int32_t) ((value > max) ? max : ((value < min) ? min : value));
+}
+
+/** Streaming model of one channel: feed PDM bits, collect PCM samples */
+class chain
+{
+public:
+    explicit chain(filters const & f) : m_f(f), m_lpf(lpf_impulse(f))
+    {
+        for (unsigned k = 0U; k < comp_taps; k++)
+        {
+            m_comp[k] = reg13(f.comp[k]);
+        }
+    }
+
+    /** One PDM bit (0 or 1); appends a PCM sample to out every 2 * sincdec bits */
+    void push(unsigned bit, std::vector<int32_t> & out)
+    {
+        /* CIC: integrators at the PDM rate, combs at the decimated rate */
+        int64_t x = (0U != bit) ? 1 : -1;
+        for (unsigned i = 0U; i < m_f.sinc_order; i++)
+        {
+            m_integrator[i] += x;
+            x = m_integrator[i];
+        }
+
+        if (++m_phase < m_f.sincdec)
+        {
+            return;
+        }
+
+        m_phase = 0U;
+        for (unsigned i = 0U; i < m_f.sinc_order; i++)
+        {
+            int64_t y = x - m_comb[i];
+            m_comb[i] = x;
+            x         = y;
+        }
+
+        sinc_output(sat20(x >> m_f.sincrng), out);
+    }
+
+    /** Run a whole bit stream */
+    std::vector<int32_t> run(std::vector<uint8_t> const & bits)
+    {
+        std::vector<int32_t> out;
+        out.reserve(bits.size() / (2U * m_f.sincdec) + 1U);
+        for (uint8_t bit : bits)
+        {
+            push(bit, out);
+        }
+
+        return out;
+    }
+
+    /** Samples that hit the 20-bit limit in any stage */
+    uint64_t saturations() const
+    {
+        return m_saturations;
+    }
+
+private:
+    int32_t saturate(int64_t value)
+    {
+        int32_t y = sat20(value);
+        m_saturations += (y != value) ? 1U : 0U;
+
+        return y;
+    }
+
+    void sinc_output(int32_t x, std::vector<int32_t> & out)
+    {
+        /* Compensation at the sinc rate */
+        m_comp_line[m_comp_pos] = x >> m_f.comp_shift;
+        int64_t acc = 0;
+        for (unsigned k = 0U; k < comp_taps; k++)
+        {
+            acc += (int64_t) m_comp[k] * m_comp_line[(m_comp_pos + comp_taps - k) % comp_taps];
+        }
+
+        m_comp_pos = (m_comp_pos + 1U) % comp_taps;
+        int32_t c  = saturate(round_shift(acc, fir_q));
+
+        /* Half-band LPF, every second output kept */
+        m_lpf_line[m_lpf_pos] = c >> m_f.lpf_shift;
+        unsigned newest       = m_lpf_pos;
+        m_lpf_pos             = (m_lpf_pos + 1U) % lpf_taps;
+        m_lpf_phase ^= 1U;
+        if (0U != m_lpf_phase)
+        {
+            return;
+        }
+
+        acc = 0;
+        for (unsigned k = 0U; k < lpf_taps; k++)
+        {
+            if (0 != m_lpf[k])
+            {
+                acc += (int64_t) m_lpf[k] * m_lpf_line[(newest + lpf_taps - k) % lpf_taps];
+            }
+        }
+
+        int32_t l = saturate(round_shift(acc, fir_q));
+
+        /* HPF at the PCM rate */
+        int64_t in = l >> m_f.hpf_shift;
+        int64_t v  = (int64_t) reg16(m_f.hpf_h[0]) * in + (int64_t) reg16(m_f.hpf_h[1]) * m_hpf_x1;
+        acc        = (int64_t) reg16(m_f.hpf_s0) * v + ((int64_t) reg16(m_f.hpf_k1) * m_hpf_y1 << hpf_q);
+        m_hpf_x1   = in;
+        m_hpf_y1   = saturate(round_shift(acc, 2 * hpf_q));
+
+        out.push_back((int32_t) m_hpf_y1);
+    }
+
+    filters                         m_f;
+    std::array<int32_t, lpf_taps>   m_lpf;
+    std::array<int32_t, comp_taps>  m_comp        = {};
+    std::array<int64_t, 4>          m_integrator  = {};
+    std::array<int64_t, 4>          m_comb        = {};
+    unsigned                        m_phase       = 0U;
+    std::array<int32_t, comp_taps>  m_comp_line   = {};
+    unsigned                        m_comp_pos    = 0U;
+    std::array<int32_t, lpf_taps>   m_lpf_line    = {};
+    unsigned                        m_lpf_pos     = 0U;
+    unsigned                        m_lpf_phase   = 0U;
+    int64_t                         m_hpf_x1      = 0;
+    int64_t                         m_hpf_y1      = 0;
+    uint64_t                        m_saturations = 0U;
+};
+
+/***********************************************************************************************************************
+ * Stimulus and measurement
+ **********************************************************************************************************************/
+
+/**
+ * Second-order delta-sigma modulator (stable up to an input of about 0.7)
+ * @param input  Input at PDM bit n, relative to +-1: double input(size_t n)
+ */
+template <typename Input>
+inline std::vector<uint8_t> modulate(Input input, size_t bits)
+{
+    std::vector<uint8_t> out(bits);
+    double               i1 = 0.0;
+    double               i2 = 0.0;
+    double               y  = 1.0;
+
+    for (size_t n = 0U; n < bits; n++)
+    {
+        double x = input(n);
+        i1     += x - y;
+        i2     += i1 - y;
+        y       = (i2 >= 0.0) ? 1.0 : -1.0;
+        out[n]  = (y > 0.0) ? 1U : 0U;
+    }
+
+    return out;
+}
+
+/** PDM bits of a sine, amplitude relative to +-1 */
+inline std::vector<uint8_t> modulate_sine(double amplitude, double f_hz, double fs, size_t bits)
+{
+    return modulate([=](size_t n) { return amplitude * std::sin(2.0 * pi * f_hz * (double) n / fs); }, bits);
+}
+
+/** Time of PCM sample 0 in PDM bits: it completes with the second sinc output, which ends at bit 2R - 1 */
+inline double pcm_time0(filters const & f)
+{
+    return (2.0 * f.sincdec) - 1.0;
+}
+
+/** Solve a small dense system in place (Gauss-Jordan, partial pivoting); false when singular */
+inline bool solve(std::vector<std::vector<double>> & a, std::vector<double> & x)
+{
+    size_t n = x.size();
+    for (size_t i = 0U; i < n; i++)
+    {
+        size_t pivot = i;
+        for (size_t r = i + 1U; r < n; r++)
+        {
+            if (std::fabs(a[r][i]) > std::fabs(a[pivot][i]))
+            {
+                pivot = r;
+            }
+        }
+
+        if (std::fabs(a[pivot][i]) < 1e-15)
+        {
+            return false;
+        }
+
+        std::swap(a[i], a[pivot]);
+        std::swap(x[i], x[pivot]);
+
+        for (size_t r = 0U; r < n; r++)
+        {
+            if (r != i)
+            {
+                double m = a[r][i] / a[i][i];
+                for (size_t c = i; c < n; c++)
+                {
+                    a[r][c] -= m * a[i][c];
+                }
+
+                x[r] -= m * x[i];
+            }
+        }
+    }
+
+    for (size_t i = 0U; i < n; i++)
+    {
+        x[i] /= a[i][i];
+    }
+
+    return true;
+}
+
+/**
+ * Joint least-squares fit of sines of known frequencies plus DC to samples[first..]
+ * @param t0        Time of sample 0, in units of 1 / fs_in
+ * @param fs_in     Rate the frequencies and t0 refer to
+ * @param fs        Sample rate
+ * @param residual  If not NULL: RMS of what the fit leaves
+ * @return Phasor per tone: y = Re(p * exp(j w t)), so a cosine input of phase 0 gives the response directly
+ */
+inline std::vector<std::complex<double>> fit_tones(std::vector<int32_t> const & samples, size_t first,
+                                                   std::vector<double> const & f_hz, double fs, double t0,
+                                                   double fs_in, double * residual = nullptr)
+{
+    size_t                           k = (2U * f_hz.size()) + 1U;
+    std::vector<std::vector<double>> a(k, std::vector<double>(k, 0.0));
+    std::vector<double>              b(k, 0.0);
+    std::vector<double>              basis(k);
+
+    auto fill = [&](size_t n) {
+        double t = (t0 / fs_in) + ((double) n / fs);
+        for (size_t i = 0U; i < f_hz.size(); i++)
+        {
+            basis[2U * i]      = std::cos(2.0 * pi * f_hz[i] * t);
+            basis[2U * i + 1U] = std::sin(2.0 * pi * f_hz[i] * t);
+        }
+
+        basis[k - 1U] = 1.0;
+    };
+
+    for (size_t n = first; n < samples.size(); n++)
+    {
+        fill(n);
+        for (size_t i = 0U; i < k; i++)
+        {
+            for (size_t j = 0U; j < k; j++)
+            {
+                a[i][j] += basis[i] * basis[j];
+            }
+
+            b[i] += basis[i] * samples[n];
+        }
+    }
+
+    std::vector<std::complex<double>> out(f_hz.size());
+    if (!solve(a, b))
+    {
+        return out;
+    }
+
+    for (size_t i = 0U; i < f_hz.size(); i++)
+    {
+        out[i] = std::complex<double>(b[2U * i], -b[2U * i + 1U]);
+    }
+
+    if (nullptr != residual)
+    {
+        double sum = 0.0;
+        for (size_t n = first; n < samples.size(); n++)
+        {
+            fill(n);
+            double y = 0.0;
+            for (size_t i = 0U; i < k; i++)
+            {
+                y += b[i] * basis[i];
+            }
+
+            sum += (samples[n] - y) * (samples[n] - y);
+        }
+
+        *residual = std::sqrt(sum / (double) (samples.size() - first));
+    }
+
+    return out;
+}
+
+/**
+ * Least-squares fit of a sine of known frequency (plus DC) to samples[first..]
+ * @return Amplitude
+ */
+inline double fit_sine(std::vector<int32_t> const & samples, size_t first, double f_hz, double fs)
+{
+    return std::abs(fit_tones(samples, first, {f_hz}, fs, 0.0, fs)[0]);
+}
+
+} // namespace pdm_model
+
+#endif /* PDM_MODEL_HPP */
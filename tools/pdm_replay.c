@@ -0,0 +1,949 @@
+/**
+ * @file pdm_replay.c
+ * @brief Host replay of recorded captures through the firmware's block pipeline
+ * @details Streams the samples of recorded dumps block by block through the code the data interrupt and the foreground
+ *          run on target: a host driver double fills the session ring and calls pdm_session_isr(), the same call
+ *          pdm0_callback() makes, and pdm_session_process() hands every block, in order, to a block hook that runs the
+ *          collection chain of the recorder (width kernel convert and store, then the segment detector). Algorithm
+ *          changes in these modules can so be validated and timed on field recordings far faster than real time.
+ *
+ *          Inputs (one or more captures per file, each replayed in its own session start/stop):
+ *          - text: decoded dumps as pdm_logdec prints them, and the older dumps written as text by the firmware; the
+ *            hex words between "*** PURE DATA OUTPUT START ***" and "*** PURE DATA OUTPUT END ***"
+ *          - log: the raw bytes of the log RTT channel (no pdm_logdec step), detected by the record sync byte
+ *          - raw: little endian 32-bit words, as -o writes them; width and rate from -w and -r
+ *
+ *          The stream format, gain and PCM width of a dump give the kernel width (PCM16 words are replayed by the
+ *          16-bit kernel, raw words by the kernel of the recorded width, 20 bits for dumps that do not give it) and the
+ *          stored format, so a replay at unity gain stores every word as it was recorded. The gap table is replayed as
+ *          buffer overwrite errors followed by a late block, so the integrity tracker counts the missing samples
+ *          exactly as it does on target; a gap inside a block is applied at the next block boundary.
+ *
+ *          The virtual time base counts samples: a block completes at the index of its last sample. With -t the
+ *          replay is paced to real time, otherwise it runs as fast as possible; -q runs the foreground only every n
+ *          blocks, so a consumer that falls behind the slots or the ring (and the drops it causes) can be reproduced.
+ *
+ *          Usage: pdm_replay [-f text|log|raw] [-w 20|16] [-r rate_hz] [-g gain_q8] [-l level] [-q blocks] [-t]
+ *                            [-o out.bin] [-v] [file]
+ *            -f  input format (default: log if the input starts with a record sync byte, text otherwise)
+ *            -w  PCM width of raw input (default 20)
+ *            -r  sample rate (default: nominal rate of the dump, PDM_CFG_SAMPLE_RATE_HZ without one)
+ *            -g  software gain applied on replay, Q8 (default 256: unity)
+ *            -l  segment detector level (default PDM_CFG_SEGMENT_LEVEL), 0: segment store off
+ *            -v  print every closed segment
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_session.h"
+#include "pdm_kernel.h"
+#include "pdm_segment.h"
+#include "pdm_log.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/** Blocks as the firmware delivers them (PDM_CALLBACK_NUM_SAMPLES) in a ring of four */
+#define PDM_REPLAY_BLOCK_SAMPLES    (1024U)
+#define PDM_REPLAY_RING_SAMPLES     (4U * PDM_REPLAY_BLOCK_SAMPLES)
+
+#define PDM_REPLAY_MAX_GAPS         (1024U)
+
+/** Segment pool, in multiples of the longest segment and its pre-roll */
+#define PDM_REPLAY_SEGMENT_POOLS    (4U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+typedef enum e_pdm_replay_input_format
+{
+    PDM_REPLAY_INPUT_AUTO = 0,
+    PDM_REPLAY_INPUT_TEXT,
+    PDM_REPLAY_INPUT_LOG,
+    PDM_REPLAY_INPUT_RAW,
+} pdm_replay_input_format_t;
+
+typedef struct st_pdm_replay_gap
+{
+    uint32_t offset;                   ///< Data index of the first sample after the gap
+    uint32_t missing;
+} pdm_replay_gap_t;
+
+/** Input reader, one capture at a time */
+typedef struct st_pdm_replay_input
+{
+    FILE                    * p_file;
+    pdm_replay_input_format_t format;
+    bool                      in_data;     ///< Between the data start and end of a capture
+
+    /* Header of the current capture */
+    uint32_t         declared;             ///< Samples announced by the header, 0 if none
+    uint32_t         stream_format;        ///< pdm_kernel_format_t of the stored words
+    uint32_t         gain_q8;              ///< Gain the words were stored with
+    uint32_t         pcm_bits;             ///< PCM width of raw words, 0 if not given
+    uint32_t         rate_hz;              ///< Nominal rate, 0 if not given
+    uint32_t         gap_count;
+    pdm_replay_gap_t gaps[PDM_REPLAY_MAX_GAPS];
+
+    /* Text: current line and parse position */
+    char   * p_line;
+    size_t   line_size;
+    char   * p_next;
+
+    /* Log: arguments of the current data record not yet returned */
+    uint32_t args[PDM_LOG_MAX_ARGS];
+    uint32_t arg_count;
+    uint32_t arg_next;
+} pdm_replay_input_t;
+
+/** Block hook state of one capture */
+typedef struct st_pdm_replay
+{
+    pdm_kernel_t const * p_kernel;
+    pdm_kernel_format_t  format;
+    int32_t              gain_q8;
+    uint64_t             valid_until;      ///< Stream index after the last real sample; the last block is padded
+    uint64_t             next_index;       ///< Expected stream index of the next block
+
+    uint64_t samples;
+    uint32_t gaps;
+    uint64_t gap_samples;
+    uint32_t peak;
+    double   sum_squares;
+
+    bool               segments;           ///< Segment store on
+    pdm_segment_ctrl_t segment;
+    uint32_t           segment_printed;    ///< Next segment ID to report
+    bool               verbose;
+
+    FILE * p_out;
+} pdm_replay_t;
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static uint32_t              g_ring[PDM_REPLAY_RING_SAMPLES];
+static uint32_t              g_slot_storage[PDM_CFG_BLOCK_SLOTS * PDM_REPLAY_BLOCK_SAMPLES];
+static pdm_integrity_block_t g_slot_info[PDM_CFG_BLOCK_SLOTS];
+static pdm_segment_entry_t   g_segment_index[PDM_CFG_SEGMENT_ENTRIES];
+
+/* Virtual time base in samples, read by the session through the timestamp hook */
+static uint64_t g_clock;
+
+/* Ring handed over by the session at start */
+static uint32_t * g_p_ring;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_replay_usage(char const * p_name)
+{
+    fprintf(stderr,
+            "usage: %s [-f text|log|raw] [-w 20|16] [-r rate_hz] [-g gain_q8] [-l level] [-q blocks] [-t] "
+            "[-o out.bin] [-v] [file]\n", p_name);
+}
+
+/* Host driver double: the replay loop fills the ring and raises the events itself */
+static fsp_err_t pdm_replay_driver_start(void * p_ctrl, uint32_t * p_ring, uint32_t ring_samples,
+                                         uint32_t block_samples)
+{
+    FSP_PARAMETER_NOT_USED(p_ctrl);
+    FSP_PARAMETER_NOT_USED(ring_samples);
+    FSP_PARAMETER_NOT_USED(block_samples);
+
+    g_p_ring = p_ring;
+
+    return FSP_SUCCESS;
+}
+
+static pdm_session_driver_t const g_pdm_replay_driver =
+{
+    .p_open  = NULL,
+    .p_start = pdm_replay_driver_start,
+    .p_stop  = NULL,
+    .p_close = NULL,
+};
+
+static uint64_t pdm_replay_timestamp(void)
+{
+    return g_clock;
+}
+
+static uint64_t pdm_replay_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static uint32_t pdm_replay_u32(uint8_t const * p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* Next log record; false at the end of the input */
+static bool pdm_replay_log_record(FILE * p_in, uint32_t * p_id, uint32_t * p_args, uint32_t * p_nargs)
+{
+    uint8_t word[4];
+    int     c;
+
+    /* Records are written whole or not at all; resync only on corrupt input */
+    while (EOF != (c = fgetc(p_in)))
+    {
+        if (PDM_LOG_SYNC != (uint32_t) c)
+        {
+            continue;
+        }
+
+        word[0] = (uint8_t) c;
+        if (3U != fread(&word[1], 1U, 3U, p_in))
+        {
+            return false;
+        }
+
+        uint32_t header = pdm_replay_u32(word);
+        uint32_t nargs  = (header >> 8) & 0xFFU;
+        uint32_t id     = header >> 16;
+
+        if ((nargs > PDM_LOG_MAX_ARGS) || (id >= PDM_LOG_ID_COUNT))
+        {
+            continue;
+        }
+
+        /* Timestamp word, then the arguments */
+        for (uint32_t i = 0U; i <= nargs; i++)
+        {
+            if (1U != fread(word, sizeof(word), 1U, p_in))
+            {
+                return false;
+            }
+
+            if (0U != i)
+            {
+                p_args[i - 1U] = pdm_replay_u32(word);
+            }
+        }
+
+        *p_id    = id;
+        *p_nargs = nargs;
+
+        return true;
+    }
+
+    return false;
+}
+
+/* Header fields shared by the text and log inputs */
+static void pdm_replay_header_reset(pdm_replay_input_t * p_in, uint32_t declared)
+{
+    p_in->declared      = declared;
+    p_in->stream_format = PDM_KERNEL_FORMAT_RAW20;
+    p_in->gain_q8       = (uint32_t) PDM_KERNEL_GAIN_UNITY;
+    p_in->pcm_bits      = 0U;
+    p_in->rate_hz       = 0U;
+    p_in->gap_count     = 0U;
+}
+
+static void pdm_replay_gap_add(pdm_replay_input_t * p_in, uint32_t offset, uint32_t missing)
+{
+    if (p_in->gap_count < PDM_REPLAY_MAX_GAPS)
+    {
+        p_in->gaps[p_in->gap_count].offset  = offset;
+        p_in->gaps[p_in->gap_count].missing = missing;
+        p_in->gap_count++;
+    }
+}
+
+/* Skip to the data of the next capture, collecting its header; false at the end of the input */
+static bool pdm_replay_capture_begin(pdm_replay_input_t * p_in)
+{
+    p_in->in_data = false;
+
+    if (PDM_REPLAY_INPUT_RAW == p_in->format)
+    {
+        /* One capture per file, no header */
+        int c = fgetc(p_in->p_file);
+        if (EOF == c)
+        {
+            return false;
+        }
+
+        ungetc(c, p_in->p_file);
+        pdm_replay_header_reset(p_in, 0U);
+        p_in->in_data = true;
+
+        return true;
+    }
+
+    if (PDM_REPLAY_INPUT_LOG == p_in->format)
+    {
+        uint32_t id;
+        uint32_t nargs;
+
+        while (pdm_replay_log_record(p_in->p_file, &id, p_in->args, &nargs))
+        {
+            if ((PDM_LOG_DUMP_HEADER == id) && (nargs >= 1U))
+            {
+                pdm_replay_header_reset(p_in, p_in->args[0]);
+            }
+            else if ((PDM_LOG_DUMP_FORMAT == id) && (nargs >= 2U))
+            {
+                p_in->stream_format = p_in->args[0];
+                p_in->gain_q8       = p_in->args[1];
+                p_in->pcm_bits      = (nargs >= 3U) ? p_in->args[2] : 0U;
+            }
+            else if ((PDM_LOG_DUMP_GAP == id) && (nargs >= 2U))
+            {
+                pdm_replay_gap_add(p_in, p_in->args[0], p_in->args[1]);
+            }
+            else if ((PDM_LOG_DUMP_STAMPS == id) && (nargs >= 4U))
+            {
+                p_in->rate_hz = p_in->args[3];
+            }
+            else if (PDM_LOG_DUMP_DATA_START == id)
+            {
+                p_in->arg_count = 0U;
+                p_in->arg_next  = 0U;
+                p_in->in_data   = true;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    while (-1 != getline(&p_in->p_line, &p_in->line_size, p_in->p_file))
+    {
+        char const * p_line = p_in->p_line;
+        unsigned     a;
+        unsigned     b;
+        unsigned     c = 0U;       /* PCM width stays 0 in dumps that do not give it */
+        unsigned     d;
+
+        if (1 == sscanf(p_line, "Total collected samples: %u", &a))
+        {
+            pdm_replay_header_reset(p_in, a);
+        }
+        else if (2 <= sscanf(p_line, "Stream format: %u (0: raw 20-bit, 1: PCM16), gain %u/256, PCM width %u", &a, &b,
+                             &c))
+        {
+            p_in->stream_format = a;
+            p_in->gain_q8       = b;
+            p_in->pcm_bits      = c;
+        }
+        else if (2 == sscanf(p_line, "GAP %u %u", &a, &b))
+        {
+            pdm_replay_gap_add(p_in, a, b);
+        }
+        else if (4 == sscanf(p_line, "Stamps: %u, %u samples per block, clock %u Hz, nominal rate %u Hz", &a, &b, &c,
+                             &d))
+        {
+            p_in->rate_hz = d;
+        }
+        else if (NULL != strstr(p_line, "*** PURE DATA OUTPUT START ***"))
+        {
+            p_in->p_next  = NULL;
+            p_in->in_data = true;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Up to count words of the current capture; fewer at its end */
+static uint32_t pdm_replay_capture_read(pdm_replay_input_t * p_in, uint32_t * p_words, uint32_t count)
+{
+    uint32_t n = 0U;
+
+    while (p_in->in_data && (n < count))
+    {
+        if (PDM_REPLAY_INPUT_RAW == p_in->format)
+        {
+            uint8_t word[4];
+            if (1U != fread(word, sizeof(word), 1U, p_in->p_file))
+            {
+                p_in->in_data = false;
+                break;
+            }
+
+            p_words[n++] = pdm_replay_u32(word);
+        }
+        else if (PDM_REPLAY_INPUT_LOG == p_in->format)
+        {
+            if (p_in->arg_next < p_in->arg_count)
+            {
+                p_words[n++] = p_in->args[p_in->arg_next++];
+                continue;
+            }
+
+            uint32_t id;
+            uint32_t nargs;
+            if (!pdm_replay_log_record(p_in->p_file, &id, p_in->args, &nargs) ||
+                ((PDM_LOG_DUMP_DATA_FIRST != id) && (PDM_LOG_DUMP_DATA != id)))
+            {
+                /* End record, an aborted dump or anything else ends the data */
+                p_in->in_data = false;
+                break;
+            }
+
+            p_in->arg_count = nargs;
+            p_in->arg_next  = 0U;
+        }
+        else
+        {
+            if (NULL == p_in->p_next)
+            {
+                if (-1 == getline(&p_in->p_line, &p_in->line_size, p_in->p_file))
+                {
+                    p_in->in_data = false;
+                    break;
+                }
+
+                if (NULL != strstr(p_in->p_line, "*** PURE DATA OUTPUT END ***"))
+                {
+                    p_in->in_data = false;
+                    break;
+                }
+
+                p_in->p_next = p_in->p_line;
+            }
+
+            /* Words are 8 hex digits; anything else on the line (timestamp prefixes, notes) is skipped */
+            char * p = p_in->p_next;
+            while (isspace((unsigned char) *p))
+            {
+                p++;
+            }
+
+            if ('\0' == *p)
+            {
+                p_in->p_next = NULL;
+                continue;
+            }
+
+            char * p_end = p;
+            while (('\0' != *p_end) && !isspace((unsigned char) *p_end))
+            {
+                p_end++;
+            }
+
+            p_in->p_next = p_end;
+
+            bool hex = (8 == (p_end - p));
+            for (char const * q = p; hex && (q < p_end); q++)
+            {
+                hex = (0 != isxdigit((unsigned char) *q));
+            }
+
+            if (hex)
+            {
+                p_words[n++] = (uint32_t) strtoul(p, NULL, 16);
+            }
+            else if (0 == strncmp(p, "[dump", 5))
+            {
+                /* Aborted dump */
+                p_in->in_data = false;
+            }
+        }
+    }
+
+    return n;
+}
+
+/* Report the segments closed since the last call */
+static void pdm_replay_segments_report(pdm_replay_t * p_replay)
+{
+    pdm_segment_entry_t entry;
+
+    while (FSP_SUCCESS == pdm_segment_find(&p_replay->segment, p_replay->segment_printed, &entry))
+    {
+        if (p_replay->verbose)
+        {
+            printf("SEGMENT %u start %llu length %u peak %u rms %u\n", entry.id, (unsigned long long) entry.start,
+                   entry.length, entry.peak, entry.rms);
+        }
+
+        p_replay->segment_printed = entry.id + 1U;
+    }
+}
+
+/* Session block hook: the collection chain of the recorder, chunk by chunk */
+static void pdm_replay_block(pdm_session_t * p_session, uint32_t * p_block, pdm_integrity_block_t const * p_info,
+                             void * p_context)
+{
+    FSP_PARAMETER_NOT_USED(p_session);
+
+    pdm_replay_t * p_replay = (pdm_replay_t *) p_context;
+
+    /* Dropped blocks and replayed gaps both show up as a jump in the stream index */
+    if (p_info->sample_index != p_replay->next_index)
+    {
+        p_replay->gaps++;
+        p_replay->gap_samples += p_info->sample_index - p_replay->next_index;
+    }
+
+    p_replay->next_index = p_info->sample_index + PDM_REPLAY_BLOCK_SAMPLES;
+
+    uint32_t count = PDM_REPLAY_BLOCK_SAMPLES;
+    if (p_replay->valid_until < p_replay->next_index)
+    {
+        count = (p_replay->valid_until > p_info->sample_index) ?
+                (uint32_t) (p_replay->valid_until - p_info->sample_index) : 0U;
+    }
+
+    for (uint32_t done = 0U; done < count; done += PDM_KERNEL_BLOCK)
+    {
+        uint32_t n = ((count - done) < PDM_KERNEL_BLOCK) ? (count - done) : PDM_KERNEL_BLOCK;
+        int32_t  samples[PDM_KERNEL_BLOCK];
+        uint32_t words[PDM_KERNEL_BLOCK];
+
+        p_replay->p_kernel->convert(&p_block[done], samples, n);
+        p_replay->p_kernel->store[p_replay->format](&p_block[done], words, n, p_replay->gain_q8);
+
+        /* The block completed with its last sample, which is also its time on the sample clock */
+        if (p_replay->segments)
+        {
+            pdm_segment_append(&p_replay->segment, p_info->sample_index + done, p_info->sample_index + done, words,
+                               samples, n);
+        }
+
+        for (uint32_t i = 0U; i < n; i++)
+        {
+            uint32_t level = (uint32_t) ((samples[i] < 0) ? -samples[i] : samples[i]);
+            p_replay->peak         = (level > p_replay->peak) ? level : p_replay->peak;
+            p_replay->sum_squares += (double) samples[i] * (double) samples[i];
+        }
+
+        if (NULL != p_replay->p_out)
+        {
+            uint8_t bytes[PDM_KERNEL_BLOCK * 4U];
+            for (uint32_t i = 0U; i < n; i++)
+            {
+                bytes[(4U * i) + 0U] = (uint8_t) words[i];
+                bytes[(4U * i) + 1U] = (uint8_t) (words[i] >> 8);
+                bytes[(4U * i) + 2U] = (uint8_t) (words[i] >> 16);
+                bytes[(4U * i) + 3U] = (uint8_t) (words[i] >> 24);
+            }
+
+            (void) fwrite(bytes, 4U, n, p_replay->p_out);
+        }
+    }
+
+    p_replay->samples += count;
+
+    if (p_replay->segments)
+    {
+        pdm_replay_segments_report(p_replay);
+    }
+}
+
+/* Sleep until a time on the monotonic clock */
+static void pdm_replay_pace(uint64_t until_ns)
+{
+    struct timespec ts =
+    {
+        .tv_sec  = (time_t) (until_ns / 1000000000ULL),
+        .tv_nsec = (long) (until_ns % 1000000000ULL),
+    };
+
+    while (0 != clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL))
+    {
+        /* Interrupted: sleep on */
+    }
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    pdm_replay_input_format_t format        = PDM_REPLAY_INPUT_AUTO;
+    uint32_t                  raw_bits      = 20U;
+    uint32_t                  rate_override = 0U;
+    int32_t                   gain_q8       = PDM_KERNEL_GAIN_UNITY;
+    int32_t                   level         = PDM_CFG_SEGMENT_LEVEL;
+    uint32_t                  every         = 1U;
+    bool                      realtime      = false;
+    bool                      verbose       = false;
+    char const              * p_out_name    = NULL;
+    char const              * p_in_name     = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool value = (i + 1) < argc;
+
+        if ((0 == strcmp(argv[i], "-f")) && value)
+        {
+            i++;
+            format = (0 == strcmp(argv[i], "text")) ? PDM_REPLAY_INPUT_TEXT :
+                     (0 == strcmp(argv[i], "log")) ? PDM_REPLAY_INPUT_LOG :
+                     (0 == strcmp(argv[i], "raw")) ? PDM_REPLAY_INPUT_RAW : PDM_REPLAY_INPUT_AUTO;
+            if (PDM_REPLAY_INPUT_AUTO == format)
+            {
+                pdm_replay_usage(argv[0]);
+
+                return 2;
+            }
+        }
+        else if ((0 == strcmp(argv[i], "-w")) && value)
+        {
+            raw_bits = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if ((0 == strcmp(argv[i], "-r")) && value)
+        {
+            rate_override = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if ((0 == strcmp(argv[i], "-g")) && value)
+        {
+            gain_q8 = (int32_t) strtol(argv[++i], NULL, 0);
+        }
+        else if ((0 == strcmp(argv[i], "-l")) && value)
+        {
+            level = (int32_t) strtol(argv[++i], NULL, 0);
+        }
+        else if ((0 == strcmp(argv[i], "-q")) && value)
+        {
+            every = (uint32_t) strtoul(argv[++i], NULL, 0);
+            every = (0U != every) ? every : 1U;
+        }
+        else if ((0 == strcmp(argv[i], "-o")) && value)
+        {
+            p_out_name = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "-t"))
+        {
+            realtime = true;
+        }
+        else if (0 == strcmp(argv[i], "-v"))
+        {
+            verbose = true;
+        }
+        else if (('-' == argv[i][0]) || (NULL != p_in_name))
+        {
+            pdm_replay_usage(argv[0]);
+
+            return 2;
+        }
+        else
+        {
+            p_in_name = argv[i];
+        }
+    }
+
+    if (NULL == pdm_kernel_select(raw_bits))
+    {
+        fprintf(stderr, "pdm_replay: no kernel for %u-bit samples\n", raw_bits);
+
+        return 2;
+    }
+
+    static pdm_replay_input_t input;
+    input.p_file = stdin;
+    if (NULL != p_in_name)
+    {
+        input.p_file = fopen(p_in_name, "rb");
+        if (NULL == input.p_file)
+        {
+            perror(p_in_name);
+
+            return 1;
+        }
+    }
+
+    if (PDM_REPLAY_INPUT_AUTO == format)
+    {
+        int c = fgetc(input.p_file);
+        format = (PDM_LOG_SYNC == (uint32_t) c) ? PDM_REPLAY_INPUT_LOG : PDM_REPLAY_INPUT_TEXT;
+        (void) ungetc(c, input.p_file);
+    }
+
+    input.format = format;
+
+    pdm_replay_t replay;
+    memset(&replay, 0, sizeof(replay));
+    replay.verbose = verbose;
+
+    if (NULL != p_out_name)
+    {
+        replay.p_out = fopen(p_out_name, "wb");
+        if (NULL == replay.p_out)
+        {
+            perror(p_out_name);
+
+            return 1;
+        }
+    }
+
+    pdm_session_cfg_t const session_cfg =
+    {
+        .p_driver          = &g_pdm_replay_driver,
+        .p_ring            = g_ring,
+        .ring_samples      = PDM_REPLAY_RING_SAMPLES,
+        .block_samples     = PDM_REPLAY_BLOCK_SAMPLES,
+        .p_slot_storage    = g_slot_storage,
+        .p_slot_info       = g_slot_info,
+        .slots             = PDM_CFG_BLOCK_SLOTS,
+        .p_timestamp       = pdm_replay_timestamp,
+        .cycles_per_second = PDM_CFG_SAMPLE_RATE_HZ,
+        .p_notify          = NULL,
+        .p_block           = pdm_replay_block,
+        .p_context         = &replay,
+    };
+
+    static pdm_session_t session;
+    fsp_err_t            err = pdm_session_open(&session, &session_cfg);
+    if (FSP_SUCCESS != err)
+    {
+        fprintf(stderr, "pdm_replay: session open failed: %d\n", (int) err);
+
+        return 1;
+    }
+
+    uint32_t * p_pool   = NULL;
+    uint32_t * p_pre    = NULL;
+    int        status   = 0;
+    uint32_t   captures = 0U;
+
+    while ((0 == status) && pdm_replay_capture_begin(&input))
+    {
+        uint32_t            bits   = raw_bits;
+        pdm_kernel_format_t stored = (16U == bits) ? PDM_KERNEL_FORMAT_PCM16 : PDM_KERNEL_FORMAT_RAW20;
+        uint32_t            rate = (0U != rate_override) ? rate_override :
+                        (0U != input.rate_hz) ? input.rate_hz : PDM_CFG_SAMPLE_RATE_HZ;
+
+        if (PDM_KERNEL_FORMAT_PCM16 == input.stream_format)
+        {
+            bits   = 16U;
+            stored = PDM_KERNEL_FORMAT_PCM16;
+        }
+        else if (PDM_REPLAY_INPUT_RAW != format)
+        {
+            /* Raw words are FIFO words of the recorded width */
+            bits   = (0U != input.pcm_bits) ? input.pcm_bits : 20U;
+            stored = PDM_KERNEL_FORMAT_RAW20;
+        }
+
+        if (NULL == pdm_kernel_select(bits))
+        {
+            fprintf(stderr, "pdm_replay: no kernel for %u-bit samples\n", bits);
+            status = 1;
+            break;
+        }
+
+        replay.p_kernel        = pdm_kernel_select(bits);
+        replay.format          = stored;
+        replay.gain_q8         = gain_q8;
+        replay.valid_until     = UINT64_MAX;
+        replay.next_index      = 0U;
+        replay.samples         = 0U;
+        replay.gaps            = 0U;
+        replay.gap_samples     = 0U;
+        replay.peak            = 0U;
+        replay.sum_squares     = 0.0;
+        replay.segment_printed = 0U;
+        replay.segments        = (0 != level);
+
+        /* The session runs on a sample clock: one timestamp unit per sample at the replay rate */
+        session.cfg.cycles_per_second = rate;
+
+        if (replay.segments)
+        {
+            uint32_t pre = (uint32_t) (((uint64_t) PDM_CFG_SEGMENT_PRE_MS * rate) / 1000U);
+            uint32_t max = (uint32_t) (((uint64_t) PDM_CFG_SEGMENT_MAX_MS * rate) / 1000U);
+
+            free(p_pool);
+            free(p_pre);
+            p_pool = malloc(sizeof(uint32_t) * PDM_REPLAY_SEGMENT_POOLS * (pre + max));
+            p_pre  = malloc(sizeof(uint32_t) * ((0U != pre) ? pre : 1U));
+
+            pdm_segment_cfg_t const segment_cfg =
+            {
+                .p_pool       = p_pool,
+                .capacity     = PDM_REPLAY_SEGMENT_POOLS * (pre + max),
+                .p_index      = g_segment_index,
+                .entries      = PDM_CFG_SEGMENT_ENTRIES,
+                .p_preroll    = p_pre,
+                .pre_samples  = pre,
+                .hold_samples = (uint32_t) (((uint64_t) PDM_CFG_SEGMENT_HOLD_MS * rate) / 1000U),
+                .max_samples  = max,
+                .level        = level,
+                .rate_hz      = rate,
+                .clock_hz     = rate,
+            };
+
+            if ((NULL == p_pool) || (NULL == p_pre) ||
+                (FSP_SUCCESS != pdm_segment_open(&replay.segment, &segment_cfg)))
+            {
+                fprintf(stderr, "pdm_replay: segment store setup failed\n");
+                status = 1;
+                break;
+            }
+        }
+
+        /* First block completes at sample block - 1 */
+        g_clock = UINT64_MAX;
+        err     = pdm_session_start(&session, rate);
+        if (FSP_SUCCESS != err)
+        {
+            fprintf(stderr, "pdm_replay: session start failed: %d\n", (int) err);
+            status = 1;
+            break;
+        }
+
+        uint64_t index    = 0U;            // Stream index of the next block, lost samples included
+        uint32_t offset   = 0U;            // Data index of the next block
+        uint32_t gap      = 0U;
+        uint64_t pipe_ns  = 0U;
+        uint64_t start_ns = pdm_replay_now_ns();
+        uint32_t blocks   = 0U;
+        bool     more     = true;
+
+        while (more)
+        {
+            uint32_t * p_dst = &g_p_ring[(session.callbacks % (PDM_REPLAY_RING_SAMPLES / PDM_REPLAY_BLOCK_SAMPLES)) *
+                                         PDM_REPLAY_BLOCK_SAMPLES];
+            uint32_t n = pdm_replay_capture_read(&input, p_dst, PDM_REPLAY_BLOCK_SAMPLES);
+            if (0U == n)
+            {
+                break;
+            }
+
+            /* The tail of the capture goes out as a padded block the hook only takes the real samples of */
+            if (n < PDM_REPLAY_BLOCK_SAMPLES)
+            {
+                memset(&p_dst[n], 0, sizeof(uint32_t) * (PDM_REPLAY_BLOCK_SAMPLES - n));
+                more = false;
+            }
+
+            /* Samples missing before this block: an overwrite error, then the block comes late by as much */
+            uint32_t missing = 0U;
+            for (; (gap < input.gap_count) && (input.gaps[gap].offset <= offset); gap++)
+            {
+                missing += input.gaps[gap].missing;
+            }
+
+            if (0U != missing)
+            {
+                g_clock += missing;
+                pdm_session_isr(&session, PDM_SESSION_EVENT_ERROR, PDM_INTEGRITY_ERROR_BUFFER_OVERWRITE);
+                index += missing;
+            }
+
+            if (!more)
+            {
+                replay.valid_until = index + n;
+            }
+
+            g_clock = index + PDM_REPLAY_BLOCK_SAMPLES - 1U;
+
+            if (realtime)
+            {
+                pdm_replay_pace(start_ns + (((index + PDM_REPLAY_BLOCK_SAMPLES) * 1000000000ULL) / rate));
+            }
+
+            uint32_t t0 = pdm_port_cycles();
+            pdm_session_isr(&session, PDM_SESSION_EVENT_BLOCK, 0U);
+
+            blocks++;
+            if (0U == (blocks % every))
+            {
+                (void) pdm_session_process(&session);
+            }
+
+            pipe_ns += (uint32_t) (pdm_port_cycles() - t0);
+
+            index  += PDM_REPLAY_BLOCK_SAMPLES;
+            offset += n;
+        }
+
+        uint32_t t0 = pdm_port_cycles();
+        (void) pdm_session_stop(&session);
+        (void) pdm_session_process(&session);
+        if (replay.segments)
+        {
+            pdm_segment_close(&replay.segment);
+            pdm_replay_segments_report(&replay);
+        }
+
+        pipe_ns += (uint32_t) (pdm_port_cycles() - t0);
+
+        uint64_t                  wall_ns = pdm_replay_now_ns() - start_ns;
+        pdm_session_stats_t       stats;
+        pdm_integrity_telemetry_t tm;
+        pdm_session_stats_get(&session, &stats);
+        pdm_integrity_telemetry_get(pdm_session_integrity(&session), &tm);
+
+        double audio_s = (double) replay.samples / rate;
+        double pipe_s  = (double) pipe_ns / 1e9;
+        double wall_s  = (double) wall_ns / 1e9;
+
+        printf("Capture %u: %u samples declared, %s, gain %u/256, replayed with kernel %s at %u Hz, gain %d/256\n",
+               captures, input.declared, (PDM_KERNEL_FORMAT_PCM16 == input.stream_format) ? "PCM16" : "raw",
+               input.gain_q8, replay.p_kernel->p_name, rate, (int) gain_q8);
+        printf("  Replayed: %llu samples (%.3f s) in %u blocks, %u gaps (%llu samples), %u dropped, "
+               "%llu lost in hardware, slot high water %u\n",
+               (unsigned long long) replay.samples, audio_s, stats.callbacks, replay.gaps,
+               (unsigned long long) replay.gap_samples, stats.dropped, (unsigned long long) tm.samples_lost,
+               stats.slot_high_water);
+        printf("  Input levels: peak %u, rms %.1f (20-bit scale)\n", replay.peak,
+               (0U != replay.samples) ? sqrt(replay.sum_squares / (double) replay.samples) : 0.0);
+
+        if (replay.segments)
+        {
+            printf("  Segments: %u closed, %u evicted, level %d\n", replay.segment_printed, replay.segment.evicted,
+                   (int) level);
+        }
+
+        printf("  Pipeline: %.3f s, %.1f ns/sample, %.1f x real time; wall %.3f s, %.1f x real time%s\n", pipe_s,
+               (0U != replay.samples) ? (double) pipe_ns / (double) replay.samples : 0.0,
+               (pipe_s > 0.0) ? audio_s / pipe_s : 0.0, wall_s, (wall_s > 0.0) ? audio_s / wall_s : 0.0,
+               realtime ? " (paced)" : "");
+
+        if ((0U != input.declared) && (input.declared != replay.samples))
+        {
+            printf("  Warning: %u samples declared, %llu found\n", input.declared,
+                   (unsigned long long) replay.samples);
+        }
+
+        captures++;
+    }
+
+    (void) pdm_session_close(&session);
+    free(p_pool);
+    free(p_pre);
+    free(input.p_line);
+
+    if (NULL != replay.p_out)
+    {
+        fclose(replay.p_out);
+    }
+
+    if (stdin != input.p_file)
+    {
+        fclose(input.p_file);
+    }
+
+    if ((0 == status) && (0U == captures))
+    {
+        fprintf(stderr, "pdm_replay: no capture found\n");
+        status = 1;
+    }
+
+    return status;
+}
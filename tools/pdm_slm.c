@@ -0,0 +1,425 @@
+/**
+ * @file pdm_slm.c
+ * @brief Host accuracy and cost check of the sound level meter (src/pdm_slm.c)
+ * @details Meters synthetic tones and compares the readings with the expected levels:
+ *          - A and C weighting: a tone at every third-octave midband, LAeq - LZeq and LCeq - LZeq against the
+ *            IEC 61672-1 analog responses, inside limits modelled on class 1 (+-1 dB up to 4 kHz, the class 1 limits
+ *            of IEC 61672-1:2002 above)
+ *          - bands, third-octave and octave: a tone at every midband reads within +-0.4 dB in its band, a tone at every
+ *            band edge -3 +-0.5 dB in both bands it separates, the power sum of all bands is within +-1 dB of the
+ *            tone, and bands two octaves or more from the tone (aliases of the decimators included) read at least
+ *            55 dB (third-octave) or 35 dB (octave) below it. The margin to the 60 and 43 dB of the analog filters is
+ *            for the top bands near half the rate, whose skirts the bilinear transform widens.
+ *          - intervals: a 1 kHz tone changing level at every interval end reads the level of each interval, with the
+ *            interval lengths kept to the rate; a rate change mid-interval and a flush report the short interval
+ *
+ *          Every rate in a list that includes the PDM rate is checked, the samples delivered in calls of pseudo-random
+ *          length (1 to 2048 samples) as data callbacks would deliver them. The cost is reported in ns per sample, as
+ *          a share of real time, and as biquad sections per input sample against a bank without decimation.
+ *
+ *          Usage: pdm_slm [-r rate_hz] [-v]
+ *            -r  meter at this rate only
+ *            -v  print every reading, not only failures
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_slm.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+#define PDM_SLM_FULL_SCALE        (524288.0)         // 20-bit samples
+#define PDM_SLM_MAX_CALL          (2048U)
+#define PDM_SLM_PI                (3.14159265358979323846)
+#define PDM_SLM_LEVEL_DB          (-20.0)            // Tone level, dB below a full scale sine
+#define PDM_SLM_INTERVAL_MS       (1000U)            // Tones run for two intervals; the second one is read
+#define PDM_SLM_STEP_INTERVAL_MS  (250U)
+#define PDM_SLM_STEP_INTERVALS    (12U)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+/** Running totals of one rate */
+typedef struct st_pdm_slm_totals
+{
+    uint32_t checks;
+    uint32_t failed;
+    uint64_t ns;
+    uint64_t samples;
+    bool     verbose;
+} pdm_slm_totals_t;
+
+/***********************************************************************************************************************
+ * Private global variables
+ **********************************************************************************************************************/
+
+static uint32_t const g_pdm_slm_rates[] = {48000U, 44100U, 32258U, 16000U};
+
+/* Weighting limits (below, above) from band 37 (5 kHz) to band 43 (20 kHz); +-1 dB below */
+static double const g_pdm_slm_limits[7][2] =
+{
+    {1.5, 1.5}, {2.0, 1.5}, {2.5, 1.5}, {3.0, 2.0}, {5.0, 2.0}, {16.0, 2.5}, {1000.0, 3.0},
+};
+
+static uint32_t g_pdm_slm_seed = 0x9E3779B9U;
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+static void pdm_slm_usage(char const * p_name)
+{
+    fprintf(stderr, "usage: %s [-r rate_hz] [-v]\n", p_name);
+}
+
+static uint32_t pdm_slm_call_length(void)
+{
+    g_pdm_slm_seed = (g_pdm_slm_seed * 1664525U) + 1013904223U;
+
+    return 1U + ((g_pdm_slm_seed >> 8) % PDM_SLM_MAX_CALL);
+}
+
+static double pdm_slm_midband_hz(uint32_t band)
+{
+    return pow(10.0, band / 10.0);
+}
+
+/* IEC 61672-1 analog weighting in dB, 0 at 1 kHz */
+static double pdm_slm_weighting_db(double frequency_hz, bool a_weighting)
+{
+    static double const f1 = 20.598997;
+    static double const f2 = 107.65265;
+    static double const f3 = 737.86223;
+    static double const f4 = 12194.217;
+
+    double fs[2] = {frequency_hz * frequency_hz, 1.0e6};
+    double db[2];
+
+    for (uint32_t i = 0U; i < 2U; i++)
+    {
+        double f = fs[i];
+        double c = (f4 * f4 * f * f) / ((f + (f1 * f1)) * (f + (f1 * f1)) * (f + (f4 * f4)) * (f + (f4 * f4)));
+
+        db[i] = 10.0 * log10(a_weighting ? (c * f * f / ((f + (f2 * f2)) * (f + (f3 * f3)))) : c);
+    }
+
+    return db[0] - db[1];
+}
+
+/* Meter count samples of a tone continuing at sample n0, the last call ending with the last sample */
+static void pdm_slm_feed(pdm_slm_ctrl_t * p_meter, double frequency_hz, double level_db, uint64_t n0, uint64_t count,
+                         pdm_slm_totals_t * p_totals)
+{
+    int32_t  block[PDM_SLM_MAX_CALL];
+    uint32_t fill      = 0U;
+    uint32_t call      = pdm_slm_call_length();
+    double   rate      = (double) p_meter->cfg.rate_hz;
+    double   amplitude = pow(10.0, level_db / 20.0) * PDM_SLM_FULL_SCALE;
+
+    for (uint64_t n = n0; n < (n0 + count); n++)
+    {
+        double x = amplitude * sin(2.0 * PDM_SLM_PI * frequency_hz * ((double) n / rate));
+
+        block[fill++] = (int32_t) llround(x);
+        if ((fill == call) || ((n + 1U) == (n0 + count)))
+        {
+            uint32_t start = pdm_port_cycles();
+            (void) pdm_slm_process(p_meter, block, fill);
+            p_totals->ns      += pdm_port_cycles() - start;
+            p_totals->samples += fill;
+            fill               = 0U;
+            call               = pdm_slm_call_length();
+        }
+    }
+}
+
+static uint64_t pdm_slm_interval_end(uint32_t rate_hz, uint32_t interval_ms, uint64_t interval)
+{
+    return ((uint64_t) rate_hz * interval_ms * interval) / 1000U;
+}
+
+/* Meter a steady tone for two intervals and read the second */
+static void pdm_slm_tone(pdm_slm_ctrl_t * p_meter, pdm_slm_cfg_t const * p_cfg, double frequency_hz,
+                         pdm_slm_result_t * p_result, pdm_slm_totals_t * p_totals)
+{
+    (void) pdm_slm_open(p_meter, p_cfg);
+    pdm_slm_feed(p_meter, frequency_hz, PDM_SLM_LEVEL_DB, 0U, pdm_slm_interval_end(p_cfg->rate_hz,
+                                                                                   p_cfg->interval_ms, 2U), p_totals);
+    pdm_slm_get(p_meter, p_result);
+}
+
+static void pdm_slm_check(pdm_slm_totals_t * p_totals, char const * p_what, uint32_t rate_hz, double value,
+                          double expected, double below, double above)
+{
+    bool ok = (value >= (expected - below)) && (value <= (expected + above));
+
+    if (!ok || p_totals->verbose)
+    {
+        printf("%-4s %6u Hz  %-44s %8.2f, expected %7.2f (-%.1f/+%.1f)\n", ok ? "ok" : "FAIL", rate_hz, p_what, value,
+               expected, below, above);
+    }
+
+    p_totals->checks++;
+    p_totals->failed += ok ? 0U : 1U;
+}
+
+static double pdm_slm_band_sum(pdm_slm_result_t const * p_result)
+{
+    double sum = 0.0;
+
+    for (uint32_t i = 0U; i < p_result->band_count; i++)
+    {
+        sum += pow(10.0, p_result->band[i] / 10.0);
+    }
+
+    return 10.0 * log10(sum);
+}
+
+/* Bands of one width: midband and edge tones, weighting at the third-octave midbands */
+static void pdm_slm_bands(pdm_slm_ctrl_t * p_meter, uint32_t rate_hz, pdm_slm_bands_t bands,
+                          pdm_slm_totals_t * p_totals)
+{
+    pdm_slm_cfg_t const cfg =
+    {
+        .rate_hz = rate_hz, .scale = (float) (1.0 / PDM_SLM_FULL_SCALE), .full_scale_db = 0.0f, .bands = bands,
+        .low_band = (PDM_SLM_BANDS_OCTAVE == bands) ? 12U : 10U, .interval_ms = PDM_SLM_INTERVAL_MS,
+    };
+    char const * p_width   = (PDM_SLM_BANDS_OCTAVE == bands) ? "octave" : "third-octave";
+    double       spurious  = (PDM_SLM_BANDS_OCTAVE == bands) ? 35.0 : 55.0;
+    double       edge      = pow(10.0, 0.15 / (double) bands);
+    char         what[64];
+
+    if (FSP_SUCCESS != pdm_slm_open(p_meter, &cfg))
+    {
+        printf("FAIL %6u Hz  cannot open the %s meter\n", rate_hz, p_width);
+        p_totals->checks++;
+        p_totals->failed++;
+
+        return;
+    }
+
+    uint32_t count = p_meter->band_count;
+    uint32_t step  = 3U / (uint32_t) bands;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        uint32_t         band = cfg.low_band + (i * step);
+        pdm_slm_result_t result;
+
+        /* Midband */
+        pdm_slm_tone(p_meter, &cfg, pdm_slm_midband_hz(band), &result, p_totals);
+
+        snprintf(what, sizeof(what), "%s band %u, its midband", p_width, band);
+        pdm_slm_check(p_totals, what, rate_hz, result.band[i], PDM_SLM_LEVEL_DB, 0.4, 0.4);
+        snprintf(what, sizeof(what), "%s band sum, midband %u", p_width, band);
+        pdm_slm_check(p_totals, what, rate_hz, pdm_slm_band_sum(&result), PDM_SLM_LEVEL_DB, 1.0, 1.0);
+
+        double worst = -1000.0;
+        for (uint32_t k = 0U; k < count; k++)
+        {
+            uint32_t distance = (k > i) ? (k - i) : (i - k);
+            if ((distance * step) >= 6U)
+            {
+                worst = fmax(worst, (double) result.band[k]);
+            }
+        }
+
+        if (worst > -1000.0)
+        {
+            snprintf(what, sizeof(what), "%s bands 2+ octaves from midband %u", p_width, band);
+            pdm_slm_check(p_totals, what, rate_hz, worst - PDM_SLM_LEVEL_DB, -spurious, 1000.0, 0.0);
+        }
+
+        if (PDM_SLM_BANDS_THIRD_OCTAVE == bands)
+        {
+            double limit_below = 1.0;
+            double limit_above = 1.0;
+            if (band >= 37U)
+            {
+                limit_below = g_pdm_slm_limits[band - 37U][0];
+                limit_above = g_pdm_slm_limits[band - 37U][1];
+            }
+
+            snprintf(what, sizeof(what), "A weighting at band %u", band);
+            pdm_slm_check(p_totals, what, rate_hz, (double) (result.laeq - result.lzeq),
+                          pdm_slm_weighting_db(pdm_slm_midband_hz(band), true), limit_below, limit_above);
+            snprintf(what, sizeof(what), "C weighting at band %u", band);
+            pdm_slm_check(p_totals, what, rate_hz, (double) (result.lceq - result.lzeq),
+                          pdm_slm_weighting_db(pdm_slm_midband_hz(band), false), limit_below, limit_above);
+            snprintf(what, sizeof(what), "Z level at band %u", band);
+            pdm_slm_check(p_totals, what, rate_hz, (double) result.lzeq, PDM_SLM_LEVEL_DB, 0.1, 0.1);
+        }
+
+        /* Upper edge, shared with the next band */
+        if ((i + 1U) < count)
+        {
+            pdm_slm_tone(p_meter, &cfg, pdm_slm_midband_hz(band) * edge, &result, p_totals);
+
+            snprintf(what, sizeof(what), "%s bands %u and %u, their edge", p_width, band, band + step);
+            pdm_slm_check(p_totals, what, rate_hz, result.band[i], PDM_SLM_LEVEL_DB - 3.01, 0.5, 0.5);
+            pdm_slm_check(p_totals, what, rate_hz, result.band[i + 1U], PDM_SLM_LEVEL_DB - 3.01, 0.5, 0.5);
+            snprintf(what, sizeof(what), "%s band sum, edge of %u", p_width, band);
+            pdm_slm_check(p_totals, what, rate_hz, pdm_slm_band_sum(&result), PDM_SLM_LEVEL_DB, 1.0, 1.0);
+        }
+    }
+}
+
+/* Level steps at the interval ends, then a rate change in the middle of an interval and a flush */
+static void pdm_slm_intervals(pdm_slm_ctrl_t * p_meter, uint32_t rate_hz, pdm_slm_totals_t * p_totals)
+{
+    pdm_slm_cfg_t cfg =
+    {
+        .rate_hz = rate_hz, .scale = (float) (1.0 / PDM_SLM_FULL_SCALE), .full_scale_db = 0.0f,
+        .bands = PDM_SLM_BANDS_THIRD_OCTAVE, .low_band = 14U, .interval_ms = PDM_SLM_STEP_INTERVAL_MS,
+    };
+    pdm_slm_result_t result;
+    char             what[64];
+
+    (void) pdm_slm_open(p_meter, &cfg);
+
+    for (uint32_t k = 0U; k < PDM_SLM_STEP_INTERVALS; k++)
+    {
+        double   level = PDM_SLM_LEVEL_DB - ((0U != (k & 1U)) ? 10.0 : 0.0);
+        uint64_t first = pdm_slm_interval_end(rate_hz, cfg.interval_ms, k);
+        uint64_t end   = pdm_slm_interval_end(rate_hz, cfg.interval_ms, k + 1U);
+
+        pdm_slm_feed(p_meter, 1000.0, level, first, end - first, p_totals);
+        pdm_slm_get(p_meter, &result);
+
+        snprintf(what, sizeof(what), "interval %u: count", k);
+        pdm_slm_check(p_totals, what, rate_hz, result.interval, k + 1U, 0.0, 0.0);
+        snprintf(what, sizeof(what), "interval %u: ms", k);
+        pdm_slm_check(p_totals, what, rate_hz, result.duration_ms, cfg.interval_ms, 0.0, 0.0);
+        if (0U != k)
+        {
+            snprintf(what, sizeof(what), "interval %u: LAeq, 1 kHz stepped", k);
+            pdm_slm_check(p_totals, what, rate_hz, (double) result.laeq, level, 0.2, 0.2);
+        }
+    }
+
+    /* Half an interval more, then half the rate */
+    cfg.interval_ms = PDM_SLM_INTERVAL_MS;
+    (void) pdm_slm_open(p_meter, &cfg);
+    pdm_slm_feed(p_meter, 1000.0, PDM_SLM_LEVEL_DB, 0U, (3U * (uint64_t) rate_hz) / 2U, p_totals);
+
+    bool ok = (FSP_SUCCESS == pdm_slm_rate_set(p_meter, rate_hz / 2U));
+    pdm_slm_get(p_meter, &result);
+    pdm_slm_check(p_totals, "rate change: accepted", rate_hz, ok ? 1.0 : 0.0, 1.0, 0.0, 0.0);
+    pdm_slm_check(p_totals, "rate change: short interval count", rate_hz, result.interval, 2.0, 0.0, 0.0);
+    pdm_slm_check(p_totals, "rate change: short interval ms", rate_hz, result.duration_ms, 500.0, 1.0, 1.0);
+    pdm_slm_check(p_totals, "rate change: short interval LZeq", rate_hz, (double) result.lzeq, PDM_SLM_LEVEL_DB,
+                  0.1, 0.1);
+
+    pdm_slm_feed(p_meter, 1000.0, PDM_SLM_LEVEL_DB, 0U, rate_hz / 2U, p_totals);
+    pdm_slm_get(p_meter, &result);
+    pdm_slm_check(p_totals, "rate change: next interval LAeq", rate_hz, (double) result.laeq, PDM_SLM_LEVEL_DB, 0.2,
+                  0.2);
+
+    /* A quarter interval more, flushed as at the end of a recording */
+    pdm_slm_feed(p_meter, 1000.0, PDM_SLM_LEVEL_DB, 0U, rate_hz / 8U, p_totals);
+    uint32_t flushed = pdm_slm_flush(p_meter);
+    pdm_slm_get(p_meter, &result);
+    pdm_slm_check(p_totals, "flush: done", rate_hz, flushed, 1.0, 0.0, 0.0);
+    pdm_slm_check(p_totals, "flush: interval count", rate_hz, result.interval, 4.0, 0.0, 0.0);
+    pdm_slm_check(p_totals, "flush: interval ms", rate_hz, result.duration_ms, 250.0, 1.0, 1.0);
+    pdm_slm_check(p_totals, "flush: nothing left", rate_hz, pdm_slm_flush(p_meter), 0.0, 0.0, 0.0);
+}
+
+/* Biquad sections per input sample of the bank as built, and without decimation */
+static void pdm_slm_cost(pdm_slm_ctrl_t * p_meter, uint32_t rate_hz, pdm_slm_totals_t const * p_totals)
+{
+    pdm_slm_cfg_t const cfg =
+    {
+        .rate_hz = rate_hz, .scale = 1.0f, .full_scale_db = 0.0f, .bands = PDM_SLM_BANDS_THIRD_OCTAVE, .low_band = 14U,
+        .interval_ms = PDM_SLM_INTERVAL_MS,
+    };
+
+    (void) pdm_slm_open(p_meter, &cfg);
+
+    double sections = (double) (p_meter->a_weighting.stages + p_meter->c_weighting.stages);
+    double direct   = sections + (3.0 * p_meter->band_count);
+    double taps     = 0.0;
+    for (uint32_t j = 0U; j < p_meter->stage_count; j++)
+    {
+        sections += 3.0 * p_meter->stage[j].bands / (double) (1U << j);
+        if ((j + 1U) < p_meter->stage_count)
+        {
+            taps += (double) (((PDM_SLM_HALFBAND_TAPS + 1U) / 4U) + 1U) / (double) (2U << j);
+        }
+    }
+
+    double ns_per_sample = (double) p_totals->ns / (double) p_totals->samples;
+    printf("%6u Hz: meter %.1f ns per sample, %.3f %% of real time; third-octave 25 Hz up, %u bands in %u stages: "
+           "%.1f biquad sections and %.1f decimator taps per sample (%.0f sections without decimation)\n",
+           rate_hz, ns_per_sample, ns_per_sample * rate_hz / 1e7, p_meter->band_count, p_meter->stage_count, sections,
+           taps, direct);
+}
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    uint32_t only    = 0U;
+    bool     verbose = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "-r")) && ((i + 1) < argc))
+        {
+            only = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if (0 == strcmp(argv[i], "-v"))
+        {
+            verbose = true;
+        }
+        else
+        {
+            pdm_slm_usage(argv[0]);
+
+            return 2;
+        }
+    }
+
+    pdm_slm_ctrl_t * p_meter = malloc(sizeof(*p_meter));
+    if (NULL == p_meter)
+    {
+        return 2;
+    }
+
+    uint32_t checks = 0U;
+    uint32_t failed = 0U;
+
+    for (uint32_t r = 0U; r < (sizeof(g_pdm_slm_rates) / sizeof(g_pdm_slm_rates[0])); r++)
+    {
+        uint32_t         rate   = (0U != only) ? only : g_pdm_slm_rates[r];
+        pdm_slm_totals_t totals = {.verbose = verbose};
+
+        pdm_slm_bands(p_meter, rate, PDM_SLM_BANDS_THIRD_OCTAVE, &totals);
+        pdm_slm_bands(p_meter, rate, PDM_SLM_BANDS_OCTAVE, &totals);
+        pdm_slm_intervals(p_meter, rate, &totals);
+        pdm_slm_cost(p_meter, rate, &totals);
+
+        checks += totals.checks;
+        failed += totals.failed;
+
+        if (0U != only)
+        {
+            break;
+        }
+    }
+
+    free(p_meter);
+    printf("%u checks, %u failed\n", checks, failed);
+
+    return (0U == failed) ? 0 : 1;
+}
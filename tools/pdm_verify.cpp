@@ -0,0 +1,797 @@
+/**
+ * @file pdm_verify.cpp
+ * @brief Host verification of PDM filter configurations against the fixed-point chain model
+ * @details Reads a pdm_extended_cfg_t initializer (by default g_pdm0_cfg_extend from ra_gen/hal_data.c, with the
+ *          #defines of ra_gen/hal_data.h; a tools/pdm_coefgen header works the same way) and drives delta-sigma
+ *          modulated stimuli through tools/pdm_model.hpp:
+ *          - sine sweep: magnitude and phase per frequency, next to the analytic response of the same registers
+ *          - passband ripple over [-l, -p] and stopband attenuation of tones that alias onto that band
+ *          - THD+N and effective bits of a single tone, SINAD of a multitone
+ *          - idle noise floor (dynamic range) and white noise (broadband gain against the analytic prediction)
+ *
+ *          Levels are relative to the PDM full scale (a +-1 bit stream); effective bits are referred to that full
+ *          scale. The PCM output is taken as configured by pcm_width (20 bits, or the 16-bit window), -w overrides.
+ *
+ *          With -S every sinc_filter_mode and stage input shift combination of the loaded coefficients is measured
+ *          (256 configurations, sincrng adapted to each order) and reported as CSV. All stimulus runs of all
+ *          configurations are spread over -j threads (default: all cores).
+ *
+ *          Limits (-R, -A, -E) turn the report into a check: the exit status is 1 when the single configuration, or
+ *          in a sweep the file's own configuration, misses one.
+ *
+ *          Usage: pdm_verify [-f file] ... [-v variable] [-c pdm_clock_hz] [-p passband_hz] [-l low_hz]
+ *                            [-a amplitude] [-n samples] [-k sweep_points] [-w pcm_window] [-j threads] [-S]
+ *                            [-R max_ripple_db] [-A min_stopband_db] [-E min_enob]
+ */
+
+/***********************************************************************************************************************
+ * Includes
+ **********************************************************************************************************************/
+#include "pdm_model.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/***********************************************************************************************************************
+ * Macro definitions
+ **********************************************************************************************************************/
+
+/* PCM samples thrown away before measuring: several HPF time constants */
+#define PDM_VERIFY_SETTLE_SAMPLES   (512U)
+
+/* Stopband tones per side of the PCM rate, multitone tone count */
+#define PDM_VERIFY_STOP_TONES       (6U)
+#define PDM_VERIFY_MULTITONES       (8U)
+
+/* White noise standard deviation, relative to the PDM full scale */
+#define PDM_VERIFY_NOISE_SIGMA      (0.2)
+
+/* Window value meaning the 20-bit output */
+#define PDM_VERIFY_WINDOW_20BIT     (-1)
+
+/***********************************************************************************************************************
+ * Typedef definitions
+ **********************************************************************************************************************/
+
+namespace
+{
+
+struct pdm_verify_opts
+{
+    std::vector<std::string> files;
+    std::string              variable     = "g_pdm0_cfg_extend";
+    double                   pdm_clock_hz = 4000000.0;
+    double                   passband_hz  = 0.0;              ///< 0: 40 % of the PCM rate
+    double                   low_hz       = 1000.0;
+    double                   amplitude    = 0.5;
+    unsigned                 samples      = 4096U;
+    unsigned                 points       = 24U;
+    int                      window       = -2;               ///< -2: from pcm_width
+    unsigned                 threads      = 0U;
+    bool                     sweep        = false;
+    double                   max_ripple   = -1.0;
+    double                   min_stopband = -1.0;
+    double                   min_enob     = -1.0;
+};
+
+struct pdm_verify_config
+{
+    pdm_model::filters f;
+    int                window = PDM_VERIFY_WINDOW_20BIT;
+    std::string        label;
+};
+
+enum pdm_verify_kind
+{
+    PDM_VERIFY_SWEEP,
+    PDM_VERIFY_STOP,
+    PDM_VERIFY_THD,
+    PDM_VERIFY_MULTITONE,
+    PDM_VERIFY_IDLE,
+    PDM_VERIFY_NOISE,
+};
+
+/** One stimulus run */
+struct pdm_verify_job
+{
+    size_t                             config;
+    pdm_verify_kind                    kind;
+    std::vector<double>                in_hz;        ///< Input tones
+    std::vector<double>                out_hz;       ///< Where they land in the PCM band
+    double                             amplitude = 0.0;
+    std::vector<std::complex<double>>  phasors;      ///< Fitted output per tone
+    double                             residual  = 0.0;
+    uint64_t                           saturations = 0U;
+};
+
+struct pdm_verify_point
+{
+    double f_hz;
+    double mag_db;
+    double phase_deg;
+    double model_mag_db;
+    double model_phase_deg;
+};
+
+struct pdm_verify_result
+{
+    double                        rate_hz          = 0.0;
+    double                        ripple_db        = 0.0;
+    double                        stopband_db      = 0.0;
+    double                        thdn_db          = 0.0;
+    double                        enob             = 0.0;
+    double                        multitone_db     = 0.0;
+    double                        dynamic_range_db = 0.0;
+    double                        noise_gain_db    = 0.0;
+    double                        model_dev_db     = 0.0;
+    uint64_t                      saturations      = 0U;
+    std::vector<pdm_verify_point> points;
+};
+
+/***********************************************************************************************************************
+ * Private Functions
+ **********************************************************************************************************************/
+
+/* Configuration source: #defines and the initializer of one variable */
+class pdm_verify_source
+{
+public:
+    bool load(std::vector<std::string> const & files)
+    {
+        for (std::string const & path : files)
+        {
+            std::ifstream in(path);
+            if (!in)
+            {
+                fprintf(stderr, "cannot read %s\n", path.c_str());
+
+                return false;
+            }
+
+            std::stringstream text;
+            text << in.rdbuf();
+            m_text += text.str() + "\n";
+        }
+
+        std::istringstream lines(m_text);
+        std::string        line;
+        while (std::getline(lines, line))
+        {
+            std::istringstream words(line);
+            std::string        directive;
+            std::string        name;
+            std::string        value;
+            if ((words >> directive >> name) && ("#define" == directive) && std::getline(words, value))
+            {
+                m_defines[name] = value;
+            }
+        }
+
+        return true;
+    }
+
+    /* Number of a token: literal, #define or enumerator ending in its value (PDM_SINC_FILTER_MODE_4) */
+    bool value(std::string token, long & out, int depth = 0) const
+    {
+        token.erase(std::remove_if(token.begin(), token.end(),
+                                   [](char c) { return std::isspace((unsigned char) c) || ('(' == c) || (')' == c); }),
+                    token.end());
+        if (token.empty() || (depth > 8))
+        {
+            return false;
+        }
+
+        if (std::isdigit((unsigned char) token[0]) || ('-' == token[0]))
+        {
+            out = strtol(token.c_str(), NULL, 0);
+
+            return true;
+        }
+
+        auto define = m_defines.find(token);
+        if (m_defines.end() != define)
+        {
+            return value(define->second, out, depth + 1);
+        }
+
+        size_t underscore = token.find_last_of('_');
+        if ((std::string::npos != underscore) && ((underscore + 1U) < token.size()) &&
+            std::isdigit((unsigned char) token[underscore + 1U]))
+        {
+            out = strtol(token.c_str() + underscore + 1U, NULL, 10);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /* Fields of "variable = { .field = value, .array = { ... }, ... }" */
+    bool fields(std::string const & variable, std::map<std::string, std::string> & out) const
+    {
+        size_t at = 0U;
+        for (;;)
+        {
+            at = m_text.find(variable, at);
+            if (std::string::npos == at)
+            {
+                return false;
+            }
+
+            size_t next = m_text.find_first_not_of(" \t\r\n", at + variable.size());
+            if ((std::string::npos != next) && ('=' == m_text[next]))
+            {
+                at = m_text.find('{', next);
+                break;
+            }
+
+            at += variable.size();
+        }
+
+        if (std::string::npos == at)
+        {
+            return false;
+        }
+
+        int    depth = 0;
+        size_t end   = at;
+        for (; end < m_text.size(); end++)
+        {
+            depth += ('{' == m_text[end]) ? 1 : (('}' == m_text[end]) ? -1 : 0);
+            if (0 == depth)
+            {
+                break;
+            }
+        }
+
+        std::string body = m_text.substr(at + 1U, end - at - 1U);
+        size_t      pos  = 0U;
+        while (std::string::npos != (pos = body.find('.', pos)))
+        {
+            size_t eq = body.find('=', pos);
+            if (std::string::npos == eq)
+            {
+                break;
+            }
+
+            std::string name = body.substr(pos + 1U, eq - pos - 1U);
+            name.erase(std::remove_if(name.begin(), name.end(), [](char c) { return std::isspace((unsigned char) c); }),
+                       name.end());
+
+            size_t start = body.find_first_not_of(" \t\r\n", eq + 1U);
+            size_t stop;
+            if ((std::string::npos != start) && ('{' == body[start]))
+            {
+                stop = body.find('}', start);
+                out[name] = body.substr(start + 1U, stop - start - 1U);
+                stop++;
+            }
+            else
+            {
+                stop = body.find(',', eq);
+                stop = (std::string::npos == stop) ? body.size() : stop;
+                out[name] = body.substr(eq + 1U, stop - eq - 1U);
+            }
+
+            pos = stop;
+        }
+
+        return true;
+    }
+
+    /* Output window of the pcm_width enumerator: PDM_PCM_WIDTH_16_BITS_<shift>_<msb>, 20-bit otherwise */
+    int window() const
+    {
+        size_t at = m_text.find("PDM_PCM_WIDTH_16_BITS_");
+        if (std::string::npos == at)
+        {
+            return PDM_VERIFY_WINDOW_20BIT;
+        }
+
+        return (int) strtol(m_text.c_str() + at + strlen("PDM_PCM_WIDTH_16_BITS_"), NULL, 10);
+    }
+
+private:
+    std::string                        m_text;
+    std::map<std::string, std::string> m_defines;
+};
+
+/* Filter registers from the initializer fields */
+bool pdm_verify_filters(pdm_verify_source const & source, std::map<std::string, std::string> const & fields,
+                        pdm_model::filters & f)
+{
+    auto scalar = [&](char const * p_name, unsigned & out) {
+        long value;
+        auto it = fields.find(p_name);
+        if ((fields.end() == it) || !source.value(it->second, value))
+        {
+            fprintf(stderr, "missing or unreadable field %s\n", p_name);
+
+            return false;
+        }
+
+        out = (unsigned) value;
+
+        return true;
+    };
+
+    auto list = [&](char const * p_name, uint16_t * p_out, size_t count) {
+        auto it = fields.find(p_name);
+        if (fields.end() == it)
+        {
+            fprintf(stderr, "missing field %s\n", p_name);
+
+            return false;
+        }
+
+        std::istringstream items(it->second);
+        std::string        item;
+        size_t             n = 0U;
+        long               value;
+        while (std::getline(items, item, ',') && (n < count))
+        {
+            if (!source.value(item, value))
+            {
+                return false;
+            }
+
+            p_out[n++] = (uint16_t) value;
+        }
+
+        if (n != count)
+        {
+            fprintf(stderr, "field %s has %zu of %zu values\n", p_name, n, count);
+        }
+
+        return n == count;
+    };
+
+    unsigned s0 = 0U;
+    unsigned k1 = 0U;
+    unsigned h0 = 0U;
+
+    bool ok = scalar("sinc_filter_mode", f.sinc_order) && scalar("sincdec", f.sincdec) &&
+              scalar("sincrng", f.sincrng) && scalar("compensation_filter_shift", f.comp_shift) &&
+              scalar("low_pass_filter_shift", f.lpf_shift) && scalar("high_pass_filter_shift", f.hpf_shift) &&
+              scalar("hpf_coefficient_s0", s0) && scalar("hpf_coefficient_k1", k1) &&
+              scalar("lpf_coefficient_h0", h0) && list("hpf_coefficient_h", f.hpf_h.data(), f.hpf_h.size()) &&
+              list("compensation_filter_coefficient_h", f.comp.data(), f.comp.size()) &&
+              list("lpf_coefficient_h1", f.lpf.data(), f.lpf.size());
+
+    f.hpf_s0 = (uint16_t) s0;
+    f.hpf_k1 = (uint16_t) k1;
+    f.lpf_h0 = (uint16_t) h0;
+
+    return ok && (f.sinc_order >= 1U) && (f.sinc_order <= 4U) && (0U != f.sincdec);
+}
+
+/* Run fn(i) for i in [0, count) on up to `threads` threads */
+template <typename Fn>
+void pdm_verify_parallel(size_t count, unsigned threads, Fn fn)
+{
+    std::atomic<size_t>      next(0U);
+    std::vector<std::thread> pool;
+
+    for (unsigned t = 0U; t < std::max(1U, threads); t++)
+    {
+        pool.emplace_back([&]() {
+            for (size_t i = next++; i < count; i = next++)
+            {
+                fn(i);
+            }
+        });
+    }
+
+    for (std::thread & thread : pool)
+    {
+        thread.join();
+    }
+}
+
+double pdm_verify_rate(pdm_verify_opts const & opts, pdm_model::filters const & f)
+{
+    return opts.pdm_clock_hz / (2.0 * f.sincdec);
+}
+
+double pdm_verify_passband(pdm_verify_opts const & opts, pdm_model::filters const & f)
+{
+    return (opts.passband_hz > 0.0) ? opts.passband_hz : 0.4 * pdm_verify_rate(opts, f);
+}
+
+/* Output gain of a unit PDM amplitude at DC with flat filters, window included */
+double pdm_verify_scale(pdm_verify_config const & config)
+{
+    return pdm_model::scale(config.f) / ((config.window >= 0) ? std::ldexp(1.0, config.window) : 1.0);
+}
+
+/* Stimulus runs of one configuration */
+void pdm_verify_jobs(pdm_verify_opts const & opts, size_t index, pdm_verify_config const & config,
+                     std::vector<pdm_verify_job> & jobs)
+{
+    double rate     = pdm_verify_rate(opts, config.f);
+    double passband = pdm_verify_passband(opts, config.f);
+    double a        = opts.amplitude;
+
+    /* Log sweep from 20 Hz to just below the PCM Nyquist frequency */
+    for (unsigned i = 0U; i < opts.points; i++)
+    {
+        double f_hz = 20.0 * std::pow((0.49 * rate) / 20.0, (double) i / std::max(1U, opts.points - 1U));
+        jobs.push_back({index, PDM_VERIFY_SWEEP, {f_hz}, {f_hz}, a, {}, 0.0, 0U});
+    }
+
+    /* Tones either side of the PCM rate that fold onto the measured passband */
+    for (unsigned i = 0U; i < PDM_VERIFY_STOP_TONES; i++)
+    {
+        double folded = opts.low_hz + ((passband - opts.low_hz) * (i + 0.5) / PDM_VERIFY_STOP_TONES);
+        jobs.push_back({index, PDM_VERIFY_STOP, {rate - folded}, {folded}, a, {}, 0.0, 0U});
+        jobs.push_back({index, PDM_VERIFY_STOP, {rate + folded}, {folded}, a, {}, 0.0, 0U});
+    }
+
+    jobs.push_back({index, PDM_VERIFY_THD, {997.0}, {997.0}, a, {}, 0.0, 0U});
+
+    std::vector<double> tones;
+    for (unsigned i = 0U; i < PDM_VERIFY_MULTITONES; i++)
+    {
+        tones.push_back(opts.low_hz * std::pow(passband / opts.low_hz, (i + 0.5) / PDM_VERIFY_MULTITONES));
+    }
+
+    jobs.push_back({index, PDM_VERIFY_MULTITONE, tones, tones, a / PDM_VERIFY_MULTITONES, {}, 0.0, 0U});
+    jobs.push_back({index, PDM_VERIFY_IDLE, {}, {}, 0.0, {}, 0.0, 0U});
+    jobs.push_back({index, PDM_VERIFY_NOISE, {}, {}, PDM_VERIFY_NOISE_SIGMA, {}, 0.0, 0U});
+}
+
+void pdm_verify_run(pdm_verify_opts const & opts, pdm_verify_config const & config, pdm_verify_job & job)
+{
+    pdm_model::filters const & f    = config.f;
+    double                     fs   = opts.pdm_clock_hz;
+    size_t                     bits = (size_t) (opts.samples + PDM_VERIFY_SETTLE_SAMPLES) * 2U * f.sincdec;
+    std::vector<uint8_t>       pdm;
+
+    if (PDM_VERIFY_NOISE == job.kind)
+    {
+        std::mt19937                     rng(12345U);
+        std::normal_distribution<double> noise(0.0, job.amplitude);
+        pdm = pdm_model::modulate([&](size_t) { return noise(rng); }, bits);
+    }
+    else
+    {
+        std::vector<double> const & in = job.in_hz;
+        double                      a  = job.amplitude;
+        pdm = pdm_model::modulate([&](size_t n) {
+            double x = 0.0;
+            for (size_t i = 0U; i < in.size(); i++)
+            {
+                /* Spread multitone phases so the peaks do not line up */
+                x += a * std::sin((2.0 * pdm_model::pi * in[i] * (double) n / fs) + (2.4 * (double) i));
+            }
+
+            return x;
+        }, bits);
+    }
+
+    pdm_model::chain     chain(f);
+    std::vector<int32_t> pcm = chain.run(pdm);
+
+    if (config.window >= 0)
+    {
+        for (int32_t & y : pcm)
+        {
+            int32_t w = y >> config.window;
+            y         = std::max(-32768, std::min(32767, w));
+            job.saturations += (y != w) ? 1U : 0U;
+        }
+    }
+
+    job.saturations += chain.saturations();
+    job.phasors = pdm_model::fit_tones(pcm, PDM_VERIFY_SETTLE_SAMPLES, job.out_hz, pdm_verify_rate(opts, f),
+                                       pdm_model::pcm_time0(f), fs, &job.residual);
+
+    /* Undo the multitone phase offsets and the sine (not cosine) input: input phasor -j a exp(j 2.4 i) */
+    for (size_t i = 0U; i < job.phasors.size(); i++)
+    {
+        job.phasors[i] /= std::complex<double>(0.0, -job.amplitude) * std::polar(1.0, 2.4 * (double) i);
+    }
+}
+
+double pdm_verify_db(double ratio)
+{
+    return 20.0 * std::log10(std::max(ratio, 1e-12));
+}
+
+/* Wrap a phase to (-180, 180] degrees */
+double pdm_verify_degrees(double radians)
+{
+    double d = std::remainder(radians * 180.0 / pdm_model::pi, 360.0);
+
+    return (d <= -180.0) ? d + 360.0 : d;
+}
+
+/* Figures of one configuration from its finished runs */
+void pdm_verify_summarize(pdm_verify_opts const & opts, pdm_verify_config const & config,
+                          std::vector<pdm_verify_job> const & jobs, size_t first, size_t count,
+                          pdm_verify_result & r)
+{
+    pdm_model::filters const & f        = config.f;
+    double                     scale    = pdm_verify_scale(config);
+    double                     passband = pdm_verify_passband(opts, f);
+    double                     lo       = 1e9;
+    double                     hi       = -1e9;
+    double                     stop     = -1e9;
+
+    r.rate_hz = pdm_verify_rate(opts, f);
+
+    for (size_t j = first; j < (first + count); j++)
+    {
+        pdm_verify_job const & job = jobs[j];
+        r.saturations += job.saturations;
+
+        switch (job.kind)
+        {
+            case PDM_VERIFY_SWEEP:
+            {
+                std::complex<double> h     = job.phasors[0] / scale;
+                std::complex<double> model = pdm_model::chain_response(f, job.in_hz[0], opts.pdm_clock_hz);
+                pdm_verify_point     p     =
+                {
+                    job.in_hz[0], pdm_verify_db(std::abs(h)), pdm_verify_degrees(std::arg(h)),
+                    pdm_verify_db(std::abs(model)), pdm_verify_degrees(std::arg(model)),
+                };
+                r.points.push_back(p);
+
+                if ((p.f_hz >= opts.low_hz) && (p.f_hz <= passband))
+                {
+                    lo = std::min(lo, p.mag_db);
+                    hi = std::max(hi, p.mag_db);
+                }
+
+                if (p.model_mag_db > -40.0)
+                {
+                    r.model_dev_db = std::max(r.model_dev_db, std::fabs(p.mag_db - p.model_mag_db));
+                }
+
+                break;
+            }
+
+            case PDM_VERIFY_STOP:
+            {
+                stop = std::max(stop, pdm_verify_db(std::abs(job.phasors[0]) / scale));
+                break;
+            }
+
+            case PDM_VERIFY_THD:
+            {
+                double fundamental = std::abs(job.phasors[0]) * job.amplitude / std::sqrt(2.0);
+                r.thdn_db = pdm_verify_db(job.residual / fundamental);
+                r.enob    = (-r.thdn_db + pdm_verify_db(1.0 / job.amplitude) - 1.76) / 6.02;
+                break;
+            }
+
+            case PDM_VERIFY_MULTITONE:
+            {
+                double power = 0.0;
+                for (std::complex<double> const & p : job.phasors)
+                {
+                    power += std::norm(p * job.amplitude) / 2.0;
+                }
+
+                r.multitone_db = pdm_verify_db(std::sqrt(power) / job.residual);
+                break;
+            }
+
+            case PDM_VERIFY_IDLE:
+            {
+                /* Full-scale sine at 1 kHz against the idle floor, at least the rounding noise of one LSB */
+                double full_scale = scale * pdm_model::chain_gain(f, 1000.0, opts.pdm_clock_hz) / std::sqrt(2.0);
+                r.dynamic_range_db = pdm_verify_db(full_scale / std::max(job.residual, 1.0 / std::sqrt(12.0)));
+                break;
+            }
+
+            case PDM_VERIFY_NOISE:
+            {
+                /* White input of variance s^2 over 0..fs/2: output variance s^2 * mean |H|^2 over that band */
+                double   sum   = 0.0;
+                unsigned steps = 1U << 16;
+                for (unsigned i = 0U; i < steps; i++)
+                {
+                    double g = pdm_model::chain_gain(f, (i + 0.5) * opts.pdm_clock_hz / (2.0 * steps),
+                                                     opts.pdm_clock_hz);
+                    sum += g * g;
+                }
+
+                double predicted = job.amplitude * scale * std::sqrt(sum / steps);
+                r.noise_gain_db  = pdm_verify_db(job.residual / predicted);
+                break;
+            }
+        }
+    }
+
+    r.ripple_db   = hi - lo;
+    r.stopband_db = -stop;
+    std::sort(r.points.begin(), r.points.end(),
+              [](pdm_verify_point const & a, pdm_verify_point const & b) { return a.f_hz < b.f_hz; });
+}
+
+bool pdm_verify_pass(pdm_verify_opts const & opts, pdm_verify_result const & r)
+{
+    return ((opts.max_ripple < 0.0) || (r.ripple_db <= opts.max_ripple)) &&
+           ((opts.min_stopband < 0.0) || (r.stopband_db >= opts.min_stopband)) &&
+           ((opts.min_enob < 0.0) || (r.enob >= opts.min_enob)) && (0U == r.saturations);
+}
+
+void pdm_verify_usage(char const * p_name)
+{
+    fprintf(stderr,
+            "usage: %s [-f file] ... [-v variable] [-c pdm_clock_hz] [-p passband_hz] [-l low_hz] [-a amplitude]\n"
+            "          [-n samples] [-k sweep_points] [-w pcm_window (-1: 20-bit, 0..4: 16-bit window)] [-j threads]\n"
+            "          [-S] [-R max_ripple_db] [-A min_stopband_db] [-E min_enob]\n",
+            p_name);
+}
+
+} // namespace
+
+/***********************************************************************************************************************
+ * Functions
+ **********************************************************************************************************************/
+
+int main(int argc, char ** argv)
+{
+    pdm_verify_opts opts;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "-S"))
+        {
+            opts.sweep = true;
+            continue;
+        }
+
+        char const * p_value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+        if ((NULL == p_value) || ('-' != argv[i][0]) || ('\0' == argv[i][1]) || ('\0' != argv[i][2]))
+        {
+            pdm_verify_usage(argv[0]);
+
+            return 2;
+        }
+
+        switch (argv[i][1])
+        {
+            case 'f': opts.files.push_back(p_value); break;
+            case 'v': opts.variable = p_value; break;
+            case 'c': opts.pdm_clock_hz = strtod(p_value, NULL); break;
+            case 'p': opts.passband_hz = strtod(p_value, NULL); break;
+            case 'l': opts.low_hz = strtod(p_value, NULL); break;
+            case 'a': opts.amplitude = strtod(p_value, NULL); break;
+            case 'n': opts.samples = (unsigned) strtoul(p_value, NULL, 0); break;
+            case 'k': opts.points = (unsigned) strtoul(p_value, NULL, 0); break;
+            case 'w': opts.window = (int) strtol(p_value, NULL, 0); break;
+            case 'j': opts.threads = (unsigned) strtoul(p_value, NULL, 0); break;
+            case 'R': opts.max_ripple = strtod(p_value, NULL); break;
+            case 'A': opts.min_stopband = strtod(p_value, NULL); break;
+            case 'E': opts.min_enob = strtod(p_value, NULL); break;
+            default:
+            {
+                pdm_verify_usage(argv[0]);
+
+                return 2;
+            }
+        }
+
+        i++;
+    }
+
+    if (opts.files.empty())
+    {
+        opts.files = {"../ra_gen/hal_data.c", "../ra_gen/hal_data.h"};
+    }
+
+    if (0U == opts.threads)
+    {
+        opts.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    pdm_verify_source                  source;
+    std::map<std::string, std::string> fields;
+    pdm_verify_config                  base;
+
+    if (!source.load(opts.files))
+    {
+        return 2;
+    }
+
+    if (!source.fields(opts.variable, fields) || !pdm_verify_filters(source, fields, base.f))
+    {
+        fprintf(stderr, "no usable initializer of %s\n", opts.variable.c_str());
+
+        return 2;
+    }
+
+    base.window = (opts.window >= -1) ? opts.window : source.window();
+    base.label  = opts.variable;
+
+    /* The file's configuration first, then every order and shift combination */
+    std::vector<pdm_verify_config> configs = {base};
+    if (opts.sweep)
+    {
+        for (unsigned order = 1U; order <= 4U; order++)
+        {
+            for (unsigned shifts = 0U; shifts < 64U; shifts++)
+            {
+                pdm_verify_config c = base;
+                c.f.sinc_order      = order;
+                c.f.sincrng         = (order == base.f.sinc_order) ? base.f.sincrng
+                                                                   : pdm_model::sincrng_for(order, base.f.sincdec);
+                c.f.comp_shift      = shifts & 3U;
+                c.f.lpf_shift       = (shifts >> 2) & 3U;
+                c.f.hpf_shift       = (shifts >> 4) & 3U;
+                c.label             = "sweep";
+                configs.push_back(c);
+            }
+        }
+    }
+
+    std::vector<pdm_verify_job> jobs;
+    std::vector<size_t>         first(configs.size());
+    for (size_t c = 0U; c < configs.size(); c++)
+    {
+        first[c] = jobs.size();
+        pdm_verify_jobs(opts, c, configs[c], jobs);
+    }
+
+    pdm_verify_parallel(jobs.size(), opts.threads,
+                        [&](size_t j) { pdm_verify_run(opts, configs[jobs[j].config], jobs[j]); });
+
+    std::vector<pdm_verify_result> results(configs.size());
+    pdm_verify_parallel(configs.size(), opts.threads, [&](size_t c) {
+        size_t end = ((c + 1U) < configs.size()) ? first[c + 1U] : jobs.size();
+        pdm_verify_summarize(opts, configs[c], jobs, first[c], end - first[c], results[c]);
+    });
+
+    if (opts.sweep)
+    {
+        printf("label,order,sincdec,sincrng,comp_shift,lpf_shift,hpf_shift,window,rate_hz,ripple_db,stopband_db,"
+               "thdn_db,enob,multitone_sinad_db,dynamic_range_db,noise_gain_db,model_dev_db,saturations,pass\n");
+        for (size_t c = 0U; c < configs.size(); c++)
+        {
+            pdm_model::filters const & f = configs[c].f;
+            pdm_verify_result const &  r = results[c];
+            printf("%s,%u,%u,%u,%u,%u,%u,%d,%.2f,%.3f,%.1f,%.1f,%.2f,%.1f,%.1f,%.2f,%.3f,%llu,%d\n",
+                   configs[c].label.c_str(), f.sinc_order, f.sincdec, f.sincrng, f.comp_shift, f.lpf_shift,
+                   f.hpf_shift, configs[c].window, r.rate_hz, r.ripple_db, r.stopband_db, r.thdn_db, r.enob,
+                   r.multitone_db, r.dynamic_range_db, r.noise_gain_db, r.model_dev_db,
+                   (unsigned long long) r.saturations, pdm_verify_pass(opts, r) ? 1 : 0);
+        }
+    }
+    else
+    {
+        pdm_model::filters const & f = base.f;
+        pdm_verify_result const &  r = results[0];
+
+        printf("# %s: order %u, sincdec %u, sincrng %u, shifts %u/%u/%u, window %d, %.2f Hz\n",
+               opts.variable.c_str(), f.sinc_order, f.sincdec, f.sincrng, f.comp_shift, f.lpf_shift, f.hpf_shift,
+               base.window, r.rate_hz);
+        printf("# f_hz,mag_db,phase_deg,model_mag_db,model_phase_deg\n");
+        for (pdm_verify_point const & p : r.points)
+        {
+            printf("%.1f,%.3f,%.2f,%.3f,%.2f\n", p.f_hz, p.mag_db, p.phase_deg, p.model_mag_db, p.model_phase_deg);
+        }
+
+        printf("# ripple %.3f dB over %.0f..%.0f Hz\n", r.ripple_db, opts.low_hz, pdm_verify_passband(opts, f));
+        printf("# stopband %.1f dB\n", r.stopband_db);
+        printf("# thd+n %.1f dB at %.2f of full scale, %.2f effective bits\n", r.thdn_db, opts.amplitude, r.enob);
+        printf("# multitone sinad %.1f dB\n", r.multitone_db);
+        printf("# dynamic range %.1f dB\n", r.dynamic_range_db);
+        printf("# noise gain %+.2f dB against the analytic response\n", r.noise_gain_db);
+        printf("# model deviation %.3f dB, %llu saturations\n", r.model_dev_db, (unsigned long long) r.saturations);
+    }
+
+    return pdm_verify_pass(opts, results[0]) ? 0 : 1;
+}